@@ -0,0 +1,26 @@
+#pragma once
+#include "Vector3.h"
+
+///==========================================================
+/// 境界球
+///==========================================================
+struct Sphere
+{
+	Vector3 center;
+	float radius;
+};
+///==========================================================
+/// 境界球
+///==========================================================
+
+///==========================================================
+/// 軸平行境界箱（AABB）
+///==========================================================
+struct AABB
+{
+	Vector3 min;
+	Vector3 max;
+};
+///==========================================================
+/// 軸平行境界箱（AABB）
+///==========================================================
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+#include "Vector3.h"
+
+///==========================================================
+/// 平面（dot(normal, p) + distance >= 0 が表側）
+///==========================================================
+struct Plane
+{
+	Vector3 normal;
+	float distance;
+};
+///==========================================================
+/// 平面（dot(normal, p) + distance >= 0 が表側）
+///==========================================================
+
+///==========================================================
+/// 視錐台。6枚の平面はすべて内側を向いている
+///==========================================================
+struct Frustum
+{
+	//左, 右, 下, 上, 近, 遠
+	Plane planes[6];
+};
+///==========================================================
+/// 視錐台。6枚の平面はすべて内側を向いている
+///==========================================================
\ No newline at end of file
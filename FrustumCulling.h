@@ -0,0 +1,368 @@
+#pragma once
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "BoundingVolume.h"
+#include "Frustum.h"
+#include "VertexData.h"
+#include "MatrixMath.h"
+
+///==========================================================
+/// 境界球をSoA（成分ごとの配列）で持つ
+///==========================================================
+struct SphereSoA final
+{
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> radius;
+
+	size_t size() const { return centerX.size(); }
+
+	void resize(size_t count)
+	{
+		centerX.resize(count); centerY.resize(count); centerZ.resize(count);
+		radius.resize(count);
+	}
+
+	void Set(size_t index, const Sphere& sphere)
+	{
+		centerX[index] = sphere.center.x; centerY[index] = sphere.center.y; centerZ[index] = sphere.center.z;
+		radius[index] = sphere.radius;
+	}
+
+	Sphere Get(size_t index) const
+	{
+		return { { centerX[index], centerY[index], centerZ[index] }, radius[index] };
+	}
+};
+
+///==========================================================
+/// AABBをSoAで持つ。判定しやすいように中心と半分の大きさで保存する
+///==========================================================
+struct AABBSoA final
+{
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+
+	size_t size() const { return centerX.size(); }
+
+	void resize(size_t count)
+	{
+		centerX.resize(count); centerY.resize(count); centerZ.resize(count);
+		extentX.resize(count); extentY.resize(count); extentZ.resize(count);
+	}
+
+	void Set(size_t index, const AABB& aabb)
+	{
+		centerX[index] = (aabb.min.x + aabb.max.x) * 0.5f;
+		centerY[index] = (aabb.min.y + aabb.max.y) * 0.5f;
+		centerZ[index] = (aabb.min.z + aabb.max.z) * 0.5f;
+		extentX[index] = (aabb.max.x - aabb.min.x) * 0.5f;
+		extentY[index] = (aabb.max.y - aabb.min.y) * 0.5f;
+		extentZ[index] = (aabb.max.z - aabb.min.z) * 0.5f;
+	}
+};
+
+//ViewProjection行列から視錐台を作る（行ベクトル規約、クリップ空間のzは0～1）
+//clip = v * M なので、各平面は行列の列の組み合わせになる
+static Frustum MakeFrustum(const Matrix4x4& viewProjection)
+{
+	const Matrix4x4& m = viewProjection;
+	//列ベクトル (m[0][j], m[1][j], m[2][j], m[3][j]) の符号付き和
+	auto combine = [&m](int column, float sign) -> Plane
+		{
+			return {
+				{ m.m[0][3] + sign * m.m[0][column], m.m[1][3] + sign * m.m[1][column], m.m[2][3] + sign * m.m[2][column] },
+				m.m[3][3] + sign * m.m[3][column] };
+		};
+
+	Frustum frustum{};
+	frustum.planes[0] = combine(0, 1.0f);     //左   -w <= x
+	frustum.planes[1] = combine(0, -1.0f);    //右    x <= w
+	frustum.planes[2] = combine(1, 1.0f);     //下   -w <= y
+	frustum.planes[3] = combine(1, -1.0f);    //上    y <= w
+	frustum.planes[4] = { { m.m[0][2], m.m[1][2], m.m[2][2] }, m.m[3][2] };    //近  0 <= z
+	frustum.planes[5] = combine(2, -1.0f);    //遠    z <= w
+
+	//球の判定で距離をそのまま使えるように正規化しておく
+	for (Plane& plane : frustum.planes)
+	{
+		float length = std::sqrt(plane.normal.x * plane.normal.x + plane.normal.y * plane.normal.y + plane.normal.z * plane.normal.z);
+		assert(length != 0.0f);
+		plane.normal.x /= length;
+		plane.normal.y /= length;
+		plane.normal.z /= length;
+		plane.distance /= length;
+	}
+	return frustum;
+}
+
+//平面までの符号付き距離
+static float SignedDistance(const Plane& plane, const Vector3& point)
+{
+	return plane.normal.x * point.x + plane.normal.y * point.y + plane.normal.z * point.z + plane.distance;
+}
+
+//球が視錐台と重なっているか
+static bool IsVisible(const Frustum& frustum, const Sphere& sphere)
+{
+	for (const Plane& plane : frustum.planes)
+	{
+		if (SignedDistance(plane, sphere.center) < -sphere.radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//中心と半分の大きさで表した箱が視錐台と重なっているか
+//平面の法線方向に一番遠い頂点が裏側にあれば見えない
+static bool IsVisible(const Frustum& frustum, const Vector3& center, const Vector3& extent)
+{
+	for (const Plane& plane : frustum.planes)
+	{
+		float radius = std::fabs(plane.normal.x) * extent.x + std::fabs(plane.normal.y) * extent.y + std::fabs(plane.normal.z) * extent.z;
+		if (SignedDistance(plane, center) < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//AABBが視錐台と重なっているか
+static bool IsVisible(const Frustum& frustum, const AABB& aabb)
+{
+	const Vector3 center{ (aabb.min.x + aabb.max.x) * 0.5f, (aabb.min.y + aabb.max.y) * 0.5f, (aabb.min.z + aabb.max.z) * 0.5f };
+	const Vector3 extent{ (aabb.max.x - aabb.min.x) * 0.5f, (aabb.max.y - aabb.min.y) * 0.5f, (aabb.max.z - aabb.min.z) * 0.5f };
+	return IsVisible(frustum, center, extent);
+}
+
+//頂点を囲むAABB
+static AABB MakeAABB(std::span<const VertexData> vertices)
+{
+	assert(!vertices.empty());
+	AABB aabb{
+		{ vertices[0].position.x, vertices[0].position.y, vertices[0].position.z },
+		{ vertices[0].position.x, vertices[0].position.y, vertices[0].position.z } };
+	for (const VertexData& vertex : vertices)
+	{
+		aabb.min.x = std::fmin(aabb.min.x, vertex.position.x);
+		aabb.min.y = std::fmin(aabb.min.y, vertex.position.y);
+		aabb.min.z = std::fmin(aabb.min.z, vertex.position.z);
+		aabb.max.x = std::fmax(aabb.max.x, vertex.position.x);
+		aabb.max.y = std::fmax(aabb.max.y, vertex.position.y);
+		aabb.max.z = std::fmax(aabb.max.z, vertex.position.z);
+	}
+	return aabb;
+}
+
+//頂点を囲む境界球（中心はAABBの中心）
+static Sphere MakeBoundingSphere(std::span<const VertexData> vertices)
+{
+	const AABB aabb = MakeAABB(vertices);
+	Sphere sphere{ { (aabb.min.x + aabb.max.x) * 0.5f, (aabb.min.y + aabb.max.y) * 0.5f, (aabb.min.z + aabb.max.z) * 0.5f }, 0.0f };
+	float radiusSquared = 0.0f;
+	for (const VertexData& vertex : vertices)
+	{
+		float dx = vertex.position.x - sphere.center.x;
+		float dy = vertex.position.y - sphere.center.y;
+		float dz = vertex.position.z - sphere.center.z;
+		radiusSquared = std::fmax(radiusSquared, dx * dx + dy * dy + dz * dz);
+	}
+	sphere.radius = std::sqrt(radiusSquared);
+	return sphere;
+}
+
+//ローカル空間の境界球をワールド空間に移す
+//半径は一番大きい軸のスケールで拡大するので、不均一スケールでも外側に収まる
+static Sphere TransformSphere(const Sphere& sphere, const Matrix4x4& world)
+{
+	Sphere result{};
+	result.center.x = sphere.center.x * world.m[0][0] + sphere.center.y * world.m[1][0] + sphere.center.z * world.m[2][0] + world.m[3][0];
+	result.center.y = sphere.center.x * world.m[0][1] + sphere.center.y * world.m[1][1] + sphere.center.z * world.m[2][1] + world.m[3][1];
+	result.center.z = sphere.center.x * world.m[0][2] + sphere.center.y * world.m[1][2] + sphere.center.z * world.m[2][2] + world.m[3][2];
+	float scaleSquared = 0.0f;
+	for (int i = 0; i < 3; i++)
+	{
+		scaleSquared = std::fmax(scaleSquared, world.m[i][0] * world.m[i][0] + world.m[i][1] * world.m[i][1] + world.m[i][2] * world.m[i][2]);
+	}
+	result.radius = sphere.radius * std::sqrt(scaleSquared);
+	return result;
+}
+
+//ワールド空間の視錐台をローカル空間に移す
+//平面を行列で移して正規化し直すので、不均一スケールでもローカル空間の境界球をそのまま判定できる
+static Frustum MakeLocalFrustum(const Frustum& frustum, const Matrix4x4& world)
+{
+	Frustum result{};
+	for (int i = 0; i < 6; i++)
+	{
+		const Plane& plane = frustum.planes[i];
+		//ローカルの点pはワールドで p * world なので、平面の係数は world * (normal, distance)
+		Plane& local = result.planes[i];
+		local.normal.x = world.m[0][0] * plane.normal.x + world.m[0][1] * plane.normal.y + world.m[0][2] * plane.normal.z;
+		local.normal.y = world.m[1][0] * plane.normal.x + world.m[1][1] * plane.normal.y + world.m[1][2] * plane.normal.z;
+		local.normal.z = world.m[2][0] * plane.normal.x + world.m[2][1] * plane.normal.y + world.m[2][2] * plane.normal.z;
+		local.distance = world.m[3][0] * plane.normal.x + world.m[3][1] * plane.normal.y + world.m[3][2] * plane.normal.z + plane.distance;
+		float length = std::sqrt(local.normal.x * local.normal.x + local.normal.y * local.normal.y + local.normal.z * local.normal.z);
+		assert(length != 0.0f);
+		local.normal.x /= length;
+		local.normal.y /= length;
+		local.normal.z /= length;
+		local.distance /= length;
+	}
+	return result;
+}
+
+//ビットが立っている要素の番号をvisibleに詰める
+static inline size_t AppendVisible(uint32_t mask, size_t baseIndex, std::span<uint32_t> visible, size_t count)
+{
+	while (mask != 0)
+	{
+		visible[count++] = uint32_t(baseIndex + std::countr_zero(mask));
+		mask &= mask - 1;
+	}
+	return count;
+}
+
+//見えている球の番号をvisibleに詰めて、その個数を返す
+//visibleは球の数以上の大きさが必要
+static size_t CullSpheres(const Frustum& frustum, const SphereSoA& spheres, std::span<uint32_t> visible)
+{
+	const size_t count = spheres.size();
+	assert(count <= visible.size());
+	size_t index = 0;
+	size_t visibleCount = 0;
+
+#if defined(MATRIXMATH_USE_AVX)
+	//8個ずつ処理する
+	for (; index + 8 <= count; index += 8)
+	{
+		const __m256 cx = _mm256_loadu_ps(&spheres.centerX[index]);
+		const __m256 cy = _mm256_loadu_ps(&spheres.centerY[index]);
+		const __m256 cz = _mm256_loadu_ps(&spheres.centerZ[index]);
+		const __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&spheres.radius[index]));
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (const Plane& plane : frustum.planes)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_set1_ps(plane.normal.x), cx),
+				_mm256_mul_ps(_mm256_set1_ps(plane.normal.y), cy)),
+				_mm256_mul_ps(_mm256_set1_ps(plane.normal.z), cz)),
+				_mm256_set1_ps(plane.distance));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+		}
+		visibleCount = AppendVisible(uint32_t(_mm256_movemask_ps(inside)), index, visible, visibleCount);
+	}
+#elif defined(MATRIXMATH_USE_SSE)
+	//4個ずつ処理する
+	for (; index + 4 <= count; index += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(&spheres.centerX[index]);
+		const __m128 cy = _mm_loadu_ps(&spheres.centerY[index]);
+		const __m128 cz = _mm_loadu_ps(&spheres.centerZ[index]);
+		const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[index]));
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (const Plane& plane : frustum.planes)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(plane.normal.x), cx),
+				_mm_mul_ps(_mm_set1_ps(plane.normal.y), cy)),
+				_mm_mul_ps(_mm_set1_ps(plane.normal.z), cz)),
+				_mm_set1_ps(plane.distance));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+		visibleCount = AppendVisible(uint32_t(_mm_movemask_ps(inside)), index, visible, visibleCount);
+	}
+#endif
+
+	//残り（またはSIMDが使えない場合の全部）
+	for (; index < count; index++)
+	{
+		if (IsVisible(frustum, spheres.Get(index)))
+		{
+			visible[visibleCount++] = uint32_t(index);
+		}
+	}
+	return visibleCount;
+}
+
+//見えているAABBの番号をvisibleに詰めて、その個数を返す
+//visibleはAABBの数以上の大きさが必要
+static size_t CullAABBs(const Frustum& frustum, const AABBSoA& aabbs, std::span<uint32_t> visible)
+{
+	const size_t count = aabbs.size();
+	assert(count <= visible.size());
+	size_t index = 0;
+	size_t visibleCount = 0;
+
+#if defined(MATRIXMATH_USE_AVX)
+	//8個ずつ処理する
+	for (; index + 8 <= count; index += 8)
+	{
+		const __m256 cx = _mm256_loadu_ps(&aabbs.centerX[index]);
+		const __m256 cy = _mm256_loadu_ps(&aabbs.centerY[index]);
+		const __m256 cz = _mm256_loadu_ps(&aabbs.centerZ[index]);
+		const __m256 ex = _mm256_loadu_ps(&aabbs.extentX[index]);
+		const __m256 ey = _mm256_loadu_ps(&aabbs.extentY[index]);
+		const __m256 ez = _mm256_loadu_ps(&aabbs.extentZ[index]);
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (const Plane& plane : frustum.planes)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_set1_ps(plane.normal.x), cx),
+				_mm256_mul_ps(_mm256_set1_ps(plane.normal.y), cy)),
+				_mm256_mul_ps(_mm256_set1_ps(plane.normal.z), cz)),
+				_mm256_set1_ps(plane.distance));
+			__m256 radius = _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.normal.x)), ex),
+				_mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.normal.y)), ey)),
+				_mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.normal.z)), ez));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_sub_ps(_mm256_setzero_ps(), radius), _CMP_GE_OQ));
+		}
+		visibleCount = AppendVisible(uint32_t(_mm256_movemask_ps(inside)), index, visible, visibleCount);
+	}
+#elif defined(MATRIXMATH_USE_SSE)
+	//4個ずつ処理する
+	for (; index + 4 <= count; index += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(&aabbs.centerX[index]);
+		const __m128 cy = _mm_loadu_ps(&aabbs.centerY[index]);
+		const __m128 cz = _mm_loadu_ps(&aabbs.centerZ[index]);
+		const __m128 ex = _mm_loadu_ps(&aabbs.extentX[index]);
+		const __m128 ey = _mm_loadu_ps(&aabbs.extentY[index]);
+		const __m128 ez = _mm_loadu_ps(&aabbs.extentZ[index]);
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (const Plane& plane : frustum.planes)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(plane.normal.x), cx),
+				_mm_mul_ps(_mm_set1_ps(plane.normal.y), cy)),
+				_mm_mul_ps(_mm_set1_ps(plane.normal.z), cz)),
+				_mm_set1_ps(plane.distance));
+			__m128 radius = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(std::fabs(plane.normal.x)), ex),
+				_mm_mul_ps(_mm_set1_ps(std::fabs(plane.normal.y)), ey)),
+				_mm_mul_ps(_mm_set1_ps(std::fabs(plane.normal.z)), ez));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_sub_ps(_mm_setzero_ps(), radius)));
+		}
+		visibleCount = AppendVisible(uint32_t(_mm_movemask_ps(inside)), index, visible, visibleCount);
+	}
+#endif
+
+	//残り（またはSIMDが使えない場合の全部）
+	for (; index < count; index++)
+	{
+		const Vector3 center{ aabbs.centerX[index], aabbs.centerY[index], aabbs.centerZ[index] };
+		const Vector3 extent{ aabbs.extentX[index], aabbs.extentY[index], aabbs.extentZ[index] };
+		if (IsVisible(frustum, center, extent))
+		{
+			visible[visibleCount++] = uint32_t(index);
+		}
+	}
+	return visibleCount;
+}
@@ -0,0 +1,127 @@
+#include "MappedFile.h"
+#include <bit>
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	file_ = file;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping_)
+	{
+		Close();
+		return false;
+	}
+	data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+	if (!data_)
+	{
+		Close();
+		return false;
+	}
+	size_ = size_t(fileSize.QuadPart);
+#else
+	file_ = open(path.c_str(), O_RDONLY);
+	if (file_ < 0)
+	{
+		return false;
+	}
+
+	struct stat status {};
+	if (fstat(file_, &status) != 0 || status.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+	void* data = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, file_, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+	data_ = static_cast<const uint8_t*>(data);
+	size_ = size_t(status.st_size);
+#endif
+	return true;
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+	if (data_)
+	{
+		UnmapViewOfFile(data_);
+	}
+	if (mapping_)
+	{
+		CloseHandle(mapping_);
+	}
+	if (file_)
+	{
+		CloseHandle(file_);
+	}
+	file_ = nullptr;
+	mapping_ = nullptr;
+#else
+	if (data_)
+	{
+		munmap(const_cast<uint8_t*>(data_), size_);
+	}
+	if (file_ >= 0)
+	{
+		close(file_);
+	}
+	file_ = -1;
+#endif
+	data_ = nullptr;
+	size_ = 0;
+}
+
+uint64_t HashBytes(const uint8_t* data, size_t size)
+{
+	static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+	static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+	uint64_t hash = kPrime1 ^ (uint64_t(size) * kPrime2);
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		std::memcpy(&word, data + i, sizeof(word));
+		hash ^= std::rotl(word * kPrime2, 31) * kPrime1;
+		hash = std::rotl(hash, 27) * kPrime1 + kPrime2;
+	}
+	if (i < size)
+	{
+		uint64_t tail = 0;
+		std::memcpy(&tail, data + i, size - i);
+		hash ^= std::rotl(tail * kPrime2, 31) * kPrime1;
+	}
+	//最後によく混ぜる
+	hash ^= hash >> 33;
+	hash *= kPrime2;
+	hash ^= hash >> 29;
+	return hash;
+}
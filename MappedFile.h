@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 読み込み専用でメモリにマップしたファイル
+// Windowsは CreateFileMapping / MapViewOfFile、それ以外は mmap を使う
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { Close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// ファイルを開いてマップする。開けなければfalse
+	bool Open(const std::string& path);
+	// マップを解除してファイルを閉じる
+	void Close();
+
+	const uint8_t* data() const { return data_; }
+	size_t size() const { return size_; }
+private:
+#if defined(_WIN32)
+	void* file_ = nullptr;
+	void* mapping_ = nullptr;
+#else
+	int file_ = -1;
+#endif
+	const uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+};
+
+// 中身のハッシュ値。8バイトずつ混ぜるので、テキストの解析よりずっと速い
+uint64_t HashBytes(const uint8_t* data, size_t size);
@@ -4,4 +4,6 @@
 /// </summary>
 struct Matrix4x4 final {
 	float m[4][4];
+
+	constexpr bool operator==(const Matrix4x4&) const = default;
 };
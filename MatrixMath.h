@@ -2,12 +2,117 @@
 
 #include "Matrix4x4.h"
 #include "Vector3.h"
+#include "Transform.h"
 #include <cmath>
+#include <cassert>
+#include <span>
+#include <type_traits>
+
+///==========================================================
+/// SIMD命令セットの選択（コンパイル時）
+/// MATRIXMATH_NO_SIMD を定義するとスカラー実装になる
+///==========================================================
+#if !defined(MATRIXMATH_NO_SIMD)
+#if defined(__AVX__)
+#define MATRIXMATH_USE_AVX
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATRIXMATH_USE_SSE
+#endif
+#endif
+
+#if defined(MATRIXMATH_USE_SSE) || defined(MATRIXMATH_USE_AVX)
+#include <immintrin.h>
+#endif
+
+#if defined(MATRIXMATH_USE_SSE)
+//行をSSEレジスタに読み込む
+static inline __m128 LoadRow(const Matrix4x4& m, int row)
+{
+	return _mm_loadu_ps(m.m[row]);
+}
+
+//SSEレジスタを行に書き込む
+static inline void StoreRow(Matrix4x4& m, int row, __m128 v)
+{
+	_mm_storeu_ps(m.m[row], v);
+}
+
+//4要素分のsin/cosをまとめて計算する（誤差はfloatで数ULP程度）
+static inline void SinCos4(__m128 x, __m128& outSin, __m128& outCos)
+{
+	//x = q * (π/2) + r, |r| <= π/4 に範囲縮約する
+	const __m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.636619772f)));
+	const __m128 qf = _mm_cvtepi32_ps(q);
+	__m128 r = _mm_sub_ps(x, _mm_mul_ps(qf, _mm_set1_ps(1.5703125f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(4.837512969970703125e-4f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(7.549789954891882e-8f)));
+	const __m128 r2 = _mm_mul_ps(r, r);
+
+	//[-π/4, π/4] での多項式近似
+	__m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), r2), _mm_set1_ps(8.3321608736e-3f));
+	s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(-1.6666654611e-1f));
+	s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, r2), r), r);
+	__m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), r2), _mm_set1_ps(-1.388731625493765e-3f));
+	c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(4.166664568298827e-2f));
+	c = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(c, r2), r2), _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, _mm_set1_ps(0.5f))));
+
+	//象限に応じてsin/cosの入れ替えと符号を決める
+	const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+	const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+	const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+	const __m128 sinValue = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+	const __m128 cosValue = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+	outSin = _mm_xor_ps(sinValue, sinSign);
+	outCos = _mm_xor_ps(cosValue, cosSign);
+}
+
+//2x2行列（行優先で a b c d の順）の積 A*B
+static inline __m128 Mat2Multiply(__m128 a, __m128 b)
+{
+	return _mm_add_ps(
+		_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+//2x2行列の余因子行列との積 adj(A)*B
+static inline __m128 Mat2AdjMultiply(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+//2x2行列と余因子行列の積 A*adj(B)
+static inline __m128 Mat2MultiplyAdj(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(
+		_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+#endif
 
 //行列の加法
-static Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2)
+static constexpr Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2)
 {
 	Matrix4x4 result{};
+#if defined(MATRIXMATH_USE_AVX)
+	if (!std::is_constant_evaluated())
+	{
+		_mm256_storeu_ps(result.m[0], _mm256_add_ps(_mm256_loadu_ps(m1.m[0]), _mm256_loadu_ps(m2.m[0])));
+		_mm256_storeu_ps(result.m[2], _mm256_add_ps(_mm256_loadu_ps(m1.m[2]), _mm256_loadu_ps(m2.m[2])));
+		return result;
+	}
+#elif defined(MATRIXMATH_USE_SSE)
+	if (!std::is_constant_evaluated())
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			StoreRow(result, i, _mm_add_ps(LoadRow(m1, i), LoadRow(m2, i)));
+		}
+		return result;
+	}
+#endif
 	for (int i = 0; i < 4; i++)
 	{
 		for (int j = 0; j < 4; j++)
@@ -19,9 +124,26 @@ static Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2)
 }
 
 //行列の減法
-static Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2)
+static constexpr Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2)
 {
 	Matrix4x4 result{};
+#if defined(MATRIXMATH_USE_AVX)
+	if (!std::is_constant_evaluated())
+	{
+		_mm256_storeu_ps(result.m[0], _mm256_sub_ps(_mm256_loadu_ps(m1.m[0]), _mm256_loadu_ps(m2.m[0])));
+		_mm256_storeu_ps(result.m[2], _mm256_sub_ps(_mm256_loadu_ps(m1.m[2]), _mm256_loadu_ps(m2.m[2])));
+		return result;
+	}
+#elif defined(MATRIXMATH_USE_SSE)
+	if (!std::is_constant_evaluated())
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			StoreRow(result, i, _mm_sub_ps(LoadRow(m1, i), LoadRow(m2, i)));
+		}
+		return result;
+	}
+#endif
 	for (int i = 0; i < 4; i++)
 	{
 		for (int j = 0; j < 4; j++)
@@ -33,9 +155,49 @@ static Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2)
 }
 
 //行列の積
-static Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2)
+static constexpr Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2)
 {
 	Matrix4x4 result{};
+#if defined(MATRIXMATH_USE_AVX)
+	if (!std::is_constant_evaluated())
+	{
+		//2行ずつまとめて計算する。m2の各行は上下のレーンに複製しておく
+		const __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[0]));
+		const __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[1]));
+		const __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[2]));
+		const __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[3]));
+		for (int i = 0; i < 4; i += 2)
+		{
+			const __m256 a = _mm256_loadu_ps(m1.m[i]);
+			//スカラー版と同じ k = 0,1,2,3 の順に加算する（丸めを揃えるためFMAは使わない）
+			__m256 r = _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+			_mm256_storeu_ps(result.m[i], r);
+		}
+		return result;
+	}
+#elif defined(MATRIXMATH_USE_SSE)
+	if (!std::is_constant_evaluated())
+	{
+		const __m128 b0 = LoadRow(m2, 0);
+		const __m128 b1 = LoadRow(m2, 1);
+		const __m128 b2 = LoadRow(m2, 2);
+		const __m128 b3 = LoadRow(m2, 3);
+		for (int i = 0; i < 4; i++)
+		{
+			const __m128 a = LoadRow(m1, i);
+			//スカラー版と同じ k = 0,1,2,3 の順に加算する（丸めを揃えるためFMAは使わない）
+			__m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+			StoreRow(result, i, r);
+		}
+		return result;
+	}
+#endif
 	for (int i = 0; i < 4; i++)
 	{
 		for (int j = 0; j < 4; j++)
@@ -50,8 +212,60 @@ static Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2)
 }
 
 //逆行列
-static Matrix4x4 Inverse(const Matrix4x4& matrix)
+static constexpr Matrix4x4 Inverse(const Matrix4x4& matrix)
 {
+#if defined(MATRIXMATH_USE_SSE)
+	if (!std::is_constant_evaluated())
+	{
+		//2x2のブロックに分けて計算する
+		//	| A B |
+		//	| C D |
+		const __m128 r0 = LoadRow(matrix, 0);
+		const __m128 r1 = LoadRow(matrix, 1);
+		const __m128 r2 = LoadRow(matrix, 2);
+		const __m128 r3 = LoadRow(matrix, 3);
+		const __m128 a = _mm_movelh_ps(r0, r1);
+		const __m128 b = _mm_movehl_ps(r1, r0);
+		const __m128 c = _mm_movelh_ps(r2, r3);
+		const __m128 d = _mm_movehl_ps(r3, r2);
+
+		//各ブロックの行列式 (|A| |B| |C| |D|)
+		const __m128 detSub = _mm_sub_ps(
+			_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+			_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0))));
+		const __m128 detA = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(0, 0, 0, 0));
+		const __m128 detB = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(1, 1, 1, 1));
+		const __m128 detC = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(2, 2, 2, 2));
+		const __m128 detD = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(3, 3, 3, 3));
+
+		const __m128 dc = Mat2AdjMultiply(d, c);
+		const __m128 ab = Mat2AdjMultiply(a, b);
+		__m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), Mat2Multiply(b, dc));
+		__m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), Mat2Multiply(c, ab));
+		__m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), Mat2MultiplyAdj(d, ab));
+		__m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), Mat2MultiplyAdj(a, dc));
+
+		//|M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+		__m128 trace = _mm_mul_ps(ab, _mm_shuffle_ps(dc, dc, _MM_SHUFFLE(3, 1, 2, 0)));
+		trace = _mm_add_ps(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(2, 3, 0, 1)));
+		trace = _mm_add_ps(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(1, 0, 3, 2)));
+		const __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+
+		//除算は1回だけ。余因子の符号もここでまとめて掛ける
+		const __m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+		x = _mm_mul_ps(x, invDet);
+		y = _mm_mul_ps(y, invDet);
+		z = _mm_mul_ps(z, invDet);
+		w = _mm_mul_ps(w, invDet);
+
+		Matrix4x4 result{};
+		StoreRow(result, 0, _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+		StoreRow(result, 1, _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+		StoreRow(result, 2, _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+		StoreRow(result, 3, _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+		return result;
+	}
+#endif
 	Matrix4x4 result{};
 
 	float det
@@ -83,10 +297,78 @@ static Matrix4x4 Inverse(const Matrix4x4& matrix)
 	return result;
 }
 
+//アフィン変換行列の逆行列（4列目が (0,0,0,1) の行列に限る）
+//3x3部分の逆行列と平行移動だけを計算するので、一般の逆行列より安い
+static constexpr Matrix4x4 InverseAffine(const Matrix4x4& m)
+{
+	//3x3部分の余因子
+	float c00 = m.m[1][1] * m.m[2][2] - m.m[1][2] * m.m[2][1];
+	float c01 = m.m[1][2] * m.m[2][0] - m.m[1][0] * m.m[2][2];
+	float c02 = m.m[1][0] * m.m[2][1] - m.m[1][1] * m.m[2][0];
+	float det = m.m[0][0] * c00 + m.m[0][1] * c01 + m.m[0][2] * c02;
+	float invDet = 1.0f / det;
+
+	Matrix4x4 result{};
+	result.m[0][0] = c00 * invDet;
+	result.m[1][0] = c01 * invDet;
+	result.m[2][0] = c02 * invDet;
+	result.m[0][1] = (m.m[0][2] * m.m[2][1] - m.m[0][1] * m.m[2][2]) * invDet;
+	result.m[1][1] = (m.m[0][0] * m.m[2][2] - m.m[0][2] * m.m[2][0]) * invDet;
+	result.m[2][1] = (m.m[0][1] * m.m[2][0] - m.m[0][0] * m.m[2][1]) * invDet;
+	result.m[0][2] = (m.m[0][1] * m.m[1][2] - m.m[0][2] * m.m[1][1]) * invDet;
+	result.m[1][2] = (m.m[0][2] * m.m[1][0] - m.m[0][0] * m.m[1][2]) * invDet;
+	result.m[2][2] = (m.m[0][0] * m.m[1][1] - m.m[0][1] * m.m[1][0]) * invDet;
+
+	//平行移動は -t * A^-1
+	for (int j = 0; j < 3; j++)
+	{
+		result.m[3][j] = -(m.m[3][0] * result.m[0][j] + m.m[3][1] * result.m[1][j] + m.m[3][2] * result.m[2][j]);
+	}
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
+//剛体変換（回転 + 平行移動のみ）の逆行列
+//回転部分は転置するだけで済む。スケールが入っている行列には使えない
+static constexpr Matrix4x4 InverseRigid(const Matrix4x4& m)
+{
+	Matrix4x4 result{};
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			result.m[i][j] = m.m[j][i];
+		}
+	}
+
+	//平行移動は -t * R^T
+	for (int j = 0; j < 3; j++)
+	{
+		result.m[3][j] = -(m.m[3][0] * m.m[j][0] + m.m[3][1] * m.m[j][1] + m.m[3][2] * m.m[j][2]);
+	}
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
 //転置行列
-static Matrix4x4 Transpose(const Matrix4x4& m)
+static constexpr Matrix4x4 Transpose(const Matrix4x4& m)
 {
 	Matrix4x4 result{};
+#if defined(MATRIXMATH_USE_SSE)
+	if (!std::is_constant_evaluated())
+	{
+		__m128 r0 = LoadRow(m, 0);
+		__m128 r1 = LoadRow(m, 1);
+		__m128 r2 = LoadRow(m, 2);
+		__m128 r3 = LoadRow(m, 3);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		StoreRow(result, 0, r0);
+		StoreRow(result, 1, r1);
+		StoreRow(result, 2, r2);
+		StoreRow(result, 3, r3);
+		return result;
+	}
+#endif
 	for (int i = 0; i < 4; i++)
 	{
 		for (int j = 0; j < 4; j++)
@@ -98,7 +380,7 @@ static Matrix4x4 Transpose(const Matrix4x4& m)
 }
 
 //単位行列
-static Matrix4x4 MakeIdentity()
+static constexpr Matrix4x4 MakeIdentity()
 {
 	Matrix4x4 result{};
 	for (int i = 0; i < 4; i++)
@@ -119,7 +401,7 @@ static Matrix4x4 MakeIdentity()
 }
 
 //拡大縮小行列
-static Matrix4x4 MakeScaleMatrix(const Vector3& scale)
+static constexpr Matrix4x4 MakeScaleMatrix(const Vector3& scale)
 {
 	Matrix4x4 result{};
 	result.m[0][0] = scale.x;
@@ -169,7 +451,7 @@ static Matrix4x4 MakeRotateZMatrix(float radian)
 }
 
 //平行移動行列
-static Matrix4x4 MakeTranslateMatrix(const Vector3& translate)
+static constexpr Matrix4x4 MakeTranslateMatrix(const Vector3& translate)
 {
 	Matrix4x4 result{};
 	for (int i = 0; i < 4; i++)
@@ -192,10 +474,76 @@ static Matrix4x4 MakeTranslateMatrix(const Vector3& translate)
 	return result;
 }
 
+//XYZ回転行列（Rx * Ry * Rz を展開したもの）
+//sin/cosは各軸1回ずつしか計算しない
+static Matrix4x4 MakeRotateMatrix(const Vector3& radian)
+{
+	float sx = std::sin(radian.x), cx = std::cos(radian.x);
+	float sy = std::sin(radian.y), cy = std::cos(radian.y);
+	float sz = std::sin(radian.z), cz = std::cos(radian.z);
+
+	Matrix4x4 result{};
+	result.m[0][0] = cy * cz;
+	result.m[0][1] = cy * sz;
+	result.m[0][2] = -sy;
+	result.m[1][0] = sx * sy * cz - cx * sz;
+	result.m[1][1] = sx * sy * sz + cx * cz;
+	result.m[1][2] = sx * cy;
+	result.m[2][0] = cx * sy * cz + sx * sz;
+	result.m[2][1] = cx * sy * sz - sx * cz;
+	result.m[2][2] = cx * cy;
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
 //三次元アフィン変換行列
+//S * Rx * Ry * Rz * T を行列の積を使わずに直接組み立てる
 static Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& radian, const Vector3& translate)
 {
-	return  Multiply(MakeScaleMatrix(scale), Multiply(Multiply(MakeRotateXMatrix(radian.x), Multiply(MakeRotateYMatrix(radian.y), MakeRotateZMatrix(radian.z))), MakeTranslateMatrix(translate)));
+	Matrix4x4 result = MakeRotateMatrix(radian);
+	const float s[3] = { scale.x, scale.y, scale.z };
+	for (int i = 0; i < 3; i++)
+	{
+		result.m[i][0] *= s[i];
+		result.m[i][1] *= s[i];
+		result.m[i][2] *= s[i];
+	}
+	result.m[3][0] = translate.x;
+	result.m[3][1] = translate.y;
+	result.m[3][2] = translate.z;
+	return result;
+}
+
+//三次元アフィン変換行列（まとめて計算する版）
+static void MakeAffineMatrices(std::span<const Transform> transforms, std::span<Matrix4x4> worldMatrices)
+{
+	assert(transforms.size() <= worldMatrices.size());
+	for (size_t i = 0; i < transforms.size(); i++)
+	{
+		worldMatrices[i] = MakeAffineMatrix(transforms[i].scale, transforms[i].rotate, transforms[i].translate);
+	}
+}
+
+//ビュー行列（カメラのTransformから直接作る）
+//Inverse(MakeAffineMatrix(...)) と同じ結果を、回転の転置とスケールの逆数だけで求める
+static Matrix4x4 MakeViewMatrix(const Transform& camera)
+{
+	const Matrix4x4 r = MakeRotateMatrix(camera.rotate);
+	const float invScale[3] = { 1.0f / camera.scale.x, 1.0f / camera.scale.y, 1.0f / camera.scale.z };
+	const Vector3& t = camera.translate;
+
+	//View = T^-1 * R^T * S^-1
+	Matrix4x4 result{};
+	for (int j = 0; j < 3; j++)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			result.m[i][j] = r.m[j][i] * invScale[j];
+		}
+		result.m[3][j] = -(t.x * r.m[j][0] + t.y * r.m[j][1] + t.z * r.m[j][2]) * invScale[j];
+	}
+	result.m[3][3] = 1.0f;
+	return result;
 }
 
 //透視投影行列
@@ -211,7 +559,7 @@ static Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float n
 }
 
 //正射影行列
-static Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip)
+static constexpr Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip)
 {
 	Matrix4x4 result{};
 	result.m[0][0] = 2 / (right - left);
@@ -225,7 +573,7 @@ static Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, floa
 }
 
 //ビューポート変換行列
-static Matrix4x4 MakeViewportMatrix(float left, float top, float width, float height, float minDepth, float maxDepth)
+static constexpr Matrix4x4 MakeViewportMatrix(float left, float top, float width, float height, float minDepth, float maxDepth)
 {
 	Matrix4x4 result{};
 	result.m[0][0] = width / 2.0f;
@@ -237,3 +585,42 @@ static Matrix4x4 MakeViewportMatrix(float left, float top, float width, float he
 	result.m[3][3] = 1.0f;
 	return result;
 }
+
+///==========================================================
+/// 演算子（中身は上の関数と同じ）
+///==========================================================
+static constexpr Matrix4x4 operator+(const Matrix4x4& m1, const Matrix4x4& m2) { return Add(m1, m2); }
+static constexpr Matrix4x4 operator-(const Matrix4x4& m1, const Matrix4x4& m2) { return Subtract(m1, m2); }
+static constexpr Matrix4x4 operator*(const Matrix4x4& m1, const Matrix4x4& m2) { return Multiply(m1, m2); }
+
+static constexpr Matrix4x4& operator+=(Matrix4x4& m1, const Matrix4x4& m2)
+{
+	m1 = Add(m1, m2);
+	return m1;
+}
+
+static constexpr Matrix4x4& operator-=(Matrix4x4& m1, const Matrix4x4& m2)
+{
+	m1 = Subtract(m1, m2);
+	return m1;
+}
+
+static constexpr Matrix4x4& operator*=(Matrix4x4& m1, const Matrix4x4& m2)
+{
+	m1 = Multiply(m1, m2);
+	return m1;
+}
+
+///==========================================================
+/// コンパイル時テスト
+/// 定数式ではSIMDを通らずスカラー実装で評価される
+///==========================================================
+static_assert(MakeIdentity() * MakeIdentity() == MakeIdentity());
+static_assert(Transpose(MakeTranslateMatrix({ 1.0f, 2.0f, 3.0f })).m[0][3] == 1.0f);
+static_assert(MakeScaleMatrix({ 2.0f, 4.0f, 8.0f }) * MakeTranslateMatrix({ 1.0f, 2.0f, 3.0f })
+	== Matrix4x4{ { { 2.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 4.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 8.0f, 0.0f }, { 1.0f, 2.0f, 3.0f, 1.0f } } });
+static_assert(Inverse(MakeScaleMatrix({ 2.0f, 4.0f, 8.0f })) == MakeScaleMatrix({ 0.5f, 0.25f, 0.125f }));
+static_assert(InverseAffine(MakeTranslateMatrix({ 1.0f, 2.0f, 3.0f })) == MakeTranslateMatrix({ -1.0f, -2.0f, -3.0f }));
+static_assert(InverseRigid(MakeTranslateMatrix({ 1.0f, 2.0f, 3.0f })) == MakeTranslateMatrix({ -1.0f, -2.0f, -3.0f }));
+static_assert(MakeIdentity() + MakeIdentity() - MakeIdentity() == MakeIdentity());
+static_assert(MakeOrthographicMatrix(0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 100.0f).m[3][0] == -1.0f);
@@ -0,0 +1,423 @@
+#include "MeshCache.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
+#include "ObjLoader.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+	static constexpr char kMagic[4] = { 'M', 'E', 'S', 'H' };
+	static constexpr uint64_t kAlignment = 16;
+
+	//alignmentの倍数に切り上げる
+	uint64_t AlignUp(uint64_t value)
+	{
+		return (value + kAlignment - 1) & ~(kAlignment - 1);
+	}
+
+	//ファイルの中身のハッシュ値
+	uint64_t HashFile(const std::string& path, uint64_t size)
+	{
+		if (size == 0)
+		{
+			return HashBytes(nullptr, 0);
+		}
+		MappedFile file;
+		if (!file.Open(path))
+		{
+			return 0;
+		}
+		return HashBytes(file.data(), file.size());
+	}
+
+	//更新日時を整数にする
+	bool GetFileStatus(const std::string& path, uint64_t& size, int64_t& writeTime)
+	{
+		std::error_code error;
+		size = std::filesystem::file_size(path, error);
+		if (error)
+		{
+			return false;
+		}
+		writeTime = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+		return !error;
+	}
+
+	//section全体がファイルに収まっているか
+	bool IsInside(const MeshCacheHeader& header, uint64_t offset, uint64_t count, uint64_t stride)
+	{
+		return offset % kAlignment == 0 && offset <= header.fileSize && count * stride <= header.fileSize - offset;
+	}
+}
+
+bool MeshCache::Open(const std::string& path)
+{
+	Close();
+	if (!file_.Open(path) || file_.size() < sizeof(MeshCacheHeader))
+	{
+		Close();
+		return false;
+	}
+	const MeshCacheHeader& header = *reinterpret_cast<const MeshCacheHeader*>(file_.data());
+	const bool valid =
+		std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+		header.version == kMeshCacheVersion &&
+		header.vertexStride == sizeof(VertexData) &&
+		header.indexStride == sizeof(uint32_t) &&
+		header.fileSize == file_.size() &&
+		header.dependencyCount > 0 &&
+		header.lodCount > 0 &&
+		IsInside(header, header.vertexOffset, header.vertexCount, sizeof(VertexData)) &&
+		IsInside(header, header.indexOffset, header.indexCount, sizeof(uint32_t)) &&
+		IsInside(header, header.submeshOffset, header.submeshCount, sizeof(MeshCacheSubmesh)) &&
+		IsInside(header, header.lodOffset, header.lodCount, sizeof(MeshCacheLod)) &&
+		IsInside(header, header.meshletOffset, header.meshletCount, sizeof(MeshletData)) &&
+		IsInside(header, header.materialOffset, header.materialCount, sizeof(MeshCacheMaterial)) &&
+		IsInside(header, header.dependencyOffset, header.dependencyCount, sizeof(MeshCacheDependency)) &&
+		IsInside(header, header.stringOffset, header.stringSize, 1);
+	if (!valid)
+	{
+		Close();
+		return false;
+	}
+	header_ = &header;
+
+	//表の中の番号と文字列の範囲も確かめておく（以降は範囲外を読まない）
+	auto isValidString = [&](const MeshCacheString& string)
+		{
+			return string.offset <= header.stringSize && string.size <= header.stringSize - string.offset;
+		};
+	for (const uint32_t index : indices())
+	{
+		if (index >= header.vertexCount)
+		{
+			Close();
+			return false;
+		}
+	}
+	for (const MeshCacheSubmesh& submesh : submeshes())
+	{
+		if (submesh.indexStart > header.indexCount || submesh.indexCount > header.indexCount - submesh.indexStart ||
+			submesh.materialIndex >= header.materialCount || !isValidString(submesh.name) ||
+			submesh.meshletStart > header.meshletCount || submesh.meshletCount > header.meshletCount - submesh.meshletStart)
+		{
+			Close();
+			return false;
+		}
+	}
+	for (const MeshletData& meshlet : meshlets())
+	{
+		if (meshlet.indexStart > header.indexCount || meshlet.indexCount > header.indexCount - meshlet.indexStart)
+		{
+			Close();
+			return false;
+		}
+	}
+	for (const MeshCacheLod& lod : lods())
+	{
+		if (lod.submeshStart > header.submeshCount || lod.submeshCount > header.submeshCount - lod.submeshStart)
+		{
+			Close();
+			return false;
+		}
+	}
+	for (const MeshCacheMaterial& material : materials())
+	{
+		if (!isValidString(material.name) || !isValidString(material.textureFilePath))
+		{
+			Close();
+			return false;
+		}
+	}
+	for (const MeshCacheDependency& dependency : dependencies())
+	{
+		if (!isValidString(dependency.path))
+		{
+			Close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void MeshCache::Close()
+{
+	file_.Close();
+	header_ = nullptr;
+}
+
+MeshCache::Status MeshCache::Validate(const std::string& sourcePath) const
+{
+	if (!header_ || GetString(dependencies()[0].path) != sourcePath)
+	{
+		return Status::kStale;
+	}
+	Status status = Status::kUpToDate;
+	for (const MeshCacheDependency& dependency : dependencies())
+	{
+		const std::string path(GetString(dependency.path));
+		uint64_t size = 0;
+		int64_t writeTime = 0;
+		if (!GetFileStatus(path, size, writeTime) || size != dependency.size)
+		{
+			return Status::kStale;
+		}
+		//日時が変わっていても、中身が同じならそのまま使える
+		if (writeTime != dependency.writeTime)
+		{
+			if (HashFile(path, size) != dependency.hash)
+			{
+				return Status::kStale;
+			}
+			status = Status::kTouched;
+		}
+	}
+	return status;
+}
+
+std::span<const VertexData> MeshCache::vertices() const
+{
+	return GetSection<VertexData>(header_->vertexOffset, header_->vertexCount);
+}
+
+std::span<const uint32_t> MeshCache::indices() const
+{
+	return GetSection<uint32_t>(header_->indexOffset, header_->indexCount);
+}
+
+std::span<const MeshCacheSubmesh> MeshCache::submeshes() const
+{
+	return GetSection<MeshCacheSubmesh>(header_->submeshOffset, header_->submeshCount);
+}
+
+std::span<const MeshCacheLod> MeshCache::lods() const
+{
+	return GetSection<MeshCacheLod>(header_->lodOffset, header_->lodCount);
+}
+
+std::span<const MeshletData> MeshCache::meshlets() const
+{
+	return GetSection<MeshletData>(header_->meshletOffset, header_->meshletCount);
+}
+
+std::span<const MeshCacheMaterial> MeshCache::materials() const
+{
+	return GetSection<MeshCacheMaterial>(header_->materialOffset, header_->materialCount);
+}
+
+std::span<const MeshCacheDependency> MeshCache::dependencies() const
+{
+	return GetSection<MeshCacheDependency>(header_->dependencyOffset, header_->dependencyCount);
+}
+
+std::string_view MeshCache::GetString(const MeshCacheString& string) const
+{
+	return std::string_view(reinterpret_cast<const char*>(file_.data() + header_->stringOffset) + string.offset, string.size);
+}
+
+const MeshOptimizationReport& MeshCache::optimization() const
+{
+	return header_->optimization;
+}
+
+ModelData MeshCache::ToModelData() const
+{
+	ModelData modelData;
+	modelData.vertices.assign(vertices().begin(), vertices().end());
+	modelData.indices.assign(indices().begin(), indices().end());
+	modelData.meshlets.assign(meshlets().begin(), meshlets().end());
+	//LOD表の1つ目が元のメッシュ、2つ目からがModelData::lods
+	for (size_t i = 0; i < lods().size(); i++)
+	{
+		const MeshCacheLod& lod = lods()[i];
+		std::vector<SubmeshData>& submeshData = i == 0 ? modelData.submeshes : modelData.lods.emplace_back(LodData{ {}, lod.error }).submeshes;
+		for (const MeshCacheSubmesh& submesh : submeshes().subspan(lod.submeshStart, lod.submeshCount))
+		{
+			submeshData.push_back({ std::string(GetString(submesh.name)), submesh.indexStart, submesh.indexCount, submesh.materialIndex, submesh.meshletStart, submesh.meshletCount });
+		}
+	}
+	for (const MeshCacheMaterial& material : materials())
+	{
+		MaterialData& materialData = modelData.materials.emplace_back();
+		materialData.name = GetString(material.name);
+		materialData.diffuseColor = material.diffuseColor;
+		materialData.specularColor = material.specularColor;
+		materialData.shininess = material.shininess;
+		materialData.alpha = material.alpha;
+		materialData.textureFilePath = GetString(material.textureFilePath);
+	}
+	return modelData;
+}
+
+bool MeshCache::Write(const std::string& path, const ModelData& modelData, const std::vector<std::string>& dependencies, const MeshOptimizationReport& optimization)
+{
+	//文字列はまとめて1つの領域に入れる
+	std::string strings;
+	auto addString = [&](const std::string& string)
+		{
+			MeshCacheString result{ uint32_t(strings.size()), uint32_t(string.size()) };
+			strings += string;
+			return result;
+		};
+
+	std::vector<MeshCacheSubmesh> submeshTable;
+	std::vector<MeshCacheLod> lodTable;
+	auto addLod = [&](const std::vector<SubmeshData>& submeshes, float error)
+		{
+			lodTable.push_back({ uint32_t(submeshTable.size()), uint32_t(submeshes.size()), error, 0 });
+			for (const SubmeshData& submesh : submeshes)
+			{
+				submeshTable.push_back({ addString(submesh.name), submesh.indexStart, submesh.indexCount, submesh.materialIndex, submesh.meshletStart, submesh.meshletCount });
+			}
+		};
+	addLod(modelData.submeshes, 0.0f);
+	for (const LodData& lod : modelData.lods)
+	{
+		addLod(lod.submeshes, lod.error);
+	}
+	std::vector<MeshCacheMaterial> materialTable;
+	for (const MaterialData& material : modelData.materials)
+	{
+		materialTable.push_back({ addString(material.name), material.diffuseColor, material.specularColor, material.shininess, material.alpha, addString(material.textureFilePath) });
+	}
+	std::vector<MeshCacheDependency> dependencyTable;
+	for (const std::string& dependency : dependencies)
+	{
+		MeshCacheDependency entry{};
+		entry.path = addString(dependency);
+		if (!GetFileStatus(dependency, entry.size, entry.writeTime))
+		{
+			return false;
+		}
+		entry.hash = HashFile(dependency, entry.size);
+		dependencyTable.push_back(entry);
+	}
+
+	//各領域の位置を決める
+	MeshCacheHeader header{};
+	std::memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kMeshCacheVersion;
+	header.vertexStride = sizeof(VertexData);
+	header.indexStride = sizeof(uint32_t);
+	header.vertexCount = uint32_t(modelData.vertices.size());
+	header.indexCount = uint32_t(modelData.indices.size());
+	header.submeshCount = uint32_t(submeshTable.size());
+	header.lodCount = uint32_t(lodTable.size());
+	header.materialCount = uint32_t(materialTable.size());
+	header.dependencyCount = uint32_t(dependencyTable.size());
+	header.stringSize = uint32_t(strings.size());
+	header.meshletCount = uint32_t(modelData.meshlets.size());
+	header.vertexOffset = AlignUp(sizeof(MeshCacheHeader));
+	header.indexOffset = AlignUp(header.vertexOffset + uint64_t(header.vertexCount) * sizeof(VertexData));
+	header.submeshOffset = AlignUp(header.indexOffset + uint64_t(header.indexCount) * sizeof(uint32_t));
+	header.lodOffset = AlignUp(header.submeshOffset + submeshTable.size() * sizeof(MeshCacheSubmesh));
+	header.meshletOffset = AlignUp(header.lodOffset + lodTable.size() * sizeof(MeshCacheLod));
+	header.materialOffset = AlignUp(header.meshletOffset + modelData.meshlets.size() * sizeof(MeshletData));
+	header.dependencyOffset = AlignUp(header.materialOffset + materialTable.size() * sizeof(MeshCacheMaterial));
+	header.stringOffset = AlignUp(header.dependencyOffset + dependencyTable.size() * sizeof(MeshCacheDependency));
+	header.fileSize = header.stringOffset + strings.size();
+	header.optimization = optimization;
+
+	//一時ファイルに書いてから置き換える
+	const std::string temporaryPath = path + ".tmp";
+	std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	uint64_t position = 0;
+	auto writeAt = [&](uint64_t offset, const void* data, size_t size)
+		{
+			static constexpr uint8_t kPadding[kAlignment] = {};
+			bool result = std::fwrite(kPadding, 1, size_t(offset - position), file) == offset - position;
+			result = result && std::fwrite(data, 1, size, file) == size;
+			position = offset + size;
+			return result;
+		};
+	bool written =
+		writeAt(0, &header, sizeof(header)) &&
+		writeAt(header.vertexOffset, modelData.vertices.data(), modelData.vertices.size() * sizeof(VertexData)) &&
+		writeAt(header.indexOffset, modelData.indices.data(), modelData.indices.size() * sizeof(uint32_t)) &&
+		writeAt(header.submeshOffset, submeshTable.data(), submeshTable.size() * sizeof(MeshCacheSubmesh)) &&
+		writeAt(header.lodOffset, lodTable.data(), lodTable.size() * sizeof(MeshCacheLod)) &&
+		writeAt(header.meshletOffset, modelData.meshlets.data(), modelData.meshlets.size() * sizeof(MeshletData)) &&
+		writeAt(header.materialOffset, materialTable.data(), materialTable.size() * sizeof(MeshCacheMaterial)) &&
+		writeAt(header.dependencyOffset, dependencyTable.data(), dependencyTable.size() * sizeof(MeshCacheDependency)) &&
+		writeAt(header.stringOffset, strings.data(), strings.size());
+	written = std::fclose(file) == 0 && written;
+
+	std::error_code error;
+	if (written)
+	{
+		std::filesystem::rename(temporaryPath, path, error);
+	}
+	if (!written || error)
+	{
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+	return true;
+}
+
+MeshOptimizationReport CookMesh(ModelData& modelData)
+{
+	//LODのインデックスも並べ替えるので、LODを先に作る。メッシュレットは並べ替えた後の順番で作る
+	GenerateLodChain(modelData);
+	MeshOptimizationReport report = OptimizeMesh(modelData);
+	BuildMeshlets(modelData);
+	report.after = AnalyzeVertexCache(std::span<const uint32_t>(modelData.indices.data(), BaseIndexCount(modelData)), modelData.vertices.size());
+	return report;
+}
+
+ModelData LoadCachedObjFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount, MeshOptimizationReport* optimization)
+{
+	const std::string sourcePath = directoryPath + "/" + filename;
+	const std::string cachePath = sourcePath + ".mesh";
+
+	//1. キャッシュが元ファイルと合っていればそれを使う
+	MeshCache cache;
+	if (cache.Open(cachePath))
+	{
+		const MeshCache::Status status = cache.Validate(sourcePath);
+		if (status != MeshCache::Status::kStale)
+		{
+			ModelData modelData = cache.ToModelData();
+			const MeshOptimizationReport report = cache.optimization();
+			if (optimization)
+			{
+				*optimization = report;
+			}
+			if (status == MeshCache::Status::kTouched)
+			{
+				//日時だけ変わっていたので、次からハッシュ値を計算しなくて済むよう書き直す
+				std::vector<std::string> dependencies;
+				for (const MeshCacheDependency& dependency : cache.dependencies())
+				{
+					dependencies.emplace_back(cache.GetString(dependency.path));
+				}
+				cache.Close();
+				MeshCache::Write(cachePath, modelData, dependencies, report);
+			}
+			return modelData;
+		}
+		cache.Close();
+	}
+
+	//2. 無いか古ければ解析して CookMesh し、キャッシュを書き出す（書けなくても読み込みは続ける）
+	std::vector<std::string> materialFilenames;
+	ModelData modelData = LoadObjFile(directoryPath, filename, threadCount, &materialFilenames);
+	const MeshOptimizationReport report = CookMesh(modelData);
+	if (optimization)
+	{
+		*optimization = report;
+	}
+	std::vector<std::string> dependencies{ sourcePath };
+	for (const std::string& materialFilename : materialFilenames)
+	{
+		dependencies.push_back(directoryPath + "/" + materialFilename);
+	}
+	MeshCache::Write(cachePath, modelData, dependencies, report);
+	return modelData;
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "ModelData.h"
+
+///==========================================================
+/// 変換済みメッシュのキャッシュファイル（.mesh）
+/// ヘッダー、頂点、インデックス、サブメッシュ表、LOD表、メッシュレット、マテリアル表、依存ファイル表、文字列を
+/// この順に16バイト境界で並べる。読み込みはファイルをマップして直接参照する
+/// 頂点とインデックスは OptimizeMesh で並べ替えた後のもの
+/// 接線（ModelData::tangents）は描画で使うようになるまで入れない。必要なら読み込んだ後で GenerateTangents で作る
+///==========================================================
+
+//形式を変えたら上げる（古いキャッシュは作り直される）
+static constexpr uint32_t kMeshCacheVersion = 8;
+
+///==========================================================
+/// 文字列領域の中の位置
+///==========================================================
+struct MeshCacheString
+{
+	uint32_t offset;
+	uint32_t size;
+};
+
+///==========================================================
+/// ファイルの先頭
+///==========================================================
+struct MeshCacheHeader
+{
+	char magic[4];				// "MESH"
+	uint32_t version;			// kMeshCacheVersion
+	uint32_t vertexStride;		// sizeof(VertexData)
+	uint32_t indexStride;		// sizeof(uint32_t)
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t submeshCount;		// 全てのLODの分
+	uint32_t lodCount;			// 元のメッシュを含む
+	uint32_t materialCount;
+	uint32_t dependencyCount;
+	uint32_t stringSize;
+	uint32_t meshletCount;		// 全てのサブメッシュの分
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint64_t submeshOffset;
+	uint64_t lodOffset;
+	uint64_t meshletOffset;
+	uint64_t materialOffset;
+	uint64_t dependencyOffset;
+	uint64_t stringOffset;
+	uint64_t fileSize;
+	MeshOptimizationReport optimization;	// 書き出したときの OptimizeMesh の結果
+};
+
+///==========================================================
+/// 同じマテリアルで描画するインデックスの範囲
+///==========================================================
+struct MeshCacheSubmesh
+{
+	MeshCacheString name;
+	uint32_t indexStart;
+	uint32_t indexCount;
+	uint32_t materialIndex;
+	uint32_t meshletStart;
+	uint32_t meshletCount;
+};
+
+///==========================================================
+/// LOD1段分のサブメッシュ表の範囲。1つ目は元のメッシュ
+///==========================================================
+struct MeshCacheLod
+{
+	uint32_t submeshStart;
+	uint32_t submeshCount;
+	float error;
+	uint32_t padding;
+};
+
+///==========================================================
+/// マテリアル
+///==========================================================
+struct MeshCacheMaterial
+{
+	MeshCacheString name;
+	Vector3 diffuseColor;
+	Vector3 specularColor;
+	float shininess;
+	float alpha;
+	MeshCacheString textureFilePath;
+};
+
+///==========================================================
+/// 元になったファイル（obj / mtl）
+/// 更新日時とサイズが同じならそのまま使い、日時だけ違うときは中身のハッシュ値で確かめる
+///==========================================================
+struct MeshCacheDependency
+{
+	MeshCacheString path;
+	uint64_t size;
+	int64_t writeTime;
+	uint64_t hash;
+};
+
+///==========================================================
+/// キャッシュファイルを読み込み専用でマップしたもの
+/// vertices() / indices() はマップした領域を直接指すので、アップロード用のバッファにそのままコピーできる
+///==========================================================
+class MeshCache
+{
+public:
+	//キャッシュの状態
+	enum class Status
+	{
+		kUpToDate,		// そのまま使える
+		kTouched,		// 使えるが、元ファイルの更新日時だけが変わっている（書き直すと次から速い）
+		kStale,			// 使えない
+	};
+
+	//ファイルを開いて、ヘッダーと各領域の範囲を確かめる。壊れていたり形式が古ければfalse
+	bool Open(const std::string& path);
+	void Close();
+
+	//元ファイルと比べる。sourcePathは1つ目の依存ファイル（obj）と一致しなければならない
+	Status Validate(const std::string& sourcePath) const;
+
+	std::span<const VertexData> vertices() const;
+	std::span<const uint32_t> indices() const;
+	std::span<const MeshCacheSubmesh> submeshes() const;
+	std::span<const MeshCacheLod> lods() const;
+	std::span<const MeshletData> meshlets() const;
+	std::span<const MeshCacheMaterial> materials() const;
+	std::span<const MeshCacheDependency> dependencies() const;
+	std::string_view GetString(const MeshCacheString& string) const;
+	const MeshOptimizationReport& optimization() const;
+
+	//ModelDataにコピーする
+	ModelData ToModelData() const;
+
+	//ModelDataからキャッシュファイルを書く。dependenciesの1つ目は元のobjファイル、optimizationはヘッダーに残す
+	//一時ファイルに書いてから置き換えるので、途中で止まっても壊れたキャッシュは残らない
+	static bool Write(const std::string& path, const ModelData& modelData, const std::vector<std::string>& dependencies, const MeshOptimizationReport& optimization);
+
+private:
+	template <typename T>
+	std::span<const T> GetSection(uint64_t offset, uint32_t count) const
+	{
+		return { reinterpret_cast<const T*>(file_.data() + offset), count };
+	}
+
+	MappedFile file_;
+	const MeshCacheHeader* header_ = nullptr;
+};
+
+//キャッシュに書き出す前の処理をまとめて行う。解析したばかりの（LODもメッシュレットも無い）ModelDataに使う
+//GenerateLodChain でLODを作り、OptimizeMesh で描画順を並べ替え、BuildMeshlets でメッシュレットを作る
+//戻り値は描画順を並べ替える前と、メッシュレットに分けた後の頂点キャッシュの効率（元のメッシュの三角形だけで求める）
+MeshOptimizationReport CookMesh(ModelData& modelData);
+
+//キャッシュを使ってobjファイルを読み込む
+//objと同じ場所の "<filename>.mesh" が元ファイル（obj / mtl）と合っていればそれを読み、無いか古ければ LoadObjFile で解析し、CookMesh してから書き出す
+//CookMesh の時間は初回だけかかる
+//optimization: nullptrでなければ、CookMesh の戻り値を受け取る（キャッシュから読んだときも同じ値）
+ModelData LoadCachedObjFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount = 0, MeshOptimizationReport* optimization = nullptr);
@@ -0,0 +1,463 @@
+#include "MeshOptimizer.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+	//Forsythの方法で想定する頂点キャッシュの大きさ（LRU）と点数の係数
+	static constexpr uint32_t kOptimizeCacheSize = 32;
+	static constexpr float kCacheDecayPower = 1.5f;
+	static constexpr float kLastTriangleScore = 0.75f;
+	static constexpr float kValenceBoostScale = 2.0f;
+	static constexpr float kValenceBoostPower = 0.5f;
+	static constexpr uint32_t kValenceTableSize = 64;
+
+	static constexpr uint32_t kInvalidIndex = ~0u;
+
+	///==========================================================
+	/// 頂点の点数の表（キャッシュの位置と、残りの三角形の数で決まる）
+	///==========================================================
+	struct VertexScoreTable
+	{
+		float cache[kOptimizeCacheSize];
+		float valence[kValenceTableSize];
+
+		VertexScoreTable()
+		{
+			for (uint32_t i = 0; i < kOptimizeCacheSize; i++)
+			{
+				//直前の三角形の頂点は、次の三角形で使いすぎないよう少し下げる
+				cache[i] = i < 3 ? kLastTriangleScore : std::pow(1.0f - float(i - 3) / float(kOptimizeCacheSize - 3), kCacheDecayPower);
+			}
+			valence[0] = 0.0f;
+			for (uint32_t i = 1; i < kValenceTableSize; i++)
+			{
+				//残りが少ない頂点を先に片付けて、取り残される三角形を減らす
+				valence[i] = kValenceBoostScale * std::pow(float(i), -kValenceBoostPower);
+			}
+		}
+
+		float Get(int32_t cachePosition, uint32_t remaining) const
+		{
+			if (remaining == 0)
+			{
+				return -1.0f;
+			}
+			const float cacheScore = cachePosition < 0 ? 0.0f : cache[cachePosition];
+			return cacheScore + valence[std::min(remaining, kValenceTableSize - 1)];
+		}
+	};
+
+	//FIFOの頂点キャッシュを1三角形分進めて、キャッシュに無かった頂点の数を返す
+	//timestampsは頂点ごとの入った時刻。時刻はキャッシュに入るたびに進むので、cacheSizeより古ければ追い出されている
+	uint32_t UpdateFifoCache(const uint32_t* triangle, uint32_t cacheSize, std::vector<uint32_t>& timestamps, uint32_t& time)
+	{
+		uint32_t misses = 0;
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			const uint32_t vertex = triangle[corner];
+			if (time - timestamps[vertex] > cacheSize)
+			{
+				timestamps[vertex] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+	//三角形の面積の2倍の長さを持つ法線（向きは描画の表）
+	Vector3 TriangleNormal(std::span<const Vector3> positions, const uint32_t* triangle)
+	{
+		const Vector3& a = positions[triangle[0]];
+		return Cross(Subtract(positions[triangle[1]], a), Subtract(positions[triangle[2]], a));
+	}
+}
+
+VertexCacheStatistics AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStatistics statistics{};
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	for (size_t i = 0; i + 3 <= indices.size(); i += 3)
+	{
+		statistics.transformCount += UpdateFifoCache(&indices[i], cacheSize, timestamps, time);
+	}
+
+	//使われている頂点だけを数える
+	size_t usedVertexCount = 0;
+	for (const uint32_t timestamp : timestamps)
+	{
+		usedVertexCount += timestamp != 0;
+	}
+	const size_t triangleCount = indices.size() / 3;
+	statistics.acmr = triangleCount == 0 ? 0.0f : float(statistics.transformCount) / float(triangleCount);
+	statistics.atvr = usedVertexCount == 0 ? 0.0f : float(statistics.transformCount) / float(usedVertexCount);
+	return statistics;
+}
+
+void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount)
+{
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2)
+	{
+		return;
+	}
+	static const VertexScoreTable scoreTable;
+
+	//1. 頂点ごとに、それを使う三角形の一覧を作る
+	//   adjacency[adjacencyOffsets[v], +remaining[v]) が頂点vを使う未出力の三角形
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		remaining[indices[i]]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount, 0);
+	std::exclusive_scan(remaining.begin(), remaining.end(), adjacencyOffsets.begin(), 0u);
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	{
+		std::vector<uint32_t> fill = adjacencyOffsets;
+		for (size_t i = 0; i < triangleCount * 3; i++)
+		{
+			adjacency[fill[indices[i]]++] = uint32_t(i / 3);
+		}
+	}
+
+	//2. 頂点と三角形の点数の初期値
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = scoreTable.Get(-1, remaining[v]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	uint32_t best = 0;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		const uint32_t* triangle = &indices[t * 3];
+		triangleScores[t] = vertexScores[triangle[0]] + vertexScores[triangle[1]] + vertexScores[triangle[2]];
+		if (triangleScores[t] > triangleScores[best])
+		{
+			best = uint32_t(t);
+		}
+	}
+
+	//キャッシュから続く三角形が無くなったときに始め直す三角形の候補（点数の高い順に取り出す。点数が同じなら番号の小さい順）
+	//三角形の点数はキャッシュの頂点を使うときだけ変わるので、最後のキャッシュの頂点が追い出されたときに今の点数で入れ直す
+	//取り出したときに出力済みか点数が変わっていれば古い候補なので捨てる
+	struct RestartCandidate
+	{
+		float score;
+		uint32_t triangle;
+	};
+	auto isLowerPriority = [](const RestartCandidate& a, const RestartCandidate& b)
+		{
+			return a.score < b.score || (a.score == b.score && a.triangle > b.triangle);
+		};
+	std::vector<RestartCandidate> restartHeap(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		restartHeap[t] = { triangleScores[t], uint32_t(t) };
+	}
+	std::make_heap(restartHeap.begin(), restartHeap.end(), isLowerPriority);
+
+	//3. 点数の最も高い三角形を1つずつ出力して、キャッシュと周りの点数を更新する
+	std::vector<uint32_t> result(triangleCount * 3);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	uint32_t cache[kOptimizeCacheSize + 3];
+	uint32_t cacheCount = 0;
+	for (size_t output = 0; output < triangleCount; output++)
+	{
+		const uint32_t triangle[3] = { indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2] };
+		std::copy(triangle, triangle + 3, &result[output * 3]);
+		emitted[best] = 1;
+
+		//出力した三角形を各頂点の一覧から外す
+		for (const uint32_t vertex : triangle)
+		{
+			uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+			const uint32_t count = remaining[vertex];
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (list[i] == best)
+				{
+					std::swap(list[i], list[count - 1]);
+					remaining[vertex]--;
+					break;
+				}
+			}
+		}
+
+		//出力した三角形の頂点をキャッシュの先頭に入れる（LRU）
+		uint32_t newCache[kOptimizeCacheSize + 3];
+		uint32_t newCacheCount = 0;
+		for (const uint32_t vertex : triangle)
+		{
+			if (std::find(newCache, newCache + newCacheCount, vertex) == newCache + newCacheCount)
+			{
+				newCache[newCacheCount++] = vertex;
+			}
+		}
+		const uint32_t triangleVertexCount = newCacheCount;
+		for (uint32_t i = 0; i < cacheCount; i++)
+		{
+			if (std::find(newCache, newCache + triangleVertexCount, cache[i]) == newCache + triangleVertexCount)
+			{
+				newCache[newCacheCount++] = cache[i];
+			}
+		}
+
+		//キャッシュに関わる頂点の点数を更新し、その差を三角形の点数に足す
+		for (uint32_t i = 0; i < newCacheCount; i++)
+		{
+			const uint32_t vertex = newCache[i];
+			cachePositions[vertex] = i < kOptimizeCacheSize ? int32_t(i) : -1;
+			const float score = scoreTable.Get(cachePositions[vertex], remaining[vertex]);
+			const float delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+			const uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+			for (uint32_t j = 0; j < remaining[vertex]; j++)
+			{
+				triangleScores[list[j]] += delta;
+			}
+		}
+		cacheCount = std::min(newCacheCount, kOptimizeCacheSize);
+		std::copy(newCache, newCache + cacheCount, cache);
+
+		//キャッシュから追い出された頂点の三角形のうち、もうキャッシュの頂点を使わないものを更新した後の点数で候補に入れる
+		for (uint32_t i = cacheCount; i < newCacheCount; i++)
+		{
+			const uint32_t vertex = newCache[i];
+			const uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+			for (uint32_t j = 0; j < remaining[vertex]; j++)
+			{
+				const uint32_t* corners = &indices[size_t(list[j]) * 3];
+				if (cachePositions[corners[0]] < 0 && cachePositions[corners[1]] < 0 && cachePositions[corners[2]] < 0)
+				{
+					restartHeap.push_back({ triangleScores[list[j]], list[j] });
+					std::push_heap(restartHeap.begin(), restartHeap.end(), isLowerPriority);
+				}
+			}
+		}
+
+		//次の三角形はキャッシュの頂点を使うものから選ぶ
+		best = kInvalidIndex;
+		float bestScore = -1.0f;
+		for (uint32_t i = 0; i < cacheCount; i++)
+		{
+			const uint32_t vertex = cache[i];
+			const uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+			for (uint32_t j = 0; j < remaining[vertex]; j++)
+			{
+				if (triangleScores[list[j]] > bestScore)
+				{
+					bestScore = triangleScores[list[j]];
+					best = list[j];
+				}
+			}
+		}
+		//キャッシュから続く三角形が無ければ、まだ出力していない三角形のうち点数の最も高いものから始め直す
+		//（このとき残りの三角形はどれもキャッシュの頂点を使わないので、候補の点数が最新かどうかだけ確かめればよい）
+		while (best == kInvalidIndex && !restartHeap.empty())
+		{
+			std::pop_heap(restartHeap.begin(), restartHeap.end(), isLowerPriority);
+			const RestartCandidate candidate = restartHeap.back();
+			restartHeap.pop_back();
+			if (!emitted[candidate.triangle] && candidate.score == triangleScores[candidate.triangle])
+			{
+				best = candidate.triangle;
+			}
+		}
+		assert(best != kInvalidIndex || output + 1 == triangleCount);
+	}
+	std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const Vector3> positions, float threshold)
+{
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2)
+	{
+		return;
+	}
+	static constexpr uint32_t kCacheSize = kVertexCacheAnalyzeSize;
+	std::vector<uint32_t> timestamps(positions.size(), 0);
+	uint32_t time = kCacheSize + 1;
+
+	//1. 3頂点ともキャッシュに無い三角形で区切る（そこで別の部分に移ったとみなす）
+	std::vector<uint32_t> hardBoundaries;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		if (UpdateFifoCache(&indices[t * 3], kCacheSize, timestamps, time) == 3 || t == 0)
+		{
+			hardBoundaries.push_back(uint32_t(t));
+		}
+	}
+	hardBoundaries.push_back(uint32_t(triangleCount));
+
+	//2. その中を、区切ってもキャッシュの効率がthreshold倍以内に収まるところでさらに区切る
+	std::vector<uint32_t> clusters;
+	for (size_t h = 0; h + 1 < hardBoundaries.size(); h++)
+	{
+		const uint32_t start = hardBoundaries[h];
+		const uint32_t end = hardBoundaries[h + 1];
+		time += kCacheSize + 1;
+		uint32_t clusterMisses = 0;
+		for (uint32_t t = start; t < end; t++)
+		{
+			clusterMisses += UpdateFifoCache(&indices[t * 3], kCacheSize, timestamps, time);
+		}
+		const float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+
+		uint32_t clusterStart = start;
+		uint32_t runningMisses = 0;
+		time += kCacheSize + 1;
+		for (uint32_t t = start; t < end; t++)
+		{
+			runningMisses += UpdateFifoCache(&indices[t * 3], kCacheSize, timestamps, time);
+			if (float(runningMisses) <= clusterThreshold * float(t + 1 - clusterStart))
+			{
+				clusters.push_back(clusterStart);
+				clusterStart = t + 1;
+				runningMisses = 0;
+				time += kCacheSize + 1;
+			}
+		}
+		//残りは直前の塊につなげる（新しく始めると効率が落ちる）
+		if (clusterStart == start)
+		{
+			clusters.push_back(start);
+		}
+	}
+	const size_t clusterCount = clusters.size();
+	clusters.push_back(uint32_t(triangleCount));
+
+	//3. 塊ごとに、メッシュの中心から見てどれだけ外を向いているかを求める
+	Vector3 meshCenter{};
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		meshCenter = Add(meshCenter, positions[indices[i]]);
+	}
+	meshCenter = Multiply(1.0f / float(triangleCount * 3), meshCenter);
+
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		Vector3 center{};
+		Vector3 normal{};
+		float area = 0.0f;
+		for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			const uint32_t* triangle = &indices[t * 3];
+			const Vector3 triangleNormal = TriangleNormal(positions, triangle);
+			const float triangleArea = Length(triangleNormal);
+			const Vector3 triangleCenter = Add(Add(positions[triangle[0]], positions[triangle[1]]), positions[triangle[2]]);
+			center = Add(center, Multiply(triangleArea / 3.0f, triangleCenter));
+			normal = Add(normal, triangleNormal);
+			area += triangleArea;
+		}
+		const float normalLength = Length(normal);
+		if (area <= 0.0f || normalLength <= 0.0f)
+		{
+			sortKeys[c] = 0.0f;
+			continue;
+		}
+		center = Multiply(1.0f / area, center);
+		sortKeys[c] = Dot(Subtract(center, meshCenter), Multiply(1.0f / normalLength, normal));
+	}
+
+	//4. 外を向いた塊から描く（手前の面が先に深度を書くので、奥の面のピクセルシェーダーが減る）
+	std::vector<uint32_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0u);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(triangleCount * 3);
+	for (const uint32_t c : order)
+	{
+		result.insert(result.end(), indices.begin() + size_t(clusters[c]) * 3, indices.begin() + size_t(clusters[c + 1]) * 3);
+	}
+	std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void OptimizeVertexFetch(std::vector<VertexData>& vertices, std::span<uint32_t> indices)
+{
+	std::vector<uint32_t> remap(vertices.size(), kInvalidIndex);
+	std::vector<VertexData> result;
+	result.reserve(vertices.size());
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == kInvalidIndex)
+		{
+			remap[index] = uint32_t(result.size());
+			result.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices.swap(result);
+}
+
+MeshOptimizationReport OptimizeMesh(ModelData& modelData)
+{
+	//頂点を並べ替えると接線と順番が合わなくなる
+	assert(modelData.tangents.empty());
+	//効率は元のメッシュの三角形だけで求める（LODの三角形は元のメッシュと同時には描かない）
+	MeshOptimizationReport report{};
+	const size_t baseIndexCount = BaseIndexCount(modelData);
+	report.before = AnalyzeVertexCache(std::span<const uint32_t>(modelData.indices.data(), baseIndexCount), modelData.vertices.size());
+
+	//三角形はサブメッシュ（LODのサブメッシュも含む）の中でだけ並べ替える。サブメッシュで使う頂点に詰めた番号を振ってから処理する
+	std::vector<const SubmeshData*> submeshes;
+	for (const SubmeshData& submesh : modelData.submeshes)
+	{
+		submeshes.push_back(&submesh);
+	}
+	for (const LodData& lod : modelData.lods)
+	{
+		for (const SubmeshData& submesh : lod.submeshes)
+		{
+			submeshes.push_back(&submesh);
+		}
+	}
+	std::vector<uint32_t> localIndices(modelData.vertices.size(), kInvalidIndex);
+	std::vector<uint32_t> globalIndices;
+	std::vector<Vector3> positions;
+	std::vector<uint32_t> submeshIndices;
+	for (const SubmeshData* submesh : submeshes)
+	{
+		std::span<uint32_t> range(modelData.indices.data() + submesh->indexStart, submesh->indexCount);
+		globalIndices.clear();
+		positions.clear();
+		submeshIndices.resize(range.size());
+		for (size_t i = 0; i < range.size(); i++)
+		{
+			const uint32_t vertex = range[i];
+			if (localIndices[vertex] == kInvalidIndex)
+			{
+				localIndices[vertex] = uint32_t(globalIndices.size());
+				globalIndices.push_back(vertex);
+				const Vector4& position = modelData.vertices[vertex].position;
+				positions.push_back({ position.x, position.y, position.z });
+			}
+			submeshIndices[i] = localIndices[vertex];
+		}
+
+		OptimizeVertexCache(submeshIndices, globalIndices.size());
+		OptimizeOverdraw(submeshIndices, positions);
+
+		for (size_t i = 0; i < range.size(); i++)
+		{
+			range[i] = globalIndices[submeshIndices[i]];
+		}
+		for (const uint32_t vertex : globalIndices)
+		{
+			localIndices[vertex] = kInvalidIndex;
+		}
+	}
+
+	OptimizeVertexFetch(modelData.vertices, modelData.indices);
+	report.after = AnalyzeVertexCache(std::span<const uint32_t>(modelData.indices.data(), baseIndexCount), modelData.vertices.size());
+	return report;
+}
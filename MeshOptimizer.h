@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "ModelData.h"
+
+///==========================================================
+/// 描画順の最適化
+/// 頂点キャッシュ（変換済み頂点の再利用）→ オーバードロー → 頂点フェッチの順に並べ替える
+/// 時間がかかるので、読み込みのたびではなくキャッシュ（.mesh）を書き出すときに1回だけ行う
+///==========================================================
+
+//ACMR / ATVRを求めるときに想定する頂点キャッシュの大きさ（FIFO）
+static constexpr uint32_t kVertexCacheAnalyzeSize = 16;
+
+///==========================================================
+/// 頂点キャッシュの効率
+///==========================================================
+struct VertexCacheStatistics
+{
+	uint32_t transformCount;	// キャッシュに無く頂点シェーダーを実行した回数
+	float acmr;					// 三角形あたりの実行回数（0.5～3、小さいほど良い）
+	float atvr;					// 使われる頂点あたりの実行回数（1が最良）
+};
+
+///==========================================================
+/// OptimizeMeshの前後の効率
+///==========================================================
+struct MeshOptimizationReport
+{
+	VertexCacheStatistics before;
+	VertexCacheStatistics after;
+};
+
+//インデックス列を頂点キャッシュで再現して効率を求める
+VertexCacheStatistics AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = kVertexCacheAnalyzeSize);
+
+//三角形の順番を頂点キャッシュに合わせて並べ替える（Forsythの方法）。indicesの番号はvertexCount未満
+void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount);
+
+//頂点キャッシュの効率をthreshold倍までしか落とさない範囲で、外側を向いた三角形の塊から先に描くよう並べ替える
+//OptimizeVertexCacheの後に呼ぶ。indicesの番号はpositionsの要素数未満
+void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const Vector3> positions, float threshold = 1.05f);
+
+//頂点をインデックスで最初に使われる順に並べ替えて、インデックスを付け替える（使われない頂点は消える）
+void OptimizeVertexFetch(std::vector<VertexData>& vertices, std::span<uint32_t> indices);
+
+//サブメッシュ（LODのサブメッシュも含む）ごとに三角形を並べ替えてから頂点を並べ替える。サブメッシュの範囲とマテリアルは変わらない
+//戻り値の効率は元のメッシュ（ModelData::submeshes）の範囲のインデックスだけで求める
+//頂点は元のメッシュで最初に使われる順になる。三角形の順番が変わるので、メッシュレットはこの後で作る（BuildMeshlets）
+//頂点の順番も変わるので、接線（ModelData::tangents）もこの後で作る（GenerateTangents）
+MeshOptimizationReport OptimizeMesh(ModelData& modelData);
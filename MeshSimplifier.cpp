@@ -0,0 +1,409 @@
+#include "MeshSimplifier.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+	static constexpr uint32_t kInvalidIndex = ~0u;
+
+	///==========================================================
+	/// 二次誤差。平面までの距離の2乗の和 x^T A x + 2 b・x + c を、対称行列Aの上半分で持つ
+	/// weightは足した平面の面積の和（誤差を面積あたりにするのに使う）
+	///==========================================================
+	struct Quadric
+	{
+		float a00, a01, a02, a11, a12, a22;
+		float b0, b1, b2;
+		float c;
+		float weight;
+	};
+
+	//平面 normal・x + d = 0 の二次誤差（normalは単位ベクトル）
+	Quadric MakePlaneQuadric(const Vector3& normal, float d, float weight)
+	{
+		Quadric quadric{};
+		quadric.a00 = weight * normal.x * normal.x;
+		quadric.a01 = weight * normal.x * normal.y;
+		quadric.a02 = weight * normal.x * normal.z;
+		quadric.a11 = weight * normal.y * normal.y;
+		quadric.a12 = weight * normal.y * normal.z;
+		quadric.a22 = weight * normal.z * normal.z;
+		quadric.b0 = weight * normal.x * d;
+		quadric.b1 = weight * normal.y * d;
+		quadric.b2 = weight * normal.z * d;
+		quadric.c = weight * d * d;
+		quadric.weight = weight;
+		return quadric;
+	}
+
+	void AddQuadric(Quadric& quadric, const Quadric& other)
+	{
+		quadric.a00 += other.a00;
+		quadric.a01 += other.a01;
+		quadric.a02 += other.a02;
+		quadric.a11 += other.a11;
+		quadric.a12 += other.a12;
+		quadric.a22 += other.a22;
+		quadric.b0 += other.b0;
+		quadric.b1 += other.b1;
+		quadric.b2 += other.b2;
+		quadric.c += other.c;
+		quadric.weight += other.weight;
+	}
+
+	//pに動かしたときの、面積で重み付けした距離の2乗の合計（二次誤差を足したものの値は、それぞれの値の和になる）
+	float QuadricValue(const Quadric& quadric, const Vector3& p)
+	{
+		return
+			quadric.a00 * p.x * p.x + quadric.a11 * p.y * p.y + quadric.a22 * p.z * p.z +
+			2.0f * (quadric.a01 * p.x * p.y + quadric.a02 * p.x * p.z + quadric.a12 * p.y * p.z) +
+			2.0f * (quadric.b0 * p.x + quadric.b1 * p.y + quadric.b2 * p.z) + quadric.c;
+	}
+
+	Vector3 TriangleNormal(const Vector3& a, const Vector3& b, const Vector3& c)
+	{
+		return Cross(Subtract(b, a), Subtract(c, a));
+	}
+
+	//同じ座標の頂点が他にある頂点（UV / 法線の継ぎ目）と、開いた縁や3枚以上の面が集まる辺の頂点に印を付ける
+	std::vector<uint8_t> FindLockedVertices(std::span<const uint32_t> indices, std::span<const Vector3> positions)
+	{
+		std::vector<uint8_t> locked(positions.size(), 0);
+
+		std::vector<uint32_t> order(positions.size());
+		std::iota(order.begin(), order.end(), 0u);
+		auto lessPosition = [&](uint32_t a, uint32_t b)
+			{
+				const Vector3& p = positions[a];
+				const Vector3& q = positions[b];
+				return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+			};
+		std::sort(order.begin(), order.end(), lessPosition);
+		for (size_t i = 1; i < order.size(); i++)
+		{
+			if (!lessPosition(order[i - 1], order[i]))
+			{
+				locked[order[i - 1]] = 1;
+				locked[order[i]] = 1;
+			}
+		}
+
+		//向きのある辺 a→b に対して b→a がちょうど1本あれば、2枚の面の間の辺
+		std::vector<uint64_t> edges;
+		edges.reserve(indices.size());
+		for (size_t i = 0; i + 3 <= indices.size(); i += 3)
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				edges.push_back(uint64_t(indices[i + corner]) << 32 | indices[i + (corner + 1) % 3]);
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		for (size_t i = 0; i < edges.size(); i++)
+		{
+			const uint32_t a = uint32_t(edges[i] >> 32);
+			const uint32_t b = uint32_t(edges[i]);
+			const uint64_t reverse = uint64_t(b) << 32 | a;
+			const auto range = std::equal_range(edges.begin(), edges.end(), reverse);
+			const bool duplicated = (i > 0 && edges[i - 1] == edges[i]) || (i + 1 < edges.size() && edges[i + 1] == edges[i]);
+			if (range.second - range.first != 1 || duplicated)
+			{
+				locked[a] = 1;
+				locked[b] = 1;
+			}
+		}
+		return locked;
+	}
+}
+
+float SimplifyMesh(std::span<const uint32_t> indices, std::span<const Vector3> positions, size_t targetIndexCount, float targetError, std::vector<uint32_t>& result)
+{
+	result.assign(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+	const size_t vertexCount = positions.size();
+	if (result.size() <= targetIndexCount || vertexCount == 0)
+	{
+		return 0.0f;
+	}
+
+	//1. 座標を [0, 1] に収める（floatの二次誤差で桁が落ちないように）
+	Vector3 minimum{ FLT_MAX, FLT_MAX, FLT_MAX };
+	Vector3 maximum{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (const Vector3& position : positions)
+	{
+		minimum = { std::min(minimum.x, position.x), std::min(minimum.y, position.y), std::min(minimum.z, position.z) };
+		maximum = { std::max(maximum.x, position.x), std::max(maximum.y, position.y), std::max(maximum.z, position.z) };
+	}
+	const float extent = std::max({ maximum.x - minimum.x, maximum.y - minimum.y, maximum.z - minimum.z });
+	if (!(extent > 0.0f))
+	{
+		return 0.0f;
+	}
+	std::vector<Vector3> points(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		points[v] = Multiply(1.0f / extent, Subtract(positions[v], minimum));
+	}
+	const float errorLimit = targetError / extent;
+	const float errorLimitSquared = errorLimit < 1e18f ? errorLimit * errorLimit : FLT_MAX;
+
+	//2. 動かさない頂点と、頂点ごとの二次誤差（周りの面の平面を面積で重み付けして足す）
+	const std::vector<uint8_t> locked = FindLockedVertices(result, positions);
+	std::vector<Quadric> quadrics(vertexCount, Quadric{});
+	for (size_t i = 0; i < result.size(); i += 3)
+	{
+		const Vector3& a = points[result[i]];
+		const Vector3 normal = TriangleNormal(a, points[result[i + 1]], points[result[i + 2]]);
+		const float length = Length(normal);
+		if (length <= 0.0f)
+		{
+			continue;
+		}
+		const Vector3 unitNormal = Multiply(1.0f / length, normal);
+		const Quadric quadric = MakePlaneQuadric(unitNormal, -Dot(unitNormal, a), length * 0.5f);
+		for (int corner = 0; corner < 3; corner++)
+		{
+			AddQuadric(quadrics[result[i + corner]], quadric);
+		}
+	}
+
+	//3. 安い縮約から順に行う。1回の中では、縮約した頂点の周りにはもう触らない（面の向きの確認が古くならないように）
+	const size_t targetTriangleCount = targetIndexCount / 3;
+	float maxError = 0.0f;
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<float> bestCosts(vertexCount);
+	std::vector<float> restValues(vertexCount);
+	std::vector<uint32_t> bestTargets(vertexCount);
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint8_t> touched(vertexCount);
+	while (result.size() / 3 > targetTriangleCount)
+	{
+		const size_t triangleCount = result.size() / 3;
+
+		//頂点ごとの面の一覧
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+		for (const uint32_t index : result)
+		{
+			adjacencyOffsets[index + 1]++;
+		}
+		std::inclusive_scan(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+		adjacency.resize(result.size());
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < result.size(); i++)
+			{
+				adjacency[fill[result[i]]++] = uint32_t(i / 3);
+			}
+		}
+
+		//頂点ごとに、辺でつながった頂点のうち寄せたときの誤差が最も小さいもの
+		//vをwに寄せた後のwは両方の面を受け持つので、誤差はQv + Qwをwの位置で測る（縮約したときも同じものをwに残す）
+		//Qwのwの位置での値は寄せる元によらないので、先に頂点ごとに求めておく
+		for (uint32_t w = 0; w < vertexCount; w++)
+		{
+			restValues[w] = QuadricValue(quadrics[w], points[w]);
+		}
+		std::fill(bestCosts.begin(), bestCosts.end(), FLT_MAX);
+		std::fill(bestTargets.begin(), bestTargets.end(), kInvalidIndex);
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				const uint32_t v = result[i + corner];
+				if (locked[v])
+				{
+					continue;
+				}
+				for (int other = 1; other < 3; other++)
+				{
+					const uint32_t w = result[i + (corner + other) % 3];
+					//面積あたりの距離の2乗
+					const float cost = std::fabs(QuadricValue(quadrics[v], points[w]) + restValues[w]) / std::max(quadrics[v].weight + quadrics[w].weight, FLT_MIN);
+					if (w != v && cost < bestCosts[v])
+					{
+						bestCosts[v] = cost;
+						bestTargets[v] = w;
+					}
+				}
+			}
+		}
+		candidates.clear();
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			if (bestTargets[v] != kInvalidIndex && bestCosts[v] <= errorLimitSquared)
+			{
+				candidates.push_back(v);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) { return bestCosts[a] < bestCosts[b]; });
+
+		//寄せると裏返る面（または大きく傾いて継ぎ目に沿った細い面になるもの）があれば縮約しない
+		auto flips = [&](uint32_t v, uint32_t w)
+			{
+				for (uint32_t j = adjacencyOffsets[v]; j < adjacencyOffsets[v + 1]; j++)
+				{
+					const uint32_t* triangle = &result[size_t(adjacency[j]) * 3];
+					if (triangle[0] == w || triangle[1] == w || triangle[2] == w)
+					{
+						continue;
+					}
+					Vector3 moved[3];
+					for (int corner = 0; corner < 3; corner++)
+					{
+						moved[corner] = points[triangle[corner] == v ? w : triangle[corner]];
+					}
+					const Vector3 before = TriangleNormal(points[triangle[0]], points[triangle[1]], points[triangle[2]]);
+					const Vector3 after = TriangleNormal(moved[0], moved[1], moved[2]);
+					if (Dot(before, after) <= 0.25f * Length(before) * Length(after))
+					{
+						return true;
+					}
+				}
+				return false;
+			};
+
+		std::iota(remap.begin(), remap.end(), 0u);
+		std::fill(touched.begin(), touched.end(), 0);
+		size_t removedCount = 0;
+		for (const uint32_t v : candidates)
+		{
+			const uint32_t w = bestTargets[v];
+			if (triangleCount - removedCount <= targetTriangleCount)
+			{
+				break;
+			}
+			if (touched[v] || touched[w] || flips(v, w))
+			{
+				continue;
+			}
+			remap[v] = w;
+			AddQuadric(quadrics[w], quadrics[v]);
+			maxError = std::max(maxError, bestCosts[v]);
+			for (uint32_t j = adjacencyOffsets[v]; j < adjacencyOffsets[v + 1]; j++)
+			{
+				const uint32_t* triangle = &result[size_t(adjacency[j]) * 3];
+				removedCount += triangle[0] == w || triangle[1] == w || triangle[2] == w;
+				touched[triangle[0]] = 1;
+				touched[triangle[1]] = 1;
+				touched[triangle[2]] = 1;
+			}
+		}
+		if (removedCount == 0)
+		{
+			break;
+		}
+
+		//寄せた頂点を付け替えて、つぶれた面を消す
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			const uint32_t a = remap[result[i]];
+			const uint32_t b = remap[result[i + 1]];
+			const uint32_t c = remap[result[i + 2]];
+			if (a != b && b != c && c != a)
+			{
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+		}
+		result.resize(write);
+	}
+	return std::sqrt(maxError) * extent;
+}
+
+void GenerateLodChain(ModelData& modelData, std::span<const float> ratios)
+{
+	//前に作ったLODがあれば消す（元のメッシュのインデックスは先頭にある）
+	uint32_t baseIndexEnd = 0;
+	for (const SubmeshData& submesh : modelData.submeshes)
+	{
+		baseIndexEnd = std::max(baseIndexEnd, submesh.indexStart + submesh.indexCount);
+	}
+	modelData.indices.resize(baseIndexEnd);
+	modelData.lods.clear();
+
+	std::vector<uint32_t> localIndices(modelData.vertices.size(), kInvalidIndex);
+	std::vector<uint32_t> globalIndices;
+	std::vector<Vector3> positions;
+	std::vector<uint32_t> sourceIndices;
+	std::vector<uint32_t> simplified;
+	size_t sourceIndexCount = baseIndexEnd;
+	float sourceError = 0.0f;
+	for (const float ratio : ratios)
+	{
+		//前の段から減らす（元から減らすより速く、段の間で形が大きく変わらない）
+		const std::vector<SubmeshData> sourceSubmeshes = modelData.lods.empty() ? modelData.submeshes : modelData.lods.back().submeshes;
+		const size_t levelIndexStart = modelData.indices.size();
+		LodData lod{};
+		float levelError = 0.0f;
+		for (size_t i = 0; i < sourceSubmeshes.size(); i++)
+		{
+			//サブメッシュで使う頂点に詰めた番号を振る
+			const SubmeshData& submesh = sourceSubmeshes[i];
+			globalIndices.clear();
+			positions.clear();
+			sourceIndices.resize(submesh.indexCount);
+			for (uint32_t j = 0; j < submesh.indexCount; j++)
+			{
+				const uint32_t vertex = modelData.indices[submesh.indexStart + j];
+				if (localIndices[vertex] == kInvalidIndex)
+				{
+					localIndices[vertex] = uint32_t(globalIndices.size());
+					globalIndices.push_back(vertex);
+					const Vector4& position = modelData.vertices[vertex].position;
+					positions.push_back({ position.x, position.y, position.z });
+				}
+				sourceIndices[j] = localIndices[vertex];
+			}
+			for (const uint32_t vertex : globalIndices)
+			{
+				localIndices[vertex] = kInvalidIndex;
+			}
+
+			const size_t targetIndexCount = size_t(double(modelData.submeshes[i].indexCount) * ratio) / 3 * 3;
+			levelError = std::max(levelError, SimplifyMesh(sourceIndices, positions, targetIndexCount, FLT_MAX, simplified));
+
+			SubmeshData& lodSubmesh = lod.submeshes.emplace_back(submesh);
+			lodSubmesh.indexStart = uint32_t(modelData.indices.size());
+			lodSubmesh.indexCount = uint32_t(simplified.size());
+			for (const uint32_t index : simplified)
+			{
+				modelData.indices.push_back(globalIndices[index]);
+			}
+		}
+
+		//継ぎ目や縁ばかりでほとんど減らせなければ、これ以上の段は作らない
+		const size_t levelIndexCount = modelData.indices.size() - levelIndexStart;
+		if (double(levelIndexCount) > double(sourceIndexCount) * 0.9)
+		{
+			modelData.indices.resize(levelIndexStart);
+			break;
+		}
+		//段ごとのずれを足したものを、元の形からのずれとする
+		lod.error = sourceError + levelError;
+		sourceError = lod.error;
+		sourceIndexCount = levelIndexCount;
+		modelData.lods.push_back(std::move(lod));
+	}
+}
+
+uint32_t SelectLod(std::span<const LodData> lods, float scale, float distance, float fovY, float screenHeight, float thresholdPixels)
+{
+	//モデルの座標で1のずれが、画面で何ピクセルになるか
+	const float pixelsPerUnit = scale * screenHeight / (2.0f * std::max(distance, 1e-6f) * std::tan(fovY * 0.5f));
+	uint32_t lod = 0;
+	for (size_t i = 0; i < lods.size(); i++)
+	{
+		if (lods[i].error * pixelsPerUnit > thresholdPixels)
+		{
+			break;
+		}
+		lod = uint32_t(i + 1);
+	}
+	return lod;
+}
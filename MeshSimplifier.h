@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "ModelData.h"
+
+///==========================================================
+/// 二次誤差（Quadric Error Metrics）による辺の縮約でメッシュの三角形を減らす
+/// 頂点を隣の頂点に寄せる（新しい頂点を作らない）ので、UVと法線は元の値のまま使える
+/// 同じ座標に別の頂点がある所（UV / 法線の継ぎ目）と開いた縁の頂点は動かさないので、継ぎ目に隙間ができない
+///==========================================================
+
+//GenerateLodChainの既定の段（元の三角形の数に対する割合）
+static constexpr float kDefaultLodRatios[] = { 0.5f, 0.25f, 0.125f };
+
+//三角形をtargetIndexCount個のインデックスまで減らしてresultに入れる
+//ずれがtargetErrorを超える縮約はしない。indicesの番号はpositionsの要素数未満
+//戻り値は実際のずれの大きさ（positionsの座標の単位）
+float SimplifyMesh(std::span<const uint32_t> indices, std::span<const Vector3> positions, size_t targetIndexCount, float targetError, std::vector<uint32_t>& result);
+
+//modelDataのサブメッシュごとにratiosの割合まで減らしたLODを作り、ModelData::lodsに入れる
+//インデックスはModelData::indicesの後ろに足す。前の段からほとんど減らせなければそこで止める
+void GenerateLodChain(ModelData& modelData, std::span<const float> ratios = kDefaultLodRatios);
+
+//画面上のずれがthresholdPixels以下になる最も粗いLODを選ぶ。0は元のメッシュ、iはlods[i - 1]
+//scale: モデルの拡大率（軸ごとに違えば最大のもの）、distance: カメラまでの距離
+//fovY: 縦の画角（ラジアン）、screenHeight: 画面の高さ（ピクセル）
+uint32_t SelectLod(std::span<const LodData> lods, float scale, float distance, float fovY, float screenHeight, float thresholdPixels = 1.0f);
@@ -0,0 +1,307 @@
+#include "Meshlet.h"
+#include "FrustumCulling.h"
+#include "MatrixMath.h"
+#include "MeshOptimizer.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	static constexpr uint32_t kInvalidIndex = ~0u;
+
+	//三角形の並びから境界球と法線の円錐を求める
+	MeshletData ComputeMeshletBounds(std::span<const uint32_t> indices, std::span<const VertexData> vertices)
+	{
+		auto positionOf = [&](uint32_t index)
+			{
+				const Vector4& position = vertices[index].position;
+				return Vector3{ position.x, position.y, position.z };
+			};
+
+		//境界球（中心はAABBの中心）
+		Vector3 minimum{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vector3 maximum{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (const uint32_t index : indices)
+		{
+			const Vector3 position = positionOf(index);
+			minimum = { std::min(minimum.x, position.x), std::min(minimum.y, position.y), std::min(minimum.z, position.z) };
+			maximum = { std::max(maximum.x, position.x), std::max(maximum.y, position.y), std::max(maximum.z, position.z) };
+		}
+		MeshletData meshlet{};
+		meshlet.center = Multiply(0.5f, Add(minimum, maximum));
+		float radiusSquared = 0.0f;
+		for (const uint32_t index : indices)
+		{
+			const Vector3 offset = Subtract(positionOf(index), meshlet.center);
+			radiusSquared = std::max(radiusSquared, Dot(offset, offset));
+		}
+		meshlet.radius = std::sqrt(radiusSquared);
+
+		//法線の円錐。軸は面の単位法線の平均、開きは軸から最も離れた法線まで
+		Vector3 normalSum{ 0.0f, 0.0f, 0.0f };
+		for (size_t i = 0; i + 3 <= indices.size(); i += 3)
+		{
+			const Vector3 a = positionOf(indices[i]);
+			const Vector3 normal = Cross(Subtract(positionOf(indices[i + 1]), a), Subtract(positionOf(indices[i + 2]), a));
+			const float length = Length(normal);
+			if (length > 0.0f)
+			{
+				normalSum = Add(normalSum, Multiply(1.0f / length, normal));
+			}
+		}
+		const float axisLength = Length(normalSum);
+		meshlet.coneCutoff = 1.0f;
+		if (axisLength <= 0.0f)
+		{
+			meshlet.coneAxis = { 0.0f, 0.0f, 1.0f };
+			return meshlet;
+		}
+		meshlet.coneAxis = Multiply(1.0f / axisLength, normalSum);
+		float minimumDot = 1.0f;
+		for (size_t i = 0; i + 3 <= indices.size(); i += 3)
+		{
+			const Vector3 a = positionOf(indices[i]);
+			const Vector3 normal = Cross(Subtract(positionOf(indices[i + 1]), a), Subtract(positionOf(indices[i + 2]), a));
+			const float length = Length(normal);
+			if (length > 0.0f)
+			{
+				minimumDot = std::min(minimumDot, Dot(meshlet.coneAxis, normal) / length);
+			}
+		}
+		//開きが90度に近い円錐はほとんど裏向きにならないので判定しない
+		if (minimumDot > 0.1f)
+		{
+			meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+		}
+		return meshlet;
+	}
+}
+
+void BuildMeshlets(ModelData& modelData, uint32_t maxVertices, uint32_t maxTriangles)
+{
+	assert(maxVertices >= 3 && maxTriangles >= 1);
+	modelData.meshlets.clear();
+
+	//頂点が最後に入ったメッシュレットの番号（同じ塊で何度使っても1つと数える）
+	std::vector<uint32_t> lastMeshlet(modelData.vertices.size(), kInvalidIndex);
+	std::vector<uint32_t> localIndices(modelData.vertices.size());	// 塊の中での頂点の番号（meshletVerticesの位置）
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint32_t> meshletIndices;
+	std::vector<uint32_t> adjacencyOffsets(modelData.vertices.size() + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<uint32_t> triangles;
+	std::vector<uint8_t> used;
+	std::vector<uint32_t> liveCounts;
+	std::vector<Vector3> normals;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> candidateMeshlet;
+	auto build = [&](SubmeshData& submesh)
+		{
+			submesh.meshletStart = uint32_t(modelData.meshlets.size());
+			const uint32_t triangleCount = submesh.indexCount / 3;
+			if (triangleCount == 0)
+			{
+				submesh.meshletCount = 0;
+				return;
+			}
+			std::span<uint32_t> range(modelData.indices.data() + submesh.indexStart, size_t(triangleCount) * 3);
+			triangles.assign(range.begin(), range.end());
+
+			//頂点ごとの三角形の一覧と、三角形の単位法線
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+			for (const uint32_t index : triangles)
+			{
+				adjacencyOffsets[index + 1]++;
+			}
+			for (size_t v = 1; v < adjacencyOffsets.size(); v++)
+			{
+				adjacencyOffsets[v] += adjacencyOffsets[v - 1];
+			}
+			adjacency.resize(triangles.size());
+			for (size_t i = 0; i < triangles.size(); i++)
+			{
+				adjacency[adjacencyOffsets[triangles[i]]++] = uint32_t(i / 3);
+			}
+			for (size_t v = adjacencyOffsets.size() - 1; v > 0; v--)
+			{
+				adjacencyOffsets[v] = adjacencyOffsets[v - 1];
+			}
+			adjacencyOffsets[0] = 0;
+			normals.resize(triangleCount);
+			for (uint32_t t = 0; t < triangleCount; t++)
+			{
+				const Vector4& a = modelData.vertices[triangles[t * 3]].position;
+				const Vector4& b = modelData.vertices[triangles[t * 3 + 1]].position;
+				const Vector4& c = modelData.vertices[triangles[t * 3 + 2]].position;
+				const Vector3 normal = Cross({ b.x - a.x, b.y - a.y, b.z - a.z }, { c.x - a.x, c.y - a.y, c.z - a.z });
+				const float length = Length(normal);
+				normals[t] = length > 0.0f ? Multiply(1.0f / length, normal) : Vector3{ 0.0f, 0.0f, 0.0f };
+			}
+			used.assign(triangleCount, 0);
+			candidateMeshlet.assign(triangleCount, kInvalidIndex);
+			liveCounts.assign(modelData.vertices.size(), 0);
+			for (const uint32_t index : triangles)
+			{
+				liveCounts[index]++;
+			}
+
+			//頂点キャッシュの順で最初に残っている三角形から始め、塊の頂点を多く共有し、向きが揃った隣の三角形を足していく
+			uint32_t write = 0;
+			uint32_t seed = 0;
+			while (write < triangleCount * 3)
+			{
+				while (used[seed])
+				{
+					seed++;
+				}
+				const uint32_t current = uint32_t(modelData.meshlets.size());
+				const uint32_t meshletStart = write;
+				uint32_t vertexCount = 0;
+				Vector3 normalSum{ 0.0f, 0.0f, 0.0f };
+				candidates.clear();
+				meshletVertices.clear();
+				auto countNewVertices = [&](uint32_t t)
+					{
+						const uint32_t* triangle = &triangles[t * 3];
+						return uint32_t(lastMeshlet[triangle[0]] != current) +
+							uint32_t(lastMeshlet[triangle[1]] != current && triangle[1] != triangle[0]) +
+							uint32_t(lastMeshlet[triangle[2]] != current && triangle[2] != triangle[0] && triangle[2] != triangle[1]);
+					};
+				auto add = [&](uint32_t t)
+					{
+						used[t] = 1;
+						vertexCount += countNewVertices(t);
+						for (int corner = 0; corner < 3; corner++)
+						{
+							const uint32_t vertex = triangles[t * 3 + corner];
+							liveCounts[vertex]--;
+							if (lastMeshlet[vertex] != current)
+							{
+								lastMeshlet[vertex] = current;
+								localIndices[vertex] = uint32_t(meshletVertices.size());
+								meshletVertices.push_back(vertex);
+								for (uint32_t j = adjacencyOffsets[vertex]; j < adjacencyOffsets[vertex + 1]; j++)
+								{
+									const uint32_t neighbor = adjacency[j];
+									if (!used[neighbor] && candidateMeshlet[neighbor] != current)
+									{
+										candidateMeshlet[neighbor] = current;
+										candidates.push_back(neighbor);
+									}
+								}
+							}
+							range[write++] = vertex;
+						}
+						normalSum = Add(normalSum, normals[t]);
+					};
+
+				add(seed);
+				while ((write - meshletStart) / 3 < maxTriangles)
+				{
+					//候補から、新しい頂点が少なく、残りの三角形が少ない頂点を使い（取り残される三角形を減らす）、法線が塊の平均に近いものを選ぶ
+					uint32_t best = kInvalidIndex;
+					float bestScore = -FLT_MAX;
+					const Vector3 averageNormal = Multiply(1.0f / std::max(Length(normalSum), 1e-12f), normalSum);
+					size_t keep = 0;
+					for (const uint32_t t : candidates)
+					{
+						if (used[t])
+						{
+							continue;
+						}
+						candidates[keep++] = t;
+						const uint32_t newVertexCount = countNewVertices(t);
+						if (vertexCount + newVertexCount > maxVertices)
+						{
+							continue;
+						}
+						const uint32_t* triangle = &triangles[t * 3];
+						const uint32_t liveCount = liveCounts[triangle[0]] + liveCounts[triangle[1]] + liveCounts[triangle[2]];
+						const float score = float(3 - newVertexCount) * 2.0f - float(liveCount) * 0.5f + Dot(normals[t], averageNormal);
+						if (score > bestScore)
+						{
+							bestScore = score;
+							best = t;
+						}
+					}
+					candidates.resize(keep);
+					if (best == kInvalidIndex)
+					{
+						break;
+					}
+					add(best);
+				}
+
+				//塊の順に並べると頂点キャッシュの効率が少し落ちるので、塊の中で並べ直す
+				const std::span<uint32_t> meshletRange = range.subspan(meshletStart, write - meshletStart);
+				meshletIndices.resize(meshletRange.size());
+				for (size_t i = 0; i < meshletRange.size(); i++)
+				{
+					meshletIndices[i] = localIndices[meshletRange[i]];
+				}
+				OptimizeVertexCache(meshletIndices, meshletVertices.size());
+				for (size_t i = 0; i < meshletRange.size(); i++)
+				{
+					meshletRange[i] = meshletVertices[meshletIndices[i]];
+				}
+
+				MeshletData& meshlet = modelData.meshlets.emplace_back(ComputeMeshletBounds(meshletRange, modelData.vertices));
+				meshlet.indexStart = submesh.indexStart + meshletStart;
+				meshlet.indexCount = write - meshletStart;
+			}
+			submesh.meshletCount = uint32_t(modelData.meshlets.size()) - submesh.meshletStart;
+		};
+
+	for (SubmeshData& submesh : modelData.submeshes)
+	{
+		build(submesh);
+	}
+	for (LodData& lod : modelData.lods)
+	{
+		for (SubmeshData& submesh : lod.submeshes)
+		{
+			build(submesh);
+		}
+	}
+}
+
+bool IsBackfacing(const MeshletData& meshlet, const Vector3& cameraPosition)
+{
+	//球の中のどこに頂点があっても、カメラが全ての面の裏側にあるか
+	//dot(normalize(center - camera), axis) >= cutoff + radius / |center - camera| を割り算なしで判定する
+	const Vector3 toCenter = Subtract(meshlet.center, cameraPosition);
+	const float distance = Length(toCenter);
+	return Dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * distance + meshlet.radius;
+}
+
+MeshletCullingView MakeMeshletCullingView(const Frustum& frustum, const Matrix4x4& world, const Vector3& cameraPosition)
+{
+	MeshletCullingView view{};
+	view.frustum = MakeLocalFrustum(frustum, world);
+	view.cameraPosition = Transforms(cameraPosition, InverseAffine(world));
+	//行列式が負なら面の向きが逆になる
+	const Vector3 x{ world.m[0][0], world.m[0][1], world.m[0][2] };
+	const Vector3 y{ world.m[1][0], world.m[1][1], world.m[1][2] };
+	const Vector3 z{ world.m[2][0], world.m[2][1], world.m[2][2] };
+	view.cullBackface = Dot(Cross(x, y), z) > 0.0f;
+	return view;
+}
+
+size_t CullMeshlets(std::span<const MeshletData> meshlets, std::span<const uint32_t> indices, const MeshletCullingView& view, std::vector<uint32_t>& visibleIndices)
+{
+	size_t visibleCount = 0;
+	for (const MeshletData& meshlet : meshlets)
+	{
+		if (!IsVisible(view.frustum, Sphere{ meshlet.center, meshlet.radius }) ||
+			(view.cullBackface && IsBackfacing(meshlet, view.cameraPosition)))
+		{
+			continue;
+		}
+		visibleIndices.insert(visibleIndices.end(), indices.begin() + meshlet.indexStart, indices.begin() + meshlet.indexStart + meshlet.indexCount);
+		visibleCount++;
+	}
+	return visibleCount;
+}
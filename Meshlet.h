@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Frustum.h"
+#include "Matrix4x4.h"
+#include "ModelData.h"
+
+///==========================================================
+/// メッシュレット（ModelData::meshlets）を作り、毎フレーム見える塊のインデックスだけを詰める
+/// 塊は隣り合った三角形から、頂点を多く共有し向きが揃ったものを選んで育てる（小さい境界球と細い法線の円錐になる）
+/// 三角形はサブメッシュの中で塊の順に並べ替え、塊の中は頂点キャッシュの順に並べ直す
+/// オブジェクトの分け方に関係なく、塊の単位で視錐台と裏向きの判定ができる
+///==========================================================
+
+//1つのメッシュレットの上限（メッシュシェーダーでよく使われる大きさ）
+static constexpr uint32_t kMeshletMaxVertices = 64;
+static constexpr uint32_t kMeshletMaxTriangles = 124;
+
+///==========================================================
+/// メッシュレットの判定に使う視点（モデルの座標に移したもの）
+///==========================================================
+struct MeshletCullingView
+{
+	Frustum frustum;
+	Vector3 cameraPosition;
+	bool cullBackface;		// falseなら裏向きの判定をしない（鏡映を含む行列では面の向きが逆になる）
+};
+///==========================================================
+/// メッシュレットの判定に使う視点（モデルの座標に移したもの）
+///==========================================================
+
+//サブメッシュ（LODのサブメッシュも含む）ごとにメッシュレットを作り、SubmeshData::meshletStart / meshletCountを設定する
+//OptimizeMeshの後に呼ぶ（塊の種はOptimizeMeshの順に選ぶ）。サブメッシュの範囲とマテリアルは変わらない
+void BuildMeshlets(ModelData& modelData, uint32_t maxVertices = kMeshletMaxVertices, uint32_t maxTriangles = kMeshletMaxTriangles);
+
+//cameraPositionから全ての三角形が裏向きに見えるか（法線の円錐で判定するので、trueなら必ず全て裏向き）
+bool IsBackfacing(const MeshletData& meshlet, const Vector3& cameraPosition);
+
+//ワールドの視錐台とカメラの位置を、world行列のモデルの座標に移す（モデルごとに1回）
+MeshletCullingView MakeMeshletCullingView(const Frustum& frustum, const Matrix4x4& world, const Vector3& cameraPosition);
+
+//見えるメッシュレットのインデックスをvisibleIndicesの後ろに足して、見えたメッシュレットの数を返す
+size_t CullMeshlets(std::span<const MeshletData> meshlets, std::span<const uint32_t> indices, const MeshletCullingView& view, std::vector<uint32_t>& visibleIndices);
@@ -1,4 +1,103 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
 #include <vector>
+#include "Vector3.h"
 #include "VertexData.h"
 
+///==========================================================
+/// マテリアル情報（mtlファイルの内容）
+///==========================================================
+struct MaterialData
+{
+	std::string name;								// newmtl
+	Vector3 diffuseColor{ 1.0f, 1.0f, 1.0f };		// Kd
+	Vector3 specularColor{ 0.0f, 0.0f, 0.0f };		// Ks
+	float shininess = 0.0f;							// Ns
+	float alpha = 1.0f;								// d
+	std::string textureFilePath;					// map_Kd（無ければ空）
+};
+///==========================================================
+/// マテリアル情報（mtlファイルの内容）
+///==========================================================
+
+///==========================================================
+/// サブメッシュ（同じオブジェクトで同じマテリアルのインデックスの範囲）
+///==========================================================
+struct SubmeshData
+{
+	std::string name;			// o / g の名前
+	uint32_t indexStart;
+	uint32_t indexCount;
+	uint32_t materialIndex;		// ModelData::materialsの番号
+	uint32_t meshletStart = 0;	// ModelData::meshletsの範囲（BuildMeshletsで作る。無ければ0個）
+	uint32_t meshletCount = 0;
+};
+///==========================================================
+/// サブメッシュ（同じオブジェクトで同じマテリアルのインデックスの範囲）
+///==========================================================
+
+///==========================================================
+/// メッシュレット（サブメッシュを頂点と三角形が少ない塊に分けたもの）
+/// 塊ごとに視錐台と裏向きの判定をして、見える塊のインデックスだけを描画する
+///==========================================================
+struct MeshletData
+{
+	Vector3 center;			// 境界球（モデルの座標）
+	float radius;
+	Vector3 coneAxis;		// 面の法線が収まる円錐の軸（単位ベクトル）
+	float coneCutoff;		// 円錐の判定に使う値。1なら裏向きの判定をしない
+	uint32_t indexStart;	// ModelData::indicesの範囲
+	uint32_t indexCount;
+};
+///==========================================================
+/// メッシュレット（サブメッシュを頂点と三角形が少ない塊に分けたもの）
+/// 塊ごとに視錐台と裏向きの判定をして、見える塊のインデックスだけを描画する
+///==========================================================
+
+///==========================================================
+/// LOD（遠くで使う三角形を減らしたメッシュ）1段分
+/// 頂点はModelData::verticesを共有し、インデックスはModelData::indicesの元のメッシュの後ろに並ぶ
+///==========================================================
+struct LodData
+{
+	std::vector<SubmeshData> submeshes;		// ModelData::submeshesと同じ順に同じ数だけ並ぶ
+	float error;							// 元の形からのずれの大きさ（モデルの座標の単位）
+};
+///==========================================================
+/// LOD（遠くで使う三角形を減らしたメッシュ）1段分
+/// 頂点はModelData::verticesを共有し、インデックスはModelData::indicesの元のメッシュの後ろに並ぶ
+///==========================================================
+
+///==========================================================
+/// モデル情報（objファイルの内容）
+///==========================================================
+struct ModelData
+{
+	std::vector<VertexData> vertices;
+	std::vector<uint32_t> indices;			// verticesの番号。3つで1つの三角形（LODの分も含む）
+	std::vector<SubmeshData> submeshes;		// materialIndexの順に並ぶ
+	std::vector<MaterialData> materials;
+	std::vector<LodData> lods;				// 細かい順に並ぶ（lods[0]が元のメッシュの次に細かい）。無ければ空
+	std::vector<MeshletData> meshlets;		// 全てのサブメッシュ（LODの分も含む）の分をサブメッシュの順に並べる。無ければ空
+	std::vector<Vector4> tangents;			// verticesと同じ順の接線（GenerateTangentsで作る）。wは従法線の向き（±1）。無ければ空
+};
+///==========================================================
+/// モデル情報（objファイルの内容）
+///==========================================================
+
+//元のメッシュ（ModelData::submeshes）のインデックスの数。LODのインデックスはこの後ろに並ぶ
+static size_t BaseIndexCount(const ModelData& modelData)
+{
+	if (modelData.submeshes.empty())
+	{
+		return modelData.indices.size();
+	}
+	size_t count = 0;
+	for (const SubmeshData& submesh : modelData.submeshes)
+	{
+		count = std::max(count, size_t(submesh.indexStart) + submesh.indexCount);
+	}
+	return count;
+}
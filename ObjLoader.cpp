@@ -0,0 +1,990 @@
+#include "ObjLoader.h"
+#include "ParallelFor.h"
+#include "TangentSpace.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <string_view>
+
+///==========================================================
+/// f行の頂点を数えるときにSSE2で16バイトずつ調べる
+/// MATRIXMATH_NO_SIMD を定義するとスカラー実装になる
+///==========================================================
+#if !defined(MATRIXMATH_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+#define OBJLOADER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	///==========================================================
+	/// 面を構成する頂点の要素番号（objの1始まりのまま持つ。0は省略）
+	///==========================================================
+	struct ObjIndex
+	{
+		int32_t position;
+		int32_t texcoord;
+		int32_t normal;
+
+		bool operator==(const ObjIndex&) const = default;
+	};
+
+	///==========================================================
+	/// 面の途中で切り替わる状態（o / g / usemtl / s）。face番目の面から有効になる
+	///==========================================================
+	struct ObjStateChange
+	{
+		enum class Kind
+		{
+			kObject,		// o / g
+			kMaterial,		// usemtl
+			kSmoothing,		// s
+		};
+
+		size_t face;
+		Kind kind;
+		std::string name;		// sのときは "off" や "1" などの値
+	};
+
+	///==========================================================
+	/// objファイルから読んだ生の要素
+	///==========================================================
+	struct ObjRecords
+	{
+		std::vector<Vector4> positions;
+		std::vector<Vector2> texcoords;
+		std::vector<Vector3> normals;
+		std::vector<ObjIndex> faceVertices;		// 面の頂点を面の順に並べたもの
+		std::vector<size_t> faceStarts;			// 面ごとのfaceVerticesの開始位置。最後に全体の数が入る
+		std::vector<ObjStateChange> stateChanges;	// ファイルに書かれた順
+		std::vector<std::string> materialFilenames;	// mtllibに書かれた順
+	};
+
+	///==========================================================
+	/// チャンクごとに集める、数が前もって分からない要素
+	/// 並列に解析したあと、チャンクの順につなげる
+	///==========================================================
+	struct ObjChunkRecords
+	{
+		std::vector<ObjStateChange> stateChanges;
+		std::vector<std::string> materialFilenames;
+	};
+
+	//ファイル全体を読み込む
+	std::vector<char> ReadFile(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		assert(file.is_open());		// 開けなかったら止める
+		std::vector<char> buffer(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(buffer.data(), std::streamsize(buffer.size()));
+		return buffer;
+	}
+
+	//改行以外の空白か
+	bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	//f行の終わりか（改行か、行末のコメントの始まり）
+	bool IsFaceEnd(char c)
+	{
+		return c == '\n' || c == '#';
+	}
+
+	//空白を読み飛ばす（改行は読み飛ばさない）
+	const char* SkipSpaces(const char* p, const char* end)
+	{
+		while (p < end && IsSpace(*p))
+		{
+			++p;
+		}
+		return p;
+	}
+
+	//次の行の先頭を返す
+	const char* NextLine(const char* p, const char* end)
+	{
+		const char* newline = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+		return newline ? newline + 1 : end;
+	}
+
+	//空白区切りの単語を1つ読む
+	std::string_view ReadToken(const char*& p, const char* end)
+	{
+		p = SkipSpaces(p, end);
+		const char* begin = p;
+		while (p < end && !IsSpace(*p) && *p != '\n')
+		{
+			++p;
+		}
+		return std::string_view(begin, size_t(p - begin));
+	}
+
+	//小数を1つ読む。読めなければ0になる
+	//"-1.234500" のような桁数の少ない数は自前で変換し、それ以外は from_chars に任せる
+	float ReadFloat(const char*& p, const char* end)
+	{
+		p = SkipSpaces(p, end);
+		//from_charsは先頭の+を受け付けないので飛ばしておく
+		if (p < end && *p == '+')
+		{
+			++p;
+		}
+
+		//仮数を整数として、小数点以下の桁数と一緒に読む
+		const char* q = p;
+		const bool negative = q < end && *q == '-';
+		q += negative;
+		uint64_t mantissa = 0;
+		int32_t digitCount = 0;
+		int32_t fractionDigits = 0;
+		while (q < end && unsigned(*q - '0') < 10u)
+		{
+			mantissa = mantissa * 10 + uint64_t(*q - '0');
+			++digitCount;
+			++q;
+		}
+		if (q < end && *q == '.')
+		{
+			++q;
+			while (q < end && unsigned(*q - '0') < 10u)
+			{
+				mantissa = mantissa * 10 + uint64_t(*q - '0');
+				++digitCount;
+				++fractionDigits;
+				++q;
+			}
+		}
+		//末尾の0は値に影響しないので落としておく
+		while (fractionDigits > 0 && mantissa != 0 && mantissa % 10 == 0)
+		{
+			mantissa /= 10;
+			--fractionDigits;
+		}
+
+		//仮数と10の累乗がどちらもfloatで正確に表せれば、doubleで1回割ってからfloatに丸めても正しく丸められる
+		//（指数表記やinf/nanはfrom_charsに任せる）
+		const bool exponent = q < end && (*q == 'e' || *q == 'E');
+		if (digitCount > 0 && digitCount <= 19 && !exponent && mantissa <= (1u << 24) && fractionDigits <= 10)
+		{
+			static constexpr double kPowersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10 };
+			const float value = float(double(mantissa) / kPowersOf10[fractionDigits]);
+			p = q;
+			return negative ? -value : value;
+		}
+
+		float value = 0.0f;
+		std::from_chars_result result = std::from_chars(p, end, value);
+		if (result.ec == std::errc{})
+		{
+			p = result.ptr;
+		}
+		return value;
+	}
+
+	//整数を1つ読む。読めなければ0になる
+	int32_t ReadInt(const char*& p, const char* end)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			++p;
+		}
+		//桁が多すぎるときはint32_tの最大値で止める（範囲外の番号として後で弾かれる）
+		int64_t value = 0;
+		while (p < end && unsigned(*p - '0') < 10u)
+		{
+			value = std::min<int64_t>(value * 10 + (*p - '0'), INT32_MAX);
+			++p;
+		}
+		return int32_t(negative ? -value : value);
+	}
+
+	///==========================================================
+	/// 各要素の数。チャンクごとの数と、その前までの合計（書き込み位置）に使う
+	///==========================================================
+	struct ObjCounts
+	{
+		size_t positions = 0;
+		size_t texcoords = 0;
+		size_t normals = 0;
+		size_t faces = 0;
+		size_t faceVertices = 0;
+	};
+
+	//f行の頂点の数（空白区切りの単語の数）を数える。3つ未満の面は無視する
+	//"#" から後ろはコメントなので数えない。pは行末（改行か "#" の位置）まで進める
+	size_t CountFaceVertices(const char*& p, const char* end)
+	{
+		size_t count = 0;
+		bool previousIsSpace = true;
+#if defined(OBJLOADER_USE_SSE2)
+		//空白と行末の位置をビットにして、「1つ前が空白で自分は空白でない」位置の数を数える
+		const __m128i space = _mm_set1_epi8(' ');
+		const __m128i tab = _mm_set1_epi8('\t');
+		const __m128i carriageReturn = _mm_set1_epi8('\r');
+		const __m128i newline = _mm_set1_epi8('\n');
+		const __m128i comment = _mm_set1_epi8('#');
+		while (end - p >= 16)
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			const __m128i isSpaceBytes = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab)), _mm_cmpeq_epi8(bytes, carriageReturn));
+			const uint32_t isSpace = uint32_t(_mm_movemask_epi8(isSpaceBytes));
+			const uint32_t isNewline = uint32_t(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, newline), _mm_cmpeq_epi8(bytes, comment))));
+			uint32_t starts = ~isSpace & ((isSpace << 1) | uint32_t(previousIsSpace)) & 0xFFFFu;
+			if (isNewline != 0)
+			{
+				const uint32_t length = uint32_t(std::countr_zero(isNewline));
+				count += size_t(std::popcount(starts & ((1u << length) - 1)));
+				p += length;
+				return count >= 3 ? count : 0;
+			}
+			count += size_t(std::popcount(starts));
+			previousIsSpace = (isSpace >> 15) != 0;
+			p += 16;
+		}
+#endif
+		for (; p < end && !IsFaceEnd(*p); ++p)
+		{
+			const bool isSpace = IsSpace(*p);
+			count += previousIsSpace && !isSpace;
+			previousIsSpace = isSpace;
+		}
+		return count >= 3 ? count : 0;
+	}
+
+	//各要素の数を数える。ParseObjと同じ規則で数えるので、結果の数と必ず一致する
+	ObjCounts CountRecords(const char* p, const char* end)
+	{
+		ObjCounts counts;
+		while (p < end)
+		{
+			std::string_view identifier = ReadToken(p, end);
+			if (identifier == "v")
+			{
+				++counts.positions;
+			}
+			else if (identifier == "vt")
+			{
+				++counts.texcoords;
+			}
+			else if (identifier == "vn")
+			{
+				++counts.normals;
+			}
+			else if (identifier == "f")
+			{
+				const size_t faceVertexCount = CountFaceVertices(p, end);
+				counts.faces += faceVertexCount != 0;
+				counts.faceVertices += faceVertexCount;
+			}
+			p = NextLine(p, end);
+		}
+		return counts;
+	}
+
+	//面の頂点の要素番号を1つ読む。"v"、"v/vt"、"v//vn"、"v/vt/vn" のどれでもよく、省略した番号は0になる
+	//負の番号は「その行までに読んだ要素の数」からの相対位置なので、ここで絶対位置に直す
+	//pは単語の先頭を指していること。読んだあとは単語の終わりまで進める（CountFaceVerticesと同じ数だけ読むため）
+	ObjIndex ReadFaceVertex(const char*& p, const char* end, const ObjCounts& counts)
+	{
+		ObjIndex index{};
+		index.position = ReadInt(p, end);
+		if (p < end && *p == '/')
+		{
+			++p;
+			index.texcoord = ReadInt(p, end);
+		}
+		if (p < end && *p == '/')
+		{
+			++p;
+			index.normal = ReadInt(p, end);
+		}
+		if (index.position < 0)
+		{
+			index.position += int32_t(counts.positions) + 1;
+		}
+		if (index.texcoord < 0)
+		{
+			index.texcoord += int32_t(counts.texcoords) + 1;
+		}
+		if (index.normal < 0)
+		{
+			index.normal += int32_t(counts.normals) + 1;
+		}
+		while (p < end && !IsSpace(*p) && !IsFaceEnd(*p))
+		{
+			++p;
+		}
+		return index;
+	}
+
+	//objのテキストを解析して要素を取り出す
+	//recordsの配列は確保済みで、offsetの位置から書き込む（チャンクごとに並列に呼べる）
+	//状態の切り替えとmtllibはチャンクごとのchunkRecordsに書く
+	void ParseObj(const char* p, const char* end, const ObjCounts& offset, ObjRecords& records, ObjChunkRecords& chunkRecords)
+	{
+		ObjCounts counts = offset;		// ファイル先頭からの通し番号
+		while (p < end)
+		{
+			std::string_view identifier = ReadToken(p, end);		// 先頭の識別子を読む
+
+			// identifierに応じた処理
+			if (identifier == "v")
+			{
+				Vector4& position = records.positions[counts.positions++];
+				position.x = ReadFloat(p, end);
+				position.y = ReadFloat(p, end);
+				position.z = ReadFloat(p, end);
+				position.w = 1.0f;
+			}
+			else if (identifier == "vt")
+			{
+				Vector2& texcoord = records.texcoords[counts.texcoords++];
+				texcoord.x = ReadFloat(p, end);
+				texcoord.y = ReadFloat(p, end);
+			}
+			else if (identifier == "vn")
+			{
+				Vector3& normal = records.normals[counts.normals++];
+				normal.x = ReadFloat(p, end);
+				normal.y = ReadFloat(p, end);
+				normal.z = ReadFloat(p, end);
+			}
+			else if (identifier == "f")
+			{
+				// 多角形のまま読み、三角形にするのは頂点を組み立てるときに行う
+				// 3つ未満の面は数えていないので、3つ目を読むまでは書き込まない
+				ObjIndex first[3]{};
+				size_t faceVertexCount = 0;
+				for (p = SkipSpaces(p, end); faceVertexCount < 3 && p < end && !IsFaceEnd(*p); p = SkipSpaces(p, end))
+				{
+					first[faceVertexCount++] = ReadFaceVertex(p, end, counts);
+				}
+				if (faceVertexCount == 3)
+				{
+					records.faceStarts[counts.faces++] = counts.faceVertices;
+					records.faceVertices[counts.faceVertices++] = first[0];
+					records.faceVertices[counts.faceVertices++] = first[1];
+					records.faceVertices[counts.faceVertices++] = first[2];
+					for (; p < end && !IsFaceEnd(*p); p = SkipSpaces(p, end))
+					{
+						records.faceVertices[counts.faceVertices++] = ReadFaceVertex(p, end, counts);
+					}
+				}
+			}
+			else if (identifier == "usemtl" || identifier == "o" || identifier == "g" || identifier == "s")
+			{
+				// 次の面から使うマテリアル / オブジェクトの名前 / スムージンググループ
+				ObjStateChange& change = chunkRecords.stateChanges.emplace_back();
+				change.face = counts.faces;
+				change.kind = identifier == "usemtl" ? ObjStateChange::Kind::kMaterial :
+					identifier == "s" ? ObjStateChange::Kind::kSmoothing : ObjStateChange::Kind::kObject;
+				change.name = ReadToken(p, end);
+			}
+			else if (identifier == "mtllib")
+			{
+				// materialTemplateLibraryファイル名を取得（1行に複数書ける）
+				for (std::string_view materialFilename = ReadToken(p, end); !materialFilename.empty(); materialFilename = ReadToken(p, end))
+				{
+					chunkRecords.materialFilenames.emplace_back(materialFilename);
+				}
+			}
+			p = NextLine(p, end);
+		}
+	}
+
+	//バッファを行の境目でおよそ等分する
+	std::vector<const char*> SplitLines(const char* begin, const char* end, size_t chunkCount)
+	{
+		std::vector<const char*> bounds{ begin };
+		const size_t chunkSize = size_t(end - begin) / chunkCount;
+		for (size_t chunk = 1; chunk < chunkCount; ++chunk)
+		{
+			const char* bound = std::max(begin + chunk * chunkSize, bounds.back());
+			bound = bound < end ? NextLine(bound, end) : end;
+			bounds.push_back(bound);
+		}
+		bounds.push_back(end);
+		return bounds;
+	}
+
+	//チャンクごとに数えて、書き込み位置を決めてから並列に解析する
+	//1チャンクなら普通の逐次処理と同じで、何チャンクに分けても結果は同じになる
+	void ParseObjChunks(const char* begin, const char* end, uint32_t threadCount, ObjRecords& records)
+	{
+		//小さいファイルは分けても速くならない
+		static constexpr size_t kMinChunkSize = 1024 * 1024;
+		const size_t chunkCount = std::clamp<size_t>(size_t(end - begin) / kMinChunkSize, 1, ResolveThreadCount(threadCount));
+		const std::vector<const char*> bounds = SplitLines(begin, end, chunkCount);
+
+		//チャンクごとに処理する。1チャンクのときはそのまま呼ぶ
+		auto forEachChunk = [&](const std::function<void(size_t)>& func)
+			{
+				WorkerPool::Get().Run(chunkCount, func);
+			};
+
+		//1. チャンクごとの要素の数を数える
+		std::vector<ObjCounts> counts(chunkCount);
+		forEachChunk([&](size_t chunk) { counts[chunk] = CountRecords(bounds[chunk], bounds[chunk + 1]); });
+
+		//2. 前のチャンクまでの合計（プレフィックス和）が、そのチャンクの書き込み位置になる
+		std::vector<ObjCounts> offsets(chunkCount);
+		ObjCounts total;
+		for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			offsets[chunk] = total;
+			total.positions += counts[chunk].positions;
+			total.texcoords += counts[chunk].texcoords;
+			total.normals += counts[chunk].normals;
+			total.faces += counts[chunk].faces;
+			total.faceVertices += counts[chunk].faceVertices;
+		}
+		records.positions.resize(total.positions);
+		records.texcoords.resize(total.texcoords);
+		records.normals.resize(total.normals);
+		records.faceVertices.resize(total.faceVertices);
+		records.faceStarts.resize(total.faces + 1);
+		records.faceStarts[total.faces] = total.faceVertices;
+
+		//3. 各チャンクを解析する。書き込む範囲は重ならないのでロックは要らない
+		std::vector<ObjChunkRecords> chunkRecords(chunkCount);
+		forEachChunk([&](size_t chunk) { ParseObj(bounds[chunk], bounds[chunk + 1], offsets[chunk], records, chunkRecords[chunk]); });
+
+		//4. チャンクの順につなげると、ファイルに書かれた順になる
+		//チャンクの先頭の状態は前のチャンクの最後の切り替えで決まるので、つなげたあとで辿れば逐次処理と同じになる
+		for (ObjChunkRecords& chunk : chunkRecords)
+		{
+			std::move(chunk.stateChanges.begin(), chunk.stateChanges.end(), std::back_inserter(records.stateChanges));
+			std::move(chunk.materialFilenames.begin(), chunk.materialFilenames.end(), std::back_inserter(records.materialFilenames));
+		}
+	}
+
+	//要素番号から頂点を組み立てる
+	//UVが省略されていれば(0, 0)、法線の番号がobjの法線の数を超えていればflatNormalsの面法線を使う
+	//法線の番号が0（スムージンググループの面で省略された）なら長さ0にしておき、後で GenerateNormals が埋める
+	VertexData MakeVertex(const ObjRecords& records, const std::vector<Vector3>& flatNormals, const ObjIndex& index)
+	{
+		assert(index.position >= 1 && size_t(index.position) <= records.positions.size());
+		assert(index.texcoord >= 0 && size_t(index.texcoord) <= records.texcoords.size());
+		assert(index.normal >= 0 && size_t(index.normal) <= records.normals.size() + flatNormals.size());
+		// 要素へのIndexから、実際の要素の値を取得して、頂点を構築する
+		Vector4 position = records.positions[size_t(index.position) - 1];
+		Vector2 texcoord{ 0.0f, 1.0f };
+		if (index.texcoord != 0)
+		{
+			texcoord = records.texcoords[size_t(index.texcoord) - 1];
+		}
+		Vector3 normal{ 0.0f, 0.0f, 0.0f };
+		if (index.normal != 0)
+		{
+			normal = size_t(index.normal) <= records.normals.size() ?
+				records.normals[size_t(index.normal) - 1] : flatNormals[size_t(index.normal) - records.normals.size() - 1];
+		}
+		position.x *= -1;
+		texcoord.y = 1.0f - texcoord.y;
+		normal.x *= -1;
+		return { position, texcoord, normal };
+	}
+
+	///==========================================================
+	/// 多角形を三角形に分ける
+	/// 凸多角形は0番の頂点からの扇形に、凹多角形は耳を1つずつ切り取って分ける
+	/// 作業用の配列は使い回すので、面ごとにメモリを確保しない
+	///==========================================================
+	class PolygonTriangulator
+	{
+	public:
+		//多角形の法線（Newell法）。大きさは面積の2倍になる
+		static Vector3 ComputeNormal(std::span<const Vector3> corners)
+		{
+			Vector3 normal{ 0.0f, 0.0f, 0.0f };
+			for (size_t i = 0; i < corners.size(); ++i)
+			{
+				const Vector3& a = corners[i];
+				const Vector3& b = corners[(i + 1) % corners.size()];
+				normal.x += (a.y - b.y) * (a.z + b.z);
+				normal.y += (a.z - b.z) * (a.x + b.x);
+				normal.z += (a.x - b.x) * (a.y + b.y);
+			}
+			return normal;
+		}
+
+		//cornersの多角形を三角形に分け、多角形の中での頂点番号を3つずつtrianglesに入れる
+		//巻き順は元の多角形と同じ。自己交差などで耳が見つからなくなったら残りを扇形にする
+		void Triangulate(std::span<const Vector3> corners, std::vector<uint32_t>& triangles)
+		{
+			const uint32_t count = uint32_t(corners.size());
+			triangles.clear();
+			if (count == 3)
+			{
+				triangles.insert(triangles.end(), { 0, 1, 2 });
+				return;
+			}
+
+			//法線の成分が一番大きい軸を落として2次元にする。法線の向きで表裏を合わせる
+			const Vector3 normal = ComputeNormal(corners);
+			const float ax = std::abs(normal.x);
+			const float ay = std::abs(normal.y);
+			const float az = std::abs(normal.z);
+			float orientation = 1.0f;
+			points_.clear();
+			for (const Vector3& corner : corners)
+			{
+				if (ax >= ay && ax >= az)
+				{
+					points_.push_back({ corner.y, corner.z });
+					orientation = normal.x < 0.0f ? -1.0f : 1.0f;
+				}
+				else if (ay >= az)
+				{
+					points_.push_back({ corner.z, corner.x });
+					orientation = normal.y < 0.0f ? -1.0f : 1.0f;
+				}
+				else
+				{
+					points_.push_back({ corner.x, corner.y });
+					orientation = normal.z < 0.0f ? -1.0f : 1.0f;
+				}
+			}
+
+			//凸多角形なら扇形で済む
+			bool isConvex = true;
+			for (uint32_t i = 0; i < count && isConvex; ++i)
+			{
+				isConvex = Cross(points_[(i + count - 1) % count], points_[i], points_[(i + 1) % count]) * orientation >= 0.0f;
+			}
+			remaining_.clear();
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				remaining_.push_back(i);
+			}
+
+			//凹多角形は、中に他の頂点を含まない凸の角（耳）を切り取っていく
+			while (!isConvex && remaining_.size() > 3)
+			{
+				const size_t size = remaining_.size();
+				bool clipped = false;
+				for (size_t k = 0; k < size && !clipped; ++k)
+				{
+					const size_t i = (k + 1) % size;
+					const uint32_t prev = remaining_[(i + size - 1) % size];
+					const uint32_t current = remaining_[i];
+					const uint32_t next = remaining_[(i + 1) % size];
+					if (IsEar(prev, current, next, orientation))
+					{
+						triangles.insert(triangles.end(), { prev, current, next });
+						remaining_.erase(remaining_.begin() + ptrdiff_t(i));
+						clipped = true;
+					}
+				}
+				if (!clipped)
+				{
+					break;
+				}
+			}
+			for (size_t i = 1; i + 1 < remaining_.size(); ++i)
+			{
+				triangles.insert(triangles.end(), { remaining_[0], remaining_[i], remaining_[i + 1] });
+			}
+		}
+
+	private:
+		//abとacの外積（acがabの左にあれば正）
+		static float Cross(const Vector2& a, const Vector2& b, const Vector2& c)
+		{
+			return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		}
+
+		//prev, current, next の角が耳か
+		bool IsEar(uint32_t prev, uint32_t current, uint32_t next, float orientation) const
+		{
+			const Vector2& a = points_[prev];
+			const Vector2& b = points_[current];
+			const Vector2& c = points_[next];
+			if (Cross(a, b, c) * orientation <= 0.0f)
+			{
+				return false;		// 凹んだ角か、一直線
+			}
+			for (const uint32_t other : remaining_)
+			{
+				const Vector2& p = points_[other];
+				if (other == prev || other == current || other == next || p == a || p == b || p == c)
+				{
+					continue;
+				}
+				//辺の上にある点も中にあるとみなす
+				if (Cross(a, b, p) * orientation >= 0.0f && Cross(b, c, p) * orientation >= 0.0f && Cross(c, a, p) * orientation >= 0.0f)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		std::vector<Vector2> points_;
+		std::vector<uint32_t> remaining_;
+	};
+
+	//要素番号の組のハッシュ値
+	uint32_t HashObjIndex(const ObjIndex& index)
+	{
+		uint32_t hash = uint32_t(index.position) * 0x9E3779B1u;
+		hash ^= uint32_t(index.texcoord) * 0x85EBCA77u;
+		hash ^= uint32_t(index.normal) * 0xC2B2AE3Du;
+		return hash ^ (hash >> 16);
+	}
+
+	///==========================================================
+	/// 「位置/UV/法線」の組から頂点番号を引くハッシュ表（オープンアドレス法）
+	/// 頂点番号だけを持ち、組そのものは頂点と同じ順番で keys に並べる
+	///==========================================================
+	class VertexTable
+	{
+	public:
+		explicit VertexTable(size_t expectedCount)
+		{
+			keys_.reserve(expectedCount);
+			Rehash(expectedCount * 2);
+		}
+
+		//組に対応する頂点番号を返す。まだ無ければ追加して isNew を立てる
+		uint32_t Insert(const ObjIndex& key, bool& isNew)
+		{
+			//埋まり具合が半分を超えたら広げる
+			if ((keys_.size() + 1) * 2 > slots_.size())
+			{
+				Rehash(slots_.size() * 2);
+			}
+			size_t slot = HashObjIndex(key) & mask_;
+			while (slots_[slot] != kEmpty)
+			{
+				if (keys_[slots_[slot]] == key)
+				{
+					isNew = false;
+					return slots_[slot];
+				}
+				slot = (slot + 1) & mask_;
+			}
+			slots_[slot] = uint32_t(keys_.size());
+			keys_.push_back(key);
+			isNew = true;
+			return slots_[slot];
+		}
+
+	private:
+		static constexpr uint32_t kEmpty = 0xFFFFFFFFu;
+
+		void Rehash(size_t minimumSize)
+		{
+			size_t size = 16;
+			while (size < minimumSize)
+			{
+				size <<= 1;
+			}
+			slots_.assign(size, kEmpty);
+			mask_ = size - 1;
+			for (uint32_t vertex = 0; vertex < uint32_t(keys_.size()); ++vertex)
+			{
+				size_t slot = HashObjIndex(keys_[vertex]) & mask_;
+				while (slots_[slot] != kEmpty)
+				{
+					slot = (slot + 1) & mask_;
+				}
+				slots_[slot] = vertex;
+			}
+		}
+
+		std::vector<uint32_t> slots_;
+		std::vector<ObjIndex> keys_;
+		size_t mask_ = 0;
+	};
+
+	///==========================================================
+	/// 同じオブジェクト・同じマテリアル・同じスムージンググループが続く面の範囲
+	///==========================================================
+	struct ObjFaceRun
+	{
+		size_t faceStart;
+		size_t faceEnd;
+		uint32_t materialIndex;
+		const std::string* name;
+		bool isSmooth;		// "s off" / "s 0" 以外のスムージンググループの中か
+	};
+
+	//名前からマテリアルの番号を引く。見つからなければその名前で既定のマテリアルを足す
+	uint32_t FindMaterial(std::vector<MaterialData>& materials, const std::string& name)
+	{
+		for (uint32_t materialIndex = 0; materialIndex < uint32_t(materials.size()); ++materialIndex)
+		{
+			if (materials[materialIndex].name == name)
+			{
+				return materialIndex;
+			}
+		}
+		materials.emplace_back().name = name;
+		return uint32_t(materials.size() - 1);
+	}
+
+	//状態の切り替えを辿って、面をオブジェクトとマテリアルとスムージンググループの組ごとの範囲に分ける
+	//範囲はマテリアルの番号の順に並べる（同じマテリアルの中ではファイルの順）
+	std::vector<ObjFaceRun> SplitFaceRuns(const ObjRecords& records, std::vector<MaterialData>& materials)
+	{
+		static const std::string kNoName;
+		const size_t faceCount = records.faceStarts.size() - 1;
+		std::vector<ObjFaceRun> runs;
+		ObjFaceRun run{ 0, 0, 0, &kNoName, false };
+		const std::string* materialName = &kNoName;
+		auto closeRun = [&](size_t faceEnd)
+			{
+				if (faceEnd > run.faceStart)
+				{
+					run.faceEnd = faceEnd;
+					run.materialIndex = FindMaterial(materials, *materialName);
+					runs.push_back(run);
+				}
+				run.faceStart = faceEnd;
+			};
+		for (const ObjStateChange& change : records.stateChanges)
+		{
+			closeRun(std::min(change.face, faceCount));
+			switch (change.kind)
+			{
+			case ObjStateChange::Kind::kMaterial:
+				materialName = &change.name;
+				break;
+			case ObjStateChange::Kind::kObject:
+				run.name = &change.name;
+				break;
+			case ObjStateChange::Kind::kSmoothing:
+				run.isSmooth = !change.name.empty() && change.name != "off" && change.name != "0";
+				break;
+			}
+		}
+		closeRun(faceCount);
+
+		std::stable_sort(runs.begin(), runs.end(), [](const ObjFaceRun& a, const ObjFaceRun& b) { return a.materialIndex < b.materialIndex; });
+		return runs;
+	}
+
+	//face番目の面の頂点を返す。位置の番号が範囲外の面は空を返す
+	//範囲外のUV・法線の番号は省略とみなし、法線が省略された頂点には面法線を作って割り当てる
+	//ただしスムージンググループの面（isSmooth）では法線の番号を0にして、隣の面と同じ頂点にまとめてから GenerateNormals で埋める
+	//直す必要があるときだけpolygonに写して直し、それ以外は元の配列をそのまま指す
+	//polygonPositionsは三角形に分けるときか面法線を作るときだけ埋める
+	std::span<const ObjIndex> GatherPolygon(const ObjRecords& records, size_t face, bool isSmooth, std::vector<ObjIndex>& polygon, std::vector<Vector3>& polygonPositions, std::vector<Vector3>& flatNormals)
+	{
+		const std::span<const ObjIndex> corners(records.faceVertices.data() + records.faceStarts[face], records.faceStarts[face + 1] - records.faceStarts[face]);
+		//番号-1を符号なしで比べると、0以下も数以上も1回の比較で弾ける
+		const size_t positionCount = records.positions.size();
+		const size_t texcoordCount = records.texcoords.size();
+		const size_t normalCount = records.normals.size();
+		bool hasMissingTexcoord = false;
+		bool hasMissingNormal = false;
+		for (const ObjIndex& index : corners)
+		{
+			if (size_t(uint32_t(index.position - 1)) >= positionCount)
+			{
+				return {};
+			}
+			hasMissingTexcoord |= size_t(uint32_t(index.texcoord)) > texcoordCount;
+			hasMissingNormal |= size_t(uint32_t(index.normal - 1)) >= normalCount;
+		}
+		polygonPositions.clear();
+		if (corners.size() > 3 || (hasMissingNormal && !isSmooth))
+		{
+			for (const ObjIndex& index : corners)
+			{
+				const Vector4& position = records.positions[size_t(index.position) - 1];
+				polygonPositions.push_back({ position.x, position.y, position.z });
+			}
+		}
+		if (!hasMissingTexcoord && !hasMissingNormal)
+		{
+			return corners;
+		}
+
+		//面法線の番号はobjの法線の後ろに続ける（面ごとに別の番号なので、隣の面と頂点がまとめられることはない）
+		polygon.assign(corners.begin(), corners.end());
+		int32_t flatNormal = 0;
+		if (hasMissingNormal && !isSmooth)
+		{
+			flatNormals.push_back(Nomalize(PolygonTriangulator::ComputeNormal(polygonPositions)));
+			flatNormal = int32_t(records.normals.size() + flatNormals.size());
+		}
+		for (ObjIndex& index : polygon)
+		{
+			if (size_t(uint32_t(index.texcoord)) > texcoordCount)
+			{
+				index.texcoord = 0;
+			}
+			if (size_t(uint32_t(index.normal - 1)) >= normalCount)
+			{
+				index.normal = flatNormal;
+			}
+		}
+		return polygon;
+	}
+
+	//面の情報から頂点とインデックスとサブメッシュを組み立てる
+	//多角形は三角形に分け、同じ「位置/UV/法線」の組は1つの頂点にまとめる
+	void BuildMesh(const ObjRecords& records, ModelData& modelData)
+	{
+		const std::vector<ObjFaceRun> runs = SplitFaceRuns(records, modelData.materials);
+		const size_t faceCount = records.faceStarts.size() - 1;
+		//頂点の数は分からないので、位置の数を目安にする（三角形の数はn角形ごとにn-2）
+		VertexTable table(records.positions.size());
+		modelData.vertices.reserve(records.positions.size());
+		modelData.indices.reserve((records.faceVertices.size() - faceCount * 2) * 3);
+
+		//面ごとに使う作業用の配列（使い回す）
+		PolygonTriangulator triangulator;
+		std::vector<ObjIndex> polygon;
+		std::vector<Vector3> polygonPositions;
+		std::vector<uint32_t> triangles;
+		std::vector<Vector3> flatNormals;
+		for (const ObjFaceRun& run : runs)
+		{
+			//直前と同じオブジェクト・マテリアルならサブメッシュをつなげる
+			const uint32_t indexStart = uint32_t(modelData.indices.size());
+			if (modelData.submeshes.empty() || modelData.submeshes.back().materialIndex != run.materialIndex || modelData.submeshes.back().name != *run.name)
+			{
+				modelData.submeshes.push_back({ *run.name, indexStart, 0, run.materialIndex });
+			}
+
+			for (size_t face = run.faceStart; face < run.faceEnd; ++face)
+			{
+				const std::span<const ObjIndex> corners = GatherPolygon(records, face, run.isSmooth, polygon, polygonPositions, flatNormals);
+				if (corners.empty())
+				{
+					continue;
+				}
+				//三角形はそのまま使う
+				static constexpr uint32_t kTriangle[] = { 0, 1, 2 };
+				std::span<const uint32_t> polygonTriangles = kTriangle;
+				if (corners.size() > 3)
+				{
+					triangulator.Triangulate(polygonPositions, triangles);
+					polygonTriangles = triangles;
+				}
+				for (size_t triangle = 0; triangle < polygonTriangles.size(); triangle += 3)
+				{
+					// 右手系から左手系にするので巻き順を逆にする
+					for (size_t faceVertex = 3; faceVertex-- > 0;)
+					{
+						const ObjIndex& index = corners[polygonTriangles[triangle + faceVertex]];
+						bool isNew = false;
+						const uint32_t vertex = table.Insert(index, isNew);
+						if (isNew)
+						{
+							modelData.vertices.push_back(MakeVertex(records, flatNormals, index));
+						}
+						modelData.indices.push_back(vertex);
+					}
+				}
+			}
+			modelData.submeshes.back().indexCount = uint32_t(modelData.indices.size()) - modelData.submeshes.back().indexStart;
+		}
+	}
+
+	//objファイルを解析してModelDataにする。参照していたmtlファイルの名前も返す
+	ModelData ParseObjFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount, std::vector<std::string>& materialFilenames)
+	{
+		ModelData modelData;
+		const std::vector<char> buffer = ReadFile(directoryPath + "/" + filename);
+		const char* begin = buffer.data();
+		const char* end = begin + buffer.size();
+
+		//1. 要素の数を数えて確保してから解析する
+		ObjRecords records;
+		ParseObjChunks(begin, end, threadCount, records);
+
+		//2. 基本的にobjファイルと同一階層にmtlは存在させるので、ディレクトリ名とファイル名を渡す
+		materialFilenames = records.materialFilenames;
+		for (const std::string& materialFilename : materialFilenames)
+		{
+			std::vector<MaterialData> materials = LoadMaterialTemplateFile(directoryPath, materialFilename);
+			std::move(materials.begin(), materials.end(), std::back_inserter(modelData.materials));
+		}
+
+		//3. 面の情報から頂点とインデックスとサブメッシュを組み立てる
+		BuildMesh(records, modelData);
+
+		//4. スムージンググループの面でvnの無かった頂点に滑らかな法線を作る（そのような頂点が無ければ何もしない）
+		GenerateNormals(modelData, false, threadCount);
+		return modelData;
+	}
+}
+
+std::vector<MaterialData> LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename)
+{
+	std::vector<MaterialData> materials;
+	const std::vector<char> buffer = ReadFile(directoryPath + "/" + filename);
+	const char* p = buffer.data();
+	const char* end = p + buffer.size();
+
+	while (p < end)
+	{
+		std::string_view identifier = ReadToken(p, end);
+
+		// identifierに応じた処理（newmtlより前の行は無視する）
+		if (identifier == "newmtl")
+		{
+			materials.emplace_back().name = ReadToken(p, end);
+		}
+		else if (!materials.empty())
+		{
+			MaterialData& material = materials.back();
+			if (identifier == "Kd")
+			{
+				material.diffuseColor.x = ReadFloat(p, end);
+				material.diffuseColor.y = ReadFloat(p, end);
+				material.diffuseColor.z = ReadFloat(p, end);
+			}
+			else if (identifier == "Ks")
+			{
+				material.specularColor.x = ReadFloat(p, end);
+				material.specularColor.y = ReadFloat(p, end);
+				material.specularColor.z = ReadFloat(p, end);
+			}
+			else if (identifier == "Ns")
+			{
+				material.shininess = ReadFloat(p, end);
+			}
+			else if (identifier == "d")
+			{
+				material.alpha = ReadFloat(p, end);
+			}
+			else if (identifier == "map_Kd")
+			{
+				std::string_view textureFilename = ReadToken(p, end);
+				//連結してファイルパスにする
+				material.textureFilePath = directoryPath + "/";
+				material.textureFilePath += textureFilename;
+			}
+		}
+		p = NextLine(p, end);
+	}
+	return materials;
+}
+
+ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount, std::vector<std::string>* materialFilenames)
+{
+	std::vector<std::string> filenames;
+	ModelData modelData = ParseObjFile(directoryPath, filename, threadCount, filenames);
+	if (materialFilenames)
+	{
+		*materialFilenames = std::move(filenames);
+	}
+	return modelData;
+}
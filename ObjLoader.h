@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ModelData.h"
+
+///==========================================================
+/// obj / mtl ファイルの読み込み
+/// ファイル全体を一度に読み、1行ずつの文字列を作らずに直接解析する
+///==========================================================
+
+//mtlファイルを読み込む。newmtlごとに1つのマテリアルになる
+std::vector<MaterialData> LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename);
+
+//objファイルを読み込む
+//threadCount: 解析に使うスレッド数。0ならCPUのコア数、1なら逐次処理（小さいファイルは常に逐次処理）
+//スレッド数によらず結果は同じになる
+//面は "v" / "v/vt" / "v//vn" / "v/vt/vn" と負の番号に対応し、多角形は三角形に分ける。UVが無ければ(0, 0)、法線が無ければ面法線になる
+//"s 1" などのスムージンググループ（"s off" / "s 0" 以外）の中でvnの無い面は、GenerateNormals で座標の同じ頂点と滑らかにつなぐ（グループの番号は区別しない）
+//o / g と usemtl ごとにサブメッシュを分け、マテリアルの順に並べる（usemtlの無い面は名前の無い既定のマテリアルになる）
+//LODとメッシュレットと接線は作らない（ModelData::lods / meshlets / tangentsは空。LODとメッシュレットは CookMesh、接線は GenerateTangents で作る）
+//materialFilenames: nullptrでなければ、mtllibに書かれていたmtlファイルの名前を受け取る
+ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount = 0, std::vector<std::string>* materialFilenames = nullptr);
@@ -7,6 +7,33 @@ struct TransformationMatrix
 };
 ConstantBuffer<TransformationMatrix> gTransformationMatrix : register(b0);
 
+#ifdef PACKED_VERTEX
+//圧縮した座標を元に戻す値（PackedVertexData.h の VertexQuantization）
+struct VertexQuantization
+{
+    float4 positionScale;
+    float4 positionOffset;
+};
+ConstantBuffer<VertexQuantization> gVertexQuantization : register(b1);
+
+//頂点シェーダーへの入力頂点構造（PackedVertexData）
+struct VertexShaderInput
+{
+    float4 position : POSITION0;    // R16G16B16A16_UNORM。メッシュの範囲で0～1
+    float2 texcoord : TEXCOORD0;    // R16G16_FLOAT
+    float2 normal : NORMAL0;        // R16G16_SNORM。八面体に写した法線
+};
+
+//八面体に写した法線を元に戻す（VertexPacking.cpp の DecodeOctahedral と同じ計算）
+float3 DecodeOctahedral(float2 encoded)
+{
+    float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float t = max(-normal.z, 0.0f);
+    normal.x -= (normal.x >= 0.0f ? 1.0f : -1.0f) * t;
+    normal.y -= (normal.y >= 0.0f ? 1.0f : -1.0f) * t;
+    return normalize(normal);
+}
+#else
 //頂点シェーダーへの入力頂点構造
 struct VertexShaderInput
 {
@@ -15,15 +42,23 @@ struct VertexShaderInput
     float2 texcoord : TEXCOORD0;
     float3 normal : NORMAL0;
 };
+#endif
 
 //頂点シェーダー
 VertexShaderOutput main(VertexShaderInput input)
 {
     VertexShaderOutput output;
-    
+
+#ifdef PACKED_VERTEX
+    float4 position = input.position * gVertexQuantization.positionScale + gVertexQuantization.positionOffset;
+    float3 normal = DecodeOctahedral(input.normal);
+#else
+    float4 position = input.position;
+    float3 normal = input.normal;
+#endif
     //入力された頂点座標を出職データに代入
-    output.position = mul(input.position, gTransformationMatrix.WVP);
+    output.position = mul(position, gTransformationMatrix.WVP);
     output.texcoord = input.texcoord;
-    output.normal = normalize(mul(input.normal, (float3x3) gTransformationMatrix.World));
+    output.normal = normalize(mul(normal, (float3x3) gTransformationMatrix.World));
     return output;
 }
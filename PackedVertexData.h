@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include "Vector4.h"
+
+///==========================================================
+/// 圧縮した頂点データ（16バイト。VertexDataの36バイトから半分以下になる）
+///==========================================================
+struct PackedVertexData
+{
+	uint16_t position[4];	// メッシュの範囲で正規化した座標（R16G16B16A16_UNORM、wは常に1）
+	uint16_t texcoord[2];	// 半精度浮動小数点数（R16G16_FLOAT）
+	int16_t normal[2];		// 八面体に写した法線（R16G16_SNORM）
+};
+///==========================================================
+/// 圧縮した頂点データ（16バイト。VertexDataの36バイトから半分以下になる）
+///==========================================================
+
+///==========================================================
+/// 圧縮した座標を元に戻す値（position * positionScale + positionOffset）
+///==========================================================
+struct VertexQuantization final
+{
+	Vector4 positionScale;		// メッシュの大きさ（wは0）
+	Vector4 positionOffset;		// メッシュの最小の座標（wは1）
+};
+///==========================================================
+/// 圧縮した座標を元に戻す値（position * positionScale + positionOffset）
+///==========================================================
\ No newline at end of file
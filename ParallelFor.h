@@ -0,0 +1,162 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///==========================================================
+/// 処理をいくつかのタスクに分けて、使い回すワーカースレッドで並列に行う
+/// ワーカースレッドは最初に使ったときに1度だけ（CPUのコア数-1個）作り、呼び出しのたびには作らない
+/// 呼んだスレッドもタスクを処理するので、タスクの中から呼んでも（ワーカーが全て埋まっていても）止まらない
+///==========================================================
+class WorkerPool
+{
+public:
+	//プログラム全体で1つのプール（ヘッダーの中で定義しているので、どの翻訳単位から呼んでも同じもの）
+	static WorkerPool& Get()
+	{
+		static WorkerPool pool;
+		return pool;
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stopping_ = true;
+		}
+		condition_.notify_all();
+		for (std::thread& thread : threads_)
+		{
+			thread.join();
+		}
+	}
+
+	uint32_t GetThreadCount() const { return uint32_t(threads_.size()); }
+
+	//[0, taskCount) のタスクごとに task(番号) を呼び、全て終わってから戻る。タスクが1つならそのまま呼ぶ
+	void Run(size_t taskCount, const std::function<void(size_t)>& task)
+	{
+		if (taskCount <= 1 || threads_.empty())
+		{
+			for (size_t index = 0; index < taskCount; index++)
+			{
+				task(index);
+			}
+			return;
+		}
+		const std::shared_ptr<Job> job = std::make_shared<Job>(task, taskCount);
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			jobs_.push_back(job);
+		}
+		condition_.notify_all();
+		RunTasks(*job);
+
+		//他のスレッドが処理中のタスクが終わるのを待つ
+		std::unique_lock<std::mutex> lock(mutex_);
+		finished_.wait(lock, [&]() { return job->doneCount == job->taskCount; });
+	}
+
+private:
+	//Run 1回分。nextで次のタスクの番号を配る
+	struct Job
+	{
+		Job(const std::function<void(size_t)>& task, size_t taskCount) : task(task), taskCount(taskCount) {}
+
+		const std::function<void(size_t)>& task;
+		const size_t taskCount;
+		std::atomic<size_t> next = 0;
+		size_t doneCount = 0;		// mutex_で守る
+	};
+
+	WorkerPool()
+	{
+		const uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+		for (uint32_t t = 0; t < threadCount; t++)
+		{
+			threads_.emplace_back(&WorkerPool::WorkerMain, this);
+		}
+	}
+
+	//jobのタスクを無くなるまで取って処理する
+	void RunTasks(Job& job)
+	{
+		size_t doneCount = 0;
+		for (size_t index = job.next++; index < job.taskCount; index = job.next++)
+		{
+			job.task(index);
+			doneCount++;
+		}
+		if (doneCount == 0)
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> lock(mutex_);
+		job.doneCount += doneCount;
+		if (job.doneCount == job.taskCount)
+		{
+			finished_.notify_all();
+		}
+	}
+
+	void WorkerMain()
+	{
+		for (;;)
+		{
+			std::shared_ptr<Job> job;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				condition_.wait(lock, [&]() { return stopping_ || !jobs_.empty(); });
+				if (jobs_.empty())
+				{
+					return;
+				}
+				//配り終えたジョブは行列から外し、まだ残っているものを取る
+				job = jobs_.front();
+				if (job->next >= job->taskCount)
+				{
+					jobs_.pop_front();
+					continue;
+				}
+			}
+			RunTasks(*job);
+		}
+	}
+
+	std::mutex mutex_;
+	std::condition_variable condition_;		// ジョブが来た
+	std::condition_variable finished_;		// ジョブのタスクが全て終わった
+	std::deque<std::shared_ptr<Job>> jobs_;
+	bool stopping_ = false;
+	std::vector<std::thread> threads_;
+};
+
+//threadCountが0ならCPUのコア数にする
+static uint32_t ResolveThreadCount(uint32_t threadCount)
+{
+	return threadCount != 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+}
+
+//[0, count) をminItemsPerRange個以上の連続した範囲（最大threadCount個、0ならCPUのコア数）に分けて、範囲ごとにfunc(begin, end)を呼ぶ
+//範囲の分け方はcountとthreadCountだけで決まる。1つの範囲ならそのまま呼ぶ
+template <typename Func>
+void ParallelFor(size_t count, uint32_t threadCount, size_t minItemsPerRange, Func&& func)
+{
+	const size_t rangeCount = std::clamp<size_t>(count / std::max<size_t>(minItemsPerRange, 1), 1, ResolveThreadCount(threadCount));
+	if (rangeCount == 1)
+	{
+		func(size_t(0), count);
+		return;
+	}
+	WorkerPool::Get().Run(rangeCount, [&](size_t range) { func(count * range / rangeCount, count * (range + 1) / rangeCount); });
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+/// <summary>
+/// クォータニオン
+/// </summary>
+struct Quaternion final {
+	float x;
+	float y;
+	float z;
+	float w;
+};
\ No newline at end of file
@@ -0,0 +1,315 @@
+#pragma once
+
+#include "Quaternion.h"
+#include "Vector3.h"
+#include "Matrix4x4.h"
+#include "Transform.h"
+#include "MatrixMath.h"
+#include <cassert>
+#include <cmath>
+#include <span>
+
+//単位クォータニオン
+static Quaternion IdentityQuaternion()
+{
+	return { 0.0f, 0.0f, 0.0f, 1.0f };
+}
+
+//積（lhsの回転のあとにrhsの回転をする。行列の Multiply(lhs, rhs) と同じ順番）
+//ハミルトン積で書くと rhs * lhs
+static Quaternion Multiply(const Quaternion& lhs, const Quaternion& rhs)
+{
+	Quaternion result{};
+	result.x = rhs.w * lhs.x + rhs.x * lhs.w + rhs.y * lhs.z - rhs.z * lhs.y;
+	result.y = rhs.w * lhs.y - rhs.x * lhs.z + rhs.y * lhs.w + rhs.z * lhs.x;
+	result.z = rhs.w * lhs.z + rhs.x * lhs.y - rhs.y * lhs.x + rhs.z * lhs.w;
+	result.w = rhs.w * lhs.w - rhs.x * lhs.x - rhs.y * lhs.y - rhs.z * lhs.z;
+	return result;
+}
+
+//共役
+static Quaternion Conjugate(const Quaternion& q)
+{
+	return { -q.x, -q.y, -q.z, q.w };
+}
+
+//内積
+static float Dot(const Quaternion& q1, const Quaternion& q2)
+{
+	return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+}
+
+//ノルム
+static float Norm(const Quaternion& q)
+{
+	return std::sqrt(Dot(q, q));
+}
+
+//正規化
+static Quaternion Normalize(const Quaternion& q)
+{
+	float norm = Norm(q);
+	Quaternion result{};
+	if (norm != 0.0f)
+	{
+		float invNorm = 1.0f / norm;
+		result.x = q.x * invNorm;
+		result.y = q.y * invNorm;
+		result.z = q.z * invNorm;
+		result.w = q.w * invNorm;
+	}
+	return result;
+}
+
+//逆クォータニオン
+static Quaternion Inverse(const Quaternion& q)
+{
+	float norm2 = Dot(q, q);
+	assert(norm2 != 0.0f);
+	float invNorm2 = 1.0f / norm2;
+	return { -q.x * invNorm2, -q.y * invNorm2, -q.z * invNorm2, q.w * invNorm2 };
+}
+
+//任意軸回転を表すクォータニオン（axisは正規化済みであること）
+static Quaternion MakeRotateAxisAngleQuaternion(const Vector3& axis, float angle)
+{
+	float s = std::sin(angle * 0.5f);
+	return { axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f) };
+}
+
+//オイラー角からクォータニオンを作る（MakeRotateMatrix(radian) と同じ X→Y→Z の順）
+static Quaternion MakeRotateQuaternion(const Vector3& radian)
+{
+	float sx = std::sin(radian.x * 0.5f), cx = std::cos(radian.x * 0.5f);
+	float sy = std::sin(radian.y * 0.5f), cy = std::cos(radian.y * 0.5f);
+	float sz = std::sin(radian.z * 0.5f), cz = std::cos(radian.z * 0.5f);
+
+	//Multiply(Multiply(qx, qy), qz) を展開したもの
+	Quaternion result{};
+	result.x = sx * cy * cz - cx * sy * sz;
+	result.y = cx * sy * cz + sx * cy * sz;
+	result.z = cx * cy * sz - sx * sy * cz;
+	result.w = cx * cy * cz + sx * sy * sz;
+	return result;
+}
+
+//ベクトルをクォータニオンで回転させる
+static Vector3 RotateVector(const Vector3& vector, const Quaternion& q)
+{
+	//v' = v + 2w(u×v) + 2u×(u×v)
+	Vector3 t{};
+	t.x = 2.0f * (q.y * vector.z - q.z * vector.y);
+	t.y = 2.0f * (q.z * vector.x - q.x * vector.z);
+	t.z = 2.0f * (q.x * vector.y - q.y * vector.x);
+	Vector3 result{};
+	result.x = vector.x + q.w * t.x + (q.y * t.z - q.z * t.y);
+	result.y = vector.y + q.w * t.y + (q.z * t.x - q.x * t.z);
+	result.z = vector.z + q.w * t.z + (q.x * t.y - q.y * t.x);
+	return result;
+}
+
+//クォータニオンから回転行列を作る（qは正規化済みであること）
+//MakeRotateMatrix(Vector3) と同じ名前にすると { } で書いた引数が曖昧になるので名前を分けている
+static Matrix4x4 MakeRotateMatrixQuaternion(const Quaternion& q)
+{
+	float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+	Matrix4x4 result{};
+	result.m[0][0] = 1.0f - 2.0f * (yy + zz);
+	result.m[0][1] = 2.0f * (xy + wz);
+	result.m[0][2] = 2.0f * (xz - wy);
+	result.m[1][0] = 2.0f * (xy - wz);
+	result.m[1][1] = 1.0f - 2.0f * (xx + zz);
+	result.m[1][2] = 2.0f * (yz + wx);
+	result.m[2][0] = 2.0f * (xz + wy);
+	result.m[2][1] = 2.0f * (yz - wx);
+	result.m[2][2] = 1.0f - 2.0f * (xx + yy);
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
+//三次元アフィン変換行列（回転をクォータニオンで指定する）
+//名前を分けているのは、MakeAffineMatrix(Vector3, Vector3, Vector3) と並べると { } で書いた引数が曖昧になるため
+static Matrix4x4 MakeAffineMatrixQuaternion(const Vector3& scale, const Quaternion& rotate, const Vector3& translate)
+{
+	Matrix4x4 result = MakeRotateMatrixQuaternion(rotate);
+	const float s[3] = { scale.x, scale.y, scale.z };
+	for (int i = 0; i < 3; i++)
+	{
+		result.m[i][0] *= s[i];
+		result.m[i][1] *= s[i];
+		result.m[i][2] *= s[i];
+	}
+	result.m[3][0] = translate.x;
+	result.m[3][1] = translate.y;
+	result.m[3][2] = translate.z;
+	return result;
+}
+
+//オイラー角のTransformを、回転をクォータニオンで持つTransformにする
+static QuaternionTransform MakeQuaternionTransform(const Transform& transform)
+{
+	return { transform.scale, MakeRotateQuaternion(transform.rotate), transform.translate };
+}
+
+//三次元アフィン変換行列（回転をクォータニオンで持つTransformから作る）
+static Matrix4x4 MakeAffineMatrix(const QuaternionTransform& transform)
+{
+	return MakeAffineMatrixQuaternion(transform.scale, transform.rotate, transform.translate);
+}
+
+//正規化線形補間
+static Quaternion Nlerp(const Quaternion& q0, const Quaternion& q1, float t)
+{
+	//最短経路で補間するために向きを揃える
+	float sign = Dot(q0, q1) < 0.0f ? -1.0f : 1.0f;
+	Quaternion result{};
+	result.x = q0.x + (sign * q1.x - q0.x) * t;
+	result.y = q0.y + (sign * q1.y - q0.y) * t;
+	result.z = q0.z + (sign * q1.z - q0.z) * t;
+	result.w = q0.w + (sign * q1.w - q0.w) * t;
+	return Normalize(result);
+}
+
+//球面線形補間
+static Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, float t)
+{
+	float dot = Dot(q0, q1);
+	Quaternion target = q1;
+	if (dot < 0.0f)
+	{
+		target = { -q1.x, -q1.y, -q1.z, -q1.w };
+		dot = -dot;
+	}
+
+	//ほぼ同じ向きの場合はsinθが0に近くなるのでNlerpで代用する
+	if (dot >= 0.9995f)
+	{
+		return Nlerp(q0, target, t);
+	}
+
+	float theta = std::acos(dot);
+	float invSinTheta = 1.0f / std::sin(theta);
+	float scale0 = std::sin((1.0f - t) * theta) * invSinTheta;
+	float scale1 = std::sin(t * theta) * invSinTheta;
+	Quaternion result{};
+	result.x = scale0 * q0.x + scale1 * target.x;
+	result.y = scale0 * q0.y + scale1 * target.y;
+	result.z = scale0 * q0.z + scale1 * target.z;
+	result.w = scale0 * q0.w + scale1 * target.w;
+	return result;
+}
+
+#if defined(MATRIXMATH_USE_SSE)
+//4個のクォータニオンを成分ごとのレジスタに読み込む
+static inline void LoadQuaternion4(const Quaternion* q, __m128& x, __m128& y, __m128& z, __m128& w)
+{
+	x = _mm_loadu_ps(&q[0].x);
+	y = _mm_loadu_ps(&q[1].x);
+	z = _mm_loadu_ps(&q[2].x);
+	w = _mm_loadu_ps(&q[3].x);
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+}
+
+//成分ごとのレジスタから4個のクォータニオンに書き込む
+static inline void StoreQuaternion4(Quaternion* q, __m128 x, __m128 y, __m128 z, __m128 w)
+{
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+	_mm_storeu_ps(&q[0].x, x);
+	_mm_storeu_ps(&q[1].x, y);
+	_mm_storeu_ps(&q[2].x, z);
+	_mm_storeu_ps(&q[3].x, w);
+}
+
+//4要素分のacos（入力は [0, 1]、誤差は 2e-8 程度）
+static inline __m128 Acos4(__m128 x)
+{
+	__m128 p = _mm_set1_ps(-0.0012624911f);
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(0.0066700901f));
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(-0.0170881256f));
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(0.0308918810f));
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(-0.0501743046f));
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(0.0889789874f));
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(-0.2145988016f));
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(1.5707963050f));
+	return _mm_mul_ps(p, _mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), x)));
+}
+
+//4個分の補間の共通処理。weight0, weight1 で混ぜてから正規化する
+static inline void BlendQuaternion4(const Quaternion* q0, const Quaternion* q1, Quaternion* out, bool spherical, float t)
+{
+	__m128 ax, ay, az, aw, bx, by, bz, bw;
+	LoadQuaternion4(q0, ax, ay, az, aw);
+	LoadQuaternion4(q1, bx, by, bz, bw);
+
+	//最短経路で補間するために内積が負のものは符号を反転する
+	__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+	const __m128 signMask = _mm_and_ps(dot, _mm_set1_ps(-0.0f));
+	bx = _mm_xor_ps(bx, signMask);
+	by = _mm_xor_ps(by, signMask);
+	bz = _mm_xor_ps(bz, signMask);
+	bw = _mm_xor_ps(bw, signMask);
+	dot = _mm_xor_ps(dot, signMask);
+
+	const __m128 vt = _mm_set1_ps(t);
+	__m128 weight0 = _mm_sub_ps(_mm_set1_ps(1.0f), vt);
+	__m128 weight1 = vt;
+	if (spherical)
+	{
+		//sin((1-t)θ)/sinθ, sin(tθ)/sinθ。ほぼ同じ向きのものは線形補間の重みのまま
+		const __m128 theta = Acos4(_mm_min_ps(dot, _mm_set1_ps(1.0f)));
+		__m128 sinTheta, sin0, sin1, unused;
+		SinCos4(theta, sinTheta, unused);
+		SinCos4(_mm_mul_ps(weight0, theta), sin0, unused);
+		SinCos4(_mm_mul_ps(vt, theta), sin1, unused);
+		const __m128 useSlerp = _mm_cmplt_ps(dot, _mm_set1_ps(0.9995f));
+		const __m128 invSinTheta = _mm_div_ps(_mm_set1_ps(1.0f), _mm_or_ps(sinTheta, _mm_andnot_ps(useSlerp, _mm_set1_ps(1.0f))));
+		weight0 = _mm_or_ps(_mm_and_ps(useSlerp, _mm_mul_ps(sin0, invSinTheta)), _mm_andnot_ps(useSlerp, weight0));
+		weight1 = _mm_or_ps(_mm_and_ps(useSlerp, _mm_mul_ps(sin1, invSinTheta)), _mm_andnot_ps(useSlerp, weight1));
+	}
+
+	__m128 rx = _mm_add_ps(_mm_mul_ps(ax, weight0), _mm_mul_ps(bx, weight1));
+	__m128 ry = _mm_add_ps(_mm_mul_ps(ay, weight0), _mm_mul_ps(by, weight1));
+	__m128 rz = _mm_add_ps(_mm_mul_ps(az, weight0), _mm_mul_ps(bz, weight1));
+	__m128 rw = _mm_add_ps(_mm_mul_ps(aw, weight0), _mm_mul_ps(bw, weight1));
+	const __m128 length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_add_ps(_mm_mul_ps(rz, rz), _mm_mul_ps(rw, rw)));
+	const __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length2));
+	StoreQuaternion4(out, _mm_mul_ps(rx, invLength), _mm_mul_ps(ry, invLength), _mm_mul_ps(rz, invLength), _mm_mul_ps(rw, invLength));
+}
+#endif
+
+//正規化線形補間（配列をまとめて補間する版）
+static void Nlerp(std::span<const Quaternion> q0, std::span<const Quaternion> q1, float t, std::span<Quaternion> out)
+{
+	assert(q0.size() == q1.size() && q0.size() <= out.size());
+	size_t i = 0;
+#if defined(MATRIXMATH_USE_SSE)
+	for (; i + 4 <= q0.size(); i += 4)
+	{
+		BlendQuaternion4(&q0[i], &q1[i], &out[i], false, t);
+	}
+#endif
+	for (; i < q0.size(); i++)
+	{
+		out[i] = Nlerp(q0[i], q1[i], t);
+	}
+}
+
+//球面線形補間（配列をまとめて補間する版）
+static void Slerp(std::span<const Quaternion> q0, std::span<const Quaternion> q1, float t, std::span<Quaternion> out)
+{
+	assert(q0.size() == q1.size() && q0.size() <= out.size());
+	size_t i = 0;
+#if defined(MATRIXMATH_USE_SSE)
+	for (; i + 4 <= q0.size(); i += 4)
+	{
+		BlendQuaternion4(&q0[i], &q1[i], &out[i], true, t);
+	}
+#endif
+	for (; i < q0.size(); i++)
+	{
+		out[i] = Slerp(q0[i], q1[i], t);
+	}
+}
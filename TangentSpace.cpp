@@ -0,0 +1,297 @@
+#include "TangentSpace.h"
+#include "ParallelFor.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+	//これより少ない三角形（頂点）はスレッドに分けても速くならない
+	static constexpr size_t kMinItemsPerThread = 16 * 1024;
+
+	//これより細長い三角形は重みを小さくする（面積の2倍 / 最も長い辺の2乗）
+	static constexpr float kThinTriangleShape = 1e-3f;
+
+	//重みの合計（ラジアン）がこれより小さい頂点は、法線の向きを隣の頂点からも決める
+	static constexpr float kMinNormalWeight = 0.1f;
+
+	static constexpr uint32_t kInvalidIndex = ~0u;
+
+	Vector3 PositionOf(const VertexData& vertex)
+	{
+		return { vertex.position.x, vertex.position.y, vertex.position.z };
+	}
+
+	//三角形の単位法線と、3つの角の重み（角の大きさ、ラジアン）を求める。corner番目の頂点の重みがweights[corner]になる
+	//多角形を分けたときにできる細い三角形は、法線の向きが座標の丸め誤差で決まるのに180度近い角を持つので、細さに合わせて重みを小さくする
+	//（細い三角形しか使わない頂点もあるので、捨てはしない）。面積が0の三角形はfalse
+	bool ComputeTriangleFrame(const Vector3 (&positions)[3], Vector3& normal, float (&weights)[3])
+	{
+		const Vector3 edges[3] = {
+			Subtract(positions[1], positions[0]),
+			Subtract(positions[2], positions[1]),
+			Subtract(positions[0], positions[2]) };
+		const Vector3 cross = Cross(edges[0], Multiply(-1.0f, edges[2]));
+		const float crossLength = Length(cross);
+		if (!(crossLength > 0.0f) || !std::isfinite(crossLength))
+		{
+			return false;
+		}
+		normal = Multiply(1.0f / crossLength, cross);
+		//面積の2倍と最も長い辺の2乗の比（細長いほど小さい）
+		const float longestSquared = std::max({ Dot(edges[0], edges[0]), Dot(edges[1], edges[1]), Dot(edges[2], edges[2]) });
+		const float shapeScale = std::min(1.0f, crossLength / (kThinTriangleShape * longestSquared));
+		const Vector3 units[3] = { Nomalize(edges[0]), Nomalize(edges[1]), Nomalize(edges[2]) };
+		for (int corner = 0; corner < 3; corner++)
+		{
+			//角から出る2つの辺は、edges[corner]と前の辺の逆向き
+			weights[corner] = shapeScale * std::acos(std::clamp(-Dot(units[corner], units[(corner + 2) % 3]), -1.0f, 1.0f));
+		}
+		return true;
+	}
+
+	//normalに直交する単位ベクトル（接線が決まらない頂点に使う）
+	Vector3 AnyPerpendicular(const Vector3& normal)
+	{
+		const Vector3 axis = std::abs(normal.y) < 0.99f ? Vector3{ 0.0f, 1.0f, 0.0f } : Vector3{ 1.0f, 0.0f, 0.0f };
+		return Nomalize(Cross(axis, normal));
+	}
+
+	///==========================================================
+	/// 頂点（または頂点のまとまり）ごとに、それを使う角の番号を並べた表
+	/// 角は番号の小さい順に並ぶので、足し合わせる順番はスレッド数によらない
+	/// （まとまりごとの頂点の表にも使う）
+	///==========================================================
+	struct CornerTable
+	{
+		std::vector<uint32_t> starts;	// keyCount + 1個
+		std::vector<uint32_t> corners;
+
+		CornerTable(std::span<const uint32_t> cornerKeys, size_t keyCount)
+			: starts(keyCount + 1, 0), corners(cornerKeys.size())
+		{
+			for (const uint32_t key : cornerKeys)
+			{
+				++starts[key + 1];
+			}
+			std::partial_sum(starts.begin(), starts.end(), starts.begin());
+			std::vector<uint32_t> cursor(starts.begin(), starts.end() - 1);
+			for (size_t corner = 0; corner < cornerKeys.size(); corner++)
+			{
+				corners[cursor[cornerKeys[corner]]++] = uint32_t(corner);
+			}
+		}
+
+		std::span<const uint32_t> Get(size_t key) const
+		{
+			return { corners.data() + starts[key], corners.data() + starts[key + 1] };
+		}
+	};
+}
+
+void GenerateNormals(ModelData& modelData, bool overwrite, uint32_t threadCount)
+{
+	std::vector<VertexData>& vertices = modelData.vertices;
+	auto needsNormal = [&](const VertexData& vertex)
+		{
+			return overwrite || Dot(vertex.normal, vertex.normal) == 0.0f;
+		};
+	if (std::none_of(vertices.begin(), vertices.end(), needsNormal))
+	{
+		return;
+	}
+	const std::span<const uint32_t> indices(modelData.indices.data(), BaseIndexCount(modelData));
+
+	//1. 座標が同じ頂点をまとめる（座標のビット列で比べるので、-0と+0以外は完全に一致したものだけ）
+	//まとまりの番号は最初に出てきた順に振り、まとまりの頂点はgroupMembersに番号の小さい順に並べる
+	std::vector<uint32_t> groupOf(vertices.size());
+	size_t groupCount = 0;
+	{
+		auto positionKey = [&](size_t vertex)
+			{
+				const Vector4& position = vertices[vertex].position;
+				return std::array<uint32_t, 3>{ std::bit_cast<uint32_t>(position.x + 0.0f), std::bit_cast<uint32_t>(position.y + 0.0f), std::bit_cast<uint32_t>(position.z + 0.0f) };
+			};
+		//オープンアドレス法のハッシュ表（まとまりの最初の頂点の番号を持つ）
+		const size_t tableSize = std::bit_ceil(vertices.size() * 2 + 1);
+		std::vector<uint32_t> table(tableSize, kInvalidIndex);
+		for (size_t vertex = 0; vertex < vertices.size(); vertex++)
+		{
+			const std::array<uint32_t, 3> key = positionKey(vertex);
+			uint32_t hash = key[0] * 0x9E3779B1u ^ key[1] * 0x85EBCA77u ^ key[2] * 0xC2B2AE3Du;
+			hash ^= hash >> 16;
+			for (size_t slot = hash & (tableSize - 1);; slot = (slot + 1) & (tableSize - 1))
+			{
+				if (table[slot] == kInvalidIndex)
+				{
+					table[slot] = uint32_t(vertex);
+					groupOf[vertex] = uint32_t(groupCount++);
+					break;
+				}
+				if (positionKey(table[slot]) == key)
+				{
+					groupOf[vertex] = groupOf[table[slot]];
+					break;
+				}
+			}
+		}
+	}
+	const CornerTable groupMembers(groupOf, groupCount);
+
+	//2. 三角形ごとに、角の大きさを掛けた面法線を角ごとに求める
+	//埋める頂点の角だけを使う（vnのある面や面法線の面は、同じ座標の頂点の向きを変えない）
+	std::vector<Vector3> cornerNormals(indices.size());
+	ParallelFor(indices.size() / 3, threadCount, kMinItemsPerThread, [&](size_t begin, size_t end)
+		{
+			for (size_t triangle = begin; triangle < end; triangle++)
+			{
+				const uint32_t* corners = indices.data() + triangle * 3;
+				const Vector3 positions[3] = { PositionOf(vertices[corners[0]]), PositionOf(vertices[corners[1]]), PositionOf(vertices[corners[2]]) };
+				//表の面から見てcross(b - a, c - a)が手前を向く
+				Vector3 faceNormal{ 0.0f, 0.0f, 0.0f };
+				float weights[3] = { 0.0f, 0.0f, 0.0f };
+				ComputeTriangleFrame(positions, faceNormal, weights);
+				for (int corner = 0; corner < 3; corner++)
+				{
+					const float weight = needsNormal(vertices[corners[corner]]) ? weights[corner] : 0.0f;
+					cornerNormals[triangle * 3 + corner] = Multiply(weight, faceNormal);
+				}
+			}
+		});
+
+	//3. 座標のまとまりごとに足し合わせる
+	std::vector<uint32_t> cornerGroups(indices.size());
+	for (size_t corner = 0; corner < indices.size(); corner++)
+	{
+		cornerGroups[corner] = groupOf[indices[corner]];
+	}
+	const CornerTable table(cornerGroups, groupCount);
+	std::vector<Vector3> groupSums(groupCount);
+	ParallelFor(groupCount, threadCount, kMinItemsPerThread, [&](size_t begin, size_t end)
+		{
+			for (size_t group = begin; group < end; group++)
+			{
+				Vector3 sum{ 0.0f, 0.0f, 0.0f };
+				for (const uint32_t corner : table.Get(group))
+				{
+					sum = Add(sum, cornerNormals[corner]);
+				}
+				groupSums[group] = sum;
+			}
+		});
+
+	//4. 細い三角形にしか使われていないまとまり（多角形の一直線に並んだ頂点など）は、隣のまとまりの値も足して向きを決める
+	//それでも決まらなければ上向きにする（長さ0のままだとシェーダーで壊れる）
+	std::vector<Vector3> groupNormals(groupCount);
+	ParallelFor(groupCount, threadCount, kMinItemsPerThread, [&](size_t begin, size_t end)
+		{
+			for (size_t group = begin; group < end; group++)
+			{
+				Vector3 sum = groupSums[group];
+				if (Length(sum) < kMinNormalWeight)
+				{
+					for (const uint32_t corner : table.Get(group))
+					{
+						const size_t triangle = corner / 3;
+						sum = Add(sum, groupSums[cornerGroups[triangle * 3 + (corner + 1) % 3]]);
+						sum = Add(sum, groupSums[cornerGroups[triangle * 3 + (corner + 2) % 3]]);
+					}
+				}
+				groupNormals[group] = Dot(sum, sum) > 0.0f ? Nomalize(sum) : Vector3{ 0.0f, 1.0f, 0.0f };
+			}
+		});
+
+	//5. まとまりの頂点に書き込む
+	ParallelFor(groupCount, threadCount, kMinItemsPerThread, [&](size_t begin, size_t end)
+		{
+			for (size_t group = begin; group < end; group++)
+			{
+				for (const uint32_t member : groupMembers.Get(group))
+				{
+					VertexData& vertex = vertices[member];
+					if (needsNormal(vertex))
+					{
+						vertex.normal = groupNormals[group];
+					}
+				}
+			}
+		});
+}
+
+void GenerateTangents(ModelData& modelData, uint32_t threadCount)
+{
+	const std::vector<VertexData>& vertices = modelData.vertices;
+	const std::span<const uint32_t> indices(modelData.indices.data(), BaseIndexCount(modelData));
+
+	//1. 三角形ごとに、uが増える向きを角の頂点の法線に直交させ、角の大きさを掛けて角ごとに求める
+	//wにはUVの向き（表なら+、鏡映なら-）に角の大きさを掛けたものを入れる
+	std::vector<Vector4> cornerTangents(indices.size());
+	ParallelFor(indices.size() / 3, threadCount, kMinItemsPerThread, [&](size_t begin, size_t end)
+		{
+			for (size_t triangle = begin; triangle < end; triangle++)
+			{
+				const uint32_t* corners = indices.data() + triangle * 3;
+				const VertexData* triangleVertices[3] = { &vertices[corners[0]], &vertices[corners[1]], &vertices[corners[2]] };
+				const Vector3 positions[3] = { PositionOf(*triangleVertices[0]), PositionOf(*triangleVertices[1]), PositionOf(*triangleVertices[2]) };
+				const Vector3 edge1 = Subtract(positions[1], positions[0]);
+				const Vector3 edge2 = Subtract(positions[2], positions[0]);
+				const float du1 = triangleVertices[1]->texcoord.x - triangleVertices[0]->texcoord.x;
+				const float dv1 = triangleVertices[1]->texcoord.y - triangleVertices[0]->texcoord.y;
+				const float du2 = triangleVertices[2]->texcoord.x - triangleVertices[0]->texcoord.x;
+				const float dv2 = triangleVertices[2]->texcoord.y - triangleVertices[0]->texcoord.y;
+				//UVの面積（符号付き）。符号がUVの向きになる
+				const float signedArea = du1 * dv2 - du2 * dv1;
+				//uの勾配の向き（長さはUVの面積の分だけずれるが、向きだけ使う）
+				Vector3 faceTangent = Subtract(Multiply(dv2, edge1), Multiply(dv1, edge2));
+				if (signedArea < 0.0f)
+				{
+					faceTangent = Multiply(-1.0f, faceTangent);
+				}
+				Vector3 faceNormal;
+				float weights[3];
+				//面積の無い三角形とUVが潰れた三角形は向きが決まらないので足さない
+				const bool hasFrame = ComputeTriangleFrame(positions, faceNormal, weights) && signedArea != 0.0f;
+				for (int corner = 0; corner < 3; corner++)
+				{
+					Vector4& result = cornerTangents[triangle * 3 + corner];
+					const Vector3 normal = Nomalize(triangleVertices[corner]->normal);
+					const Vector3 tangent = Nomalize(Subtract(faceTangent, Multiply(Dot(faceTangent, normal), normal)));
+					if (!hasFrame || Dot(tangent, tangent) == 0.0f)
+					{
+						result = { 0.0f, 0.0f, 0.0f, 0.0f };
+						continue;
+					}
+					const float weight = weights[corner];
+					result = { tangent.x * weight, tangent.y * weight, tangent.z * weight, signedArea > 0.0f ? weight : -weight };
+				}
+			}
+		});
+
+	//2. 頂点ごとに足し合わせて、法線に直交させ直してから正規化する
+	const CornerTable table(indices, vertices.size());
+	modelData.tangents.resize(vertices.size());
+	ParallelFor(vertices.size(), threadCount, kMinItemsPerThread, [&](size_t begin, size_t end)
+		{
+			for (size_t vertex = begin; vertex < end; vertex++)
+			{
+				Vector4 sum{ 0.0f, 0.0f, 0.0f, 0.0f };
+				for (const uint32_t corner : table.Get(vertex))
+				{
+					sum += cornerTangents[corner];
+				}
+				const Vector3 normal = Nomalize(vertices[vertex].normal);
+				Vector3 tangent{ sum.x, sum.y, sum.z };
+				tangent = Nomalize(Subtract(tangent, Multiply(Dot(tangent, normal), normal)));
+				if (Dot(tangent, tangent) == 0.0f)
+				{
+					tangent = AnyPerpendicular(normal);
+				}
+				//向きの違う三角形が混ざる頂点（鏡映の継ぎ目）は、角の大きさの合計が大きい方に合わせる
+				modelData.tangents[vertex] = { tangent.x, tangent.y, tangent.z, sum.w < 0.0f ? -1.0f : 1.0f };
+			}
+		});
+}
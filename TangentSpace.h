@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include "ModelData.h"
+
+///==========================================================
+/// 頂点の法線と接線の生成
+/// 三角形の範囲ごとにスレッドで角の値を求め、頂点の範囲ごとにその頂点の角の値を足し合わせる
+/// 足す順番は三角形の順に決まっているので、スレッド数によらず結果は同じになる
+/// 元のメッシュ（ModelData::submeshesの範囲）の三角形だけを使い、LODの三角形は使わない
+///==========================================================
+
+//角の大きさで重み付けした面法線を足し合わせて、滑らかな法線を作る（多角形を分けてできた細い三角形は重みを小さくする）
+//座標が同じ頂点はUVが違っても同じ法線になる（UVの継ぎ目で陰影が切れない）
+//overwrite: falseなら長さが0の法線（objのスムージンググループの面でvnが無かった頂点）だけを、その頂点を使う角だけから埋める
+//threadCount: 0ならCPUのコア数、1なら逐次処理
+void GenerateNormals(ModelData& modelData, bool overwrite = false, uint32_t threadCount = 0);
+
+//ModelData::tangentsを作る
+//MikkTSpaceとは結果が一致しない（UVの向きが混ざる頂点を分けずに角の大きさの合計が大きい方に合わせる、足すときの重みも違う）
+//MikkTSpaceの接線で焼いた法線マップを使うと、陰影が少しずれることがある
+//面ごとにuが増える向きを求めて頂点の法線に直交するよう射影し、角の大きさで重み付けして足す
+//wはUVの向き（鏡映なら-1）で、従法線は w * cross(normal, tangent.xyz) になる
+//法線が揃ってから呼ぶ。頂点の並べ替え（OptimizeMesh）の後に呼ぶ
+void GenerateTangents(ModelData& modelData, uint32_t threadCount = 0);
@@ -0,0 +1,191 @@
+#include "TextureLoader.h"
+#include <algorithm>
+#include <filesystem>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#endif
+
+namespace
+{
+	//ファイル名をDirectXTexに渡す形にする（UTF-8として読む）
+	std::wstring ToWidePath(const std::string& path)
+	{
+#if defined(_WIN32)
+		const int size = MultiByteToWideChar(CP_UTF8, 0, path.data(), int(path.size()), nullptr, 0);
+		std::wstring result(size, L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, path.data(), int(path.size()), result.data(), size);
+		return result;
+#else
+		return std::filesystem::path(path).wstring();
+#endif
+	}
+}
+
+bool LoadTextureFile(const std::string& filePath, const TextureManifest& textureManifest, DirectX::ScratchImage& mipImages)
+{
+	//TextureCookerで変換済みなら、圧縮とミップマップの作成が済んだddsをそのまま読む
+	const std::string cookedPath = textureManifest.FindCooked(filePath);
+	if (!cookedPath.empty() && SUCCEEDED(DirectX::LoadFromDDSFile(ToWidePath(cookedPath).c_str(), DirectX::DDS_FLAGS_NONE, nullptr, mipImages)))
+	{
+		return true;
+	}
+
+#if defined(_WIN32)
+	//テクスチャファイルを呼んでプログラムで扱えるようにする
+	DirectX::ScratchImage image{};
+	HRESULT hr = DirectX::LoadFromWICFile(ToWidePath(filePath).c_str(), DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
+	if (FAILED(hr))
+	{
+		return false;
+	}
+
+	//ミップマップの作成（1x1は作るものが無い）
+	const DirectX::TexMetadata& metadata = image.GetMetadata();
+	if (metadata.width == 1 && metadata.height == 1)
+	{
+		mipImages = std::move(image);
+		return true;
+	}
+	hr = DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), metadata, DirectX::TEX_FILTER_SRGB, 0, mipImages);
+	return SUCCEEDED(hr);
+#else
+	//WICはWindowsにしか無いので、それ以外は変換済みのddsだけを読める
+	return false;
+#endif
+}
+
+TextureLoader::TextureLoader(LoadFunction loadFunction, uint32_t threadCount)
+	: loadFunction_(std::move(loadFunction))
+{
+	if (threadCount == 0)
+	{
+		threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+	for (uint32_t t = 0; t < threadCount; t++)
+	{
+		threads_.emplace_back(&TextureLoader::WorkerMain, this);
+	}
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	condition_.notify_all();
+	for (std::thread& thread : threads_)
+	{
+		thread.join();
+	}
+}
+
+TextureLoader::RequestId TextureLoader::Request(const std::string& filePath, int32_t priority, Callback callback)
+{
+	RequestId id;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		id = nextId_++;
+		requests_.emplace(id, RequestState{ filePath, priority, false, std::move(callback) });
+		queue_.push({ priority, nextSequence_++, id });
+	}
+	condition_.notify_one();
+	return id;
+}
+
+void TextureLoader::SetPriority(RequestId id, int32_t priority)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = requests_.find(id);
+	if (it == requests_.end() || it->second.started || it->second.priority == priority)
+	{
+		return;
+	}
+	//古い方は取り出したときに捨てる
+	it->second.priority = priority;
+	queue_.push({ priority, nextSequence_++, id });
+}
+
+size_t TextureLoader::DispatchCompleted()
+{
+	std::vector<Completion> completions;
+	std::vector<Callback> callbacks;
+	std::vector<std::string> filePaths;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		completions.swap(completions_);
+		for (const Completion& completion : completions)
+		{
+			auto it = requests_.find(completion.id);
+			callbacks.push_back(std::move(it->second.callback));
+			filePaths.push_back(std::move(it->second.filePath));
+			requests_.erase(it);
+		}
+	}
+	//コールバックの中で新しく要求できるように、ロックの外で呼ぶ
+	for (size_t i = 0; i < completions.size(); i++)
+	{
+		if (callbacks[i])
+		{
+			callbacks[i](filePaths[i], completions[i].image, completions[i].succeeded);
+		}
+	}
+	return completions.size();
+}
+
+size_t TextureLoader::GetPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return requests_.size();
+}
+
+void TextureLoader::WorkerMain()
+{
+#if defined(_WIN32)
+	//WICを使うスレッドごとに必要
+	const HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+	while (true)
+	{
+		RequestId id;
+		std::string filePath;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [&]() { return stopping_ || !queue_.empty(); });
+			if (stopping_)
+			{
+				break;
+			}
+			const QueueEntry entry = queue_.top();
+			queue_.pop();
+			//SetPriorityで積み直した古い方（読み終わって要求が消えていることもある）
+			auto it = requests_.find(entry.id);
+			if (it == requests_.end() || it->second.started || it->second.priority != entry.priority)
+			{
+				continue;
+			}
+			it->second.started = true;
+			id = entry.id;
+			filePath = it->second.filePath;
+		}
+
+		Completion completion{ id, DirectX::ScratchImage{}, false };
+		completion.succeeded = loadFunction_(filePath, completion.image);
+		if (!completion.succeeded)
+		{
+			completion.image.Release();
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		completions_.push_back(std::move(completion));
+	}
+#if defined(_WIN32)
+	if (SUCCEEDED(comResult))
+	{
+		CoUninitialize();
+	}
+#endif
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "externals/DirectXTex/DirectXTex.h"
+#include "TextureManifest.h"
+
+//テクスチャを読む（変換済みの dds があればそれを、無ければ png を読んでミップマップを作る）。読めなければfalse
+bool LoadTextureFile(const std::string& filePath, const TextureManifest& textureManifest, DirectX::ScratchImage& mipImages);
+
+///==========================================================
+/// テクスチャの非同期読み込み
+/// 読み込み（展開とミップマップの作成）はワーカースレッドで行い、優先度の高い要求から順に処理する
+/// 読み終わったものは DispatchCompleted を呼んだスレッド（描画のスレッド）でコールバックに渡すので
+/// コールバックの中でそのままリソースを作って転送できる。それまではプレースホルダーを使う
+///==========================================================
+class TextureLoader
+{
+public:
+	using RequestId = uint32_t;
+	//読み込みが終わったときに呼ばれる。succeededがfalseならimageは空
+	using Callback = std::function<void(const std::string& filePath, DirectX::ScratchImage& image, bool succeeded)>;
+	//要求を読む関数（既定は LoadTextureFile）
+	using LoadFunction = std::function<bool(const std::string& filePath, DirectX::ScratchImage& image)>;
+
+	//優先度の目安。大きいほど先に読む
+	static constexpr int32_t kPriorityVisible = 100;	// 画面に出ている
+	static constexpr int32_t kPriorityDefault = 0;		// まだ画面に出ていない
+
+	//threadCount: 0ならCPUのコア数-1（描画のスレッドの分を空ける）
+	TextureLoader(LoadFunction loadFunction, uint32_t threadCount = 0);
+	~TextureLoader();
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	//読み込みを頼む。すぐに戻る
+	RequestId Request(const std::string& filePath, int32_t priority, Callback callback);
+
+	//まだ読み始めていない要求の優先度を変える（見えるようになったものを先に読む）
+	void SetPriority(RequestId id, int32_t priority);
+
+	//読み終わった要求のコールバックを、要求した順ではなく読み終わった順に呼ぶ。毎フレーム呼ぶ
+	//呼んだコールバックの数を返す
+	size_t DispatchCompleted();
+
+	//コールバックをまだ呼んでいない要求の数
+	size_t GetPendingCount() const;
+
+	uint32_t GetThreadCount() const { return uint32_t(threads_.size()); }
+
+private:
+	//待ち行列の1件。優先度が同じなら先に頼んだものから
+	struct QueueEntry
+	{
+		int32_t priority;
+		uint64_t sequence;
+		RequestId id;
+		bool operator<(const QueueEntry& other) const
+		{
+			return priority != other.priority ? priority < other.priority : sequence > other.sequence;
+		}
+	};
+
+	//要求1件
+	struct RequestState
+	{
+		std::string filePath;
+		int32_t priority;
+		bool started;
+		Callback callback;
+	};
+
+	//読み終わった要求1件
+	struct Completion
+	{
+		RequestId id;
+		DirectX::ScratchImage image;
+		bool succeeded;
+	};
+
+	void WorkerMain();
+
+	LoadFunction loadFunction_;
+	mutable std::mutex mutex_;
+	std::condition_variable condition_;
+	std::priority_queue<QueueEntry> queue_;		// SetPriorityで古くなったものも残るので、取り出すときに確かめる
+	std::unordered_map<RequestId, RequestState> requests_;
+	std::vector<Completion> completions_;
+	RequestId nextId_ = 0;
+	uint64_t nextSequence_ = 0;
+	bool stopping_ = false;
+	std::vector<std::thread> threads_;
+};
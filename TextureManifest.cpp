@@ -0,0 +1,170 @@
+#include "TextureManifest.h"
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include "MappedFile.h"
+
+namespace
+{
+	static constexpr std::string_view kMagic = "TextureManifest";
+
+	//タブで区切った次の欄を取り出す
+	std::string_view NextField(std::string_view& line)
+	{
+		const size_t tab = line.find('\t');
+		std::string_view field = line.substr(0, tab);
+		line = tab == std::string_view::npos ? std::string_view{} : line.substr(tab + 1);
+		return field;
+	}
+
+	//1行を読む。欄が足りなければfalse
+	bool ParseEntry(std::string_view line, TextureManifestEntry& entry)
+	{
+		const std::string_view sourcePath = NextField(line);
+		const std::string_view hash = NextField(line);
+		const std::string_view format = NextField(line);
+		const std::string_view cookedPath = NextField(line);
+		if (sourcePath.empty() || format.empty() || cookedPath.empty())
+		{
+			return false;
+		}
+		const auto [end, error] = std::from_chars(hash.data(), hash.data() + hash.size(), entry.sourceHash, 16);
+		if (error != std::errc{} || end != hash.data() + hash.size())
+		{
+			return false;
+		}
+		entry.sourcePath = sourcePath;
+		entry.format = format;
+		entry.cookedPath = cookedPath;
+		return true;
+	}
+}
+
+bool TextureManifest::Load(const std::string& path)
+{
+	entries_.clear();
+	std::ifstream file(path);
+	if (!file)
+	{
+		return false;
+	}
+	std::string line;
+	if (!std::getline(file, line) || line != std::string(kMagic) + " " + std::to_string(kTextureManifestVersion))
+	{
+		return false;
+	}
+	while (std::getline(file, line))
+	{
+		//Windowsで書いたファイルの改行
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+		TextureManifestEntry entry{};
+		if (ParseEntry(line, entry))
+		{
+			Set(entry);
+		}
+	}
+	return true;
+}
+
+bool TextureManifest::Save(const std::string& path) const
+{
+	//一時ファイルに書いてから置き換える
+	const std::string temporaryPath = path + ".tmp";
+	std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	bool written = std::fprintf(file, "%s %u\n", kMagic.data(), kTextureManifestVersion) > 0;
+	for (const TextureManifestEntry& entry : entries_)
+	{
+		written = written && std::fprintf(file, "%s\t%016llx\t%s\t%s\n",
+			entry.sourcePath.c_str(), static_cast<unsigned long long>(entry.sourceHash), entry.format.c_str(), entry.cookedPath.c_str()) > 0;
+	}
+	written = std::fclose(file) == 0 && written;
+
+	std::error_code error;
+	if (written)
+	{
+		std::filesystem::rename(temporaryPath, path, error);
+	}
+	if (!written || error)
+	{
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+	return true;
+}
+
+const TextureManifestEntry* TextureManifest::Find(const std::string& sourcePath) const
+{
+	const std::string key = NormalizeTexturePath(sourcePath);
+	for (const TextureManifestEntry& entry : entries_)
+	{
+		if (entry.sourcePath == key)
+		{
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+void TextureManifest::Set(const TextureManifestEntry& entry)
+{
+	TextureManifestEntry normalized = entry;
+	normalized.sourcePath = NormalizeTexturePath(entry.sourcePath);
+	normalized.cookedPath = NormalizeTexturePath(entry.cookedPath);
+	for (TextureManifestEntry& existing : entries_)
+	{
+		if (existing.sourcePath == normalized.sourcePath)
+		{
+			existing = normalized;
+			return;
+		}
+	}
+	entries_.push_back(normalized);
+}
+
+std::string TextureManifest::FindCooked(const std::string& sourcePath) const
+{
+	const TextureManifestEntry* entry = Find(sourcePath);
+	std::error_code error;
+	if (!entry || !std::filesystem::is_regular_file(entry->cookedPath, error))
+	{
+		return {};
+	}
+	//元の画像が変わっていたら古いddsは使わない（png の展開よりハッシュ値の計算のほうがずっと速い）
+	if (std::filesystem::exists(entry->sourcePath, error) && HashTextureFile(entry->sourcePath) != entry->sourceHash)
+	{
+		return {};
+	}
+	return entry->cookedPath;
+}
+
+std::string NormalizeTexturePath(const std::string& path)
+{
+	std::string generic = path;
+	for (char& c : generic)
+	{
+		if (c == '\\')
+		{
+			c = '/';
+		}
+	}
+	return std::filesystem::path(generic).lexically_normal().generic_string();
+}
+
+uint64_t HashTextureFile(const std::string& path)
+{
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		return 0;
+	}
+	return HashBytes(file.data(), file.size());
+}
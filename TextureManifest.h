@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+///==========================================================
+/// 変換済みテクスチャ（.dds）の一覧
+/// TextureCooker が書き、実行時は LoadTexture がこれを見て png の代わりに dds を読む
+/// テキストで、1行目が "TextureManifest <版>"、2行目から1枚1行で
+///   元の画像のパス <TAB> 元の画像のハッシュ値（16進） <TAB> 形式 <TAB> ddsのパス
+/// パスは作業フォルダからの相対パスを '/' 区切りにしたもの
+///==========================================================
+
+//変換の方法や形式を変えたら上げる（古い一覧の画像は全て変換し直される）
+static constexpr uint32_t kTextureManifestVersion = 1;
+
+///==========================================================
+/// 1枚分
+///==========================================================
+struct TextureManifestEntry
+{
+	std::string sourcePath;
+	uint64_t sourceHash;
+	std::string format;			// "BC7" / "BC1" / "RGBA8"（4の倍数でない大きさはブロック圧縮できない）
+	std::string cookedPath;
+};
+
+///==========================================================
+/// 一覧の読み書き
+///==========================================================
+class TextureManifest
+{
+public:
+	//一覧を読む。無いか版が違えば空の一覧にしてfalse
+	bool Load(const std::string& path);
+
+	//一時ファイルに書いてから置き換える
+	bool Save(const std::string& path) const;
+
+	const TextureManifestEntry* Find(const std::string& sourcePath) const;
+
+	//同じ元の画像があれば置き換え、無ければ足す
+	void Set(const TextureManifestEntry& entry);
+
+	//sourcePathの代わりに読むddsのパス。一覧に無いか、ddsが無いか、元の画像が変わっていれば空
+	//元の画像が無いときは dds をそのまま使う（png を配らない場合）
+	std::string FindCooked(const std::string& sourcePath) const;
+
+	const std::vector<TextureManifestEntry>& entries() const { return entries_; }
+
+private:
+	std::vector<TextureManifestEntry> entries_;
+};
+
+//一覧に書くパスの形にする（"./a\\b.png" → "a/b.png"）
+std::string NormalizeTexturePath(const std::string& path);
+
+//画像ファイルの中身のハッシュ値。開けなければ0
+uint64_t HashTextureFile(const std::string& path);
@@ -1,5 +1,6 @@
 #pragma once
 #include "Vector3.h"
+#include "Quaternion.h"
 
 ///==========================================================
 /// Transform情報を作る
@@ -12,4 +13,18 @@ struct Transform
 };
 ///==========================================================
 /// Transform情報を作る
+///==========================================================
+
+///==========================================================
+/// 回転をクォータニオンで持つTransform
+/// Transformからの変換と行列の作成は QuaternionMath.h
+///==========================================================
+struct QuaternionTransform
+{
+	Vector3 scale;
+	Quaternion rotate;
+	Vector3 translate;
+};
+///==========================================================
+/// 回転をクォータニオンで持つTransform
 ///==========================================================
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+#include <cassert>
+#include <span>
+#include <vector>
+#include "Transform.h"
+#include "TransformationMatrix.h"
+#include "MatrixMath.h"
+
+///==========================================================
+/// TransformをSoA（成分ごとの配列）で持つ
+///==========================================================
+struct TransformSoA final
+{
+	std::vector<float> scaleX, scaleY, scaleZ;
+	std::vector<float> rotateX, rotateY, rotateZ;
+	std::vector<float> translateX, translateY, translateZ;
+
+	size_t size() const { return scaleX.size(); }
+
+	void resize(size_t count)
+	{
+		scaleX.resize(count, 1.0f); scaleY.resize(count, 1.0f); scaleZ.resize(count, 1.0f);
+		rotateX.resize(count); rotateY.resize(count); rotateZ.resize(count);
+		translateX.resize(count); translateY.resize(count); translateZ.resize(count);
+	}
+
+	void Set(size_t index, const Transform& transform)
+	{
+		scaleX[index] = transform.scale.x; scaleY[index] = transform.scale.y; scaleZ[index] = transform.scale.z;
+		rotateX[index] = transform.rotate.x; rotateY[index] = transform.rotate.y; rotateZ[index] = transform.rotate.z;
+		translateX[index] = transform.translate.x; translateY[index] = transform.translate.y; translateZ[index] = transform.translate.z;
+	}
+
+	Transform Get(size_t index) const
+	{
+		return {
+			{ scaleX[index], scaleY[index], scaleZ[index] },
+			{ rotateX[index], rotateY[index], rotateZ[index] },
+			{ translateX[index], translateY[index], translateZ[index] } };
+	}
+};
+
+#if defined(MATRIXMATH_USE_SSE)
+//a0*b0 + a1*b1 + a2*b2
+static inline __m128 Dot3x4(__m128 a0, __m128 a1, __m128 a2, __m128 b0, __m128 b1, __m128 b2)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, b0), _mm_mul_ps(a1, b1)), _mm_mul_ps(a2, b2));
+}
+
+//4オブジェクト分の行列を転置しながらTransfomationMatrixに書き込む
+//e[i][j] には4オブジェクト分の (i,j) 要素が入っている
+static inline void StoreMatrices4(const __m128 (&e)[4][4], Matrix4x4* dst0, Matrix4x4* dst1, Matrix4x4* dst2, Matrix4x4* dst3)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		__m128 c0 = e[i][0], c1 = e[i][1], c2 = e[i][2], c3 = e[i][3];
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		StoreRow(*dst0, i, c0);
+		StoreRow(*dst1, i, c1);
+		StoreRow(*dst2, i, c2);
+		StoreRow(*dst3, i, c3);
+	}
+}
+#endif
+
+//World行列とWVP行列をまとめて計算する
+//outputにはMapしたアップロードバッファをそのまま渡してよい
+static void ComputeTransformationMatrices(const TransformSoA& transforms, const Matrix4x4& viewProjection, std::span<TransfomationMatrix> output)
+{
+	const size_t count = transforms.size();
+	assert(count <= output.size());
+	size_t index = 0;
+
+#if defined(MATRIXMATH_USE_SSE)
+	__m128 vp[4][4];
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 4; j++)
+		{
+			vp[i][j] = _mm_set1_ps(viewProjection.m[i][j]);
+		}
+	}
+
+	//4オブジェクトずつ処理する
+	for (; index + 4 <= count; index += 4)
+	{
+		__m128 sx, cx, sy, cy, sz, cz;
+		SinCos4(_mm_loadu_ps(&transforms.rotateX[index]), sx, cx);
+		SinCos4(_mm_loadu_ps(&transforms.rotateY[index]), sy, cy);
+		SinCos4(_mm_loadu_ps(&transforms.rotateZ[index]), sz, cz);
+		const __m128 scaleX = _mm_loadu_ps(&transforms.scaleX[index]);
+		const __m128 scaleY = _mm_loadu_ps(&transforms.scaleY[index]);
+		const __m128 scaleZ = _mm_loadu_ps(&transforms.scaleZ[index]);
+
+		//World = S * Rx * Ry * Rz * T（MakeAffineMatrixと同じ展開）
+		__m128 world[4][4];
+		const __m128 sxsy = _mm_mul_ps(sx, sy);
+		const __m128 cxsy = _mm_mul_ps(cx, sy);
+		world[0][0] = _mm_mul_ps(scaleX, _mm_mul_ps(cy, cz));
+		world[0][1] = _mm_mul_ps(scaleX, _mm_mul_ps(cy, sz));
+		world[0][2] = _mm_mul_ps(scaleX, _mm_sub_ps(_mm_setzero_ps(), sy));
+		world[1][0] = _mm_mul_ps(scaleY, _mm_sub_ps(_mm_mul_ps(sxsy, cz), _mm_mul_ps(cx, sz)));
+		world[1][1] = _mm_mul_ps(scaleY, _mm_add_ps(_mm_mul_ps(sxsy, sz), _mm_mul_ps(cx, cz)));
+		world[1][2] = _mm_mul_ps(scaleY, _mm_mul_ps(sx, cy));
+		world[2][0] = _mm_mul_ps(scaleZ, _mm_add_ps(_mm_mul_ps(cxsy, cz), _mm_mul_ps(sx, sz)));
+		world[2][1] = _mm_mul_ps(scaleZ, _mm_sub_ps(_mm_mul_ps(cxsy, sz), _mm_mul_ps(sx, cz)));
+		world[2][2] = _mm_mul_ps(scaleZ, _mm_mul_ps(cx, cy));
+		world[3][0] = _mm_loadu_ps(&transforms.translateX[index]);
+		world[3][1] = _mm_loadu_ps(&transforms.translateY[index]);
+		world[3][2] = _mm_loadu_ps(&transforms.translateZ[index]);
+		world[0][3] = world[1][3] = world[2][3] = _mm_setzero_ps();
+		world[3][3] = _mm_set1_ps(1.0f);
+
+		//WVP = World * VP。Worldの4列目は (0,0,0,1) なので3項で済む
+		__m128 wvp[4][4];
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				wvp[i][j] = Dot3x4(world[i][0], world[i][1], world[i][2], vp[0][j], vp[1][j], vp[2][j]);
+			}
+		}
+		for (int j = 0; j < 4; j++)
+		{
+			wvp[3][j] = _mm_add_ps(wvp[3][j], vp[3][j]);
+		}
+
+		StoreMatrices4(wvp, &output[index].WVP, &output[index + 1].WVP, &output[index + 2].WVP, &output[index + 3].WVP);
+		StoreMatrices4(world, &output[index].World, &output[index + 1].World, &output[index + 2].World, &output[index + 3].World);
+	}
+#endif
+
+	//残り（またはSIMDが使えない場合の全部）
+	for (; index < count; index++)
+	{
+		const Transform transform = transforms.Get(index);
+		const Matrix4x4 world = MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
+		output[index].WVP = Multiply(world, viewProjection);
+		output[index].World = world;
+	}
+}
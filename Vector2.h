@@ -6,4 +6,39 @@
 struct Vector2 final {
 	float x;
 	float y;
-};
\ No newline at end of file
+
+	constexpr bool operator==(const Vector2&) const = default;
+};
+
+//加算
+constexpr Vector2 operator+(const Vector2& v1, const Vector2& v2) { return { v1.x + v2.x, v1.y + v2.y }; }
+//減算
+constexpr Vector2 operator-(const Vector2& v1, const Vector2& v2) { return { v1.x - v2.x, v1.y - v2.y }; }
+//符号反転
+constexpr Vector2 operator-(const Vector2& v) { return { -v.x, -v.y }; }
+//スカラー倍
+constexpr Vector2 operator*(const Vector2& v, float s) { return { v.x * s, v.y * s }; }
+constexpr Vector2 operator*(float s, const Vector2& v) { return { s * v.x, s * v.y }; }
+//スカラーで割る
+constexpr Vector2 operator/(const Vector2& v, float s) { return { v.x / s, v.y / s }; }
+
+constexpr Vector2& operator+=(Vector2& v1, const Vector2& v2)
+{
+	v1.x += v2.x;
+	v1.y += v2.y;
+	return v1;
+}
+
+constexpr Vector2& operator-=(Vector2& v1, const Vector2& v2)
+{
+	v1.x -= v2.x;
+	v1.y -= v2.y;
+	return v1;
+}
+
+constexpr Vector2& operator*=(Vector2& v1, float s)
+{
+	v1.x *= s;
+	v1.y *= s;
+	return v1;
+}
@@ -7,4 +7,42 @@ struct Vector3 final {
 	float x;
 	float y;
 	float z;
-};
\ No newline at end of file
+
+	constexpr bool operator==(const Vector3&) const = default;
+};
+
+//加算
+constexpr Vector3 operator+(const Vector3& v1, const Vector3& v2) { return { v1.x + v2.x, v1.y + v2.y, v1.z + v2.z }; }
+//減算
+constexpr Vector3 operator-(const Vector3& v1, const Vector3& v2) { return { v1.x - v2.x, v1.y - v2.y, v1.z - v2.z }; }
+//符号反転
+constexpr Vector3 operator-(const Vector3& v) { return { -v.x, -v.y, -v.z }; }
+//スカラー倍
+constexpr Vector3 operator*(const Vector3& v, float s) { return { v.x * s, v.y * s, v.z * s }; }
+constexpr Vector3 operator*(float s, const Vector3& v) { return { s * v.x, s * v.y, s * v.z }; }
+//スカラーで割る
+constexpr Vector3 operator/(const Vector3& v, float s) { return { v.x / s, v.y / s, v.z / s }; }
+
+constexpr Vector3& operator+=(Vector3& v1, const Vector3& v2)
+{
+	v1.x += v2.x;
+	v1.y += v2.y;
+	v1.z += v2.z;
+	return v1;
+}
+
+constexpr Vector3& operator-=(Vector3& v1, const Vector3& v2)
+{
+	v1.x -= v2.x;
+	v1.y -= v2.y;
+	v1.z -= v2.z;
+	return v1;
+}
+
+constexpr Vector3& operator*=(Vector3& v1, float s)
+{
+	v1.x *= s;
+	v1.y *= s;
+	v1.z *= s;
+	return v1;
+}
@@ -8,4 +8,45 @@ struct Vector4 final {
 	float y;
 	float z;
 	float w;
-};
\ No newline at end of file
+
+	constexpr bool operator==(const Vector4&) const = default;
+};
+
+//加算
+constexpr Vector4 operator+(const Vector4& v1, const Vector4& v2) { return { v1.x + v2.x, v1.y + v2.y, v1.z + v2.z, v1.w + v2.w }; }
+//減算
+constexpr Vector4 operator-(const Vector4& v1, const Vector4& v2) { return { v1.x - v2.x, v1.y - v2.y, v1.z - v2.z, v1.w - v2.w }; }
+//符号反転
+constexpr Vector4 operator-(const Vector4& v) { return { -v.x, -v.y, -v.z, -v.w }; }
+//スカラー倍
+constexpr Vector4 operator*(const Vector4& v, float s) { return { v.x * s, v.y * s, v.z * s, v.w * s }; }
+constexpr Vector4 operator*(float s, const Vector4& v) { return { s * v.x, s * v.y, s * v.z, s * v.w }; }
+//スカラーで割る
+constexpr Vector4 operator/(const Vector4& v, float s) { return { v.x / s, v.y / s, v.z / s, v.w / s }; }
+
+constexpr Vector4& operator+=(Vector4& v1, const Vector4& v2)
+{
+	v1.x += v2.x;
+	v1.y += v2.y;
+	v1.z += v2.z;
+	v1.w += v2.w;
+	return v1;
+}
+
+constexpr Vector4& operator-=(Vector4& v1, const Vector4& v2)
+{
+	v1.x -= v2.x;
+	v1.y -= v2.y;
+	v1.z -= v2.z;
+	v1.w -= v2.w;
+	return v1;
+}
+
+constexpr Vector4& operator*=(Vector4& v1, float s)
+{
+	v1.x *= s;
+	v1.y *= s;
+	v1.z *= s;
+	v1.w *= s;
+	return v1;
+}
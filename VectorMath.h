@@ -4,9 +4,19 @@
 #include "Matrix4x4.h"
 #include <cmath>
 #include <assert.h>
+#include <span>
+
+///==========================================================
+/// 配列版の関数はAVX2が使えるときは8要素ずつ処理する
+/// MATRIXMATH_NO_SIMD を定義するとスカラー実装になる
+///==========================================================
+#if !defined(MATRIXMATH_NO_SIMD) && defined(__AVX2__)
+#define VECTORMATH_USE_AVX2
+#include <immintrin.h>
+#endif
 
 //加算
-static Vector3 Add(const Vector3& v1, const Vector3& v2)
+static constexpr Vector3 Add(const Vector3& v1, const Vector3& v2)
 {
 	Vector3 result{};
 	result.x = v1.x + v2.x;
@@ -16,7 +26,7 @@ static Vector3 Add(const Vector3& v1, const Vector3& v2)
 }
 
 //減算
-static Vector3 Subtract(const Vector3& v1, const Vector3& v2)
+static constexpr Vector3 Subtract(const Vector3& v1, const Vector3& v2)
 {
 	Vector3 result{};
 	result.x = v1.x - v2.x;
@@ -26,7 +36,7 @@ static Vector3 Subtract(const Vector3& v1, const Vector3& v2)
 }
 
 //スカラー倍
-static Vector3 Multiply(float scalar, const Vector3& v)
+static constexpr Vector3 Multiply(float scalar, const Vector3& v)
 {
 	Vector3 result{};
 	result.x = scalar * v.x;
@@ -36,7 +46,7 @@ static Vector3 Multiply(float scalar, const Vector3& v)
 }
 
 //内積
-static float Dot(const Vector3& v1, const Vector3& v2)
+static constexpr float Dot(const Vector3& v1, const Vector3& v2)
 {
 	return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
 }
@@ -44,7 +54,7 @@ static float Dot(const Vector3& v1, const Vector3& v2)
 //長さ（ノルム）
 static float Length(const Vector3& v)
 {
-	return sqrtf(powf(v.x, 2) + powf(v.y, 2) + powf(v.z, 2));
+	return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
 }
 
 //正規化
@@ -62,7 +72,7 @@ static Vector3 Nomalize(const Vector3& v)
 }
 
 //座標変換
-static Vector3 Transforms(const Vector3& vector, const Matrix4x4& matrix)
+static constexpr Vector3 Transforms(const Vector3& vector, const Matrix4x4& matrix)
 {
 	Vector3 result{};
 	result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] + 1.0f * matrix.m[3][0];
@@ -77,7 +87,7 @@ static Vector3 Transforms(const Vector3& vector, const Matrix4x4& matrix)
 }
 
 //クロス積
-static Vector3 Cross(const Vector3& v1, const Vector3& v2)
+static constexpr Vector3 Cross(const Vector3& v1, const Vector3& v2)
 {
 	Vector3 result{};
 	result.x = v1.y * v2.z - v1.z * v2.y;
@@ -85,3 +95,175 @@ static Vector3 Cross(const Vector3& v1, const Vector3& v2)
 	result.z = v1.x * v2.y - v1.y * v2.x;
 	return result;
 }
+
+#if defined(VECTORMATH_USE_AVX2)
+//8個のVector3を成分ごとのレジスタに読み込む（AoS -> SoA）
+static inline void LoadVector3x8(const Vector3* v, __m256& x, __m256& y, __m256& z)
+{
+	const float* p = &v->x;
+	__m256 m03 = _mm256_castps128_ps256(_mm_loadu_ps(p + 0));
+	__m256 m14 = _mm256_castps128_ps256(_mm_loadu_ps(p + 4));
+	__m256 m25 = _mm256_castps128_ps256(_mm_loadu_ps(p + 8));
+	m03 = _mm256_insertf128_ps(m03, _mm_loadu_ps(p + 12), 1);
+	m14 = _mm256_insertf128_ps(m14, _mm_loadu_ps(p + 16), 1);
+	m25 = _mm256_insertf128_ps(m25, _mm_loadu_ps(p + 20), 1);
+	const __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+	const __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+	x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+//成分ごとのレジスタから8個のVector3に書き込む（SoA -> AoS）
+static inline void StoreVector3x8(Vector3* v, __m256 x, __m256 y, __m256 z)
+{
+	float* p = &v->x;
+	const __m256 rxy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+	const __m256 ryz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+	const __m256 rzx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+	const __m256 r03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+	const __m256 r14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+	const __m256 r25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+	_mm_storeu_ps(p + 0, _mm256_castps256_ps128(r03));
+	_mm_storeu_ps(p + 4, _mm256_castps256_ps128(r14));
+	_mm_storeu_ps(p + 8, _mm256_castps256_ps128(r25));
+	_mm_storeu_ps(p + 12, _mm256_extractf128_ps(r03, 1));
+	_mm_storeu_ps(p + 16, _mm256_extractf128_ps(r14, 1));
+	_mm_storeu_ps(p + 20, _mm256_extractf128_ps(r25, 1));
+}
+
+//x*m0 + y*m1 + z*m2 + m3（スカラー版と同じ順で加算する）
+static inline __m256 TransformComponent8(__m256 x, __m256 y, __m256 z, const Matrix4x4& matrix, int column)
+{
+	__m256 r = _mm256_mul_ps(x, _mm256_set1_ps(matrix.m[0][column]));
+	r = _mm256_add_ps(r, _mm256_mul_ps(y, _mm256_set1_ps(matrix.m[1][column])));
+	r = _mm256_add_ps(r, _mm256_mul_ps(z, _mm256_set1_ps(matrix.m[2][column])));
+	return _mm256_add_ps(r, _mm256_set1_ps(matrix.m[3][column]));
+}
+#endif
+
+//座標変換（配列版）。wで除算する
+static void Transforms(std::span<const Vector3> points, const Matrix4x4& matrix, std::span<Vector3> out)
+{
+	assert(points.size() <= out.size());
+	size_t i = 0;
+#if defined(VECTORMATH_USE_AVX2)
+	for (; i + 8 <= points.size(); i += 8)
+	{
+		__m256 x, y, z;
+		LoadVector3x8(&points[i], x, y, z);
+		const __m256 w = TransformComponent8(x, y, z, matrix, 3);
+		StoreVector3x8(&out[i],
+			_mm256_div_ps(TransformComponent8(x, y, z, matrix, 0), w),
+			_mm256_div_ps(TransformComponent8(x, y, z, matrix, 1), w),
+			_mm256_div_ps(TransformComponent8(x, y, z, matrix, 2), w));
+	}
+#endif
+	for (; i < points.size(); i++)
+	{
+		out[i] = Transforms(points[i], matrix);
+	}
+}
+
+//座標変換（配列版）。アフィン変換行列専用でwの除算をしない
+static void TransformsAffine(std::span<const Vector3> points, const Matrix4x4& matrix, std::span<Vector3> out)
+{
+	assert(points.size() <= out.size());
+	size_t i = 0;
+#if defined(VECTORMATH_USE_AVX2)
+	for (; i + 8 <= points.size(); i += 8)
+	{
+		__m256 x, y, z;
+		LoadVector3x8(&points[i], x, y, z);
+		StoreVector3x8(&out[i],
+			TransformComponent8(x, y, z, matrix, 0),
+			TransformComponent8(x, y, z, matrix, 1),
+			TransformComponent8(x, y, z, matrix, 2));
+	}
+#endif
+	for (; i < points.size(); i++)
+	{
+		const Vector3& v = points[i];
+		out[i].x = v.x * matrix.m[0][0] + v.y * matrix.m[1][0] + v.z * matrix.m[2][0] + matrix.m[3][0];
+		out[i].y = v.x * matrix.m[0][1] + v.y * matrix.m[1][1] + v.z * matrix.m[2][1] + matrix.m[3][1];
+		out[i].z = v.x * matrix.m[0][2] + v.y * matrix.m[1][2] + v.z * matrix.m[2][2] + matrix.m[3][2];
+	}
+}
+
+//正規化（配列版）。長さ0のベクトルは0のまま
+static void Nomalize(std::span<const Vector3> vectors, std::span<Vector3> out)
+{
+	assert(vectors.size() <= out.size());
+	size_t i = 0;
+#if defined(VECTORMATH_USE_AVX2)
+	for (; i + 8 <= vectors.size(); i += 8)
+	{
+		__m256 x, y, z;
+		LoadVector3x8(&vectors[i], x, y, z);
+		const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+		const __m256 nonZero = _mm256_cmp_ps(length, _mm256_setzero_ps(), _CMP_NEQ_OQ);
+		StoreVector3x8(&out[i],
+			_mm256_and_ps(nonZero, _mm256_div_ps(x, length)),
+			_mm256_and_ps(nonZero, _mm256_div_ps(y, length)),
+			_mm256_and_ps(nonZero, _mm256_div_ps(z, length)));
+	}
+#endif
+	for (; i < vectors.size(); i++)
+	{
+		out[i] = Nomalize(vectors[i]);
+	}
+}
+
+//内積（配列版）
+static void Dot(std::span<const Vector3> v1, std::span<const Vector3> v2, std::span<float> out)
+{
+	assert(v1.size() == v2.size() && v1.size() <= out.size());
+	size_t i = 0;
+#if defined(VECTORMATH_USE_AVX2)
+	for (; i + 8 <= v1.size(); i += 8)
+	{
+		__m256 ax, ay, az, bx, by, bz;
+		LoadVector3x8(&v1[i], ax, ay, az);
+		LoadVector3x8(&v2[i], bx, by, bz);
+		_mm256_storeu_ps(&out[i], _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz)));
+	}
+#endif
+	for (; i < v1.size(); i++)
+	{
+		out[i] = Dot(v1[i], v2[i]);
+	}
+}
+
+//クロス積（配列版）
+static void Cross(std::span<const Vector3> v1, std::span<const Vector3> v2, std::span<Vector3> out)
+{
+	assert(v1.size() == v2.size() && v1.size() <= out.size());
+	size_t i = 0;
+#if defined(VECTORMATH_USE_AVX2)
+	for (; i + 8 <= v1.size(); i += 8)
+	{
+		__m256 ax, ay, az, bx, by, bz;
+		LoadVector3x8(&v1[i], ax, ay, az);
+		LoadVector3x8(&v2[i], bx, by, bz);
+		StoreVector3x8(&out[i],
+			_mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by)),
+			_mm256_sub_ps(_mm256_mul_ps(az, bx), _mm256_mul_ps(ax, bz)),
+			_mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(ay, bx)));
+	}
+#endif
+	for (; i < v1.size(); i++)
+	{
+		out[i] = Cross(v1[i], v2[i]);
+	}
+}
+
+///==========================================================
+/// コンパイル時テスト
+///==========================================================
+static_assert(Add(Vector3{ 1.0f, 2.0f, 3.0f }, Vector3{ 4.0f, 5.0f, 6.0f }) == Vector3{ 5.0f, 7.0f, 9.0f });
+static_assert(Subtract(Vector3{ 4.0f, 5.0f, 6.0f }, Vector3{ 1.0f, 2.0f, 3.0f }) == Vector3{ 3.0f, 3.0f, 3.0f });
+static_assert(Multiply(2.0f, Vector3{ 1.0f, 2.0f, 3.0f }) == Vector3{ 2.0f, 4.0f, 6.0f });
+static_assert(Dot(Vector3{ 1.0f, 2.0f, 3.0f }, Vector3{ 4.0f, 5.0f, 6.0f }) == 32.0f);
+static_assert(Cross(Vector3{ 1.0f, 0.0f, 0.0f }, Vector3{ 0.0f, 1.0f, 0.0f }) == Vector3{ 0.0f, 0.0f, 1.0f });
+static_assert(Vector3{ 1.0f, 2.0f, 3.0f } + Vector3{ 1.0f, 1.0f, 1.0f } * 2.0f == Vector3{ 3.0f, 4.0f, 5.0f });
+static_assert(-Vector3{ 1.0f, -2.0f, 3.0f } == Vector3{ -1.0f, 2.0f, -3.0f });
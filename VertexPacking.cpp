@@ -0,0 +1,185 @@
+#include "VertexPacking.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	static constexpr float kUnorm16Max = 65535.0f;
+	static constexpr float kSnorm16Max = 32767.0f;
+
+	//0は正として扱う符号
+	float SignNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	//SNORM16を元に戻す（D3Dの変換と同じく-32768は-1にする）
+	float DecodeSnorm16(int16_t value)
+	{
+		return std::max(float(value) / kSnorm16Max, -1.0f);
+	}
+}
+
+uint16_t FloatToHalf(float value)
+{
+	const uint32_t bits = std::bit_cast<uint32_t>(value);
+	const uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+	const uint32_t absolute = bits & 0x7FFFFFFF;
+	//無限大とNaN
+	if (absolute >= 0x7F800000)
+	{
+		return sign | 0x7C00 | (absolute > 0x7F800000 ? 0x0200 : 0);
+	}
+	//65520以上は丸めると無限大になる
+	if (absolute >= 0x477FF000)
+	{
+		return sign | 0x7C00;
+	}
+	//2^-14未満は非正規化数。2^24倍すると仮数そのものになる（1024に丸まれば最小の正規化数になる）
+	if (absolute < 0x38800000)
+	{
+		return sign | uint16_t(std::nearbyint(std::bit_cast<float>(absolute) * 16777216.0f));
+	}
+	//指数のバイアスを127から15にして、仮数の下位13bitを偶数丸めで落とす
+	const uint32_t rounded = absolute + 0x0FFF + ((absolute >> 13) & 1);
+	return sign | uint16_t((rounded - 0x38000000) >> 13);
+}
+
+float HalfToFloat(uint16_t value)
+{
+	const uint32_t sign = uint32_t(value & 0x8000) << 16;
+	const uint32_t exponent = (value >> 10) & 0x1F;
+	const uint32_t mantissa = value & 0x03FF;
+	if (exponent == 0)
+	{
+		const float magnitude = float(mantissa) * (1.0f / 16777216.0f);
+		return sign ? -magnitude : magnitude;
+	}
+	if (exponent == 0x1F)
+	{
+		return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+	}
+	return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+void EncodeOctahedral(const Vector3& normal, int16_t encoded[2])
+{
+	const float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	if (length <= 0.0f)
+	{
+		encoded[0] = 0;
+		encoded[1] = 0;
+		return;
+	}
+	//上半分はそのまま、下半分は四隅に折り返して [-1, 1]^2 に写す
+	float u = normal.x / length;
+	float v = normal.y / length;
+	if (normal.z < 0.0f)
+	{
+		const float foldedU = (1.0f - std::fabs(v)) * SignNotZero(u);
+		const float foldedV = (1.0f - std::fabs(u)) * SignNotZero(v);
+		u = foldedU;
+		v = foldedV;
+	}
+
+	//切り捨てと切り上げの組み合わせのうち、元に戻したときに最も近いものにする
+	//差は1e-5程度なので、内積（1との差がfloatの精度より小さい）ではなく成分の差の2乗和で比べる
+	const Vector3 target = Multiply(1.0f / Length(normal), normal);
+	const float scaledU = u * kSnorm16Max;
+	const float scaledV = v * kSnorm16Max;
+	float bestDistance = FLT_MAX;
+	for (int i = 0; i < 4; i++)
+	{
+		const int16_t candidate[2] =
+		{
+			int16_t(std::clamp((i & 1) ? std::ceil(scaledU) : std::floor(scaledU), -kSnorm16Max, kSnorm16Max)),
+			int16_t(std::clamp((i & 2) ? std::ceil(scaledV) : std::floor(scaledV), -kSnorm16Max, kSnorm16Max)),
+		};
+		const Vector3 difference = Subtract(DecodeOctahedral(candidate), target);
+		const float distance = Dot(difference, difference);
+		if (distance < bestDistance)
+		{
+			bestDistance = distance;
+			encoded[0] = candidate[0];
+			encoded[1] = candidate[1];
+		}
+	}
+}
+
+Vector3 DecodeOctahedral(const int16_t encoded[2])
+{
+	const float u = DecodeSnorm16(encoded[0]);
+	const float v = DecodeSnorm16(encoded[1]);
+	Vector3 normal{ u, v, 1.0f - std::fabs(u) - std::fabs(v) };
+	//下半分（zが負）は四隅から折り返して戻す
+	const float t = std::max(-normal.z, 0.0f);
+	normal.x -= SignNotZero(normal.x) * t;
+	normal.y -= SignNotZero(normal.y) * t;
+	return Nomalize(normal);
+}
+
+VertexQuantization ComputeVertexQuantization(std::span<const VertexData> vertices)
+{
+	if (vertices.empty())
+	{
+		return { { 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } };
+	}
+	Vector3 minimum{ FLT_MAX, FLT_MAX, FLT_MAX };
+	Vector3 maximum{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (const VertexData& vertex : vertices)
+	{
+		minimum = { std::min(minimum.x, vertex.position.x), std::min(minimum.y, vertex.position.y), std::min(minimum.z, vertex.position.z) };
+		maximum = { std::max(maximum.x, vertex.position.x), std::max(maximum.y, vertex.position.y), std::max(maximum.z, vertex.position.z) };
+	}
+	return { { maximum.x - minimum.x, maximum.y - minimum.y, maximum.z - minimum.z, 0.0f }, { minimum.x, minimum.y, minimum.z, 1.0f } };
+}
+
+PackedVertexData PackVertex(const VertexData& vertex, const VertexQuantization& quantization)
+{
+	//[0, 1] にしてから16bitに丸める（大きさが0の軸は0）
+	auto quantize = [](float value, float scale, float offset)
+		{
+			const float normalized = scale > 0.0f ? (value - offset) / scale : 0.0f;
+			return uint16_t(std::lround(std::clamp(normalized, 0.0f, 1.0f) * kUnorm16Max));
+		};
+
+	PackedVertexData packed{};
+	packed.position[0] = quantize(vertex.position.x, quantization.positionScale.x, quantization.positionOffset.x);
+	packed.position[1] = quantize(vertex.position.y, quantization.positionScale.y, quantization.positionOffset.y);
+	packed.position[2] = quantize(vertex.position.z, quantization.positionScale.z, quantization.positionOffset.z);
+	packed.position[3] = uint16_t(kUnorm16Max);
+	packed.texcoord[0] = FloatToHalf(vertex.texcoord.x);
+	packed.texcoord[1] = FloatToHalf(vertex.texcoord.y);
+	EncodeOctahedral(vertex.normal, packed.normal);
+	return packed;
+}
+
+VertexData UnpackVertex(const PackedVertexData& vertex, const VertexQuantization& quantization)
+{
+	auto dequantize = [](uint16_t value, float scale, float offset)
+		{
+			return float(value) / kUnorm16Max * scale + offset;
+		};
+
+	VertexData unpacked{};
+	unpacked.position.x = dequantize(vertex.position[0], quantization.positionScale.x, quantization.positionOffset.x);
+	unpacked.position.y = dequantize(vertex.position[1], quantization.positionScale.y, quantization.positionOffset.y);
+	unpacked.position.z = dequantize(vertex.position[2], quantization.positionScale.z, quantization.positionOffset.z);
+	unpacked.position.w = dequantize(vertex.position[3], quantization.positionScale.w, quantization.positionOffset.w);
+	unpacked.texcoord = { HalfToFloat(vertex.texcoord[0]), HalfToFloat(vertex.texcoord[1]) };
+	unpacked.normal = DecodeOctahedral(vertex.normal);
+	return unpacked;
+}
+
+VertexQuantization PackVertices(std::span<const VertexData> vertices, std::span<PackedVertexData> out)
+{
+	const VertexQuantization quantization = ComputeVertexQuantization(vertices);
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		out[i] = PackVertex(vertices[i], quantization);
+	}
+	return quantization;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include "PackedVertexData.h"
+#include "VertexData.h"
+
+///==========================================================
+/// VertexData と PackedVertexData の変換
+/// 座標はメッシュの範囲で16bitに、UVは半精度に、法線は八面体に写して16bit x 2にする
+/// 元に戻す処理は Object3d.VS.hlsl（PACKED_VERTEX を定義したとき）と同じ計算になる
+///==========================================================
+
+//float と半精度浮動小数点数の変換（最も近い値に丸める。範囲外は無限大になる）
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+
+//単位ベクトルを八面体に写して16bit x 2にする。4通りの丸め方から元に戻したときに最も近いものを選ぶ
+void EncodeOctahedral(const Vector3& normal, int16_t encoded[2]);
+Vector3 DecodeOctahedral(const int16_t encoded[2]);
+
+//頂点の範囲から座標の圧縮に使う値を求める
+VertexQuantization ComputeVertexQuantization(std::span<const VertexData> vertices);
+
+//1頂点ずつの変換
+PackedVertexData PackVertex(const VertexData& vertex, const VertexQuantization& quantization);
+VertexData UnpackVertex(const PackedVertexData& vertex, const VertexQuantization& quantization);
+
+//まとめて変換する。outはverticesと同じ数。座標を元に戻すための値を返す
+VertexQuantization PackVertices(std::span<const VertexData> vertices, std::span<PackedVertexData> out);
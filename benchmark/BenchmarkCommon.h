@@ -0,0 +1,36 @@
+#pragma once
+
+///==========================================================
+/// benchmark/ のプログラムで共通に使う関数
+///==========================================================
+#include <chrono>
+#include <cstdio>
+
+//処理時間を計測する。最も速かった回の値を返す
+template <typename Func>
+static double MeasureBest(int repeat, Func func)
+{
+	double best = 1e30;
+	for (int i = 0; i < repeat; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		func();
+		auto end = std::chrono::steady_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(end - start).count();
+		if (ns < best)
+		{
+			best = ns;
+		}
+	}
+	return best;
+}
+
+//確かめる項目を1つ調べる。満たされなければ FAILED: <項目> を表示してfalseを返す
+static bool Check(const char* name, bool condition)
+{
+	if (!condition)
+	{
+		std::printf("FAILED: %s\n", name);
+	}
+	return condition;
+}
@@ -0,0 +1,115 @@
+///==========================================================
+/// FrustumCulling.h のマイクロベンチマーク
+/// 1オブジェクトずつ IsVisible で判定する方法と
+/// CullSpheres / CullAABBs のまとめて判定する方法を比べる
+/// 両者の可視リストが一致するかも確かめる
+///
+/// ビルド例（Windowsヘッダーは不要）
+///   g++ -std=c++20 -O2 -march=native -I.. CullingBenchmark.cpp -o CullingBenchmark
+///   cl /std:c++20 /O2 /EHsc /arch:AVX2 /I.. CullingBenchmark.cpp
+///==========================================================
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "FrustumCulling.h"
+#include "BenchmarkCommon.h"
+
+int main(int argc, char** argv)
+{
+	const size_t objectCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+	const int repeat = 20;
+
+	Transform camera{ { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -10.0f } };
+	const Frustum frustum = MakeFrustum(Multiply(MakeViewMatrix(camera), MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f)));
+
+	//既知の配置で判定が正しいか確認する
+	bool ok = true;
+	ok &= Check("sphere in front of camera", IsVisible(frustum, Sphere{ { 0.0f, 0.0f, 0.0f }, 1.0f }));
+	ok &= Check("sphere behind camera", !IsVisible(frustum, Sphere{ { 0.0f, 0.0f, -20.0f }, 1.0f }));
+	ok &= Check("sphere beyond far plane", !IsVisible(frustum, Sphere{ { 0.0f, 0.0f, 200.0f }, 1.0f }));
+	ok &= Check("sphere far to the right", !IsVisible(frustum, Sphere{ { 50.0f, 0.0f, 0.0f }, 1.0f }));
+	ok &= Check("sphere crossing the near plane", IsVisible(frustum, Sphere{ { 0.0f, 0.0f, -10.5f }, 1.0f }));
+	ok &= Check("aabb in front of camera", IsVisible(frustum, AABB{ { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } }));
+	ok &= Check("aabb above the frustum", !IsVisible(frustum, AABB{ { -1.0f, 30.0f, -1.0f }, { 1.0f, 32.0f, 1.0f } }));
+	ok &= Check("aabb straddling the left plane", IsVisible(frustum, AABB{ { -30.0f, -1.0f, 9.0f }, { 0.0f, 1.0f, 11.0f } }));
+
+	//カメラの周囲にランダムに配置する
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> positionDist(-120.0f, 120.0f);
+	std::uniform_real_distribution<float> sizeDist(0.1f, 5.0f);
+
+	std::vector<Sphere> spheres(objectCount);
+	std::vector<AABB> aabbs(objectCount);
+	SphereSoA sphereSoA;
+	AABBSoA aabbSoA;
+	sphereSoA.resize(objectCount);
+	aabbSoA.resize(objectCount);
+	for (size_t i = 0; i < objectCount; i++)
+	{
+		Vector3 center{ positionDist(random), positionDist(random), positionDist(random) };
+		Vector3 extent{ sizeDist(random), sizeDist(random), sizeDist(random) };
+		spheres[i] = { center, sizeDist(random) };
+		aabbs[i] = { center - extent, center + extent };
+		sphereSoA.Set(i, spheres[i]);
+		aabbSoA.Set(i, aabbs[i]);
+	}
+
+	std::vector<uint32_t> reference(objectCount);
+	std::vector<uint32_t> visible(objectCount);
+	size_t referenceCount = 0;
+	size_t visibleCount = 0;
+
+	//球: 1オブジェクトずつ
+	double sphereScalarNs = MeasureBest(repeat, [&]()
+		{
+			referenceCount = 0;
+			for (size_t i = 0; i < objectCount; i++)
+			{
+				if (IsVisible(frustum, spheres[i]))
+				{
+					reference[referenceCount++] = uint32_t(i);
+				}
+			}
+		});
+	//球: まとめて
+	double sphereBatchNs = MeasureBest(repeat, [&]()
+		{
+			visibleCount = CullSpheres(frustum, sphereSoA, visible);
+		});
+	ok &= Check("CullSpheres matches IsVisible",
+		referenceCount == visibleCount && std::equal(reference.begin(), reference.begin() + referenceCount, visible.begin()));
+	const size_t sphereVisibleCount = visibleCount;
+
+	//AABB: 1オブジェクトずつ
+	double aabbScalarNs = MeasureBest(repeat, [&]()
+		{
+			referenceCount = 0;
+			for (size_t i = 0; i < objectCount; i++)
+			{
+				if (IsVisible(frustum, aabbs[i]))
+				{
+					reference[referenceCount++] = uint32_t(i);
+				}
+			}
+		});
+	//AABB: まとめて
+	double aabbBatchNs = MeasureBest(repeat, [&]()
+		{
+			visibleCount = CullAABBs(frustum, aabbSoA, visible);
+		});
+	ok &= Check("CullAABBs matches IsVisible",
+		referenceCount == visibleCount && std::equal(reference.begin(), reference.begin() + referenceCount, visible.begin()));
+
+	std::printf("objects          : %zu\n", objectCount);
+	std::printf("sphere visible   : %zu\n", sphereVisibleCount);
+	std::printf("sphere per-object: %8.3f ms (%6.2f ns/object)\n", sphereScalarNs * 1e-6, sphereScalarNs / double(objectCount));
+	std::printf("sphere batch     : %8.3f ms (%6.2f ns/object)\n", sphereBatchNs * 1e-6, sphereBatchNs / double(objectCount));
+	std::printf("aabb visible     : %zu\n", visibleCount);
+	std::printf("aabb per-object  : %8.3f ms (%6.2f ns/object)\n", aabbScalarNs * 1e-6, aabbScalarNs / double(objectCount));
+	std::printf("aabb batch       : %8.3f ms (%6.2f ns/object)\n", aabbBatchNs * 1e-6, aabbBatchNs / double(objectCount));
+	std::printf("result           : %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
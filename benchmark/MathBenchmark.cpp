@@ -0,0 +1,374 @@
+///==========================================================
+/// MatrixMath.h / VectorMath.h のマイクロベンチマーク
+/// 1回呼び出し（single）と 1k / 100k / 1M 要素の配列で計測し
+/// ns/op とスループットを表示する。--json を付けるとJSONでも出力する
+///
+/// ビルド例（Windowsヘッダーは不要）
+///   g++ -std=c++20 -O2 -march=native -I.. MathBenchmark.cpp -o MathBenchmark
+///   cl /std:c++20 /O2 /EHsc /arch:AVX2 /I.. MathBenchmark.cpp
+///
+/// 使い方
+///   MathBenchmark [--json <出力ファイル>] [--repeat <回数>]
+///   出力ファイルに - を指定すると標準出力に書き出す
+///==========================================================
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MatrixMath.h"
+#include "VectorMath.h"
+#include "BenchmarkCommon.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	//計算結果を最適化で消されないようにする
+	template <typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+#if defined(_MSC_VER)
+		//ポインタ自体をvolatileにする（volatile const void* だと指す先がvolatileなだけで、代入は消されうる）
+		static const void* volatile sink;
+		sink = &value;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "g"(&value) : "memory");
+#endif
+	}
+
+	//コンパイル時に選ばれたSIMD命令セット
+	const char* MatrixMathSimdName()
+	{
+#if defined(MATRIXMATH_USE_AVX)
+		return "avx";
+#elif defined(MATRIXMATH_USE_SSE)
+		return "sse";
+#else
+		return "scalar";
+#endif
+	}
+
+	const char* VectorMathSimdName()
+	{
+#if defined(VECTORMATH_USE_AVX2)
+		return "avx2";
+#else
+		return "scalar";
+#endif
+	}
+
+	///==========================================================
+	/// 計測結果
+	///==========================================================
+	struct Result final
+	{
+		std::string name;
+		size_t count;         //1回の計測で処理した要素数（singleは呼び出し回数）
+		bool single;          //1回呼び出しの計測か
+		double totalNs;       //1回の計測にかかった時間
+		size_t bytesPerOp;    //1要素あたりの読み書きバイト数
+	};
+
+	double NsPerOp(const Result& result) { return result.totalNs / double(result.count); }
+	double OpsPerSecond(const Result& result) { return double(result.count) / (result.totalNs * 1e-9); }
+	double GigabytesPerSecond(const Result& result) { return double(result.count * result.bytesPerOp) / result.totalNs; }
+
+	///==========================================================
+	/// ベンチマーク用の入力データ
+	///==========================================================
+	struct Inputs final
+	{
+		std::vector<Matrix4x4> matrices;
+		std::vector<Transform> transforms;
+		std::vector<float> fovY;
+		std::vector<Vector3> vectors1;
+		std::vector<Vector3> vectors2;
+		Matrix4x4 viewProjection;
+	};
+
+	Inputs MakeInputs(size_t count)
+	{
+		std::mt19937 random(12345);
+		std::uniform_real_distribution<float> scaleDist(0.5f, 2.0f);
+		std::uniform_real_distribution<float> rotateDist(-3.14159265f, 3.14159265f);
+		std::uniform_real_distribution<float> translateDist(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> fovDist(0.3f, 1.5f);
+
+		Inputs inputs;
+		inputs.matrices.resize(count);
+		inputs.transforms.resize(count);
+		inputs.fovY.resize(count);
+		inputs.vectors1.resize(count);
+		inputs.vectors2.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			inputs.transforms[i] = {
+				{ scaleDist(random), scaleDist(random), scaleDist(random) },
+				{ rotateDist(random), rotateDist(random), rotateDist(random) },
+				{ translateDist(random), translateDist(random), translateDist(random) } };
+			//逆行列が存在するようにアフィン行列を入力にする
+			inputs.matrices[i] = MakeAffineMatrix(inputs.transforms[i].scale, inputs.transforms[i].rotate, inputs.transforms[i].translate);
+			inputs.fovY[i] = fovDist(random);
+			inputs.vectors1[i] = { translateDist(random), translateDist(random), translateDist(random) };
+			inputs.vectors2[i] = { translateDist(random), translateDist(random), translateDist(random) };
+		}
+
+		Transform camera{ { 1.0f, 1.0f, 1.0f }, { 0.3f, 0.2f, 0.0f }, { 0.0f, 5.0f, -50.0f } };
+		inputs.viewProjection = Multiply(MakeViewMatrix(camera), MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 1000.0f));
+		return inputs;
+	}
+
+	///==========================================================
+	/// 1回呼び出しの計測
+	/// 同じ入力で関数を繰り返し呼び、1回あたりの時間を求める
+	///==========================================================
+	std::vector<Result> RunSingle(const Inputs& inputs, int repeat)
+	{
+		const size_t calls = 1000000;
+		const Matrix4x4& m1 = inputs.matrices[0];
+		const Matrix4x4& m2 = inputs.matrices[1];
+		const Transform& transform = inputs.transforms[0];
+		const Vector3& v1 = inputs.vectors1[0];
+		const Vector3& v2 = inputs.vectors2[0];
+
+		std::vector<Result> results;
+		auto add = [&](const char* name, size_t bytesPerOp, const std::function<void()>& func)
+			{
+				results.push_back({ name, calls, true, MeasureBest(repeat, func), bytesPerOp });
+			};
+
+		add("Multiply", sizeof(Matrix4x4) * 3, [&]()
+			{
+				for (size_t i = 0; i < calls; i++)
+				{
+					DoNotOptimize(m1);
+					Matrix4x4 result = Multiply(m1, m2);
+					DoNotOptimize(result);
+				}
+			});
+		add("Inverse", sizeof(Matrix4x4) * 2, [&]()
+			{
+				for (size_t i = 0; i < calls; i++)
+				{
+					DoNotOptimize(m1);
+					Matrix4x4 result = Inverse(m1);
+					DoNotOptimize(result);
+				}
+			});
+		add("MakeAffineMatrix", sizeof(Transform) + sizeof(Matrix4x4), [&]()
+			{
+				for (size_t i = 0; i < calls; i++)
+				{
+					DoNotOptimize(transform);
+					Matrix4x4 result = MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
+					DoNotOptimize(result);
+				}
+			});
+		add("MakePerspectiveFovMatrix", sizeof(float) + sizeof(Matrix4x4), [&]()
+			{
+				float fovY = inputs.fovY[0];
+				for (size_t i = 0; i < calls; i++)
+				{
+					DoNotOptimize(fovY);
+					Matrix4x4 result = MakePerspectiveFovMatrix(fovY, 1280.0f / 720.0f, 0.1f, 1000.0f);
+					DoNotOptimize(result);
+				}
+			});
+		add("Transforms", sizeof(Vector3) * 2 + sizeof(Matrix4x4), [&]()
+			{
+				for (size_t i = 0; i < calls; i++)
+				{
+					DoNotOptimize(v1);
+					Vector3 result = Transforms(v1, inputs.viewProjection);
+					DoNotOptimize(result);
+				}
+			});
+		add("Nomalize", sizeof(Vector3) * 2, [&]()
+			{
+				for (size_t i = 0; i < calls; i++)
+				{
+					DoNotOptimize(v1);
+					Vector3 result = Nomalize(v1);
+					DoNotOptimize(result);
+				}
+			});
+		add("Cross", sizeof(Vector3) * 3, [&]()
+			{
+				for (size_t i = 0; i < calls; i++)
+				{
+					DoNotOptimize(v1);
+					Vector3 result = Cross(v1, v2);
+					DoNotOptimize(result);
+				}
+			});
+		return results;
+	}
+
+	///==========================================================
+	/// 配列の計測
+	/// 配列版の関数がある場合はそちらを使う（実際に使っているカーネル）
+	///==========================================================
+	std::vector<Result> RunArray(const Inputs& inputs, size_t count, int repeat)
+	{
+		std::vector<Matrix4x4> outMatrices(count);
+		std::vector<Vector3> outVectors(count);
+		std::span<const Matrix4x4> matrices(inputs.matrices.data(), count);
+		std::span<const Transform> transforms(inputs.transforms.data(), count);
+		std::span<const Vector3> vectors1(inputs.vectors1.data(), count);
+		std::span<const Vector3> vectors2(inputs.vectors2.data(), count);
+
+		std::vector<Result> results;
+		auto add = [&](const char* name, size_t bytesPerOp, const std::function<void()>& func)
+			{
+				results.push_back({ name, count, false, MeasureBest(repeat, func), bytesPerOp });
+			};
+
+		add("Multiply", sizeof(Matrix4x4) * 2, [&]()
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					outMatrices[i] = Multiply(matrices[i], inputs.viewProjection);
+				}
+				DoNotOptimize(outMatrices.front());
+			});
+		add("Inverse", sizeof(Matrix4x4) * 2, [&]()
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					outMatrices[i] = Inverse(matrices[i]);
+				}
+				DoNotOptimize(outMatrices.front());
+			});
+		add("MakeAffineMatrix", sizeof(Transform) + sizeof(Matrix4x4), [&]()
+			{
+				MakeAffineMatrices(transforms, outMatrices);
+				DoNotOptimize(outMatrices.front());
+			});
+		add("MakePerspectiveFovMatrix", sizeof(float) + sizeof(Matrix4x4), [&]()
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					outMatrices[i] = MakePerspectiveFovMatrix(inputs.fovY[i], 1280.0f / 720.0f, 0.1f, 1000.0f);
+				}
+				DoNotOptimize(outMatrices.front());
+			});
+		add("Transforms", sizeof(Vector3) * 2, [&]()
+			{
+				Transforms(vectors1, inputs.viewProjection, outVectors);
+				DoNotOptimize(outVectors.front());
+			});
+		add("Nomalize", sizeof(Vector3) * 2, [&]()
+			{
+				Nomalize(vectors1, outVectors);
+				DoNotOptimize(outVectors.front());
+			});
+		add("Cross", sizeof(Vector3) * 3, [&]()
+			{
+				Cross(vectors1, vectors2, outVectors);
+				DoNotOptimize(outVectors.front());
+			});
+		return results;
+	}
+
+	void PrintTable(const std::vector<Result>& results)
+	{
+		std::printf("%-26s %10s %12s %14s %10s\n", "function", "count", "ns/op", "Mops/s", "GB/s");
+		for (const Result& result : results)
+		{
+			std::printf("%-26s %10s %12.3f %14.2f %10.2f\n",
+				result.name.c_str(),
+				result.single ? "single" : std::to_string(result.count).c_str(),
+				NsPerOp(result),
+				OpsPerSecond(result) * 1e-6,
+				GigabytesPerSecond(result));
+		}
+	}
+
+	void WriteJson(std::FILE* file, const std::vector<Result>& results, int repeat)
+	{
+		std::fprintf(file, "{\n");
+		std::fprintf(file, "  \"matrixMathSimd\": \"%s\",\n", MatrixMathSimdName());
+		std::fprintf(file, "  \"vectorMathSimd\": \"%s\",\n", VectorMathSimdName());
+		std::fprintf(file, "  \"repeat\": %d,\n", repeat);
+		std::fprintf(file, "  \"results\": [\n");
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& result = results[i];
+			std::fprintf(file,
+				"    { \"name\": \"%s\", \"mode\": \"%s\", \"count\": %zu, \"nsPerOp\": %.4f, \"opsPerSecond\": %.1f, \"bytesPerSecond\": %.1f }%s\n",
+				result.name.c_str(),
+				result.single ? "single" : "array",
+				result.count,
+				NsPerOp(result),
+				OpsPerSecond(result),
+				GigabytesPerSecond(result) * 1e9,
+				i + 1 < results.size() ? "," : "");
+		}
+		std::fprintf(file, "  ]\n");
+		std::fprintf(file, "}\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const char* jsonPath = nullptr;
+	int repeat = 5;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			jsonPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+		{
+			repeat = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			std::fprintf(stderr, "usage: %s [--json <file>] [--repeat <count>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const size_t arraySizes[] = { 1000, 100000, 1000000 };
+	const Inputs inputs = MakeInputs(arraySizes[2]);
+
+	std::vector<Result> results = RunSingle(inputs, repeat);
+	for (size_t count : arraySizes)
+	{
+		std::vector<Result> arrayResults = RunArray(inputs, count, repeat);
+		results.insert(results.end(), arrayResults.begin(), arrayResults.end());
+	}
+
+	//JSONを標準出力に書くときは表を出さない
+	const bool jsonToStdout = jsonPath && std::strcmp(jsonPath, "-") == 0;
+	if (!jsonToStdout)
+	{
+		std::printf("MatrixMath: %s / VectorMath: %s\n", MatrixMathSimdName(), VectorMathSimdName());
+		PrintTable(results);
+	}
+
+	if (jsonPath)
+	{
+		std::FILE* file = jsonToStdout ? stdout : std::fopen(jsonPath, "w");
+		if (!file)
+		{
+			std::fprintf(stderr, "cannot open %s\n", jsonPath);
+			return 1;
+		}
+		WriteJson(file, results, repeat);
+		if (!jsonToStdout)
+		{
+			std::fclose(file);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,159 @@
+///==========================================================
+/// MatrixMath.h のSIMD実装とスカラー実装（MATRIXMATH_NO_SIMD）の結果を比べる
+/// 乱数の行列で Add / Subtract / Multiply / Transpose / Inverse を両方で計算し
+/// Add / Subtract / Multiply / Transpose は 0 ULP（ビット単位で同じ。+0 と -0 は同じとみなす）
+/// Inverse は計算方法が違う（SIMDは2x2ブロック、スカラーは余因子展開）ので、
+/// 逆行列の最大要素に対する誤差が kInverseTolerance 以下であることを確かめる
+///
+/// 0 ULP で一致させるには積和をFMAにまとめさせないこと（-ffp-contract=off、/fp:fast は使わない）
+/// SIMDなしの環境（MATRIXMATH_USE_SSE も AVX も無い）では比べるものが無いので失敗とする
+///
+/// ビルド例（Windowsヘッダーは不要）
+///   g++ -std=c++20 -O2 -march=native -ffp-contract=off -I.. MatrixSimdCheck.cpp MatrixSimdCheckScalar.cpp -o MatrixSimdCheck
+///   cl /std:c++20 /O2 /EHsc /arch:AVX2 /fp:precise /I.. MatrixSimdCheck.cpp MatrixSimdCheckScalar.cpp
+///
+/// 使い方
+///   MatrixSimdCheck [行列の数]
+///==========================================================
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "MatrixMath.h"
+#include "BenchmarkCommon.h"
+
+//MatrixSimdCheckScalar.cpp（MATRIXMATH_NO_SIMD でビルドしたもの）
+Matrix4x4 ScalarAdd(const Matrix4x4& m1, const Matrix4x4& m2);
+Matrix4x4 ScalarSubtract(const Matrix4x4& m1, const Matrix4x4& m2);
+Matrix4x4 ScalarMultiply(const Matrix4x4& m1, const Matrix4x4& m2);
+Matrix4x4 ScalarTranspose(const Matrix4x4& m);
+Matrix4x4 ScalarInverse(const Matrix4x4& m);
+
+namespace
+{
+	//Inverse の許容誤差（逆行列の最大要素に対する比）。floatの機械イプシロンの約100倍
+	constexpr float kInverseTolerance = 1e-5f;
+
+	//floatを大小の順に並ぶ整数にする（+0 と -0 は同じ値になる）
+	int64_t OrderedBits(float value)
+	{
+		const int32_t bits = std::bit_cast<int32_t>(value);
+		return bits < 0 ? -int64_t(bits & 0x7fffffff) : int64_t(bits);
+	}
+
+	//2つの行列の要素ごとのULP差の最大値
+	int64_t MaxUlp(const Matrix4x4& a, const Matrix4x4& b)
+	{
+		int64_t result = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				result = std::max(result, std::abs(OrderedBits(a.m[i][j]) - OrderedBits(b.m[i][j])));
+			}
+		}
+		return result;
+	}
+
+	//要素ごとの差の最大値を、referenceの最大要素で割ったもの
+	float MaxRelativeError(const Matrix4x4& value, const Matrix4x4& reference)
+	{
+		float error = 0.0f;
+		float scale = 0.0f;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				error = std::max(error, std::fabs(value.m[i][j] - reference.m[i][j]));
+				scale = std::max(scale, std::fabs(reference.m[i][j]));
+			}
+		}
+		return error / scale;
+	}
+
+	//要素が [-range, range] の行列。diagonalを対角に足すと逆行列を安定して求められる
+	Matrix4x4 RandomMatrix(std::mt19937& random, float range, float diagonal)
+	{
+		std::uniform_real_distribution<float> distribution(-range, range);
+		Matrix4x4 result{};
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				result.m[i][j] = distribution(random) + (i == j ? diagonal : 0.0f);
+			}
+		}
+		return result;
+	}
+
+	//拡大縮小・回転・平行移動のアフィン変換行列
+	Matrix4x4 RandomAffineMatrix(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+		std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+		std::uniform_real_distribution<float> translate(-100.0f, 100.0f);
+		return MakeAffineMatrix({ scale(random), scale(random), scale(random) }, { angle(random), angle(random), angle(random) },
+			{ translate(random), translate(random), translate(random) });
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const size_t count = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 100000;
+
+#if defined(MATRIXMATH_USE_AVX)
+	std::printf("SIMD path        : AVX\n");
+#elif defined(MATRIXMATH_USE_SSE)
+	std::printf("SIMD path        : SSE\n");
+#else
+	std::printf("SIMD path        : none (nothing to compare)\n");
+	return 1;
+#endif
+
+	std::mt19937 random(12345);
+	int64_t addUlp = 0;
+	int64_t subtractUlp = 0;
+	int64_t multiplyUlp = 0;
+	int64_t transposeUlp = 0;
+	float inverseError = 0.0f;
+	float affineInverseError = 0.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		//値の大きさが違う行列も混ぜる
+		const float range = i % 3 == 0 ? 1.0f : (i % 3 == 1 ? 1000.0f : 1e-3f);
+		const Matrix4x4 m1 = RandomMatrix(random, range, 0.0f);
+		const Matrix4x4 m2 = RandomMatrix(random, range, 0.0f);
+		addUlp = std::max(addUlp, MaxUlp(Add(m1, m2), ScalarAdd(m1, m2)));
+		subtractUlp = std::max(subtractUlp, MaxUlp(Subtract(m1, m2), ScalarSubtract(m1, m2)));
+		multiplyUlp = std::max(multiplyUlp, MaxUlp(Multiply(m1, m2), ScalarMultiply(m1, m2)));
+		transposeUlp = std::max(transposeUlp, MaxUlp(Transpose(m1), ScalarTranspose(m1)));
+
+		const Matrix4x4 regular = RandomMatrix(random, range, 4.0f * range);
+		inverseError = std::max(inverseError, MaxRelativeError(Inverse(regular), ScalarInverse(regular)));
+		const Matrix4x4 affine = RandomAffineMatrix(random);
+		affineInverseError = std::max(affineInverseError, MaxRelativeError(Inverse(affine), ScalarInverse(affine)));
+	}
+
+	std::printf("matrices         : %zu\n", count);
+	std::printf("Add              : %lld ULP\n", static_cast<long long>(addUlp));
+	std::printf("Subtract         : %lld ULP\n", static_cast<long long>(subtractUlp));
+	std::printf("Multiply         : %lld ULP\n", static_cast<long long>(multiplyUlp));
+	std::printf("Transpose        : %lld ULP\n", static_cast<long long>(transposeUlp));
+	std::printf("Inverse          : %.3g (regular), %.3g (affine), tolerance %.3g\n", inverseError, affineInverseError, kInverseTolerance);
+
+	bool ok = true;
+	ok &= Check("Add matches the scalar path bit for bit", addUlp == 0);
+	ok &= Check("Subtract matches the scalar path bit for bit", subtractUlp == 0);
+	ok &= Check("Multiply matches the scalar path bit for bit", multiplyUlp == 0);
+	ok &= Check("Transpose matches the scalar path bit for bit", transposeUlp == 0);
+	ok &= Check("Inverse of regular matrices stays within the tolerance", inverseError <= kInverseTolerance);
+	ok &= Check("Inverse of affine matrices stays within the tolerance", affineInverseError <= kInverseTolerance);
+
+	std::printf("result           : %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
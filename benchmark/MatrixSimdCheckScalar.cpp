@@ -0,0 +1,17 @@
+///==========================================================
+/// MatrixSimdCheck.cpp から呼ぶスカラー実装
+/// MATRIXMATH_NO_SIMD を定義してから MatrixMath.h を読み込むので、同じ関数がSIMDを通らずに計算される
+/// MatrixMath.h の関数と演算子はどれも static なので、SIMDありの翻訳単位と同じプログラムにリンクしてもぶつからない
+///==========================================================
+#define MATRIXMATH_NO_SIMD
+#include "MatrixMath.h"
+
+#if defined(MATRIXMATH_USE_SSE) || defined(MATRIXMATH_USE_AVX)
+#error "MatrixSimdCheckScalar.cpp must be built without SIMD"
+#endif
+
+Matrix4x4 ScalarAdd(const Matrix4x4& m1, const Matrix4x4& m2) { return Add(m1, m2); }
+Matrix4x4 ScalarSubtract(const Matrix4x4& m1, const Matrix4x4& m2) { return Subtract(m1, m2); }
+Matrix4x4 ScalarMultiply(const Matrix4x4& m1, const Matrix4x4& m2) { return Multiply(m1, m2); }
+Matrix4x4 ScalarTranspose(const Matrix4x4& m) { return Transpose(m); }
+Matrix4x4 ScalarInverse(const Matrix4x4& m) { return Inverse(m); }
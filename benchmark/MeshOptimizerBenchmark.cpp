@@ -0,0 +1,305 @@
+///==========================================================
+/// MeshOptimizer.cpp のベンチマーク
+/// 球を格子状に並べたメッシュ（三角形の順番はばらばら）と、行ごとに並んだ格子のメッシュを作り
+/// OptimizeMesh の前後の ACMR / ATVR（FIFO 16 / 32）と、6方向から見たオーバードローを比べる
+/// ディレクトリを指定すると、その中のobjファイルも同じように調べる
+/// 三角形（頂点の中身と向き）がサブメッシュごとに変わっていないか、ACMRが悪くなっていないかも確かめる
+///
+/// ビルド例（Windowsヘッダーは不要）
+///   g++ -std=c++20 -O2 -march=native -pthread -I.. MeshOptimizerBenchmark.cpp ../MeshOptimizer.cpp ../ObjLoader.cpp ../TangentSpace.cpp -o MeshOptimizerBenchmark
+///   cl /std:c++20 /O2 /EHsc /I.. MeshOptimizerBenchmark.cpp ..\MeshOptimizer.cpp ..\ObjLoader.cpp ..\TangentSpace.cpp
+///
+/// 使い方
+///   MeshOptimizerBenchmark [球の分割数] [objファイルのあるディレクトリ]
+///==========================================================
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <numbers>
+#include <random>
+
+#include "MeshOptimizer.h"
+#include "ObjLoader.h"
+#include "VectorMath.h"
+#include "BenchmarkCommon.h"
+
+namespace
+{
+	//マテリアルが1つのモデルにする
+	void SetSingleSubmesh(ModelData& model)
+	{
+		model.materials.assign(1, MaterialData{});
+		model.submeshes.assign(1, SubmeshData{ "", 0, uint32_t(model.indices.size()), 0 });
+	}
+
+	//球を count x count x count の格子状に並べる。球どうしが奥行き方向に重なるのでオーバードローが起きる
+	//三角形の順番はばらばらにする（並べ替えていない出力の最悪の場合）
+	ModelData MakeSphereLattice(uint32_t segments, uint32_t count)
+	{
+		ModelData model;
+		const float pi = std::numbers::pi_v<float>;
+		for (uint32_t sphere = 0; sphere < count * count * count; sphere++)
+		{
+			const Vector3 center{ float(sphere % count) * 2.5f, float(sphere / count % count) * 2.5f, float(sphere / (count * count)) * 2.5f };
+			const uint32_t base = uint32_t(model.vertices.size());
+			for (uint32_t lat = 0; lat <= segments; lat++)
+			{
+				const float theta = pi * float(lat) / float(segments);
+				for (uint32_t lon = 0; lon <= segments; lon++)
+				{
+					const float phi = 2.0f * pi * float(lon) / float(segments);
+					const Vector3 normal{ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+					const Vector3 position = Add(center, normal);
+					model.vertices.push_back({ { position.x, position.y, position.z, 1.0f }, { float(lon) / float(segments), float(lat) / float(segments) }, normal });
+				}
+			}
+			for (uint32_t lat = 0; lat < segments; lat++)
+			{
+				for (uint32_t lon = 0; lon < segments; lon++)
+				{
+					const uint32_t a = base + lat * (segments + 1) + lon;
+					const uint32_t b = a + segments + 1;
+					//外側が表になる向き（cross(b - a, c - a) が外を向く）
+					model.indices.insert(model.indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+				}
+			}
+		}
+
+		std::vector<std::array<uint32_t, 3>> triangles(model.indices.size() / 3);
+		std::memcpy(triangles.data(), model.indices.data(), model.indices.size() * sizeof(uint32_t));
+		std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1));
+		std::memcpy(model.indices.data(), triangles.data(), model.indices.size() * sizeof(uint32_t));
+		SetSingleSubmesh(model);
+		return model;
+	}
+
+	//size x size の格子を行ごとに並べる（多くのエクスポーターの出力に近い）
+	ModelData MakeGrid(uint32_t size)
+	{
+		ModelData model;
+		for (uint32_t y = 0; y <= size; y++)
+		{
+			for (uint32_t x = 0; x <= size; x++)
+			{
+				model.vertices.push_back({ { float(x), 0.0f, float(y), 1.0f }, { float(x) / float(size), float(y) / float(size) }, { 0.0f, 1.0f, 0.0f } });
+			}
+		}
+		for (uint32_t y = 0; y < size; y++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				const uint32_t a = y * (size + 1) + x;
+				const uint32_t b = a + size + 1;
+				model.indices.insert(model.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+		SetSingleSubmesh(model);
+		return model;
+	}
+
+	//6方向から正射影で描いたときの、見えている画素あたりのピクセルシェーダーの実行回数
+	//裏面は描かず、深度テストはラスタライズの順に行う（Early-Z）
+	double AnalyzeOverdraw(const ModelData& model)
+	{
+		static constexpr int kResolution = 256;
+		Vector3 minimum{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vector3 maximum{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (const VertexData& vertex : model.vertices)
+		{
+			minimum = { std::min(minimum.x, vertex.position.x), std::min(minimum.y, vertex.position.y), std::min(minimum.z, vertex.position.z) };
+			maximum = { std::max(maximum.x, vertex.position.x), std::max(maximum.y, vertex.position.y), std::max(maximum.z, vertex.position.z) };
+		}
+		const float extent = std::max({ maximum.x - minimum.x, maximum.y - minimum.y, maximum.z - minimum.z, 1e-6f });
+		const float scale = float(kResolution - 1) / extent;
+
+		uint64_t shaded = 0;
+		uint64_t covered = 0;
+		std::vector<float> depth(kResolution * kResolution);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			for (const float side : { 1.0f, -1.0f })
+			{
+				std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::infinity());
+				for (size_t i = 0; i + 3 <= model.indices.size(); i += 3)
+				{
+					//side側から見て表を向いている面だけを描く
+					const Vector4* positions[3];
+					for (int corner = 0; corner < 3; corner++)
+					{
+						positions[corner] = &model.vertices[model.indices[i + corner]].position;
+					}
+					const Vector3 a{ positions[0]->x, positions[0]->y, positions[0]->z };
+					const Vector3 normal = Cross(Subtract({ positions[1]->x, positions[1]->y, positions[1]->z }, a), Subtract({ positions[2]->x, positions[2]->y, positions[2]->z }, a));
+					const float facing[3] = { normal.x, normal.y, normal.z };
+					if (facing[axis] * side <= 0.0f)
+					{
+						continue;
+					}
+					//画面の座標と深度（手前ほど小さい）
+					float p[3][3];
+					for (int corner = 0; corner < 3; corner++)
+					{
+						const float xyz[3] = { positions[corner]->x - minimum.x, positions[corner]->y - minimum.y, positions[corner]->z - minimum.z };
+						p[corner][0] = xyz[(axis + 1) % 3] * scale;
+						p[corner][1] = xyz[(axis + 2) % 3] * scale;
+						p[corner][2] = -side * xyz[axis];
+					}
+					const float area = (p[1][0] - p[0][0]) * (p[2][1] - p[0][1]) - (p[1][1] - p[0][1]) * (p[2][0] - p[0][0]);
+					if (area == 0.0f)
+					{
+						continue;
+					}
+					const int x0 = std::max(0, int(std::ceil(std::min({ p[0][0], p[1][0], p[2][0] }) - 0.5f)));
+					const int x1 = std::min(kResolution - 1, int(std::floor(std::max({ p[0][0], p[1][0], p[2][0] }) - 0.5f)));
+					const int y0 = std::max(0, int(std::ceil(std::min({ p[0][1], p[1][1], p[2][1] }) - 0.5f)));
+					const int y1 = std::min(kResolution - 1, int(std::floor(std::max({ p[0][1], p[1][1], p[2][1] }) - 0.5f)));
+					for (int y = y0; y <= y1; y++)
+					{
+						for (int x = x0; x <= x1; x++)
+						{
+							const float px = float(x) + 0.5f;
+							const float py = float(y) + 0.5f;
+							float weights[3];
+							for (int corner = 0; corner < 3; corner++)
+							{
+								const float* e0 = p[(corner + 1) % 3];
+								const float* e1 = p[(corner + 2) % 3];
+								weights[corner] = ((e1[0] - e0[0]) * (py - e0[1]) - (e1[1] - e0[1]) * (px - e0[0])) / area;
+							}
+							if (weights[0] < 0.0f || weights[1] < 0.0f || weights[2] < 0.0f)
+							{
+								continue;
+							}
+							const float z = weights[0] * p[0][2] + weights[1] * p[1][2] + weights[2] * p[2][2];
+							float& stored = depth[y * kResolution + x];
+							if (z < stored)
+							{
+								stored = z;
+								shaded++;
+							}
+						}
+					}
+				}
+				for (const float value : depth)
+				{
+					covered += value != std::numeric_limits<float>::infinity();
+				}
+			}
+		}
+		return covered == 0 ? 0.0 : double(shaded) / double(covered);
+	}
+
+	//三角形を頂点の中身で表し、向きを変えずに回して並べたもの（順番と頂点番号によらない比較用）
+	std::vector<std::array<VertexData, 3>> CollectTriangles(const ModelData& model, const SubmeshData& submesh)
+	{
+		auto less = [](const VertexData& a, const VertexData& b) { return std::memcmp(&a, &b, sizeof(VertexData)) < 0; };
+		std::vector<std::array<VertexData, 3>> triangles;
+		for (uint32_t i = submesh.indexStart; i < submesh.indexStart + submesh.indexCount; i += 3)
+		{
+			std::array<VertexData, 3> triangle{ model.vertices[model.indices[i]], model.vertices[model.indices[i + 1]], model.vertices[model.indices[i + 2]] };
+			const size_t first = std::min_element(triangle.begin(), triangle.end(), less) - triangle.begin();
+			std::rotate(triangle.begin(), triangle.begin() + first, triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end(), [](const auto& a, const auto& b) { return std::memcmp(a.data(), b.data(), sizeof(a)) < 0; });
+		return triangles;
+	}
+
+	//サブメッシュの範囲、マテリアル、三角形の集まりが変わっていないか
+	bool IsSameTriangles(const ModelData& a, const ModelData& b)
+	{
+		if (a.submeshes.size() != b.submeshes.size() || a.indices.size() != b.indices.size() || b.vertices.size() > a.vertices.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.submeshes.size(); i++)
+		{
+			const SubmeshData& submeshA = a.submeshes[i];
+			const SubmeshData& submeshB = b.submeshes[i];
+			if (submeshA.indexStart != submeshB.indexStart || submeshA.indexCount != submeshB.indexCount || submeshA.materialIndex != submeshB.materialIndex)
+			{
+				return false;
+			}
+			const auto trianglesA = CollectTriangles(a, submeshA);
+			const auto trianglesB = CollectTriangles(b, submeshB);
+			if (std::memcmp(trianglesA.data(), trianglesB.data(), trianglesA.size() * sizeof(trianglesA[0])) != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//最適化の前後を比べて表示する
+	bool Report(const char* name, const ModelData& source)
+	{
+		ModelData optimized;
+		MeshOptimizationReport report{};
+		const double ns = MeasureBest(3, [&]()
+			{
+				optimized = source;
+				report = OptimizeMesh(optimized);
+			});
+		//オーバードローの並べ替えの効果を分けて見るため、頂点キャッシュの並べ替えだけの結果も作る
+		ModelData cacheOnly = source;
+		OptimizeVertexCache(cacheOnly.indices, cacheOnly.vertices.size());
+
+		const VertexCacheStatistics before32 = AnalyzeVertexCache(source.indices, source.vertices.size(), 32);
+		const VertexCacheStatistics after32 = AnalyzeVertexCache(optimized.indices, optimized.vertices.size(), 32);
+		std::printf("%s\n", name);
+		std::printf("  triangles        : %zu (%zu vertices, %zu submeshes)\n", source.indices.size() / 3, source.vertices.size(), source.submeshes.size());
+		std::printf("  OptimizeMesh     : %8.2f ms (%.1f Mtri/s)\n", ns * 1e-6, double(source.indices.size() / 3) / (ns * 1e-9) * 1e-6);
+		std::printf("  ACMR (FIFO 16)   : %.3f -> %.3f\n", report.before.acmr, report.after.acmr);
+		std::printf("  ATVR (FIFO 16)   : %.3f -> %.3f\n", report.before.atvr, report.after.atvr);
+		std::printf("  ACMR (FIFO 32)   : %.3f -> %.3f\n", before32.acmr, after32.acmr);
+		std::printf("  overdraw         : %.3f -> %.3f (vertex cache only %.3f)\n", AnalyzeOverdraw(source), AnalyzeOverdraw(optimized), AnalyzeOverdraw(cacheOnly));
+
+		//LODのインデックス（ここでは元の三角形を逆順にしたもの）を後ろに足しても、効率は元のメッシュだけで求める
+		ModelData withLod = source;
+		LodData& lod = withLod.lods.emplace_back(LodData{ source.submeshes, 0.0f });
+		for (SubmeshData& submesh : lod.submeshes)
+		{
+			submesh.indexStart += uint32_t(source.indices.size());
+		}
+		withLod.indices.insert(withLod.indices.end(), source.indices.rbegin(), source.indices.rend());
+		const MeshOptimizationReport lodReport = OptimizeMesh(withLod);
+
+		const VertexCacheStatistics after = AnalyzeVertexCache(optimized.indices, optimized.vertices.size());
+		bool ok = true;
+		ok &= Check("triangles are preserved", IsSameTriangles(source, optimized));
+		ok &= Check("report matches AnalyzeVertexCache", std::memcmp(&report.after, &after, sizeof(after)) == 0);
+		ok &= Check("report ignores LOD indices", std::memcmp(&lodReport, &report, sizeof(report)) == 0);
+		ok &= Check("ACMR does not get worse", report.after.acmr <= report.before.acmr * 1.05f + 1e-6f);
+		return ok;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t segments = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 48;
+	bool ok = true;
+
+	ok &= Report("sphere lattice (shuffled)", MakeSphereLattice(segments, 4));
+	ok &= Report("grid (row order)", MakeGrid(segments * 8));
+
+	if (argc > 2)
+	{
+		for (const auto& entry : std::filesystem::directory_iterator(argv[2]))
+		{
+			if (entry.path().extension() == ".obj")
+			{
+				const std::string filename = entry.path().filename().string();
+				ok &= Report(filename.c_str(), LoadObjFile(argv[2], filename));
+			}
+		}
+	}
+
+	std::printf("result           : %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
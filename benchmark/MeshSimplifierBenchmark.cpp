@@ -0,0 +1,267 @@
+///==========================================================
+/// MeshSimplifier.cpp の確認とベンチマーク
+/// UVの継ぎ目（同じ座標の別の頂点）と極のある球、縁の開いた平面の格子からLODを作り
+/// 三角形の数、継ぎ目と縁が変わっていないか（隙間ができないか）、ずれの大きさ、SelectLodの選び方を調べる
+/// ディレクトリを指定すると、その中のobjファイルのLODも表示する
+///
+/// ビルド例（Windowsヘッダーは不要）
+///   g++ -std=c++20 -O2 -march=native -pthread -I.. MeshSimplifierBenchmark.cpp ../MeshSimplifier.cpp ../ObjLoader.cpp ../TangentSpace.cpp -o MeshSimplifierBenchmark
+///   cl /std:c++20 /O2 /EHsc /I.. MeshSimplifierBenchmark.cpp ..\MeshSimplifier.cpp ..\ObjLoader.cpp ..\TangentSpace.cpp
+///
+/// 使い方
+///   MeshSimplifierBenchmark [球の分割数（64以上）] [objファイルのあるディレクトリ]
+///==========================================================
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <numbers>
+#include <tuple>
+#include <vector>
+
+#include "MeshSimplifier.h"
+#include "ObjLoader.h"
+#include "BenchmarkCommon.h"
+
+namespace
+{
+	//マテリアルが1つのモデルにする
+	void SetSingleSubmesh(ModelData& model)
+	{
+		model.materials.assign(1, MaterialData{});
+		model.submeshes.assign(1, SubmeshData{ "", 0, uint32_t(model.indices.size()), 0 });
+	}
+
+	//半径1のUV球。経度0と360度の列は同じ座標の別の頂点（UVの継ぎ目）、極は経度ごとに別の頂点になる
+	ModelData MakeUvSphere(uint32_t segments)
+	{
+		ModelData model;
+		const float pi = std::numbers::pi_v<float>;
+		for (uint32_t lat = 0; lat <= segments; lat++)
+		{
+			const float theta = pi * float(lat) / float(segments);
+			for (uint32_t lon = 0; lon <= segments * 2; lon++)
+			{
+				//継ぎ目の両側の座標を完全に同じにする
+				const float phi = lon == segments * 2 ? 0.0f : pi * float(lon) / float(segments);
+				const float y = lat == 0 ? 1.0f : lat == segments ? -1.0f : std::cos(theta);
+				const float ring = lat == 0 || lat == segments ? 0.0f : std::sin(theta);
+				const Vector3 normal{ ring * std::cos(phi), y, ring * std::sin(phi) };
+				model.vertices.push_back({ { normal.x, normal.y, normal.z, 1.0f }, { float(lon) / float(segments * 2), float(lat) / float(segments) }, normal });
+			}
+		}
+		const uint32_t stride = segments * 2 + 1;
+		for (uint32_t lat = 0; lat < segments; lat++)
+		{
+			for (uint32_t lon = 0; lon < segments * 2; lon++)
+			{
+				const uint32_t a = lat * stride + lon;
+				const uint32_t b = a + stride;
+				//極の面はつぶれた三角形になるので入れない
+				if (lat != 0)
+				{
+					model.indices.insert(model.indices.end(), { a, a + 1, b });
+				}
+				if (lat != segments - 1)
+				{
+					model.indices.insert(model.indices.end(), { a + 1, b + 1, b });
+				}
+			}
+		}
+		SetSingleSubmesh(model);
+		return model;
+	}
+
+	//縁の開いた平面の格子（内側の頂点はどこへ寄せてもずれない）
+	ModelData MakeFlatGrid(uint32_t size)
+	{
+		ModelData model;
+		for (uint32_t y = 0; y <= size; y++)
+		{
+			for (uint32_t x = 0; x <= size; x++)
+			{
+				model.vertices.push_back({ { float(x), 0.0f, float(y), 1.0f }, { float(x) / float(size), float(y) / float(size) }, { 0.0f, 1.0f, 0.0f } });
+			}
+		}
+		for (uint32_t y = 0; y < size; y++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				const uint32_t a = y * (size + 1) + x;
+				const uint32_t b = a + size + 1;
+				model.indices.insert(model.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+		SetSingleSubmesh(model);
+		return model;
+	}
+
+	//辺を向きのある組（始点, 終点）で集める。usePositionなら頂点番号ではなく座標で比べる
+	using Edge = std::tuple<float, float, float, float, float, float>;
+	std::vector<Edge> CollectEdges(const ModelData& model, const SubmeshData& submesh, bool usePosition)
+	{
+		std::vector<Edge> edges;
+		for (uint32_t i = 0; i < submesh.indexCount; i += 3)
+		{
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				const uint32_t from = model.indices[submesh.indexStart + i + corner];
+				const uint32_t to = model.indices[submesh.indexStart + i + (corner + 1) % 3];
+				if (usePosition)
+				{
+					const Vector4& p = model.vertices[from].position;
+					const Vector4& q = model.vertices[to].position;
+					edges.emplace_back(p.x, p.y, p.z, q.x, q.y, q.z);
+				}
+				else
+				{
+					edges.emplace_back(float(from), 0.0f, 0.0f, float(to), 0.0f, 0.0f);
+				}
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		return edges;
+	}
+
+	//逆向きの辺が無い辺（開いた縁）
+	std::vector<Edge> CollectBorderEdges(const ModelData& model, const SubmeshData& submesh, bool usePosition)
+	{
+		const std::vector<Edge> edges = CollectEdges(model, submesh, usePosition);
+		std::vector<Edge> borders;
+		for (const Edge& edge : edges)
+		{
+			const auto [x0, y0, z0, x1, y1, z1] = edge;
+			if (!std::binary_search(edges.begin(), edges.end(), Edge{ x1, y1, z1, x0, y0, z0 }))
+			{
+				borders.push_back(edge);
+			}
+		}
+		return borders;
+	}
+
+	//LODを作って調べる
+	//closed: 座標で見ると閉じたメッシュ（継ぎ目に隙間ができれば座標で見た縁が現れる）
+	bool Report(const char* name, const ModelData& source, bool closed)
+	{
+		ModelData model;
+		const double ns = MeasureBest(3, [&]()
+			{
+				model = source;
+				GenerateLodChain(model);
+			});
+
+		const size_t sourceTriangleCount = source.indices.size() / 3;
+		std::printf("%s\n", name);
+		std::printf("  triangles        : %zu (%zu vertices)\n", sourceTriangleCount, source.vertices.size());
+		std::printf("  GenerateLodChain : %8.2f ms (%.1f Mtri/s)\n", ns * 1e-6, double(sourceTriangleCount) / (ns * 1e-9) * 1e-6);
+
+		bool ok = true;
+		ok &= Check("original mesh is unchanged", model.vertices.size() == source.vertices.size() &&
+			std::equal(source.indices.begin(), source.indices.end(), model.indices.begin()));
+
+		const std::vector<Edge> sourceBorders = CollectBorderEdges(source, source.submeshes[0], false);
+		float previousError = 0.0f;
+		for (size_t level = 0; level < model.lods.size(); level++)
+		{
+			const LodData& lod = model.lods[level];
+			const SubmeshData& submesh = lod.submeshes[0];
+			const size_t triangleCount = submesh.indexCount / 3;
+			const size_t targetTriangleCount = size_t(double(source.indices.size()) * kDefaultLodRatios[level]) / 3;
+			std::printf("  LOD%zu             : %zu triangles (%.1f%%), error %.5f\n", level + 1, triangleCount, 100.0 * double(triangleCount) / double(sourceTriangleCount), lod.error);
+
+			ok &= Check("LOD reaches the target triangle count", triangleCount <= targetTriangleCount && triangleCount > 0);
+			ok &= Check("LOD error grows with each level", lod.error >= previousError);
+			ok &= Check("LOD keeps the material", submesh.materialIndex == source.submeshes[0].materialIndex);
+			ok &= Check("LOD indices are appended after the original", submesh.indexStart >= source.indices.size() &&
+				submesh.indexStart + submesh.indexCount <= model.indices.size());
+			ok &= Check("LOD keeps seam and border edges", CollectBorderEdges(model, submesh, false) == sourceBorders);
+			if (closed)
+			{
+				ok &= Check("LOD has no cracks", CollectBorderEdges(model, submesh, true).empty());
+			}
+			previousError = lod.error;
+		}
+		ok &= Check("LOD chain has every level", model.lods.size() == std::size(kDefaultLodRatios));
+		return ok;
+	}
+
+	//SimplifyMeshの戻り値がtargetErrorを超えないか
+	bool CheckTargetError(const ModelData& source, float targetError)
+	{
+		std::vector<Vector3> positions;
+		for (const VertexData& vertex : source.vertices)
+		{
+			positions.push_back({ vertex.position.x, vertex.position.y, vertex.position.z });
+		}
+		std::vector<uint32_t> result;
+		const float error = SimplifyMesh(source.indices, positions, 0, targetError, result);
+		std::printf("  target error %.4f : %zu triangles, error %.5f\n", targetError, result.size() / 3, error);
+		return Check("SimplifyMesh stays within targetError", error <= targetError && result.size() < source.indices.size());
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	//分割数が少ないと継ぎ目と縁の頂点（動かさない頂点）ばかりになって目標まで減らせないので、64以上にする
+	const uint32_t segments = std::max(argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 256u, 64u);
+	bool ok = true;
+
+	const ModelData sphere = MakeUvSphere(segments);
+	ok &= Report("uv sphere (seam and poles)", sphere, true);
+	ok &= CheckTargetError(sphere, 0.001f);
+
+	const ModelData grid = MakeFlatGrid(segments);
+	ok &= Report("flat grid (open border)", grid, false);
+	{
+		ModelData model = grid;
+		GenerateLodChain(model);
+		ok &= Check("flat grid is simplified without error", !model.lods.empty() && model.lods.back().error < 1e-3f);
+	}
+
+	//近いほど細かいLODになり、遠ければ最も粗いLODになる
+	{
+		ModelData model = sphere;
+		GenerateLodChain(model);
+		const float fovY = 0.45f;
+		uint32_t previous = 0;
+		bool isMonotonic = true;
+		for (float distance = 0.1f; distance < 1000.0f; distance *= 1.5f)
+		{
+			const uint32_t lod = SelectLod(model.lods, 1.0f, distance, fovY, 720.0f);
+			isMonotonic &= lod >= previous;
+			previous = lod;
+		}
+		ok &= Check("SelectLod picks the original mesh up close", SelectLod(model.lods, 1.0f, 0.1f, fovY, 720.0f) == 0);
+		ok &= Check("SelectLod picks the coarsest LOD far away", SelectLod(model.lods, 1.0f, 1e6f, fovY, 720.0f) == model.lods.size());
+		ok &= Check("SelectLod gets coarser with distance", isMonotonic);
+		ok &= Check("SelectLod gets finer with scale", SelectLod(model.lods, 100.0f, 100.0f, fovY, 720.0f) <= SelectLod(model.lods, 1.0f, 100.0f, fovY, 720.0f));
+		ok &= Check("SelectLod without LODs is the original mesh", SelectLod({}, 1.0f, 1e6f, fovY, 720.0f) == 0);
+	}
+
+	if (argc > 2)
+	{
+		for (const auto& entry : std::filesystem::directory_iterator(argv[2]))
+		{
+			if (entry.path().extension() == ".obj")
+			{
+				const std::string filename = entry.path().filename().string();
+				ModelData model = LoadObjFile(argv[2], filename);
+				GenerateLodChain(model);
+				std::printf("%s\n", filename.c_str());
+				for (size_t level = 0; level < model.lods.size(); level++)
+				{
+					size_t indexCount = 0;
+					for (const SubmeshData& submesh : model.lods[level].submeshes)
+					{
+						indexCount += submesh.indexCount;
+					}
+					std::printf("  LOD%zu             : %zu triangles, error %.5f\n", level + 1, indexCount / 3, model.lods[level].error);
+				}
+			}
+		}
+	}
+
+	std::printf("result           : %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
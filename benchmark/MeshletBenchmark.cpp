@@ -0,0 +1,275 @@
+///==========================================================
+/// Meshlet.cpp の確認とベンチマーク
+/// 球を格子状に並べたメッシュを OptimizeMesh で並べ替えてからメッシュレットに分け
+/// 上限（頂点64 / 三角形124）を守っているか、サブメッシュの範囲を隙間なく覆っているか
+/// 境界球と法線の円錐が中身を囲んでいるか（見える三角形を捨てていないか）を調べる
+/// いくつかの視点で、メッシュレットの判定で減らせた三角形の割合と判定の時間も表示する
+///
+/// ビルド例（Windowsヘッダーは不要）
+///   g++ -std=c++20 -O2 -march=native -pthread -I.. MeshletBenchmark.cpp ../Meshlet.cpp ../MeshOptimizer.cpp -o MeshletBenchmark
+///   cl /std:c++20 /O2 /EHsc /I.. MeshletBenchmark.cpp ..\Meshlet.cpp ..\MeshOptimizer.cpp
+///
+/// 使い方
+///   MeshletBenchmark [球の分割数]
+///==========================================================
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include "FrustumCulling.h"
+#include "MeshOptimizer.h"
+#include "Meshlet.h"
+#include "VectorMath.h"
+#include "BenchmarkCommon.h"
+
+namespace
+{
+	Vector3 PositionOf(const ModelData& model, uint32_t index)
+	{
+		const Vector4& position = model.vertices[index].position;
+		return { position.x, position.y, position.z };
+	}
+
+	//球を count x count x count の格子状に並べる。前半の球と後半の球を別のマテリアル（サブメッシュ）にする
+	ModelData MakeSphereLattice(uint32_t segments, uint32_t count)
+	{
+		ModelData model;
+		const float pi = std::numbers::pi_v<float>;
+		const uint32_t sphereCount = count * count * count;
+		uint32_t firstHalfIndexCount = 0;
+		for (uint32_t sphere = 0; sphere < sphereCount; sphere++)
+		{
+			const Vector3 center{ float(sphere % count) * 2.5f, float(sphere / count % count) * 2.5f, float(sphere / (count * count)) * 2.5f };
+			const uint32_t base = uint32_t(model.vertices.size());
+			for (uint32_t lat = 0; lat <= segments; lat++)
+			{
+				const float theta = pi * float(lat) / float(segments);
+				for (uint32_t lon = 0; lon <= segments; lon++)
+				{
+					const float phi = 2.0f * pi * float(lon) / float(segments);
+					const Vector3 normal{ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+					const Vector3 position = Add(center, normal);
+					model.vertices.push_back({ { position.x, position.y, position.z, 1.0f }, { float(lon) / float(segments), float(lat) / float(segments) }, normal });
+				}
+			}
+			for (uint32_t lat = 0; lat < segments; lat++)
+			{
+				for (uint32_t lon = 0; lon < segments; lon++)
+				{
+					const uint32_t a = base + lat * (segments + 1) + lon;
+					const uint32_t b = a + segments + 1;
+					//外側が表になる向き（cross(b - a, c - a) が外を向く）
+					model.indices.insert(model.indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+				}
+			}
+			if (sphere + 1 == sphereCount / 2)
+			{
+				firstHalfIndexCount = uint32_t(model.indices.size());
+			}
+		}
+		model.materials.assign(2, MaterialData{});
+		model.submeshes.push_back({ "first", 0, firstHalfIndexCount, 0 });
+		model.submeshes.push_back({ "second", firstHalfIndexCount, uint32_t(model.indices.size()) - firstHalfIndexCount, 1 });
+		return model;
+	}
+
+	//上限と、サブメッシュの範囲を先頭から隙間なく覆っているか
+	bool CheckLayout(const ModelData& model)
+	{
+		bool withinLimits = true;
+		bool covers = true;
+		size_t expectedMeshletStart = 0;
+		for (const SubmeshData& submesh : model.submeshes)
+		{
+			covers &= submesh.meshletStart == expectedMeshletStart;
+			uint32_t indexStart = submesh.indexStart;
+			for (uint32_t m = submesh.meshletStart; m < submesh.meshletStart + submesh.meshletCount; m++)
+			{
+				const MeshletData& meshlet = model.meshlets[m];
+				covers &= meshlet.indexStart == indexStart && meshlet.indexCount > 0 && meshlet.indexCount % 3 == 0;
+				indexStart += meshlet.indexCount;
+
+				std::vector<uint32_t> unique(model.indices.begin() + meshlet.indexStart, model.indices.begin() + meshlet.indexStart + meshlet.indexCount);
+				std::sort(unique.begin(), unique.end());
+				unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+				withinLimits &= unique.size() <= kMeshletMaxVertices && meshlet.indexCount / 3 <= kMeshletMaxTriangles;
+			}
+			covers &= indexStart == submesh.indexStart + submesh.indexCount;
+			expectedMeshletStart += submesh.meshletCount;
+		}
+		covers &= expectedMeshletStart == model.meshlets.size();
+		bool ok = true;
+		ok &= Check("meshlets stay within 64 vertices / 124 triangles", withinLimits);
+		ok &= Check("meshlets cover each submesh without gaps", covers);
+		return ok;
+	}
+
+	//境界球が頂点を囲み、円錐の軸が単位ベクトルで、裏向きと判定されたら全ての三角形が本当に裏向きか
+	bool CheckBounds(const ModelData& model)
+	{
+		bool enclosed = true;
+		bool unitAxis = true;
+		for (const MeshletData& meshlet : model.meshlets)
+		{
+			for (uint32_t i = 0; i < meshlet.indexCount; i++)
+			{
+				const Vector3 offset = Subtract(PositionOf(model, model.indices[meshlet.indexStart + i]), meshlet.center);
+				enclosed &= Length(offset) <= meshlet.radius * (1.0f + 1e-5f) + 1e-6f;
+			}
+			unitAxis &= std::fabs(Length(meshlet.coneAxis) - 1.0f) < 1e-4f;
+		}
+
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> coordinate(-10.0f, 20.0f);
+		size_t backfacingCount = 0;
+		size_t wrongCount = 0;
+		for (int sample = 0; sample < 200; sample++)
+		{
+			const Vector3 camera{ coordinate(random), coordinate(random), coordinate(random) };
+			for (const MeshletData& meshlet : model.meshlets)
+			{
+				if (!IsBackfacing(meshlet, camera))
+				{
+					continue;
+				}
+				backfacingCount++;
+				for (uint32_t i = 0; i < meshlet.indexCount; i += 3)
+				{
+					const Vector3 a = PositionOf(model, model.indices[meshlet.indexStart + i]);
+					const Vector3 b = PositionOf(model, model.indices[meshlet.indexStart + i + 1]);
+					const Vector3 c = PositionOf(model, model.indices[meshlet.indexStart + i + 2]);
+					//表向き（カメラが面の表側にある）なら捨ててはいけない
+					wrongCount += Dot(Cross(Subtract(b, a), Subtract(c, a)), Subtract(camera, a)) > 1e-6f;
+				}
+			}
+		}
+		std::printf("  cone samples     : %zu backfacing meshlets, %zu front-facing triangles among them\n", backfacingCount, wrongCount);
+		bool ok = true;
+		ok &= Check("bounding spheres enclose their vertices", enclosed);
+		ok &= Check("cone axes are unit vectors", unitAxis);
+		ok &= Check("cone culling finds backfacing meshlets", backfacingCount > 0);
+		ok &= Check("cone culling never drops a front-facing triangle", wrongCount == 0);
+		return ok;
+	}
+
+	//ローカルに移した視錐台が、ワールドで判定した結果と同じになるか（不均一スケールと回転を含む行列）
+	bool CheckLocalFrustum()
+	{
+		const Matrix4x4 world = MakeAffineMatrix({ 0.5f, 3.0f, 1.5f }, { 0.3f, -1.1f, 0.7f }, { 4.0f, -2.0f, 9.0f });
+		const Frustum frustum = MakeFrustum(Multiply(MakeViewMatrix({ { 1.0f, 1.0f, 1.0f }, { 0.2f, 0.4f, 0.0f }, { 0.0f, 0.0f, -10.0f } }),
+			MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f)));
+		const MeshletCullingView view = MakeMeshletCullingView(frustum, world, { 1.0f, 2.0f, 3.0f });
+
+		std::mt19937 random(5);
+		std::uniform_real_distribution<float> coordinate(-20.0f, 20.0f);
+		size_t mismatches = 0;
+		for (int sample = 0; sample < 100000; sample++)
+		{
+			const Vector3 local{ coordinate(random), coordinate(random), coordinate(random) };
+			const Vector3 worldPosition = Transforms(local, world);
+			for (int i = 0; i < 6; i++)
+			{
+				const float worldDistance = SignedDistance(frustum.planes[i], worldPosition);
+				const float localDistance = SignedDistance(view.frustum.planes[i], local);
+				//ローカルの距離は移した平面の長さで割ってあるので、符号だけ比べる（平面のすぐ近くは丸めで揺れるので除く）
+				mismatches += std::fabs(worldDistance) > 1e-3f && (worldDistance < 0.0f) != (localDistance < 0.0f);
+			}
+		}
+		const Vector3 camera = Transforms(view.cameraPosition, world);
+		bool ok = true;
+		ok &= Check("local frustum matches the world frustum", mismatches == 0);
+		ok &= Check("local camera position maps back to the world", Length(Subtract(camera, { 1.0f, 2.0f, 3.0f })) < 1e-4f);
+		ok &= Check("backface culling is on for a regular matrix", view.cullBackface);
+		ok &= Check("backface culling is off for a mirrored matrix",
+			!MakeMeshletCullingView(frustum, MakeScaleMatrix({ -1.0f, 1.0f, 1.0f }), { 0.0f, 0.0f, 0.0f }).cullBackface);
+		return ok;
+	}
+
+	//視点を置いてメッシュレットの判定をし、見えている三角形を捨てていないか確かめる
+	bool Report(const char* name, const ModelData& model, const Transform& camera)
+	{
+		const Matrix4x4 viewProjection = Multiply(MakeViewMatrix(camera), MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f));
+		const Frustum frustum = MakeFrustum(viewProjection);
+		const Matrix4x4 world = MakeIdentity();
+
+		std::vector<uint32_t> visibleIndices;
+		visibleIndices.reserve(model.indices.size());
+		size_t visibleMeshletCount = 0;
+		const double ns = MeasureBest(10, [&]()
+			{
+				visibleIndices.clear();
+				visibleMeshletCount = 0;
+				const MeshletCullingView view = MakeMeshletCullingView(frustum, world, camera.translate);
+				for (const SubmeshData& submesh : model.submeshes)
+				{
+					visibleMeshletCount += CullMeshlets(std::span<const MeshletData>(model.meshlets).subspan(submesh.meshletStart, submesh.meshletCount), model.indices, view, visibleIndices);
+				}
+			});
+
+		//捨てたメッシュレットの中に、表向きで視錐台の中に頂点がある三角形が無いか
+		const MeshletCullingView view = MakeMeshletCullingView(frustum, world, camera.translate);
+		size_t droppedVisibleCount = 0;
+		size_t frontFacingCount = 0;
+		for (const MeshletData& meshlet : model.meshlets)
+		{
+			std::vector<uint32_t> single;
+			const bool kept = CullMeshlets(std::span<const MeshletData>(&meshlet, 1), model.indices, view, single) == 1;
+			for (uint32_t i = 0; i < meshlet.indexCount; i += 3)
+			{
+				const Vector3 a = PositionOf(model, model.indices[meshlet.indexStart + i]);
+				const Vector3 b = PositionOf(model, model.indices[meshlet.indexStart + i + 1]);
+				const Vector3 c = PositionOf(model, model.indices[meshlet.indexStart + i + 2]);
+				const bool frontFacing = Dot(Cross(Subtract(b, a), Subtract(c, a)), Subtract(camera.translate, a)) > 0.0f;
+				const bool inside = IsVisible(frustum, Sphere{ a, 0.0f }) || IsVisible(frustum, Sphere{ b, 0.0f }) || IsVisible(frustum, Sphere{ c, 0.0f });
+				frontFacingCount += frontFacing && inside;
+				droppedVisibleCount += !kept && frontFacing && inside;
+			}
+		}
+
+		const size_t triangleCount = model.indices.size() / 3;
+		std::printf("%s\n", name);
+		std::printf("  visible          : %zu / %zu meshlets, %zu / %zu triangles (%.1f%% culled, %zu front-facing in view)\n",
+			visibleMeshletCount, model.meshlets.size(), visibleIndices.size() / 3, triangleCount, 100.0 * (1.0 - double(visibleIndices.size() / 3) / double(triangleCount)), frontFacingCount);
+		std::printf("  CullMeshlets     : %8.3f ms (%.1f Mmeshlets/s, including index copy)\n", ns * 1e-6, double(model.meshlets.size()) / (ns * 1e-9) * 1e-6);
+		return Check("culling never drops a visible triangle", droppedVisibleCount == 0);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t segments = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 48;
+	bool ok = true;
+
+	ModelData model = MakeSphereLattice(segments, 6);
+	OptimizeMesh(model);
+	const double buildNs = MeasureBest(3, [&]() { BuildMeshlets(model); });
+
+	size_t vertexSum = 0;
+	for (const MeshletData& meshlet : model.meshlets)
+	{
+		std::vector<uint32_t> unique(model.indices.begin() + meshlet.indexStart, model.indices.begin() + meshlet.indexStart + meshlet.indexCount);
+		std::sort(unique.begin(), unique.end());
+		vertexSum += std::unique(unique.begin(), unique.end()) - unique.begin();
+	}
+	std::printf("sphere lattice\n");
+	std::printf("  triangles        : %zu (%zu vertices, %zu submeshes)\n", model.indices.size() / 3, model.vertices.size(), model.submeshes.size());
+	std::printf("  meshlets         : %zu (%.1f vertices, %.1f triangles on average)\n", model.meshlets.size(),
+		double(vertexSum) / double(model.meshlets.size()), double(model.indices.size() / 3) / double(model.meshlets.size()));
+	std::printf("  BuildMeshlets    : %8.2f ms\n", buildNs * 1e-6);
+
+	ok &= CheckLayout(model);
+	ok &= CheckBounds(model);
+	ok &= CheckLocalFrustum();
+
+	//格子の外から全体を見る / 格子の中から一部を見る / 横から端だけを見る
+	ok &= Report("view: outside", model, { { 1.0f, 1.0f, 1.0f }, { 0.3f, 0.0f, 0.0f }, { 6.25f, 12.0f, -25.0f } });
+	ok &= Report("view: inside", model, { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.8f, 0.0f }, { 6.25f, 6.25f, 6.25f } });
+	ok &= Report("view: edge", model, { { 1.0f, 1.0f, 1.0f }, { 0.0f, -1.2f, 0.0f }, { 30.0f, 6.25f, 2.0f } });
+
+	std::printf("result           : %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
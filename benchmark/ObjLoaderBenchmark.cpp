@@ -0,0 +1,300 @@
+///==========================================================
+/// ObjLoader.cpp のベンチマーク
+/// 格子状のobjファイル（既定は約100万面）を生成し
+/// 以前の getline / stringstream 版の読み込みと LoadObjFile（逐次 / 並列）を比べる
+/// LoadObjFileのインデックスを展開した結果が以前の頂点列と同じか
+/// 逐次と並列の結果が1ビットも違わないかを確かめる
+/// キャッシュ（.mesh）を書き出す初回と、キャッシュから読む2回目以降の時間も測り、結果が同じか確かめる
+/// （キャッシュは CookMesh でLODやメッシュレットなどを作った後のものなので、解析結果も CookMesh してから比べる）
+///
+/// ビルド例（Windowsヘッダーは不要）
+///   g++ -std=c++20 -O2 -march=native -pthread -I.. ObjLoaderBenchmark.cpp ../ObjLoader.cpp ../MeshCache.cpp ../MeshOptimizer.cpp ../Meshlet.cpp ../TangentSpace.cpp ../MeshSimplifier.cpp ../MappedFile.cpp -o ObjLoaderBenchmark
+///   cl /std:c++20 /O2 /EHsc /I.. ObjLoaderBenchmark.cpp ..\ObjLoader.cpp ..\MeshCache.cpp ..\MeshOptimizer.cpp ..\Meshlet.cpp ..\TangentSpace.cpp ..\MeshSimplifier.cpp ..\MappedFile.cpp
+///
+/// 使い方
+///   ObjLoaderBenchmark [面の数] [スレッド数（0ならコア数）]
+///==========================================================
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "MeshCache.h"
+#include "ObjLoader.h"
+#include "BenchmarkCommon.h"
+
+namespace
+{
+	//以前の main.cpp にあった実装（比較用）
+	MaterialData LoadMaterialTemplateFileLegacy(const std::string& directoryPath, const std::string& filename)
+	{
+		MaterialData materialData;
+		std::string line;
+		std::ifstream file(directoryPath + "/" + filename);
+		assert(file.is_open());
+		while (std::getline(file, line))
+		{
+			std::string identifire;
+			std::istringstream s(line);
+			s >> identifire;
+			if (identifire == "map_Kd")
+			{
+				std::string textureFilename;
+				s >> textureFilename;
+				materialData.textureFilePath = directoryPath + "/" + textureFilename;
+			}
+		}
+		return materialData;
+	}
+
+	//以前のModelData（頂点は三角形ごとに並び、マテリアルは1つ）
+	struct LegacyModelData
+	{
+		std::vector<VertexData> vertices;
+		MaterialData material;
+	};
+
+	LegacyModelData LoadObjFileLegacy(const std::string& directoryPath, const std::string& filename)
+	{
+		LegacyModelData modelData;
+		std::vector<Vector4> positions;
+		std::vector<Vector3> normals;
+		std::vector<Vector2> texcoords;
+		std::string line;
+		std::ifstream file(directoryPath + "/" + filename);
+		assert(file.is_open());
+		while (std::getline(file, line))
+		{
+			std::string identifier;
+			std::stringstream s(line);
+			s >> identifier;
+			if (identifier == "v")
+			{
+				Vector4 position{};
+				s >> position.x >> position.y >> position.z;
+				position.w = 1.0f;
+				positions.push_back(position);
+			}
+			else if (identifier == "vt")
+			{
+				Vector2 texcoord{};
+				s >> texcoord.x >> texcoord.y;
+				texcoords.push_back(texcoord);
+			}
+			else if (identifier == "vn")
+			{
+				Vector3 normal{};
+				s >> normal.x >> normal.y >> normal.z;
+				normals.push_back(normal);
+			}
+			else if (identifier == "f")
+			{
+				VertexData triangle[3];
+				for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex)
+				{
+					std::string vertexDefinition;
+					s >> vertexDefinition;
+					std::istringstream v(vertexDefinition);
+					uint32_t elementIndieces[3]{};
+					for (int32_t element = 0; element < 3; ++element)
+					{
+						std::string index;
+						std::getline(v, index, '/');
+						elementIndieces[element] = std::stoi(index);
+					}
+					Vector4 position = positions[size_t(elementIndieces[0]) - 1];
+					Vector2 texcoord = texcoords[size_t(elementIndieces[1]) - 1];
+					Vector3 normal = normals[size_t(elementIndieces[2]) - 1];
+					position.x *= -1;
+					texcoord.y = 1.0f - texcoord.y;
+					normal.x *= -1;
+					triangle[faceVertex] = { position,texcoord,normal };
+				}
+				modelData.vertices.push_back(triangle[2]);
+				modelData.vertices.push_back(triangle[1]);
+				modelData.vertices.push_back(triangle[0]);
+			}
+			else if (identifier == "mtllib")
+			{
+				std::string materialFilename;
+				s >> materialFilename;
+				modelData.material = LoadMaterialTemplateFileLegacy(directoryPath, materialFilename);
+			}
+		}
+		return modelData;
+	}
+
+	//インデックスを展開して、以前と同じ三角形ごとの頂点列に戻す
+	std::vector<VertexData> ExpandIndices(const ModelData& modelData)
+	{
+		std::vector<VertexData> vertices;
+		vertices.reserve(modelData.indices.size());
+		for (uint32_t index : modelData.indices)
+		{
+			vertices.push_back(modelData.vertices[index]);
+		}
+		return vertices;
+	}
+
+	//2つのModelDataが1ビットも違わないか
+	bool IsSameSubmeshes(const std::vector<SubmeshData>& a, const std::vector<SubmeshData>& b)
+	{
+		if (a.size() != b.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			const SubmeshData& x = a[i];
+			const SubmeshData& y = b[i];
+			if (x.name != y.name || x.indexStart != y.indexStart || x.indexCount != y.indexCount || x.materialIndex != y.materialIndex ||
+				x.meshletStart != y.meshletStart || x.meshletCount != y.meshletCount)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool IsSameModel(const ModelData& a, const ModelData& b)
+	{
+		if (a.vertices.size() != b.vertices.size() || a.indices != b.indices ||
+			!IsSameSubmeshes(a.submeshes, b.submeshes) || a.lods.size() != b.lods.size() || a.materials.size() != b.materials.size() ||
+			a.meshlets.size() != b.meshlets.size() ||
+			std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(VertexData)) != 0 ||
+			std::memcmp(a.meshlets.data(), b.meshlets.data(), a.meshlets.size() * sizeof(MeshletData)) != 0)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.lods.size(); i++)
+		{
+			if (!IsSameSubmeshes(a.lods[i].submeshes, b.lods[i].submeshes) || a.lods[i].error != b.lods[i].error)
+			{
+				return false;
+			}
+		}
+		for (size_t i = 0; i < a.materials.size(); i++)
+		{
+			const MaterialData& x = a.materials[i];
+			const MaterialData& y = b.materials[i];
+			if (x.name != y.name || x.diffuseColor != y.diffuseColor || x.specularColor != y.specularColor ||
+				x.shininess != y.shininess || x.alpha != y.alpha || x.textureFilePath != y.textureFilePath)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//波打った格子のobjを書き出す。面の数はおよそfaceCountになる
+	size_t WriteGridObj(const std::filesystem::path& directory, size_t faceCount)
+	{
+		const size_t cells = size_t(std::sqrt(double(faceCount) / 2.0)) + 1;
+		std::FILE* file = std::fopen((directory / "grid.obj").string().c_str(), "w");
+		assert(file);
+		std::fprintf(file, "# benchmark grid\nmtllib grid.mtl\no Grid\n");
+		for (size_t y = 0; y <= cells; y++)
+		{
+			for (size_t x = 0; x <= cells; x++)
+			{
+				float fx = float(x) / float(cells);
+				float fy = float(y) / float(cells);
+				std::fprintf(file, "v %f %f %f\n", fx * 10.0f - 5.0f, std::sin(fx * 20.0f) * std::cos(fy * 20.0f), fy * 10.0f - 5.0f);
+			}
+		}
+		for (size_t y = 0; y <= cells; y++)
+		{
+			for (size_t x = 0; x <= cells; x++)
+			{
+				std::fprintf(file, "vt %f %f\n", float(x) / float(cells), float(y) / float(cells));
+			}
+		}
+		std::fprintf(file, "vn 0.000000 1.000000 0.000000\n");
+		std::fprintf(file, "usemtl Grid\ns off\n");
+		for (size_t y = 0; y < cells; y++)
+		{
+			for (size_t x = 0; x < cells; x++)
+			{
+				size_t i0 = y * (cells + 1) + x + 1;
+				size_t i1 = i0 + 1;
+				size_t i2 = i0 + cells + 1;
+				size_t i3 = i2 + 1;
+				std::fprintf(file, "f %zu/%zu/1 %zu/%zu/1 %zu/%zu/1\n", i0, i0, i2, i2, i1, i1);
+				std::fprintf(file, "f %zu/%zu/1 %zu/%zu/1 %zu/%zu/1\n", i1, i1, i2, i2, i3, i3);
+			}
+		}
+		std::fclose(file);
+
+		file = std::fopen((directory / "grid.mtl").string().c_str(), "w");
+		assert(file);
+		std::fprintf(file, "newmtl Grid\nKd 0.8 0.8 0.8\nmap_Kd uvChecker.png\n");
+		std::fclose(file);
+		return cells * cells * 2;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const size_t requestedFaces = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	const uint32_t threadCount = argc > 2 ? uint32_t(std::strtoul(argv[2], nullptr, 10)) : 0;
+	const int repeat = 3;
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "ObjLoaderBenchmark";
+	std::filesystem::create_directories(directory);
+	const size_t faceCount = WriteGridObj(directory, requestedFaces);
+	const uintmax_t fileSize = std::filesystem::file_size(directory / "grid.obj");
+
+	LegacyModelData legacy;
+	ModelData current;
+	ModelData parallel;
+	double legacyNs = MeasureBest(repeat, [&]() { legacy = LoadObjFileLegacy(directory.string(), "grid.obj"); });
+	double currentNs = MeasureBest(repeat, [&]() { current = LoadObjFile(directory.string(), "grid.obj", 1); });
+	double parallelNs = MeasureBest(repeat, [&]() { parallel = LoadObjFile(directory.string(), "grid.obj", threadCount); });
+
+	//キャッシュを書き出す初回と、キャッシュから読む2回目以降
+	ModelData cached;
+	std::filesystem::remove(directory / "grid.obj.mesh");
+	double cookNs = MeasureBest(1, [&]() { cached = LoadCachedObjFile(directory.string(), "grid.obj", threadCount); });
+	double cachedNs = MeasureBest(repeat, [&]() { cached = LoadCachedObjFile(directory.string(), "grid.obj", threadCount); });
+	const uintmax_t cacheSize = std::filesystem::file_size(directory / "grid.obj.mesh");
+
+	const std::vector<VertexData> expanded = ExpandIndices(current);
+	//格子はマテリアルが1つなので、面の順番は以前と変わらない
+	const bool identical =
+		legacy.vertices.size() == expanded.size() &&
+		std::memcmp(legacy.vertices.data(), expanded.data(), legacy.vertices.size() * sizeof(VertexData)) == 0 &&
+		current.materials.size() == 1 && legacy.material.textureFilePath == current.materials[0].textureFilePath;
+	const bool parallelIdentical = IsSameModel(current, parallel);
+	ModelData optimized = current;
+	CookMesh(optimized);
+	const bool cachedIdentical = IsSameModel(optimized, cached);
+
+	std::printf("faces            : %zu\n", faceCount);
+	std::printf("file size        : %.1f MB\n", double(fileSize) / (1024.0 * 1024.0));
+	std::printf("getline/sstream  : %8.1f ms (%6.1f MB/s)\n", legacyNs * 1e-6, double(fileSize) / (legacyNs * 1e-9) / (1024.0 * 1024.0));
+	std::printf("LoadObjFile (1)  : %8.1f ms (%6.1f MB/s)\n", currentNs * 1e-6, double(fileSize) / (currentNs * 1e-9) / (1024.0 * 1024.0));
+	std::printf("LoadObjFile (%u)  : %8.1f ms (%6.1f MB/s)\n", threadCount, parallelNs * 1e-6, double(fileSize) / (parallelNs * 1e-9) / (1024.0 * 1024.0));
+	std::printf("cook (.mesh)     : %8.1f ms\n", cookNs * 1e-6);
+	std::printf("cached (.mesh)   : %8.1f ms (%6.1f MB/s, %.1f MB file)\n", cachedNs * 1e-6, double(cacheSize) / (cachedNs * 1e-9) / (1024.0 * 1024.0), double(cacheSize) / (1024.0 * 1024.0));
+	std::printf("speedup          : %8.2fx (serial), %.2fx (parallel), %.2fx (cached)\n", legacyNs / currentNs, legacyNs / parallelNs, legacyNs / cachedNs);
+	//16bitのインデックスが使えるかどうかも含めたメモリ量
+	const size_t indexSize = current.vertices.size() <= 0xFFFF ? sizeof(uint16_t) : sizeof(uint32_t);
+	const size_t legacyBytes = legacy.vertices.size() * sizeof(VertexData);
+	const size_t currentBytes = current.vertices.size() * sizeof(VertexData) + current.indices.size() * indexSize;
+	std::printf("vertices         : %zu -> %zu (+ %zu indices, %zu bytes each)\n", legacy.vertices.size(), current.vertices.size(), current.indices.size(), indexSize);
+	std::printf("mesh memory      : %.1f MB -> %.1f MB (%.2fx smaller)\n",
+		double(legacyBytes) / (1024.0 * 1024.0), double(currentBytes) / (1024.0 * 1024.0), double(legacyBytes) / double(currentBytes));
+
+	bool ok = true;
+	ok &= Check("LoadObjFile matches the getline/sstream loader", identical);
+	ok &= Check("serial and parallel LoadObjFile are identical", parallelIdentical);
+	ok &= Check("cached (.mesh) model matches the cooked parse", cachedIdentical);
+
+	std::filesystem::remove_all(directory);
+	std::printf("result           : %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
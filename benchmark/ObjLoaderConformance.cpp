@@ -0,0 +1,471 @@
+///==========================================================
+/// ObjLoader.cpp の面の読み込みの確認
+/// 手書きのobj（四角形、凹多角形、"v" / "v/vt" / "v//vn"、負の番号、タブやCRLF、行末のコメント、スムージンググループなど）と
+/// ランダムに作ったobjを読み込み、三角形への分割と頂点の値が正しいかを確かめる
+///
+/// ランダムなobjでは次を確かめる
+///   ・n角形がn-2個の三角形になり、どの三角形も元の面と同じ向きで、面積の合計が元の面と同じ
+///   ・三角形の頂点がすべて元の面の頂点で、位置 / UV / 法線が一致する（法線が無ければ面法線）
+///   ・大きなファイルを逐次と並列で読んだ結果が1ビットも違わない
+///
+/// ビルド例（Windowsヘッダーは不要）
+///   g++ -std=c++20 -O2 -march=native -pthread -I.. ObjLoaderConformance.cpp ../ObjLoader.cpp ../TangentSpace.cpp -o ObjLoaderConformance
+///   cl /std:c++20 /O2 /EHsc /I.. ObjLoaderConformance.cpp ..\ObjLoader.cpp ..\TangentSpace.cpp
+///
+/// 使い方
+///   ObjLoaderConformance [ランダムなobjの数] [シード]
+///==========================================================
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ObjLoader.h"
+#include "VectorMath.h"
+#include "BenchmarkCommon.h"
+
+namespace
+{
+	///==========================================================
+	/// 面の頂点の期待値（objに書いた値そのもの）
+	///==========================================================
+	struct Corner
+	{
+		Vector3 position;
+		bool hasTexcoord;
+		Vector2 texcoord;
+		bool hasNormal;
+		Vector3 normal;
+	};
+	using Polygon = std::vector<Corner>;
+
+	//テキストをobjファイルとして書いて読み込む
+	ModelData LoadObjText(const std::filesystem::path& directory, const std::string& text, uint32_t threadCount = 1)
+	{
+		std::FILE* file = std::fopen((directory / "case.obj").string().c_str(), "wb");
+		std::fwrite(text.data(), 1, text.size(), file);
+		std::fclose(file);
+		return LoadObjFile(directory.string(), "case.obj", threadCount);
+	}
+
+	//多角形の法線（Newell法）。大きさは面積の2倍
+	Vector3 PolygonNormal(const Polygon& polygon)
+	{
+		Vector3 normal{ 0.0f, 0.0f, 0.0f };
+		for (size_t i = 0; i < polygon.size(); i++)
+		{
+			const Vector3& a = polygon[i].position;
+			const Vector3& b = polygon[(i + 1) % polygon.size()].position;
+			normal.x += (a.y - b.y) * (a.z + b.z);
+			normal.y += (a.z - b.z) * (a.x + b.x);
+			normal.z += (a.x - b.x) * (a.y + b.y);
+		}
+		return normal;
+	}
+
+	bool IsNear(const Vector3& a, const Vector3& b, float tolerance)
+	{
+		return std::abs(a.x - b.x) <= tolerance && std::abs(a.y - b.y) <= tolerance && std::abs(a.z - b.z) <= tolerance;
+	}
+
+	//読み込んだ頂点が元の面の頂点のどれかと一致するか
+	bool MatchesCorner(const VertexData& vertex, const Polygon& polygon, const Vector3& flatNormal)
+	{
+		for (const Corner& corner : polygon)
+		{
+			//左手系に直した値と比べる
+			const Vector4 position{ -corner.position.x, corner.position.y, corner.position.z, 1.0f };
+			const Vector2 texcoord = corner.hasTexcoord ? Vector2{ corner.texcoord.x, 1.0f - corner.texcoord.y } : Vector2{ 0.0f, 0.0f };
+			const Vector3 normal = corner.hasNormal ? Vector3{ -corner.normal.x, corner.normal.y, corner.normal.z } : Vector3{ -flatNormal.x, flatNormal.y, flatNormal.z };
+			if (vertex.position == position && vertex.texcoord == texcoord && IsNear(vertex.normal, normal, 1e-5f))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//面の順に三角形が並んでいるモデルを、元の面と比べる（マテリアルが1つのときは面の順のまま）
+	bool VerifyFaces(const ModelData& modelData, const std::vector<Polygon>& polygons)
+	{
+		size_t index = 0;
+		for (const Polygon& polygon : polygons)
+		{
+			const Vector3 polygonNormal = PolygonNormal(polygon);
+			const Vector3 flatNormal = Nomalize(polygonNormal);
+			const float polygonArea = Length(polygonNormal) * 0.5f;
+			float area = 0.0f;
+			for (size_t triangle = 0; triangle + 2 < polygon.size(); triangle++, index += 3)
+			{
+				if (index + 3 > modelData.indices.size())
+				{
+					return false;
+				}
+				//巻き順とxの向きを元に戻す
+				Vector3 positions[3];
+				for (size_t i = 0; i < 3; i++)
+				{
+					const VertexData& vertex = modelData.vertices[modelData.indices[index + 2 - i]];
+					if (!MatchesCorner(vertex, polygon, flatNormal))
+					{
+						return false;
+					}
+					positions[i] = { -vertex.position.x, vertex.position.y, vertex.position.z };
+				}
+				const Vector3 cross = Cross(positions[1] - positions[0], positions[2] - positions[0]);
+				//裏返った三角形があってはいけない
+				if (Dot(cross, polygonNormal) < -1e-4f * Length(polygonNormal) * Length(cross))
+				{
+					return false;
+				}
+				area += Length(cross) * 0.5f;
+			}
+			if (std::abs(area - polygonArea) > 1e-3f * std::max(polygonArea, 1.0f))
+			{
+				return false;
+			}
+		}
+		return index == modelData.indices.size();
+	}
+
+	//小数を書いて、読み込んだときと同じ値に丸める
+	float AppendFloat(std::string& text, float value)
+	{
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), " %.6f", value);
+		text += buffer;
+		return std::strtof(buffer, nullptr);
+	}
+
+	///==========================================================
+	/// ランダムなobjを作る
+	/// 面は平面上の星形の多角形（凹みを含む）で、頂点の書き方・番号の正負・空白をばらばらにする
+	///==========================================================
+	class RandomObjWriter
+	{
+	public:
+		explicit RandomObjWriter(uint32_t seed) : random_(seed) {}
+
+		void Write(size_t faceCount, std::string& text, std::vector<Polygon>& polygons)
+		{
+			text.clear();
+			polygons.clear();
+			positionCount_ = 0;
+			texcoordCount_ = 0;
+			normalCount_ = 0;
+			text += "# random faces\n";
+			for (size_t face = 0; face < faceCount; face++)
+			{
+				if (Chance(0.05))
+				{
+					text += "o Object" + std::to_string(face) + NewLine();
+				}
+				polygons.push_back(WriteFace(text));
+			}
+		}
+
+	private:
+		bool Chance(double probability)
+		{
+			return std::uniform_real_distribution<double>(0.0, 1.0)(random_) < probability;
+		}
+
+		float Uniform(float min, float max)
+		{
+			return std::uniform_real_distribution<float>(min, max)(random_);
+		}
+
+		const char* Space()
+		{
+			static const char* kSpaces[] = { " ", " ", " ", "  ", "\t", " \t" };
+			return kSpaces[std::uniform_int_distribution<size_t>(0, std::size(kSpaces) - 1)(random_)];
+		}
+
+		const char* NewLine()
+		{
+			return Chance(0.2) ? (Chance(0.5) ? " \r\n" : "\r\n") : "\n";
+		}
+
+		//n番目の要素を、正の番号か負の番号で書く
+		std::string IndexText(size_t index, size_t count)
+		{
+			return Chance(0.3) ? std::to_string(int64_t(index) - int64_t(count)) : std::to_string(index + 1);
+		}
+
+		Polygon WriteFace(std::string& text)
+		{
+			//平面上の星形の多角形
+			//角度を等分してから少しずらすので、隣との角度の差はπ未満になり、中心が内側に残って自己交差しない
+			const size_t cornerCount = std::uniform_int_distribution<size_t>(3, 12)(random_);
+			std::vector<float> angles(cornerCount);
+			for (size_t i = 0; i < cornerCount; i++)
+			{
+				angles[i] = (float(i) + Uniform(0.0f, 0.9f)) * 6.2831853f / float(cornerCount);
+			}
+			const Vector3 center{ Uniform(-10.0f, 10.0f), Uniform(-10.0f, 10.0f), Uniform(-10.0f, 10.0f) };
+			const Vector3 axisU = Nomalize(Vector3{ Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f) });
+			const Vector3 axisV = Nomalize(Cross(axisU, Nomalize(Vector3{ Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f) })));
+			const bool useTexcoord = Chance(0.5);
+			const bool useNormal = Chance(0.5);
+
+			Polygon polygon(cornerCount);
+			std::vector<size_t> positionIndices(cornerCount);
+			std::vector<size_t> texcoordIndices(cornerCount);
+			std::vector<size_t> normalIndices(cornerCount);
+			for (size_t i = 0; i < cornerCount; i++)
+			{
+				Corner& corner = polygon[i];
+				const float radius = Uniform(0.2f, 2.0f);
+				const Vector3 position = center + axisU * (std::cos(angles[i]) * radius) + axisV * (std::sin(angles[i]) * radius);
+				text += "v";
+				corner.position.x = AppendFloat(text, position.x);
+				corner.position.y = AppendFloat(text, position.y);
+				corner.position.z = AppendFloat(text, position.z);
+				text += NewLine();
+				positionIndices[i] = positionCount_++;
+
+				corner.hasTexcoord = useTexcoord;
+				if (useTexcoord)
+				{
+					text += "vt";
+					corner.texcoord.x = AppendFloat(text, Uniform(0.0f, 1.0f));
+					corner.texcoord.y = AppendFloat(text, Uniform(0.0f, 1.0f));
+					text += NewLine();
+					texcoordIndices[i] = texcoordCount_++;
+				}
+				corner.hasNormal = useNormal;
+				if (useNormal)
+				{
+					const Vector3 normal = Nomalize(Vector3{ Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f) });
+					text += "vn";
+					corner.normal.x = AppendFloat(text, normal.x);
+					corner.normal.y = AppendFloat(text, normal.y);
+					corner.normal.z = AppendFloat(text, normal.z);
+					text += NewLine();
+					normalIndices[i] = normalCount_++;
+				}
+			}
+
+			//"v" / "v/vt" / "v//vn" / "v/vt/vn"
+			text += "f";
+			for (size_t i = 0; i < cornerCount; i++)
+			{
+				text += Space();
+				text += IndexText(positionIndices[i], positionCount_);
+				if (useTexcoord || useNormal)
+				{
+					text += "/";
+				}
+				if (useTexcoord)
+				{
+					text += IndexText(texcoordIndices[i], texcoordCount_);
+				}
+				if (useNormal)
+				{
+					text += "/" + IndexText(normalIndices[i], normalCount_);
+				}
+			}
+			text += Chance(0.2) ? std::string(Space()) + NewLine() : NewLine();
+			return polygon;
+		}
+
+		std::mt19937 random_;
+		size_t positionCount_ = 0;
+		size_t texcoordCount_ = 0;
+		size_t normalCount_ = 0;
+	};
+
+	//2つのModelDataが1ビットも違わないか
+	bool IsSameModel(const ModelData& a, const ModelData& b)
+	{
+		if (a.vertices.size() != b.vertices.size() || a.indices != b.indices || a.submeshes.size() != b.submeshes.size() ||
+			std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(VertexData)) != 0)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.submeshes.size(); i++)
+		{
+			if (a.submeshes[i].name != b.submeshes[i].name || a.submeshes[i].indexStart != b.submeshes[i].indexStart ||
+				a.submeshes[i].indexCount != b.submeshes[i].indexCount || a.submeshes[i].materialIndex != b.submeshes[i].materialIndex)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const size_t fileCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 300;
+	const uint32_t seed = argc > 2 ? uint32_t(std::strtoul(argv[2], nullptr, 10)) : 12345;
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "ObjLoaderConformance";
+	std::filesystem::create_directories(directory);
+	bool ok = true;
+
+	//手書きの面
+	const std::string positions = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n";
+	const std::string attributes = "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\nvn 0 0 1\n";
+	{
+		const ModelData model = LoadObjText(directory, positions + attributes + "f 1/1/1 2/2/1 3/3/1\n");
+		ok &= Check("triangle: 3 indices", model.indices.size() == 3 && model.vertices.size() == 3);
+		ok &= Check("triangle: winding is reversed", model.vertices[model.indices[0]].position == Vector4{ -1.0f, 1.0f, 0.0f, 1.0f });
+		ok &= Check("triangle: uv is flipped", model.vertices[model.indices[0]].texcoord == Vector2{ 1.0f, 0.0f });
+	}
+	{
+		const ModelData model = LoadObjText(directory, positions + "f 1 2 3 4\n");
+		ok &= Check("quad v: 2 triangles sharing 4 vertices", model.indices.size() == 6 && model.vertices.size() == 4);
+		bool flat = true;
+		for (const VertexData& vertex : model.vertices)
+		{
+			flat &= vertex.normal == Vector3{ -0.0f, 0.0f, 1.0f } && vertex.texcoord == Vector2{ 0.0f, 0.0f };
+		}
+		ok &= Check("quad v: flat normal and zero uv", flat);
+	}
+	{
+		const ModelData model = LoadObjText(directory, positions + attributes + "f 1//1 2//1 3//1 4//1\n");
+		ok &= Check("quad v//vn: normal from file", model.indices.size() == 6 && model.vertices[0].normal == Vector3{ -0.0f, 0.0f, 1.0f });
+		ok &= Check("quad v//vn: zero uv", model.vertices[0].texcoord == Vector2{ 0.0f, 0.0f });
+	}
+	{
+		const ModelData model = LoadObjText(directory, positions + attributes + "f 1/1 2/2 3/3 4/4\n");
+		ok &= Check("quad v/vt: uv from file", model.indices.size() == 6 && model.vertices.size() == 4);
+		ok &= Check("quad v/vt: flat normal", model.vertices[0].normal == Vector3{ -0.0f, 0.0f, 1.0f });
+	}
+	//直角に折れた2つの三角形
+	const std::string fold = "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 0 0 1\n";
+	{
+		//スムージンググループが無ければ面ごとの面法線になり、頂点は共有しない
+		const ModelData model = LoadObjText(directory, fold + "f 1 2 3\nf 1 4 2\n");
+		ok &= Check("fold v: flat faces", model.indices.size() == 6 && model.vertices.size() == 6 &&
+			model.vertices[model.indices[0]].normal == Vector3{ -0.0f, 0.0f, 1.0f } && model.vertices[model.indices[3]].normal == Vector3{ -0.0f, 1.0f, 0.0f });
+		const ModelData off = LoadObjText(directory, fold + "s 1\ns off\nf 1 2 3\nf 1 4 2\n");
+		ok &= Check("fold v: s off is flat", IsSameModel(model, off));
+	}
+	{
+		//スムージンググループの中でvnが無ければ共有する頂点はまとめられ、法線は2つの面の間を向く
+		const ModelData model = LoadObjText(directory, fold + "s 1\nf 1 2 3\nf 1 4 2\n");
+		ok &= Check("fold v s 1: shared vertices", model.indices.size() == 6 && model.vertices.size() == 4);
+		bool smooth = true;
+		for (const VertexData& vertex : model.vertices)
+		{
+			//左手系に直した値と比べる
+			const Vector3 position{ -vertex.position.x, vertex.position.y, vertex.position.z };
+			const Vector3 expected = position.z == 1.0f ? Vector3{ 0.0f, 1.0f, 0.0f } : position.y == 1.0f ? Vector3{ 0.0f, 0.0f, 1.0f } : Vector3{ 0.0f, 0.70710678f, 0.70710678f };
+			smooth &= IsNear(vertex.normal, Vector3{ -expected.x, expected.y, expected.z }, 1e-5f);
+		}
+		ok &= Check("fold v s 1: angle weighted normal", smooth);
+	}
+	{
+		//vnのある面は、同じ座標のスムージンググループの頂点の法線に影響しない
+		const ModelData model = LoadObjText(directory, fold + "vn 0 1 0\ns 1\nf 1 2 3\nf 1//1 4//1 2//1\n");
+		bool flat = model.indices.size() == 6;
+		for (size_t corner = 0; corner < 3 && flat; corner++)
+		{
+			flat &= IsNear(model.vertices[model.indices[corner]].normal, Vector3{ 0.0f, 0.0f, 1.0f }, 1e-6f);
+		}
+		ok &= Check("fold v s 1: vn faces are not blended", flat);
+	}
+	{
+		const ModelData relative = LoadObjText(directory, positions + attributes + "f -4/-4/-1 -3/-3/-1 -2/-2/-1 -1/-1/-1\n");
+		const ModelData absolute = LoadObjText(directory, positions + attributes + "f 1/1/1 2/2/1 3/3/1 4/4/1\n");
+		ok &= Check("negative indices", IsSameModel(relative, absolute));
+	}
+	{
+		const ModelData model = LoadObjText(directory, positions + attributes + "f\t1/1/1  2/2/1\t3/3/1 \r\nf 1/1/1 2/2/1 4/4/1\r\n");
+		ok &= Check("tabs and CRLF", model.indices.size() == 6);
+	}
+	{
+		//行末のコメントの単語は頂点として数えない（"#" が16バイト目の前と後ろにある行）
+		const ModelData model = LoadObjText(directory, positions + attributes + "f 1 2 3# a b c\nf 1/1/1 2/2/1 3/3/1 4/4/1 # quad 5 6\nf 1 3 4 #\n");
+		ok &= Check("inline comments", model.indices.size() == 12 && model.submeshes.size() == 1);
+	}
+	{
+		const ModelData model = LoadObjText(directory, positions + "f 1 2\nf\nf 1 2 9\nf 1 0 2\nf 1 2 3\n");
+		ok &= Check("short and out of range faces are skipped", model.indices.size() == 3);
+	}
+	{
+		//L字型の6角形（凹）。扇形に分けると裏返った三角形ができる
+		const std::vector<Vector3> corners = { { 0, 0, 0 }, { 2, 0, 0 }, { 2, 1, 0 }, { 1, 1, 0 }, { 1, 2, 0 }, { 0, 2, 0 } };
+		//凹んだ角(1,1)から始めると扇形では正しく分けられない
+		std::string text;
+		Polygon polygon;
+		for (size_t i = 0; i < corners.size(); i++)
+		{
+			const Vector3& corner = corners[(i + 3) % corners.size()];
+			text += "v " + std::to_string(corner.x) + " " + std::to_string(corner.y) + " " + std::to_string(corner.z) + "\n";
+			polygon.push_back({ corner, false, {}, false, {} });
+		}
+		text += "f 1 2 3 4 5 6\n";
+		const ModelData model = LoadObjText(directory, text);
+		ok &= Check("concave hexagon", VerifyFaces(model, { polygon }));
+	}
+
+	//ランダムな面
+	RandomObjWriter writer(seed);
+	std::string text;
+	std::vector<Polygon> polygons;
+	size_t failedFiles = 0;
+	size_t faceTotal = 0;
+	std::mt19937 random(seed);
+	for (size_t file = 0; file < fileCount; file++)
+	{
+		writer.Write(std::uniform_int_distribution<size_t>(1, 40)(random), text, polygons);
+		faceTotal += polygons.size();
+		if (!VerifyFaces(LoadObjText(directory, text), polygons))
+		{
+			if (failedFiles++ == 0)
+			{
+				std::FILE* failed = std::fopen((directory / "failed.obj").string().c_str(), "wb");
+				std::fwrite(text.data(), 1, text.size(), failed);
+				std::fclose(failed);
+				std::printf("first failing file kept at %s\n", (directory / "failed.obj").string().c_str());
+			}
+		}
+	}
+	ok &= Check("random faces", failedFiles == 0);
+
+	//壊れたobjでも止まらず、インデックスが頂点の範囲に収まるか（バイトをランダムに書き換える）
+	size_t brokenFiles = 0;
+	for (size_t file = 0; file < fileCount; file++)
+	{
+		writer.Write(20, text, polygons);
+		static constexpr char kBytes[] = "0123456789-+/ \t\r\nfvtn.e#";
+		const size_t mutationCount = std::uniform_int_distribution<size_t>(1, 20)(random);
+		for (size_t mutation = 0; mutation < mutationCount; mutation++)
+		{
+			text[std::uniform_int_distribution<size_t>(0, text.size() - 1)(random)] = kBytes[std::uniform_int_distribution<size_t>(0, sizeof(kBytes) - 2)(random)];
+		}
+		const ModelData model = LoadObjText(directory, text);
+		bool valid = model.indices.size() % 3 == 0;
+		for (uint32_t index : model.indices)
+		{
+			valid &= index < model.vertices.size();
+		}
+		brokenFiles += !valid;
+	}
+	ok &= Check("broken files", brokenFiles == 0);
+
+	//チャンクの境目をまたいでも逐次と同じになるか（1チャンクは1MB以上なので数MBのファイルにする）
+	writer.Write(60000, text, polygons);
+	const ModelData serial = LoadObjText(directory, text, 1);
+	const ModelData parallel = LoadObjText(directory, text, 4);
+	ok &= Check("serial and parallel are identical", IsSameModel(serial, parallel));
+	ok &= Check("large random file", VerifyFaces(serial, polygons));
+
+	std::printf("random files     : %zu (%zu faces), %zu failed\n", fileCount, faceTotal, failedFiles);
+	std::printf("large file       : %.1f MB, %zu faces\n", double(text.size()) / (1024.0 * 1024.0), polygons.size());
+	std::printf("result           : %s\n", ok ? "OK" : "FAILED");
+
+	if (ok)
+	{
+		std::filesystem::remove_all(directory);
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+///==========================================================
+/// QuaternionMath.h の結果を行列の計算と比べる
+/// - MakeRotateQuaternion → MakeRotateMatrixQuaternion が MakeRotateMatrix(Vector3) と同じ回転になること
+/// - MakeAffineMatrix(MakeQuaternionTransform(t)) が MakeAffineMatrix(scale, rotate, translate) と同じになること
+/// - 積 Multiply(a, b) の回転行列が、行列の積 Multiply(A, B) と同じになること（どちらも a の回転が先）
+/// - RotateVector が回転行列を掛けたものと同じになること
+/// - 配列版の Nlerp / Slerp（SIMD）が1個ずつの Nlerp / Slerp（スカラー）と許容誤差内で一致すること
+///
+/// ビルド例（Windowsヘッダーは不要）
+///   g++ -std=c++20 -O2 -march=native -I.. QuaternionCheck.cpp -o QuaternionCheck
+///   cl /std:c++20 /O2 /EHsc /arch:AVX2 /I.. QuaternionCheck.cpp
+///
+/// 使い方
+///   QuaternionCheck [回数]
+///==========================================================
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "QuaternionMath.h"
+#include "BenchmarkCommon.h"
+
+namespace
+{
+	//回転行列・アフィン変換行列の許容誤差（要素の最大値に対する比）
+	constexpr float kMatrixTolerance = 1e-5f;
+	//Nlerp の許容誤差。SIMDは逆数を掛けて正規化するので丸めが少し違う
+	constexpr float kNlerpTolerance = 1e-6f;
+	//Slerp の許容誤差。SIMDは acos / sin を多項式で近似している
+	constexpr float kSlerpTolerance = 1e-5f;
+
+	//2つの行列の要素ごとの差の最大値を、要素の最大値で割ったもの
+	float MaxRelativeError(const Matrix4x4& a, const Matrix4x4& b)
+	{
+		float error = 0.0f;
+		float magnitude = 1.0f;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				error = std::max(error, std::fabs(a.m[i][j] - b.m[i][j]));
+				magnitude = std::max(magnitude, std::fabs(b.m[i][j]));
+			}
+		}
+		return error / magnitude;
+	}
+
+	//2つのクォータニオンの成分ごとの差の最大値
+	float MaxError(const Quaternion& a, const Quaternion& b)
+	{
+		return std::max(std::max(std::fabs(a.x - b.x), std::fabs(a.y - b.y)), std::max(std::fabs(a.z - b.z), std::fabs(a.w - b.w)));
+	}
+
+	//行ベクトルに行列の回転部分を掛ける
+	Vector3 MultiplyRotation(const Vector3& v, const Matrix4x4& m)
+	{
+		return {
+			v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0],
+			v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1],
+			v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2],
+		};
+	}
+
+	Vector3 RandomAngles(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+		return { angle(random), angle(random), angle(random) };
+	}
+
+	Quaternion RandomQuaternion(std::mt19937& random)
+	{
+		return MakeRotateQuaternion(RandomAngles(random));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const size_t count = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 100000;
+
+#if defined(MATRIXMATH_USE_SSE)
+	std::printf("SIMD path        : SSE\n");
+#else
+	std::printf("SIMD path        : none (batch Nlerp / Slerp use the scalar loop)\n");
+#endif
+
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+	std::uniform_real_distribution<float> translate(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	float rotateError = 0.0f;
+	float affineError = 0.0f;
+	float multiplyError = 0.0f;
+	float rotateVectorError = 0.0f;
+	float inverseError = 0.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		const Vector3 angles = RandomAngles(random);
+		rotateError = std::max(rotateError, MaxRelativeError(MakeRotateMatrixQuaternion(MakeRotateQuaternion(angles)), MakeRotateMatrix(angles)));
+
+		const Transform transform{ { scale(random), scale(random), scale(random) }, angles, { translate(random), translate(random), translate(random) } };
+		affineError = std::max(affineError, MaxRelativeError(MakeAffineMatrix(MakeQuaternionTransform(transform)),
+			MakeAffineMatrix(transform.scale, transform.rotate, transform.translate)));
+
+		const Quaternion a = RandomQuaternion(random);
+		const Quaternion b = RandomQuaternion(random);
+		multiplyError = std::max(multiplyError, MaxRelativeError(MakeRotateMatrixQuaternion(Multiply(a, b)),
+			Multiply(MakeRotateMatrixQuaternion(a), MakeRotateMatrixQuaternion(b))));
+
+		const Vector3 v{ unit(random), unit(random), unit(random) };
+		const Vector3 rotated = RotateVector(v, a);
+		const Vector3 expected = MultiplyRotation(v, MakeRotateMatrixQuaternion(a));
+		rotateVectorError = std::max(rotateVectorError, std::max(std::max(std::fabs(rotated.x - expected.x), std::fabs(rotated.y - expected.y)), std::fabs(rotated.z - expected.z)));
+
+		inverseError = std::max(inverseError, MaxError(Multiply(a, Inverse(a)), IdentityQuaternion()));
+	}
+
+	//補間。内積が負のもの（最短経路のために符号を反転する）と、ほぼ同じ向きのもの（Slerpが線形補間になる）も混ぜる
+	std::vector<Quaternion> q0(count);
+	std::vector<Quaternion> q1(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		q0[i] = RandomQuaternion(random);
+		switch (i % 4)
+		{
+		case 0:
+			q1[i] = Normalize({ q0[i].x + 1e-3f * unit(random), q0[i].y + 1e-3f * unit(random), q0[i].z + 1e-3f * unit(random), q0[i].w });
+			break;
+		case 1:
+			q1[i] = { -q0[i].x, -q0[i].y, -q0[i].z, -q0[i].w };
+			q1[i] = Multiply(q1[i], MakeRotateAxisAngleQuaternion({ 0.0f, 1.0f, 0.0f }, unit(random)));
+			break;
+		default:
+			q1[i] = RandomQuaternion(random);
+			break;
+		}
+	}
+
+	std::vector<Quaternion> batch(count);
+	float nlerpError = 0.0f;
+	float slerpError = 0.0f;
+	for (float t : { 0.0f, 0.25f, 0.5f, 0.9f, 1.0f })
+	{
+		Nlerp(q0, q1, t, batch);
+		for (size_t i = 0; i < count; i++)
+		{
+			nlerpError = std::max(nlerpError, MaxError(batch[i], Nlerp(q0[i], q1[i], t)));
+		}
+		Slerp(q0, q1, t, batch);
+		for (size_t i = 0; i < count; i++)
+		{
+			slerpError = std::max(slerpError, MaxError(batch[i], Slerp(q0[i], q1[i], t)));
+		}
+	}
+
+	std::printf("quaternions      : %zu\n", count);
+	std::printf("MakeRotate       : %.3g\n", rotateError);
+	std::printf("MakeAffine       : %.3g\n", affineError);
+	std::printf("Multiply         : %.3g\n", multiplyError);
+	std::printf("RotateVector     : %.3g\n", rotateVectorError);
+	std::printf("Inverse          : %.3g\n", inverseError);
+	std::printf("Nlerp (batch)    : %.3g, tolerance %.3g\n", nlerpError, kNlerpTolerance);
+	std::printf("Slerp (batch)    : %.3g, tolerance %.3g\n", slerpError, kSlerpTolerance);
+
+	bool ok = true;
+	ok &= Check("MakeRotateMatrixQuaternion(MakeRotateQuaternion) matches MakeRotateMatrix", rotateError <= kMatrixTolerance);
+	ok &= Check("MakeAffineMatrix(QuaternionTransform) matches MakeAffineMatrix(Vector3)", affineError <= kMatrixTolerance);
+	ok &= Check("Multiply(a, b) matches the matrix product", multiplyError <= kMatrixTolerance);
+	ok &= Check("RotateVector matches the rotation matrix", rotateVectorError <= kMatrixTolerance);
+	ok &= Check("Multiply(q, Inverse(q)) is the identity", inverseError <= kMatrixTolerance);
+	ok &= Check("batch Nlerp matches the scalar Nlerp", nlerpError <= kNlerpTolerance);
+	ok &= Check("batch Slerp matches the scalar Slerp", slerpError <= kSlerpTolerance);
+
+	std::printf("result           : %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+///==========================================================
+/// TangentSpace.cpp の確認とベンチマーク
+/// 球を格子状に並べたメッシュの法線と接線を作り直し、球の式から求めた値と比べる
+///   ・法線が球の外を向き、UVの継ぎ目で分かれた頂点も同じ法線になる。既にある法線は上書きしない
+///   ・接線が単位ベクトルで法線に直交し、uが増える向きを向く。従法線 w * cross(normal, tangent) がvの増える向きを向く
+///   ・UVを鏡映にするとwが-1になる
+///   ・LODの三角形は使わず、逐次と並列の結果が1ビットも違わない
+/// 逐次と並列の時間も表示する
+///
+/// ビルド例（Windowsヘッダーは不要）
+///   g++ -std=c++20 -O2 -march=native -pthread -I.. TangentSpaceBenchmark.cpp ../TangentSpace.cpp -o TangentSpaceBenchmark
+///   cl /std:c++20 /O2 /EHsc /I.. TangentSpaceBenchmark.cpp ..\TangentSpace.cpp
+///
+/// 使い方
+///   TangentSpaceBenchmark [球の分割数（16以上）] [スレッド数（0ならコア数）]
+///==========================================================
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numbers>
+#include <vector>
+
+#include "TangentSpace.h"
+#include "VectorMath.h"
+#include "BenchmarkCommon.h"
+
+namespace
+{
+	///==========================================================
+	/// 球の頂点の、球の式から求めた向き
+	///==========================================================
+	struct SphereFrame
+	{
+		Vector3 normal;		// 外向き
+		Vector3 du;			// uが増える向き（経度の向き）
+		Vector3 dv;			// vが増える向き（緯度の向き、下向き）
+		float ring;			// 緯度の円の半径（極で0）
+	};
+
+	//球を count x count x count の格子状に並べる。uは経度、vは上の極から下の極へ0～1
+	//経度の0と1の頂点は同じ位置の別の頂点（UVの継ぎ目）になる。極の頂点も全て同じ位置にする
+	ModelData MakeSphereLattice(uint32_t segments, uint32_t count, std::vector<SphereFrame>& frames)
+	{
+		ModelData model;
+		const float pi = std::numbers::pi_v<float>;
+		const uint32_t sphereCount = count * count * count;
+		frames.clear();
+		for (uint32_t sphere = 0; sphere < sphereCount; sphere++)
+		{
+			const Vector3 center{ float(sphere % count) * 2.5f, float(sphere / count % count) * 2.5f, float(sphere / (count * count)) * 2.5f };
+			const uint32_t base = uint32_t(model.vertices.size());
+			for (uint32_t lat = 0; lat <= segments; lat++)
+			{
+				const float theta = pi * float(lat) / float(segments);
+				const float ring = lat == 0 || lat == segments ? 0.0f : std::sin(theta);
+				for (uint32_t lon = 0; lon <= segments; lon++)
+				{
+					//継ぎ目の頂点は0と同じ位置にする
+					const float phi = 2.0f * pi * float(lon % segments) / float(segments);
+					const Vector3 normal{ ring * std::cos(phi), lat == segments ? -1.0f : std::cos(theta), ring * std::sin(phi) };
+					const Vector3 position = Add(center, normal);
+					model.vertices.push_back({ { position.x, position.y, position.z, 1.0f }, { float(lon) / float(segments), float(lat) / float(segments) }, normal });
+					frames.push_back({ normal, { -std::sin(phi), 0.0f, std::cos(phi) },
+						{ std::cos(theta) * std::cos(phi), -ring, std::cos(theta) * std::sin(phi) }, ring });
+				}
+			}
+			for (uint32_t lat = 0; lat < segments; lat++)
+			{
+				for (uint32_t lon = 0; lon < segments; lon++)
+				{
+					const uint32_t a = base + lat * (segments + 1) + lon;
+					const uint32_t b = a + segments + 1;
+					//外側が表になる向き（cross(b - a, c - a) が外を向く）
+					model.indices.insert(model.indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+				}
+			}
+		}
+		model.materials.assign(1, MaterialData{});
+		model.submeshes.push_back({ "sphere", 0, uint32_t(model.indices.size()), 0 });
+		return model;
+	}
+
+	bool IsSameNormals(const ModelData& a, const ModelData& b)
+	{
+		if (a.vertices.size() != b.vertices.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.vertices.size(); i++)
+		{
+			if (std::memcmp(&a.vertices[i].normal, &b.vertices[i].normal, sizeof(Vector3)) != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool IsSameTangents(const ModelData& a, const ModelData& b)
+	{
+		return a.tangents.size() == b.tangents.size() && std::memcmp(a.tangents.data(), b.tangents.data(), a.tangents.size() * sizeof(Vector4)) == 0;
+	}
+
+	//法線を消してから作り直し、球の式と比べる
+	bool CheckNormals(ModelData model, const std::vector<SphereFrame>& frames, uint32_t segments, uint32_t threadCount)
+	{
+		for (VertexData& vertex : model.vertices)
+		{
+			vertex.normal = { 0.0f, 0.0f, 0.0f };
+		}
+		//1つだけ法線を残しておく（上書きされないはず）
+		const Vector3 kept{ 0.0f, 0.0f, -1.0f };
+		model.vertices[segments / 2].normal = kept;
+		GenerateNormals(model, false, threadCount);
+
+		float worstDot = 1.0f;
+		for (size_t i = 0; i < model.vertices.size(); i++)
+		{
+			if (i != segments / 2)
+			{
+				worstDot = std::min(worstDot, Dot(model.vertices[i].normal, frames[i].normal));
+			}
+		}
+		//経度0と1の頂点は同じ位置なので1ビットも違わない
+		bool seamMatches = true;
+		for (size_t row = 0; row < model.vertices.size(); row += segments + 1)
+		{
+			seamMatches &= std::memcmp(&model.vertices[row].normal, &model.vertices[row + segments].normal, sizeof(Vector3)) == 0;
+		}
+		std::printf("  normals          : worst dot with sphere normal %.6f\n", worstDot);
+
+		bool ok = true;
+		ok &= Check("normals point along the sphere normal", worstDot > 0.999f);
+		ok &= Check("normals match across the uv seam", seamMatches);
+		ok &= Check("existing normals are kept", model.vertices[segments / 2].normal == kept);
+		return ok;
+	}
+
+	//接線を作り、球の式と比べる。mirrorならUVのuを反転する
+	bool CheckTangents(ModelData model, const std::vector<SphereFrame>& frames, bool mirror, uint32_t threadCount)
+	{
+		if (mirror)
+		{
+			for (VertexData& vertex : model.vertices)
+			{
+				vertex.texcoord.x = 1.0f - vertex.texcoord.x;
+			}
+		}
+		GenerateTangents(model, threadCount);
+
+		bool unitAndOrthogonal = model.tangents.size() == model.vertices.size();
+		bool handedness = true;
+		float worstDot = 1.0f;
+		float worstBitangentDot = 1.0f;
+		for (size_t i = 0; i < model.tangents.size(); i++)
+		{
+			const Vector4& tangent4 = model.tangents[i];
+			const Vector3 tangent{ tangent4.x, tangent4.y, tangent4.z };
+			const Vector3& normal = model.vertices[i].normal;
+			unitAndOrthogonal &= std::abs(Length(tangent) - 1.0f) < 1e-4f && std::abs(Dot(tangent, normal)) < 1e-4f;
+			//極の近くは格子が潰れているので向きは比べない
+			if (frames[i].ring > 0.2f)
+			{
+				handedness &= tangent4.w == (mirror ? -1.0f : 1.0f);
+				const Vector3 du = mirror ? Multiply(-1.0f, frames[i].du) : frames[i].du;
+				const Vector3 bitangent = Multiply(tangent4.w, Cross(normal, tangent));
+				worstDot = std::min(worstDot, Dot(tangent, du));
+				worstBitangentDot = std::min(worstBitangentDot, Dot(bitangent, frames[i].dv));
+			}
+		}
+		std::printf("  tangents%s : worst dot with du %.6f, bitangent with dv %.6f\n", mirror ? " (mirror)" : "         ", worstDot, worstBitangentDot);
+
+		bool ok = true;
+		ok &= Check("tangents are unit length and orthogonal to the normal", unitAndOrthogonal);
+		ok &= Check(mirror ? "mirrored uv gives w = -1" : "w = +1", handedness);
+		ok &= Check("tangents point along du", worstDot > 0.98f);
+		ok &= Check("bitangents point along dv", worstBitangentDot > 0.98f);
+		return ok;
+	}
+
+	//LODの三角形（元のメッシュの後ろのインデックス）を足しても結果が変わらないか
+	bool CheckLodIgnored(const ModelData& model, uint32_t threadCount)
+	{
+		ModelData base = model;
+		ModelData withLod = model;
+		//裏返した三角形をLODとして足す（使われれば法線も接線も大きく変わる）
+		const size_t baseIndexCount = withLod.indices.size();
+		for (size_t i = 0; i < baseIndexCount; i += 3)
+		{
+			withLod.indices.insert(withLod.indices.end(), { withLod.indices[i], withLod.indices[i + 2], withLod.indices[i + 1] });
+		}
+		withLod.lods.push_back({ { { "sphere", uint32_t(baseIndexCount), uint32_t(baseIndexCount), 0 } }, 0.0f });
+		GenerateNormals(base, true, threadCount);
+		GenerateTangents(base, threadCount);
+		GenerateNormals(withLod, true, threadCount);
+		GenerateTangents(withLod, threadCount);
+		return Check("lod triangles are ignored", IsSameNormals(base, withLod) && IsSameTangents(base, withLod));
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t segments = argc > 1 ? std::max(16u, uint32_t(std::strtoul(argv[1], nullptr, 10))) : 48;
+	const uint32_t threadCount = argc > 2 ? uint32_t(std::strtoul(argv[2], nullptr, 10)) : 0;
+	bool ok = true;
+
+	//確認は小さい格子で行う
+	std::vector<SphereFrame> frames;
+	const ModelData small = MakeSphereLattice(segments, 2, frames);
+	std::printf("checks (%zu triangles)\n", small.indices.size() / 3);
+	ok &= CheckNormals(small, frames, segments, threadCount);
+	ok &= CheckTangents(small, frames, false, threadCount);
+	ok &= CheckTangents(small, frames, true, threadCount);
+	ok &= CheckLodIgnored(small, threadCount);
+
+	//時間は大きい格子で測り、逐次と並列の結果も比べる
+	ModelData serial = MakeSphereLattice(segments, 6, frames);
+	ModelData parallel = serial;
+	const double serialNormalNs = MeasureBest(3, [&]() { GenerateNormals(serial, true, 1); });
+	const double parallelNormalNs = MeasureBest(3, [&]() { GenerateNormals(parallel, true, threadCount); });
+	const double serialTangentNs = MeasureBest(3, [&]() { GenerateTangents(serial, 1); });
+	const double parallelTangentNs = MeasureBest(3, [&]() { GenerateTangents(parallel, threadCount); });
+	std::printf("sphere lattice (%zu triangles, %zu vertices)\n", serial.indices.size() / 3, serial.vertices.size());
+	std::printf("  GenerateNormals  : %8.2f ms (serial), %8.2f ms (parallel, %.2fx)\n", serialNormalNs * 1e-6, parallelNormalNs * 1e-6, serialNormalNs / parallelNormalNs);
+	std::printf("  GenerateTangents : %8.2f ms (serial), %8.2f ms (parallel, %.2fx)\n", serialTangentNs * 1e-6, parallelTangentNs * 1e-6, serialTangentNs / parallelTangentNs);
+	ok &= Check("serial and parallel results are identical", IsSameNormals(serial, parallel) && IsSameTangents(serial, parallel));
+
+	std::printf("result           : %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,305 @@
+///==========================================================
+/// DirectXTex のブロック圧縮（DirectXTexCompress.cpp）の確認とベンチマーク
+/// グラデーション、縁、ノイズを混ぜた画像にミップマップを付けて BC1 / BC3 / BC6H / BC7 に圧縮し
+/// スレッド数とタスクの大きさ（ブロックの行数）を変えた並列の結果が、逐次の結果とバイト単位で同じかを調べる
+/// 形式ごとに逐次と並列の時間と速度の比も表示する
+/// BC1 / BC3 は多ブロックのエンコーダー（TEX_COMPRESS_BC13_SIMD*）の時間とRMSEを既定のエンコーダーと比べ、誤差が上限の倍率を超えないかも調べる
+/// （8ブロックずつの経路は -mavx2 / -march=native か /arch:AVX2 のときに使われる）
+/// BC7 は段階（TEX_COMPRESS_BC7_ULTRAFAST / FAST / BASIC と既定の slow）ごとの時間とRMSEの表を、不透明な画像と半透明を含む画像で表示する
+///
+/// ビルド例（Windows以外は DirectX-Headers と DirectXMath が要る。<DXH> と <DXM> はそれぞれを置いた場所）
+///   g++ -std=c++20 -O2 -march=native -pthread -I.. -I<DXH>/include -I<DXH>/include/wsl/stubs -I<DXM>/Inc TextureCompressBenchmark.cpp ../externals/DirectXTex/{BC,BC4BC5,BC6HBC7,DirectXTexCompress,DirectXTexConvert,DirectXTexImage,DirectXTexUtil}.cpp -o TextureCompressBenchmark
+///   cl /std:c++20 /O2 /arch:AVX2 /EHsc /I.. TextureCompressBenchmark.cpp ..\externals\DirectXTex\BC.cpp ..\externals\DirectXTex\BC4BC5.cpp ..\externals\DirectXTex\BC6HBC7.cpp ..\externals\DirectXTex\DirectXTexCompress.cpp ..\externals\DirectXTex\DirectXTexConvert.cpp ..\externals\DirectXTex\DirectXTexImage.cpp ..\externals\DirectXTex\DirectXTexUtil.cpp ole32.lib
+///   （DirectXTex の *.cpp を全て渡すと、BCDirectCompute.cpp がシェーダーのコンパイル済みファイル（Shaders/Compiled）を要るので、使うものだけを渡す）
+///
+/// 使い方
+///   TextureCompressBenchmark [画像の一辺（4の倍数）] [最大スレッド数（0ならCPUのコア数）]
+///==========================================================
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "externals/DirectXTex/DirectXTex.h"
+#include "BenchmarkCommon.h"
+
+namespace
+{
+	//処理時間を計測する（ミリ秒）
+	template <typename Func>
+	double MeasureMilliseconds(Func func)
+	{
+		auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//グラデーション、縁、ノイズを混ぜた画像と、2x2の平均で作ったミップマップ
+	bool MakeTestImage(size_t size, DirectX::ScratchImage& image)
+	{
+		size_t mipLevels = 1;
+		while ((size >> mipLevels) > 0)
+		{
+			mipLevels++;
+		}
+		if (FAILED(image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, 1, mipLevels)))
+		{
+			return false;
+		}
+		std::mt19937 random(1234);
+		std::uniform_int_distribution<int> noise(-12, 12);
+		const DirectX::Image* top = image.GetImage(0, 0, 0);
+		for (size_t y = 0; y < size; y++)
+		{
+			uint8_t* row = top->pixels + y * top->rowPitch;
+			for (size_t x = 0; x < size; x++)
+			{
+				const float u = float(x) / float(size);
+				const float v = float(y) / float(size);
+				const bool edge = ((x / 37) + (y / 53)) % 3 == 0;
+				const int r = int(255.0f * u) + noise(random);
+				const int g = edge ? 40 : int(255.0f * v);
+				const int b = int(127.5f + 127.5f * std::sin(u * 20.0f + v * 7.0f));
+				const int a = edge ? 255 : int(255.0f * (0.5f + 0.5f * std::cos(v * 9.0f)));
+				row[x * 4 + 0] = uint8_t(std::clamp(r, 0, 255));
+				row[x * 4 + 1] = uint8_t(std::clamp(g, 0, 255));
+				row[x * 4 + 2] = uint8_t(std::clamp(b, 0, 255));
+				row[x * 4 + 3] = uint8_t(std::clamp(a, 0, 255));
+			}
+		}
+		for (size_t level = 1; level < mipLevels; level++)
+		{
+			const DirectX::Image* source = image.GetImage(level - 1, 0, 0);
+			const DirectX::Image* target = image.GetImage(level, 0, 0);
+			for (size_t y = 0; y < target->height; y++)
+			{
+				for (size_t x = 0; x < target->width; x++)
+				{
+					for (size_t c = 0; c < 4; c++)
+					{
+						const size_t x1 = std::min(x * 2 + 1, source->width - 1);
+						const size_t y1 = std::min(y * 2 + 1, source->height - 1);
+						const uint8_t* p = source->pixels;
+						const int sum = p[y * 2 * source->rowPitch + x * 2 * 4 + c] + p[y * 2 * source->rowPitch + x1 * 4 + c] +
+							p[y1 * source->rowPitch + x * 2 * 4 + c] + p[y1 * source->rowPitch + x1 * 4 + c];
+						target->pixels[y * target->rowPitch + x * 4 + c] = uint8_t((sum + 2) / 4);
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	//圧縮したものを展開して元の画像と比べた二乗平均平方根誤差（0-255）。withAlphaがfalseならRGBだけ
+	double ComputeRmse(const DirectX::ScratchImage& source, const DirectX::ScratchImage& compressed, bool withAlpha)
+	{
+		DirectX::ScratchImage decoded{};
+		if (FAILED(DirectX::Decompress(compressed.GetImages(), compressed.GetImageCount(), compressed.GetMetadata(), DXGI_FORMAT_R8G8B8A8_UNORM, decoded)))
+		{
+			return -1.0;
+		}
+		const size_t channels = withAlpha ? 4 : 3;
+		double sum = 0.0;
+		size_t count = 0;
+		for (size_t i = 0; i < source.GetImageCount(); i++)
+		{
+			const DirectX::Image& a = source.GetImages()[i];
+			const DirectX::Image& b = decoded.GetImages()[i];
+			for (size_t y = 0; y < a.height; y++)
+			{
+				for (size_t x = 0; x < a.width; x++)
+				{
+					for (size_t c = 0; c < channels; c++)
+					{
+						const double d = double(a.pixels[y * a.rowPitch + x * 4 + c]) - double(b.pixels[y * b.rowPitch + x * 4 + c]);
+						sum += d * d;
+						count++;
+					}
+				}
+			}
+		}
+		return std::sqrt(sum / double(count));
+	}
+
+	bool IsSame(const DirectX::ScratchImage& a, const DirectX::ScratchImage& b)
+	{
+		return a.GetPixelsSize() == b.GetPixelsSize() && std::memcmp(a.GetPixels(), b.GetPixels(), a.GetPixelsSize()) == 0;
+	}
+
+	//多ブロックのエンコーダーの誤差が既定のエンコーダーの何倍までなら良いか
+	constexpr double kMaxRmseRatio = 1.05;
+	constexpr double kMaxRmseRatioFast = 1.15;
+	//BC7 の段階ごとの、既定（slow）に対する誤差の上限の倍率
+	constexpr double kMaxRmseRatioBC7Basic = 1.1;
+	constexpr double kMaxRmseRatioBC7Fast = 1.35;
+	constexpr double kMaxRmseRatioBC7UltraFast = 2.0;
+
+	struct FormatCase
+	{
+		const char* name;
+		DXGI_FORMAT format;
+		DirectX::TEX_COMPRESS_FLAGS flags;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	const size_t size = argc > 1 ? size_t(std::atoi(argv[1])) : 128;
+	size_t maxThreads = argc > 2 ? size_t(std::atoi(argv[2])) : 0;
+	if (maxThreads == 0)
+	{
+		maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	DirectX::ScratchImage image{};
+	if (!Check("test image", size % 4 == 0 && MakeTestImage(size, image)))
+	{
+		return 1;
+	}
+	std::printf("%zux%zu, %zu mips, up to %zu threads\n", size, size, image.GetMetadata().mipLevels, maxThreads);
+
+	//1, 2, 4, ... と最大スレッド数
+	std::vector<size_t> threadCounts;
+	for (size_t threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	const FormatCase formats[] = {
+		{ "BC1", DXGI_FORMAT_BC1_UNORM, DirectX::TEX_COMPRESS_DEFAULT },
+		{ "BC3", DXGI_FORMAT_BC3_UNORM, DirectX::TEX_COMPRESS_DEFAULT },
+		{ "BC1 simd", DXGI_FORMAT_BC1_UNORM, DirectX::TEX_COMPRESS_BC13_SIMD },
+		{ "BC3 simd", DXGI_FORMAT_BC3_UNORM, DirectX::TEX_COMPRESS_BC13_SIMD },
+		{ "BC6H", DXGI_FORMAT_BC6H_UF16, DirectX::TEX_COMPRESS_DEFAULT },
+		{ "BC7 quick", DXGI_FORMAT_BC7_UNORM, DirectX::TEX_COMPRESS_BC7_QUICK },
+		{ "BC7 fast", DXGI_FORMAT_BC7_UNORM, DirectX::TEX_COMPRESS_BC7_FAST },
+		{ "BC7", DXGI_FORMAT_BC7_UNORM, DirectX::TEX_COMPRESS_DEFAULT },
+	};
+
+	bool ok = true;
+	for (const FormatCase& format : formats)
+	{
+		DirectX::ScratchImage serial{};
+		HRESULT hr = S_OK;
+		const double serialMs = MeasureMilliseconds([&]()
+			{
+				hr = DirectX::Compress(image.GetImages(), image.GetImageCount(), image.GetMetadata(), format.format, format.flags, DirectX::TEX_THRESHOLD_DEFAULT, serial);
+			});
+		ok &= Check("serial compress", SUCCEEDED(hr));
+		std::printf("%-10s serial            : %9.2f ms\n", format.name, serialMs);
+
+		//スレッド数を変える（タスクの大きさは自動）
+		for (size_t threads : threadCounts)
+		{
+			DirectX::ScratchImage parallel{};
+			const DirectX::CompressParallelOptions options = { threads, 0 };
+			const double parallelMs = MeasureMilliseconds([&]()
+				{
+					hr = DirectX::Compress(image.GetImages(), image.GetImageCount(), image.GetMetadata(), format.format, format.flags, DirectX::TEX_THRESHOLD_DEFAULT, options, parallel);
+				});
+			ok &= Check("parallel compress", SUCCEEDED(hr));
+			ok &= Check("parallel output matches serial", IsSame(serial, parallel));
+			std::printf("%-10s %3zu threads       : %9.2f ms (%.2fx)\n", format.name, threads, parallelMs, serialMs / parallelMs);
+		}
+
+		//タスクの大きさを変えても同じ結果になるか（1行ずつ、画像より大きいもの）
+		for (size_t rows : { size_t(1), size_t(3), size / 4 + 1 })
+		{
+			DirectX::ScratchImage parallel{};
+			const DirectX::CompressParallelOptions options = { maxThreads, rows };
+			hr = DirectX::Compress(image.GetImages(), image.GetImageCount(), image.GetMetadata(), format.format, format.flags, DirectX::TEX_THRESHOLD_DEFAULT, options, parallel);
+			ok &= Check("parallel compress with fixed task size", SUCCEEDED(hr) && IsSame(serial, parallel));
+		}
+
+		//TEX_COMPRESS_PARALLEL（既定の設定）と1枚だけの版
+		DirectX::ScratchImage flagged{};
+		hr = DirectX::Compress(image.GetImages(), image.GetImageCount(), image.GetMetadata(), format.format, format.flags | DirectX::TEX_COMPRESS_PARALLEL, DirectX::TEX_THRESHOLD_DEFAULT, flagged);
+		ok &= Check("TEX_COMPRESS_PARALLEL", SUCCEEDED(hr) && IsSame(serial, flagged));
+		DirectX::ScratchImage single{};
+		hr = DirectX::Compress(*image.GetImage(0, 0, 0), format.format, format.flags | DirectX::TEX_COMPRESS_PARALLEL, DirectX::TEX_THRESHOLD_DEFAULT, single);
+		ok &= Check("single image", SUCCEEDED(hr) && std::memcmp(single.GetPixels(), serial.GetPixels(), single.GetPixelsSize()) == 0);
+	}
+
+	//画質と時間の表（1スレッド）。先頭の既定のエンコーダーに対する誤差の上限の倍率を決めておく
+	struct QualityCase
+	{
+		const char* name;
+		DirectX::TEX_COMPRESS_FLAGS flags;
+		double maxRmseRatio;
+	};
+	auto printQualityTable = [&](const char* formatName, DXGI_FORMAT format, const DirectX::ScratchImage& source, bool withAlpha, std::initializer_list<QualityCase> qualities, int runs)
+		{
+			double referenceRmse = 0.0;
+			double referenceMs = 0.0;
+			for (const QualityCase& quality : qualities)
+			{
+				DirectX::ScratchImage compressed{};
+				HRESULT hr = S_OK;
+				double bestMs = 0.0;
+				for (int run = 0; run < runs; run++)
+				{
+					const double ms = MeasureMilliseconds([&]()
+						{
+							hr = DirectX::Compress(source.GetImages(), source.GetImageCount(), source.GetMetadata(), format, quality.flags, DirectX::TEX_THRESHOLD_DEFAULT, compressed);
+						});
+					bestMs = run == 0 ? ms : std::min(bestMs, ms);
+				}
+				ok &= Check("compress", SUCCEEDED(hr));
+				const double rmse = ComputeRmse(source, compressed, withAlpha);
+				if (referenceMs == 0.0)
+				{
+					referenceRmse = rmse;
+					referenceMs = bestMs;
+				}
+				std::printf("%s %-10s: %9.2f ms (%6.2fx), RMSE %.3f (%.3fx)\n", formatName, quality.name, bestMs, referenceMs / bestMs, rmse, rmse / referenceRmse);
+				ok &= Check("RMSE within the bound of the default encoder", rmse >= 0.0 && rmse <= referenceRmse * quality.maxRmseRatio);
+			}
+		};
+
+	//BC1 / BC3 の多ブロックのエンコーダー。BC1は透明な画素を黒にするので、不透明にしたものでRGBを比べる
+	DirectX::ScratchImage opaque{};
+	MakeTestImage(size, opaque);
+	for (size_t i = 0; i < opaque.GetImageCount(); i++)
+	{
+		const DirectX::Image& level = opaque.GetImages()[i];
+		for (size_t y = 0; y < level.height; y++)
+		{
+			for (size_t x = 0; x < level.width; x++)
+			{
+				level.pixels[y * level.rowPitch + x * 4 + 3] = 255;
+			}
+		}
+	}
+	for (DXGI_FORMAT format : { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM })
+	{
+		const bool withAlpha = format == DXGI_FORMAT_BC3_UNORM;
+		printQualityTable(withAlpha ? "BC3" : "BC1", format, withAlpha ? image : opaque, withAlpha, {
+			{ "default", DirectX::TEX_COMPRESS_DEFAULT, 1.0 },
+			{ "simd fast", DirectX::TEX_COMPRESS_BC13_SIMD_FAST, kMaxRmseRatioFast },
+			{ "simd", DirectX::TEX_COMPRESS_BC13_SIMD, kMaxRmseRatio },
+			{ "simd slow", DirectX::TEX_COMPRESS_BC13_SIMD_SLOW, kMaxRmseRatio },
+			}, 3);
+	}
+
+	//BC7 の段階。既定（slow）は遅いので1回だけ測る
+	for (const DirectX::ScratchImage* source : { &opaque, &image })
+	{
+		printQualityTable(source == &image ? "BC7 alpha " : "BC7 opaque", DXGI_FORMAT_BC7_UNORM, *source, true, {
+			{ "slow", DirectX::TEX_COMPRESS_DEFAULT, 1.0 },
+			{ "basic", DirectX::TEX_COMPRESS_BC7_BASIC, kMaxRmseRatioBC7Basic },
+			{ "fast", DirectX::TEX_COMPRESS_BC7_FAST, kMaxRmseRatioBC7Fast },
+			{ "ultrafast", DirectX::TEX_COMPRESS_BC7_ULTRAFAST, kMaxRmseRatioBC7UltraFast },
+			{ "quick", DirectX::TEX_COMPRESS_BC7_QUICK, kMaxRmseRatioBC7UltraFast },
+			}, 1);
+	}
+
+	std::printf("result     : %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
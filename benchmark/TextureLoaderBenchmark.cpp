@@ -0,0 +1,202 @@
+///==========================================================
+/// TextureLoader.cpp の確認とベンチマーク
+/// 読み込みの代わりに、決まった時間かかる関数で小さな画像を作る
+/// 優先度の高い要求から読むか、SetPriorityで上げた要求が先に読まれるか、失敗した要求が空の画像で返るか
+/// コールバックの中から新しく要求できるかを調べる
+/// 全てを順に読んだ時間と、要求を出し終わるまでの時間（描画を始められるまでの時間）と全て読み終わるまでの時間も表示する
+/// 一覧（TextureCooker が書く textures.manifest）を渡すと、その中の画像を main.cpp と同じように LoadTextureFile で読めるかも調べる
+///
+/// ビルド例（Windows以外は DirectX-Headers と DirectXMath が要る。<DXH> と <DXM> はそれぞれを置いた場所）
+///   g++ -std=c++20 -O2 -pthread -I.. -I<DXH>/include -I<DXH>/include/wsl/stubs -I<DXM>/Inc TextureLoaderBenchmark.cpp ../TextureLoader.cpp ../TextureManifest.cpp ../MappedFile.cpp ../externals/DirectXTex/{DirectXTexImage,DirectXTexUtil,DirectXTexDDS,DirectXTexConvert,DirectXTexMisc}.cpp -o TextureLoaderBenchmark
+///   cl /std:c++20 /O2 /EHsc /I.. TextureLoaderBenchmark.cpp ..\TextureLoader.cpp ..\TextureManifest.cpp ..\MappedFile.cpp ..\externals\DirectXTex\DirectXTexImage.cpp ..\externals\DirectXTex\DirectXTexUtil.cpp ..\externals\DirectXTex\DirectXTexDDS.cpp ..\externals\DirectXTex\DirectXTexConvert.cpp ..\externals\DirectXTex\DirectXTexMisc.cpp ..\externals\DirectXTex\DirectXTexMipmaps.cpp ..\externals\DirectXTex\DirectXTexResize.cpp ..\externals\DirectXTex\DirectXTexWIC.cpp ole32.lib windowscodecs.lib
+///   （DirectXTex の *.cpp を全て渡すと、BCDirectCompute.cpp がシェーダーのコンパイル済みファイル（Shaders/Compiled）を要るので、使うものだけを渡す。Windowsは png の読み込みに WIC を使う）
+///   （Linux では代わりの最小限のヘッダーでビルドし、TextureCooker の出力（BC7 / BC1）の一覧を渡して通ることを確かめた）
+///   （本物の DirectX-Headers / DirectXMath と MSVC ではまだビルドを確かめていない）
+///
+/// 使い方
+///   TextureLoaderBenchmark [テクスチャの数] [1枚を読む時間（ミリ秒）] [一覧のパス]
+///   一覧を渡すときはプロジェクトのフォルダで実行する（例: TextureLoaderBenchmark 64 5 resources/cooked/textures.manifest）
+///==========================================================
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TextureLoader.h"
+#include "BenchmarkCommon.h"
+
+namespace
+{
+	//milliseconds だけかけて 4x4 の画像を作る。名前が "missing" で始まれば失敗する
+	bool FakeLoad(const std::string& filePath, DirectX::ScratchImage& image, double milliseconds)
+	{
+		std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(milliseconds));
+		if (filePath.starts_with("missing"))
+		{
+			return false;
+		}
+		return SUCCEEDED(image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 4, 4, 1, 1));
+	}
+
+	//全てのコールバックが呼ばれるまで DispatchCompleted を呼び続ける
+	void DispatchAll(TextureLoader& loader)
+	{
+		while (loader.GetPendingCount() > 0)
+		{
+			loader.DispatchCompleted();
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	}
+
+	//優先度の順に読むか
+	bool CheckPriorityOrder()
+	{
+		//1つ目の要求で唯一のワーカーを止めておき、その間に残りを積む
+		std::atomic<bool> entered = false;
+		std::atomic<bool> released = false;
+		TextureLoader loader([&](const std::string& filePath, DirectX::ScratchImage& image)
+			{
+				entered = true;
+				while (filePath == "gate" && !released)
+				{
+					std::this_thread::yield();
+				}
+				return FakeLoad(filePath, image, 0.0);
+			}, 1);
+
+		std::vector<std::string> order;
+		auto record = [&](const std::string& filePath, DirectX::ScratchImage&, bool) { order.push_back(filePath); };
+		loader.Request("gate", TextureLoader::kPriorityVisible, record);
+		//ワーカーが "gate" を取るまで待つ
+		while (!entered)
+		{
+			std::this_thread::yield();
+		}
+		loader.Request("low0", TextureLoader::kPriorityDefault, record);
+		loader.Request("high0", TextureLoader::kPriorityVisible, record);
+		const TextureLoader::RequestId raised = loader.Request("low1", TextureLoader::kPriorityDefault, record);
+		loader.Request("high1", TextureLoader::kPriorityVisible, record);
+		loader.Request("low2", TextureLoader::kPriorityDefault, record);
+		loader.SetPriority(raised, TextureLoader::kPriorityVisible + 1);
+		released = true;
+		DispatchAll(loader);
+
+		const std::vector<std::string> expected = { "gate", "low1", "high0", "high1", "low0", "low2" };
+		std::printf("  order            :");
+		for (const std::string& name : order)
+		{
+			std::printf(" %s", name.c_str());
+		}
+		std::printf("\n");
+		return Check("priority order", order == expected);
+	}
+
+	//失敗した要求とコールバックの中からの要求
+	bool CheckCallbacks()
+	{
+		TextureLoader loader([](const std::string& filePath, DirectX::ScratchImage& image) { return FakeLoad(filePath, image, 1.0); }, 2);
+		bool ok = true;
+		bool missingCalled = false;
+		bool chainedCalled = false;
+		loader.Request("missing.png", TextureLoader::kPriorityDefault, [&](const std::string&, DirectX::ScratchImage& image, bool succeeded)
+			{
+				missingCalled = true;
+				ok &= Check("failed request reports failure", !succeeded && image.GetImageCount() == 0);
+			});
+		loader.Request("first.png", TextureLoader::kPriorityDefault, [&](const std::string&, DirectX::ScratchImage& image, bool succeeded)
+			{
+				ok &= Check("loaded image", succeeded && image.GetMetadata().width == 4);
+				loader.Request("chained.png", TextureLoader::kPriorityDefault, [&](const std::string&, DirectX::ScratchImage&, bool chainedSucceeded)
+					{
+						chainedCalled = chainedSucceeded;
+					});
+			});
+		DispatchAll(loader);
+		ok &= Check("failed callback called", missingCalled);
+		ok &= Check("request from callback", chainedCalled);
+		return ok;
+	}
+
+	//TextureCooker の一覧にある画像を、main.cpp と同じように LoadTextureFile で読む
+	//一覧のパスは作業フォルダからの相対パスなので、プロジェクトのフォルダで実行する
+	bool CheckCookedTextures(const std::string& manifestPath)
+	{
+		TextureManifest textureManifest;
+		if (!Check("manifest loaded", textureManifest.Load(manifestPath)))
+		{
+			return false;
+		}
+		TextureLoader loader([&textureManifest](const std::string& filePath, DirectX::ScratchImage& image)
+			{
+				return LoadTextureFile(filePath, textureManifest, image);
+			});
+		bool ok = true;
+		for (const TextureManifestEntry& entry : textureManifest.entries())
+		{
+			loader.Request(entry.sourcePath, TextureLoader::kPriorityDefault, [&ok, entry](const std::string&, DirectX::ScratchImage& image, bool succeeded)
+				{
+					const DirectX::TexMetadata& metadata = image.GetMetadata();
+					std::printf("  %-40s : %s, %zux%zu, %zu mips\n", entry.sourcePath.c_str(), entry.format.c_str(), metadata.width, metadata.height, metadata.mipLevels);
+					ok &= Check("cooked texture loaded", succeeded);
+					ok &= Check("cooked texture is block-compressed unless RGBA8", DirectX::IsCompressed(metadata.format) == (entry.format != "RGBA8"));
+					ok &= Check("cooked texture has mipmaps", metadata.mipLevels > 1 || (metadata.width == 1 && metadata.height == 1));
+				});
+		}
+		bool missingSucceeded = true;
+		loader.Request("resources/missing.png", TextureLoader::kPriorityDefault, [&](const std::string&, DirectX::ScratchImage&, bool succeeded) { missingSucceeded = succeeded; });
+		DispatchAll(loader);
+		ok &= Check("cooked textures listed", !textureManifest.entries().empty());
+		ok &= Check("texture missing from the manifest and the disk fails", !missingSucceeded);
+		return ok;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const uint32_t textureCount = argc > 1 ? uint32_t(std::atoi(argv[1])) : 64;
+	const double loadMilliseconds = argc > 2 ? std::atof(argv[2]) : 5.0;
+	const char* manifestPath = argc > 3 ? argv[3] : nullptr;
+
+	bool ok = true;
+	std::printf("checks\n");
+	ok &= CheckPriorityOrder();
+	ok &= CheckCallbacks();
+	if (manifestPath)
+	{
+		std::printf("cooked textures (%s)\n", manifestPath);
+		ok &= CheckCookedTextures(manifestPath);
+	}
+
+	std::printf("%u textures, %.1f ms each\n", textureCount, loadMilliseconds);
+	//今までの読み方（描画の前に全てを順に読む）
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < textureCount; i++)
+	{
+		DirectX::ScratchImage image{};
+		FakeLoad("texture" + std::to_string(i), image, loadMilliseconds);
+	}
+	const double serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::printf("  synchronous      : %8.2f ms before the first frame\n", serialMs);
+
+	for (uint32_t threadCount : { 1u, 4u, 0u })
+	{
+		TextureLoader loader([&](const std::string& filePath, DirectX::ScratchImage& image) { return FakeLoad(filePath, image, loadMilliseconds); }, threadCount);
+		uint32_t loaded = 0;
+		start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < textureCount; i++)
+		{
+			loader.Request("texture" + std::to_string(i), TextureLoader::kPriorityDefault, [&](const std::string&, DirectX::ScratchImage&, bool succeeded) { loaded += succeeded; });
+		}
+		const double requestMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		DispatchAll(loader);
+		const double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::printf("  async %2u threads : %8.2f ms before the first frame, %8.2f ms until all resident\n", loader.GetThreadCount(), requestMs, totalMs);
+		ok &= Check("all textures loaded", loaded == textureCount);
+	}
+
+	std::printf("result           : %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+///==========================================================
+/// TransformBatch.h のマイクロベンチマーク
+/// 1オブジェクトずつ MakeAffineMatrix + Multiply で計算する従来の方法と
+/// ComputeTransformationMatrices のバッチ処理を比べる
+///
+/// ビルド例（Windowsヘッダーは不要）
+///   g++ -std=c++20 -O2 -march=native -I.. TransformBatchBenchmark.cpp -o TransformBatchBenchmark
+///   cl /std:c++20 /O2 /EHsc /arch:AVX2 /I.. TransformBatchBenchmark.cpp
+///==========================================================
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "TransformBatch.h"
+#include "BenchmarkCommon.h"
+
+int main(int argc, char** argv)
+{
+	const size_t objectCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+	const int repeat = 20;
+
+	//ランダムなTransformを用意する
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> scaleDist(0.5f, 2.0f);
+	std::uniform_real_distribution<float> rotateDist(-3.14159265f, 3.14159265f);
+	std::uniform_real_distribution<float> translateDist(-100.0f, 100.0f);
+
+	std::vector<Transform> transforms(objectCount);
+	TransformSoA transformSoA;
+	transformSoA.resize(objectCount);
+	for (size_t i = 0; i < objectCount; i++)
+	{
+		transforms[i] = {
+			{ scaleDist(random), scaleDist(random), scaleDist(random) },
+			{ rotateDist(random), rotateDist(random), rotateDist(random) },
+			{ translateDist(random), translateDist(random), translateDist(random) } };
+		transformSoA.Set(i, transforms[i]);
+	}
+
+	Transform camera{ { 1.0f, 1.0f, 1.0f }, { 0.3f, 0.2f, 0.0f }, { 0.0f, 5.0f, -50.0f } };
+	Matrix4x4 viewProjection = Multiply(MakeViewMatrix(camera), MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 1000.0f));
+
+	std::vector<TransfomationMatrix> reference(objectCount);
+	std::vector<TransfomationMatrix> output(objectCount);
+
+	//従来の1オブジェクトずつの計算
+	double perObjectNs = MeasureBest(repeat, [&]()
+		{
+			for (size_t i = 0; i < objectCount; i++)
+			{
+				Matrix4x4 world = MakeAffineMatrix(transforms[i].scale, transforms[i].rotate, transforms[i].translate);
+				reference[i].WVP = Multiply(world, viewProjection);
+				reference[i].World = world;
+			}
+		});
+
+	//SoAのバッチ計算
+	double batchNs = MeasureBest(repeat, [&]()
+		{
+			ComputeTransformationMatrices(transformSoA, viewProjection, output);
+		});
+
+	//結果が一致しているか確認する
+	float maxError = 0.0f;
+	for (size_t i = 0; i < objectCount; i++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				maxError = std::fmax(maxError, std::fabs(reference[i].WVP.m[r][c] - output[i].WVP.m[r][c]));
+				maxError = std::fmax(maxError, std::fabs(reference[i].World.m[r][c] - output[i].World.m[r][c]));
+			}
+		}
+	}
+
+	std::printf("objects          : %zu\n", objectCount);
+	std::printf("per-object       : %8.3f ms (%6.2f ns/object)\n", perObjectNs * 1e-6, perObjectNs / double(objectCount));
+	std::printf("batch (SoA)      : %8.3f ms (%6.2f ns/object)\n", batchNs * 1e-6, batchNs / double(objectCount));
+	std::printf("speedup          : %8.2fx\n", perObjectNs / batchNs);
+	std::printf("max abs error    : %g\n", maxError);
+	return 0;
+}
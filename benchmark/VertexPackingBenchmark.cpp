@@ -0,0 +1,189 @@
+///==========================================================
+/// VertexPacking.cpp の確認とベンチマーク
+/// 半精度の変換は全てのビット列の往復と、ランダムな値が最も近い半精度に丸められているかを調べる
+/// 法線（八面体）、座標（16bit）、UV（半精度）はランダムな頂点で往復させ、誤差が上限を超えないかを調べる
+/// objファイルのあるディレクトリを指定すると、その中のモデルの誤差も表示する
+///
+/// ビルド例（Windowsヘッダーは不要）
+///   g++ -std=c++20 -O2 -march=native -pthread -I.. VertexPackingBenchmark.cpp ../VertexPacking.cpp ../ObjLoader.cpp ../TangentSpace.cpp -o VertexPackingBenchmark
+///   cl /std:c++20 /O2 /EHsc /I.. VertexPackingBenchmark.cpp ..\VertexPacking.cpp ..\ObjLoader.cpp ..\TangentSpace.cpp
+///
+/// 使い方
+///   VertexPackingBenchmark [頂点の数] [objファイルのあるディレクトリ]
+///==========================================================
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include "ObjLoader.h"
+#include "VectorMath.h"
+#include "VertexPacking.h"
+#include "BenchmarkCommon.h"
+
+namespace
+{
+	//往復させたときの誤差の最大値
+	struct RoundTripError
+	{
+		double position = 0.0;		// メッシュの大きさに対する割合
+		double texcoord = 0.0;		// 値の大きさに対する割合（1未満は絶対値）
+		double normalDegrees = 0.0;	// 角度
+	};
+
+	//2つのベクトルのなす角（度）。1に近い内積のacosは誤差が大きいので、外積の長さと内積から求める
+	double AngleDegrees(const Vector3& a, const Vector3& b)
+	{
+		const double crossX = double(a.y) * b.z - double(a.z) * b.y;
+		const double crossY = double(a.z) * b.x - double(a.x) * b.z;
+		const double crossZ = double(a.x) * b.y - double(a.y) * b.x;
+		const double dot = double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z;
+		return std::atan2(std::sqrt(crossX * crossX + crossY * crossY + crossZ * crossZ), dot) * 180.0 / std::numbers::pi;
+	}
+
+	RoundTripError MeasureRoundTrip(const std::vector<VertexData>& vertices)
+	{
+		std::vector<PackedVertexData> packed(vertices.size());
+		const VertexQuantization quantization = PackVertices(vertices, packed);
+		const double extent = std::max({ double(quantization.positionScale.x), double(quantization.positionScale.y), double(quantization.positionScale.z), 1e-30 });
+
+		RoundTripError error;
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			const VertexData& source = vertices[i];
+			const VertexData unpacked = UnpackVertex(packed[i], quantization);
+			error.position = std::max({ error.position,
+				std::fabs(double(unpacked.position.x) - source.position.x) / extent,
+				std::fabs(double(unpacked.position.y) - source.position.y) / extent,
+				std::fabs(double(unpacked.position.z) - source.position.z) / extent });
+			error.texcoord = std::max({ error.texcoord,
+				std::fabs(double(unpacked.texcoord.x) - source.texcoord.x) / std::max(1.0, std::fabs(double(source.texcoord.x))),
+				std::fabs(double(unpacked.texcoord.y) - source.texcoord.y) / std::max(1.0, std::fabs(double(source.texcoord.y))) });
+			error.normalDegrees = std::max(error.normalDegrees, AngleDegrees(unpacked.normal, source.normal));
+		}
+		return error;
+	}
+
+	//半精度の変換を調べる
+	bool CheckHalf()
+	{
+		bool ok = true;
+		//全てのビット列が往復する（NaNはNaNのまま）
+		uint32_t mismatches = 0;
+		for (uint32_t bits = 0; bits <= 0xFFFF; bits++)
+		{
+			const float value = HalfToFloat(uint16_t(bits));
+			const uint16_t back = FloatToHalf(value);
+			const bool isNaN = (bits & 0x7C00) == 0x7C00 && (bits & 0x03FF) != 0;
+			mismatches += isNaN ? !std::isnan(value) || (back & 0x7FFF) <= 0x7C00 : back != bits;
+		}
+		ok &= Check("half: every bit pattern round-trips", mismatches == 0);
+
+		//ランダムな値が隣の半精度より遠くない（最も近い値に丸められている）
+		std::mt19937 random(7);
+		std::uniform_int_distribution<uint32_t> bitsDistribution(0, 0x477FE000);
+		uint32_t notNearest = 0;
+		for (int i = 0; i < 1000000; i++)
+		{
+			const float value = std::bit_cast<float>(bitsDistribution(random) | (i & 1 ? 0x80000000u : 0u));
+			const uint16_t half = FloatToHalf(value);
+			const double error = std::fabs(double(HalfToFloat(half)) - value);
+			const double below = std::fabs(double(HalfToFloat(uint16_t(half - 1))) - value);
+			const double above = (half & 0x7FFF) < 0x7BFF ? std::fabs(double(HalfToFloat(uint16_t(half + 1))) - value) : 1e30;
+			notNearest += ((half & 0x7FFF) != 0 && error > below) || error > above;
+		}
+		ok &= Check("half: rounds to nearest", notNearest == 0);
+		ok &= Check("half: overflow becomes infinity", FloatToHalf(65520.0f) == 0x7C00 && FloatToHalf(-1e10f) == 0xFC00 && FloatToHalf(65519.0f) == 0x7BFF);
+		ok &= Check("half: ties round to even", FloatToHalf(1.0f + 1.0f / 2048.0f) == 0x3C00 && FloatToHalf(1.0f + 3.0f / 2048.0f) == 0x3C02);
+		return ok;
+	}
+
+	//単位球の上に一様に散らした法線と、軸や折り返しの境目の法線
+	std::vector<Vector3> MakeNormals(size_t count, std::mt19937& random)
+	{
+		std::vector<Vector3> normals =
+		{
+			{ 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+			Nomalize({ 1.0f, 1.0f, 0.0f }), Nomalize({ -1.0f, 1.0f, 0.0f }), Nomalize({ 1.0f, -1.0f, -1e-7f }), Nomalize({ 1.0f, 1.0f, 1.0f }), Nomalize({ -1.0f, -1.0f, -1.0f }),
+		};
+		std::normal_distribution<float> gaussian(0.0f, 1.0f);
+		while (normals.size() < count)
+		{
+			const Vector3 normal{ gaussian(random), gaussian(random), gaussian(random) };
+			if (Length(normal) > 1e-3f)
+			{
+				normals.push_back(Nomalize(normal));
+			}
+		}
+		return normals;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t vertexCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	bool ok = CheckHalf();
+
+	//ランダムな頂点（座標はメッシュの大きさがばらばら、UVは0～1と外側、法線は一様）
+	std::mt19937 random(11);
+	const std::vector<Vector3> normals = MakeNormals(vertexCount, random);
+	std::uniform_real_distribution<float> position(-250.0f, 1000.0f);
+	std::uniform_real_distribution<float> texcoord(-4.0f, 4.0f);
+	std::vector<VertexData> vertices(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		vertices[i].position = { position(random), position(random) * 0.01f, position(random), 1.0f };
+		vertices[i].texcoord = { i % 2 ? texcoord(random) : texcoord(random) * 0.125f + 0.5f, texcoord(random) };
+		vertices[i].normal = normals[i];
+	}
+
+	//座標は16bitの刻みの半分（とfloatの計算の丸め）、UVは半精度の仮数の半分、法線は16bitの八面体の刻みに収まる
+	static constexpr double kPositionLimit = 0.51 / 65535.0;
+
+	std::vector<PackedVertexData> packed(vertexCount);
+	const double packNs = MeasureBest(3, [&]() { PackVertices(vertices, packed); });
+	const RoundTripError error = MeasureRoundTrip(vertices);
+	std::printf("vertices         : %zu\n", vertexCount);
+	std::printf("vertex size      : %zu -> %zu bytes (%.0f%% smaller)\n", sizeof(VertexData), sizeof(PackedVertexData), 100.0 * (1.0 - double(sizeof(PackedVertexData)) / double(sizeof(VertexData))));
+	std::printf("PackVertices     : %8.2f ms (%.1f Mvertices/s)\n", packNs * 1e-6, double(vertexCount) / (packNs * 1e-9) * 1e-6);
+	std::printf("position error   : %.3g of extent (limit %.3g)\n", error.position, kPositionLimit);
+	std::printf("texcoord error   : %.3g relative (limit %.3g)\n", error.texcoord, 1.0 / 2048.0);
+	std::printf("normal error     : %.5f degrees\n", error.normalDegrees);
+
+	ok &= Check("position error is within half a step", error.position <= kPositionLimit);
+	ok &= Check("texcoord error is within half an ulp", error.texcoord <= 1.0 / 2048.0);
+	ok &= Check("normal error is below 0.003 degrees", error.normalDegrees < 0.003);
+
+	//大きさが0の軸（平面）でも元の座標に戻り、wは1になる
+	{
+		std::vector<VertexData> plane(2, vertices[0]);
+		plane[1].position.x += 1.0f;
+		std::vector<PackedVertexData> planePacked(plane.size());
+		const VertexQuantization quantization = PackVertices(plane, planePacked);
+		ok &= Check("flat axis keeps its coordinate", UnpackVertex(planePacked[1], quantization).position.y == plane[1].position.y &&
+			UnpackVertex(planePacked[0], quantization).position.x == plane[0].position.x && UnpackVertex(planePacked[1], quantization).position.x == plane[1].position.x &&
+			UnpackVertex(planePacked[0], quantization).position.w == 1.0f);
+	}
+
+	if (argc > 2)
+	{
+		for (const auto& entry : std::filesystem::directory_iterator(argv[2]))
+		{
+			if (entry.path().extension() == ".obj")
+			{
+				const std::string filename = entry.path().filename().string();
+				const ModelData model = LoadObjFile(argv[2], filename);
+				const RoundTripError modelError = MeasureRoundTrip(model.vertices);
+				std::printf("%-16s : position %.3g, texcoord %.3g, normal %.5f degrees\n", filename.c_str(), modelError.position, modelError.texcoord, modelError.normalDegrees);
+			}
+		}
+	}
+
+	std::printf("result           : %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
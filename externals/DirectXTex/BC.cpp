@@ -17,6 +17,10 @@
 
 #include "BC.h"
 
+#if defined(__AVX2__) || defined(_XM_SSE_INTRINSICS_)
+#include <immintrin.h>
+#endif
+
 using namespace DirectX;
 using namespace DirectX::PackedVector;
 
@@ -717,6 +721,599 @@ namespace
         pBC->bitmap = 0x00000000;
     }
 #endif // COLOR_WEIGHTS
+
+    //-------------------------------------------------------------------------------------
+    // Multi-block BC1/BC3 encoder
+    //
+    // Encodes several blocks at once with one block per SIMD lane (structure of arrays, in
+    // the style of the ISPC texture compressor). The lane width follows the instruction set
+    // the library is built for, as DirectXMath does: 8 with AVX2, 4 with SSE, and a plain
+    // 4-wide loop that the compiler can vectorize otherwise.
+    //
+    // Color endpoints come from a principal axis fit and are then refined with least squares
+    // on the chosen indices. Every candidate is scored against the palette the hardware
+    // decodes from the 5:6:5 endpoints, and each lane keeps its best one
+    //-------------------------------------------------------------------------------------
+#if defined(__AVX2__)
+    constexpr size_t c_LaneCount = 8;
+
+    struct BCLanes
+    {
+        __m256 v;
+    };
+
+    inline BCLanes LanesSet(float f) noexcept { return { _mm256_set1_ps(f) }; }
+    inline BCLanes LanesLoad(_In_reads_(c_LaneCount) const float* p) noexcept { return { _mm256_load_ps(p) }; }
+    inline void LanesStore(_Out_writes_(c_LaneCount) float* p, BCLanes a) noexcept { _mm256_store_ps(p, a.v); }
+    inline BCLanes operator+(BCLanes a, BCLanes b) noexcept { return { _mm256_add_ps(a.v, b.v) }; }
+    inline BCLanes operator-(BCLanes a, BCLanes b) noexcept { return { _mm256_sub_ps(a.v, b.v) }; }
+    inline BCLanes operator*(BCLanes a, BCLanes b) noexcept { return { _mm256_mul_ps(a.v, b.v) }; }
+    inline BCLanes operator/(BCLanes a, BCLanes b) noexcept { return { _mm256_div_ps(a.v, b.v) }; }
+    inline BCLanes LanesMin(BCLanes a, BCLanes b) noexcept { return { _mm256_min_ps(a.v, b.v) }; }
+    inline BCLanes LanesMax(BCLanes a, BCLanes b) noexcept { return { _mm256_max_ps(a.v, b.v) }; }
+    inline BCLanes LanesSqrt(BCLanes a) noexcept { return { _mm256_sqrt_ps(a.v) }; }
+    inline BCLanes LanesTruncate(BCLanes a) noexcept { return { _mm256_cvtepi32_ps(_mm256_cvttps_epi32(a.v)) }; }
+    inline BCLanes LanesLess(BCLanes a, BCLanes b) noexcept { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+    inline BCLanes LanesEqual(BCLanes a, BCLanes b) noexcept { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+    inline BCLanes LanesSelect(BCLanes mask, BCLanes a, BCLanes b) noexcept { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+    inline bool LanesAny(BCLanes mask) noexcept { return _mm256_movemask_ps(mask.v) != 0; }
+
+    // Reads one RGBA pixel of each lane's block, at pSrc[lane] + offset
+    inline void LanesTranspose(_In_reads_(c_LaneCount) const float* const* pSrc, size_t offset, BCLanes& r, BCLanes& g, BCLanes& b, BCLanes& a) noexcept
+    {
+        const __m256 p0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pSrc[0] + offset)), _mm_loadu_ps(pSrc[4] + offset), 1);
+        const __m256 p1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pSrc[1] + offset)), _mm_loadu_ps(pSrc[5] + offset), 1);
+        const __m256 p2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pSrc[2] + offset)), _mm_loadu_ps(pSrc[6] + offset), 1);
+        const __m256 p3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pSrc[3] + offset)), _mm_loadu_ps(pSrc[7] + offset), 1);
+        const __m256 t0 = _mm256_unpacklo_ps(p0, p1);
+        const __m256 t1 = _mm256_unpacklo_ps(p2, p3);
+        const __m256 t2 = _mm256_unpackhi_ps(p0, p1);
+        const __m256 t3 = _mm256_unpackhi_ps(p2, p3);
+        r.v = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+        g.v = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+        b.v = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        a.v = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    }
+#elif defined(_XM_SSE_INTRINSICS_)
+    constexpr size_t c_LaneCount = 4;
+
+    struct BCLanes
+    {
+        __m128 v;
+    };
+
+    inline BCLanes LanesSet(float f) noexcept { return { _mm_set1_ps(f) }; }
+    inline BCLanes LanesLoad(_In_reads_(c_LaneCount) const float* p) noexcept { return { _mm_load_ps(p) }; }
+    inline void LanesStore(_Out_writes_(c_LaneCount) float* p, BCLanes a) noexcept { _mm_store_ps(p, a.v); }
+    inline BCLanes operator+(BCLanes a, BCLanes b) noexcept { return { _mm_add_ps(a.v, b.v) }; }
+    inline BCLanes operator-(BCLanes a, BCLanes b) noexcept { return { _mm_sub_ps(a.v, b.v) }; }
+    inline BCLanes operator*(BCLanes a, BCLanes b) noexcept { return { _mm_mul_ps(a.v, b.v) }; }
+    inline BCLanes operator/(BCLanes a, BCLanes b) noexcept { return { _mm_div_ps(a.v, b.v) }; }
+    inline BCLanes LanesMin(BCLanes a, BCLanes b) noexcept { return { _mm_min_ps(a.v, b.v) }; }
+    inline BCLanes LanesMax(BCLanes a, BCLanes b) noexcept { return { _mm_max_ps(a.v, b.v) }; }
+    inline BCLanes LanesSqrt(BCLanes a) noexcept { return { _mm_sqrt_ps(a.v) }; }
+    inline BCLanes LanesTruncate(BCLanes a) noexcept { return { _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v)) }; }
+    inline BCLanes LanesLess(BCLanes a, BCLanes b) noexcept { return { _mm_cmplt_ps(a.v, b.v) }; }
+    inline BCLanes LanesEqual(BCLanes a, BCLanes b) noexcept { return { _mm_cmpeq_ps(a.v, b.v) }; }
+    inline BCLanes LanesSelect(BCLanes mask, BCLanes a, BCLanes b) noexcept { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+    inline bool LanesAny(BCLanes mask) noexcept { return _mm_movemask_ps(mask.v) != 0; }
+
+    // Reads one RGBA pixel of each lane's block, at pSrc[lane] + offset
+    inline void LanesTranspose(_In_reads_(c_LaneCount) const float* const* pSrc, size_t offset, BCLanes& r, BCLanes& g, BCLanes& b, BCLanes& a) noexcept
+    {
+        __m128 p0 = _mm_loadu_ps(pSrc[0] + offset);
+        __m128 p1 = _mm_loadu_ps(pSrc[1] + offset);
+        __m128 p2 = _mm_loadu_ps(pSrc[2] + offset);
+        __m128 p3 = _mm_loadu_ps(pSrc[3] + offset);
+        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+        r.v = p0;
+        g.v = p1;
+        b.v = p2;
+        a.v = p3;
+    }
+#else
+    constexpr size_t c_LaneCount = 4;
+
+    struct BCLanes
+    {
+        float v[c_LaneCount];
+    };
+
+    template <typename Op>
+    inline BCLanes LanesApply(BCLanes a, BCLanes b, Op op) noexcept
+    {
+        BCLanes r;
+        for (size_t i = 0; i < c_LaneCount; ++i)
+            r.v[i] = op(a.v[i], b.v[i]);
+        return r;
+    }
+
+    inline BCLanes LanesSet(float f) noexcept { return { { f, f, f, f } }; }
+    inline BCLanes LanesLoad(_In_reads_(c_LaneCount) const float* p) noexcept { return { { p[0], p[1], p[2], p[3] } }; }
+    inline void LanesStore(_Out_writes_(c_LaneCount) float* p, BCLanes a) noexcept { memcpy(p, a.v, sizeof(a.v)); }
+    inline BCLanes operator+(BCLanes a, BCLanes b) noexcept { return LanesApply(a, b, [](float x, float y) { return x + y; }); }
+    inline BCLanes operator-(BCLanes a, BCLanes b) noexcept { return LanesApply(a, b, [](float x, float y) { return x - y; }); }
+    inline BCLanes operator*(BCLanes a, BCLanes b) noexcept { return LanesApply(a, b, [](float x, float y) { return x * y; }); }
+    inline BCLanes operator/(BCLanes a, BCLanes b) noexcept { return LanesApply(a, b, [](float x, float y) { return x / y; }); }
+    inline BCLanes LanesMin(BCLanes a, BCLanes b) noexcept { return LanesApply(a, b, [](float x, float y) { return (y < x) ? y : x; }); }
+    inline BCLanes LanesMax(BCLanes a, BCLanes b) noexcept { return LanesApply(a, b, [](float x, float y) { return (x < y) ? y : x; }); }
+    inline BCLanes LanesSqrt(BCLanes a) noexcept { return LanesApply(a, a, [](float x, float) { return sqrtf(x); }); }
+    inline BCLanes LanesTruncate(BCLanes a) noexcept { return LanesApply(a, a, [](float x, float) { return static_cast<float>(static_cast<int32_t>(x)); }); }
+    // Masks hold 1 for true and 0 for false
+    inline BCLanes LanesLess(BCLanes a, BCLanes b) noexcept { return LanesApply(a, b, [](float x, float y) { return (x < y) ? 1.0f : 0.0f; }); }
+    inline BCLanes LanesEqual(BCLanes a, BCLanes b) noexcept { return LanesApply(a, b, [](float x, float y) { return (x == y) ? 1.0f : 0.0f; }); }
+
+    inline BCLanes LanesSelect(BCLanes mask, BCLanes a, BCLanes b) noexcept
+    {
+        BCLanes r;
+        for (size_t i = 0; i < c_LaneCount; ++i)
+            r.v[i] = (mask.v[i] != 0.0f) ? a.v[i] : b.v[i];
+        return r;
+    }
+
+    inline bool LanesAny(BCLanes mask) noexcept
+    {
+        for (size_t i = 0; i < c_LaneCount; ++i)
+        {
+            if (mask.v[i] != 0.0f)
+                return true;
+        }
+        return false;
+    }
+
+    // Reads one RGBA pixel of each lane's block, at pSrc[lane] + offset
+    inline void LanesTranspose(_In_reads_(c_LaneCount) const float* const* pSrc, size_t offset, BCLanes& r, BCLanes& g, BCLanes& b, BCLanes& a) noexcept
+    {
+        for (size_t i = 0; i < c_LaneCount; ++i)
+        {
+            r.v[i] = pSrc[i][offset + 0];
+            g.v[i] = pSrc[i][offset + 1];
+            b.v[i] = pSrc[i][offset + 2];
+            a.v[i] = pSrc[i][offset + 3];
+        }
+    }
+#endif
+
+    inline BCLanes LanesClamp(BCLanes a, float lo, float hi) noexcept
+    {
+        return LanesMin(LanesMax(a, LanesSet(lo)), LanesSet(hi));
+    }
+
+    // The pixels of c_LaneCount blocks, one block per lane; color is in the weighted space
+    struct BCBlockLanes
+    {
+        BCLanes r[NUM_PIXELS_PER_BLOCK];
+        BCLanes g[NUM_PIXELS_PER_BLOCK];
+        BCLanes b[NUM_PIXELS_PER_BLOCK];
+        BCLanes a[NUM_PIXELS_PER_BLOCK];
+    };
+
+    // A pair of 5:6:5 endpoints per lane and the colors the hardware decodes them to (weighted space)
+    struct BCEndpointLanes
+    {
+        BCLanes r0, g0, b0;
+        BCLanes r1, g1, b1;
+        BCLanes code0, code1;
+    };
+
+    //-------------------------------------------------------------------------------------
+    // Transposes count (at most c_LaneCount) blocks into lanes; unused lanes repeat the last
+    // block. pMinAlpha receives the smallest alpha of each block
+    //-------------------------------------------------------------------------------------
+    void LoadBlockLanes(
+        _In_reads_(count * NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor,
+        size_t count,
+        const HDRColorA& weights,
+        _Out_ BCBlockLanes& lanes,
+        _Out_writes_(c_LaneCount) float* pMinAlpha) noexcept
+    {
+        assert(count > 0 && count <= c_LaneCount);
+        static_assert(sizeof(XMVECTOR) == sizeof(float) * 4, "XMVECTOR should be 4 floats");
+
+        const float* pSrc[c_LaneCount];
+        for (size_t lane = 0; lane < c_LaneCount; ++lane)
+            pSrc[lane] = reinterpret_cast<const float*>(pColor + std::min(lane, count - 1) * NUM_PIXELS_PER_BLOCK);
+
+        const BCLanes wr = LanesSet(weights.r), wg = LanesSet(weights.g), wb = LanesSet(weights.b);
+        BCLanes minAlpha = LanesSet(1.0f);
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            BCLanes r, g, b;
+            LanesTranspose(pSrc, i * 4, r, g, b, lanes.a[i]);
+            lanes.r[i] = r * wr;
+            lanes.g[i] = g * wg;
+            lanes.b[i] = b * wb;
+            minAlpha = LanesMin(minAlpha, lanes.a[i]);
+        }
+
+        XM_ALIGNED_DATA(32) float alpha[c_LaneCount];
+        LanesStore(alpha, minAlpha);
+        memcpy(pMinAlpha, alpha, sizeof(alpha));
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Rounds weighted-space endpoints to 5:6:5
+    //-------------------------------------------------------------------------------------
+    inline void QuantizeChannel(BCLanes c, float weight, float levels, BCLanes& decoded, BCLanes& code) noexcept
+    {
+        code = LanesTruncate(LanesClamp(c * LanesSet(1.0f / weight), 0.0f, 1.0f) * LanesSet(levels) + LanesSet(0.5f));
+        decoded = code * LanesSet(weight / levels);
+    }
+
+    BCEndpointLanes QuantizeEndpoints(
+        BCLanes r0, BCLanes g0, BCLanes b0,
+        BCLanes r1, BCLanes g1, BCLanes b1,
+        const HDRColorA& weights) noexcept
+    {
+        BCEndpointLanes e;
+        BCLanes qr, qg, qb;
+
+        QuantizeChannel(r0, weights.r, 31.0f, e.r0, qr);
+        QuantizeChannel(g0, weights.g, 63.0f, e.g0, qg);
+        QuantizeChannel(b0, weights.b, 31.0f, e.b0, qb);
+        e.code0 = qr * LanesSet(2048.0f) + qg * LanesSet(32.0f) + qb;
+
+        QuantizeChannel(r1, weights.r, 31.0f, e.r1, qr);
+        QuantizeChannel(g1, weights.g, 63.0f, e.g1, qg);
+        QuantizeChannel(b1, weights.b, 31.0f, e.b1, qb);
+        e.code1 = qr * LanesSet(2048.0f) + qg * LanesSet(32.0f) + qb;
+
+        return e;
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Initial endpoints: the extent of the block along its principal axis
+    //-------------------------------------------------------------------------------------
+    BCEndpointLanes FitPrincipalAxis(const BCBlockLanes& lanes, const HDRColorA& weights) noexcept
+    {
+        BCLanes mr = LanesSet(0.0f), mg = LanesSet(0.0f), mb = LanesSet(0.0f);
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            mr = mr + lanes.r[i];
+            mg = mg + lanes.g[i];
+            mb = mb + lanes.b[i];
+        }
+        const BCLanes inv = LanesSet(1.0f / float(NUM_PIXELS_PER_BLOCK));
+        mr = mr * inv;
+        mg = mg * inv;
+        mb = mb * inv;
+
+        BCLanes crr = LanesSet(0.0f), crg = LanesSet(0.0f), crb = LanesSet(0.0f);
+        BCLanes cgg = LanesSet(0.0f), cgb = LanesSet(0.0f), cbb = LanesSet(0.0f);
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            const BCLanes dr = lanes.r[i] - mr;
+            const BCLanes dg = lanes.g[i] - mg;
+            const BCLanes db = lanes.b[i] - mb;
+            crr = crr + dr * dr;
+            crg = crg + dr * dg;
+            crb = crb + dr * db;
+            cgg = cgg + dg * dg;
+            cgb = cgb + dg * db;
+            cbb = cbb + db * db;
+        }
+
+        // Scale by the trace so the largest eigenvalue is between 1/3 and 1 and the power iteration
+        // below neither underflows on low contrast blocks nor overflows
+        const BCLanes trace = crr + cgg + cbb;
+        const BCLanes invTrace = LanesSet(1.0f) / LanesSelect(LanesLess(LanesSet(0.0f), trace), trace, LanesSet(1.0f));
+        crr = crr * invTrace;
+        crg = crg * invTrace;
+        crb = crb * invTrace;
+        cgg = cgg * invTrace;
+        cgb = cgb * invTrace;
+        cbb = cbb * invTrace;
+
+        // Power iteration, starting from the covariance row with the largest variance
+        const BCLanes useR = LanesLess(LanesMax(cgg, cbb), crr);
+        const BCLanes useG = LanesLess(cbb, cgg);
+        BCLanes vr = LanesSelect(useR, crr, LanesSelect(useG, crg, crb));
+        BCLanes vg = LanesSelect(useR, crg, LanesSelect(useG, cgg, cgb));
+        BCLanes vb = LanesSelect(useR, crb, LanesSelect(useG, cgb, cbb));
+        // The starting row is at least 1/3 long, so the vector only needs normalizing at the end
+        for (size_t iter = 0; iter < 4; ++iter)
+        {
+            const BCLanes nr = crr * vr + crg * vg + crb * vb;
+            const BCLanes ng = crg * vr + cgg * vg + cgb * vb;
+            const BCLanes nb = crb * vr + cgb * vg + cbb * vb;
+            vr = nr;
+            vg = ng;
+            vb = nb;
+        }
+
+        // A solid block has no axis; both endpoints end up at the mean
+        const BCLanes len2 = vr * vr + vg * vg + vb * vb;
+        const BCLanes invLen = LanesSet(1.0f) / LanesSqrt(LanesSelect(LanesLess(LanesSet(1e-30f), len2), len2, LanesSet(1.0f)));
+        vr = vr * invLen;
+        vg = vg * invLen;
+        vb = vb * invLen;
+
+        BCLanes tmin = (lanes.r[0] - mr) * vr + (lanes.g[0] - mg) * vg + (lanes.b[0] - mb) * vb;
+        BCLanes tmax = tmin;
+        for (size_t i = 1; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            const BCLanes t = (lanes.r[i] - mr) * vr + (lanes.g[i] - mg) * vg + (lanes.b[i] - mb) * vb;
+            tmin = LanesMin(tmin, t);
+            tmax = LanesMax(tmax, t);
+        }
+
+        return QuantizeEndpoints(
+            mr + vr * tmin, mg + vg * tmin, mb + vb * tmin,
+            mr + vr * tmax, mg + vg * tmax, mb + vb * tmax,
+            weights);
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Picks the nearest of the 4 palette colors for every pixel as a level 0..3 from endpoint 0
+    // to endpoint 1. The palette is evenly spaced on a line, so rounding the projection onto the
+    // line finds the nearest entry. Returns the summed squared error if computeError is set
+    //-------------------------------------------------------------------------------------
+    BCLanes SelectColorLevels(
+        const BCBlockLanes& lanes,
+        const BCEndpointLanes& e,
+        bool computeError,
+        _Out_writes_(NUM_PIXELS_PER_BLOCK) BCLanes* pLevels) noexcept
+    {
+        const BCLanes dr = e.r1 - e.r0, dg = e.g1 - e.g0, db = e.b1 - e.b0;
+        const BCLanes len2 = dr * dr + dg * dg + db * db;
+        const BCLanes scale = LanesSelect(LanesLess(LanesSet(0.0f), len2), LanesSet(3.0f) / LanesMax(len2, LanesSet(1e-12f)), LanesSet(0.0f));
+
+        BCLanes error = LanesSet(0.0f);
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            const BCLanes pr = lanes.r[i] - e.r0, pg = lanes.g[i] - e.g0, pb = lanes.b[i] - e.b0;
+            const BCLanes t = (pr * dr + pg * dg + pb * db) * scale;
+            const BCLanes level = LanesTruncate(LanesClamp(t, 0.0f, 3.0f) + LanesSet(0.5f));
+            pLevels[i] = level;
+
+            if (computeError)
+            {
+                const BCLanes f = level * LanesSet(1.0f / 3.0f);
+                const BCLanes x = pr - dr * f, y = pg - dg * f, z = pb - db * f;
+                error = error + x * x + y * y + z * z;
+            }
+        }
+
+        return error;
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Least squares endpoints for the given levels; lanes where all pixels share one
+    // palette entry keep their current endpoints
+    //-------------------------------------------------------------------------------------
+    BCEndpointLanes RefineEndpoints(
+        const BCBlockLanes& lanes,
+        _In_reads_(NUM_PIXELS_PER_BLOCK) const BCLanes* pLevels,
+        const BCEndpointLanes& current,
+        const HDRColorA& weights) noexcept
+    {
+        BCLanes w00 = LanesSet(0.0f), w01 = LanesSet(0.0f), w11 = LanesSet(0.0f);
+        BCLanes r0 = LanesSet(0.0f), g0 = LanesSet(0.0f), b0 = LanesSet(0.0f);
+        BCLanes r1 = LanesSet(0.0f), g1 = LanesSet(0.0f), b1 = LanesSet(0.0f);
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            const BCLanes t = pLevels[i] * LanesSet(1.0f / 3.0f);
+            const BCLanes s = LanesSet(1.0f) - t;
+
+            w00 = w00 + s * s;
+            w01 = w01 + s * t;
+            w11 = w11 + t * t;
+            r0 = r0 + s * lanes.r[i];
+            g0 = g0 + s * lanes.g[i];
+            b0 = b0 + s * lanes.b[i];
+            r1 = r1 + t * lanes.r[i];
+            g1 = g1 + t * lanes.g[i];
+            b1 = b1 + t * lanes.b[i];
+        }
+
+        const BCLanes det = w00 * w11 - w01 * w01;
+        const BCLanes solvable = LanesLess(LanesSet(1e-3f), det);
+        const BCLanes invDet = LanesSet(1.0f) / LanesSelect(solvable, det, LanesSet(1.0f));
+
+        return QuantizeEndpoints(
+            LanesSelect(solvable, (r0 * w11 - r1 * w01) * invDet, current.r0),
+            LanesSelect(solvable, (g0 * w11 - g1 * w01) * invDet, current.g0),
+            LanesSelect(solvable, (b0 * w11 - b1 * w01) * invDet, current.b0),
+            LanesSelect(solvable, (r1 * w00 - r0 * w01) * invDet, current.r1),
+            LanesSelect(solvable, (g1 * w00 - g0 * w01) * invDet, current.g1),
+            LanesSelect(solvable, (b1 * w00 - b0 * w01) * invDet, current.b1),
+            weights);
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Encodes the color part of c_LaneCount blocks in the 4-color mode
+    //-------------------------------------------------------------------------------------
+    void EncodeColorLanes(
+        const BCBlockLanes& lanes,
+        const HDRColorA& weights,
+        uint32_t refineCount,
+        _Out_writes_(c_LaneCount) D3DX_BC1* pBC) noexcept
+    {
+        BCEndpointLanes best = FitPrincipalAxis(lanes, weights);
+        BCLanes bestLevels[NUM_PIXELS_PER_BLOCK];
+        BCLanes bestError = SelectColorLevels(lanes, best, refineCount > 0, bestLevels);
+
+        for (uint32_t iter = 0; iter < refineCount; ++iter)
+        {
+            const BCEndpointLanes e = RefineEndpoints(lanes, bestLevels, best, weights);
+            BCLanes levels[NUM_PIXELS_PER_BLOCK];
+            const BCLanes error = SelectColorLevels(lanes, e, true, levels);
+
+            // Stop once no lane improves; refining the same levels again gives the same result
+            const BCLanes better = LanesLess(error, bestError);
+            if (!LanesAny(better))
+                break;
+
+            best.r0 = LanesSelect(better, e.r0, best.r0);
+            best.g0 = LanesSelect(better, e.g0, best.g0);
+            best.b0 = LanesSelect(better, e.b0, best.b0);
+            best.r1 = LanesSelect(better, e.r1, best.r1);
+            best.g1 = LanesSelect(better, e.g1, best.g1);
+            best.b1 = LanesSelect(better, e.b1, best.b1);
+            best.code0 = LanesSelect(better, e.code0, best.code0);
+            best.code1 = LanesSelect(better, e.code1, best.code1);
+            for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+                bestLevels[i] = LanesSelect(better, levels[i], bestLevels[i]);
+            bestError = LanesSelect(better, error, bestError);
+        }
+
+        // The 4-color mode needs rgb[0] > rgb[1]; swapping the endpoints reverses the levels
+        const BCLanes swap = LanesLess(best.code0, best.code1);
+        const BCLanes code0 = LanesSelect(swap, best.code1, best.code0);
+        const BCLanes code1 = LanesSelect(swap, best.code0, best.code1);
+
+        // Level to index (0 and 1 are the endpoints, 2 and 3 the colors 1/3 and 2/3 of the way),
+        // packed 8 pixels at a time so the 16 bits stay exact in a float
+        BCLanes bitmapLo = LanesSet(0.0f), bitmapHi = LanesSet(0.0f);
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            const BCLanes level = LanesSelect(swap, LanesSet(3.0f) - bestLevels[i], bestLevels[i]);
+            const BCLanes index = level + LanesSet(1.0f)
+                - LanesSelect(LanesEqual(level, LanesSet(0.0f)), LanesSet(1.0f), LanesSet(0.0f))
+                - LanesSelect(LanesEqual(level, LanesSet(3.0f)), LanesSet(3.0f), LanesSet(0.0f));
+            const BCLanes bit = LanesSet(static_cast<float>(1u << ((i & 7) * 2)));
+            if (i < 8)
+                bitmapLo = bitmapLo + index * bit;
+            else
+                bitmapHi = bitmapHi + index * bit;
+        }
+
+        XM_ALIGNED_DATA(32) float packed[4][c_LaneCount];
+        LanesStore(packed[0], code0);
+        LanesStore(packed[1], code1);
+        LanesStore(packed[2], bitmapLo);
+        LanesStore(packed[3], bitmapHi);
+
+        for (size_t lane = 0; lane < c_LaneCount; ++lane)
+        {
+            pBC[lane].rgb[0] = static_cast<uint16_t>(packed[0][lane]);
+            pBC[lane].rgb[1] = static_cast<uint16_t>(packed[1][lane]);
+
+            // Equal endpoints read as the 3-color mode, where index 3 is transparent black
+            pBC[lane].bitmap = (pBC[lane].rgb[0] == pBC[lane].rgb[1]) ? 0u
+                : static_cast<uint32_t>(packed[2][lane]) | (static_cast<uint32_t>(packed[3][lane]) << 16);
+        }
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Encodes the alpha part of c_LaneCount BC3 blocks, choosing per block between the mode
+    // with 8 interpolated values and the one with 6 plus explicit 0 and 255
+    //-------------------------------------------------------------------------------------
+    void EncodeAlphaLanes(
+        const BCBlockLanes& lanes,
+        _Out_writes_(c_LaneCount) D3DX_BC3* pBC) noexcept
+    {
+        BCLanes alpha[NUM_PIXELS_PER_BLOCK];
+        BCLanes lo = LanesSet(255.0f), hi = LanesSet(0.0f);
+        BCLanes innerLo = LanesSet(255.0f), innerHi = LanesSet(0.0f);
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            alpha[i] = LanesTruncate(LanesClamp(lanes.a[i], 0.0f, 1.0f) * LanesSet(255.0f) + LanesSet(0.5f));
+            lo = LanesMin(lo, alpha[i]);
+            hi = LanesMax(hi, alpha[i]);
+
+            // Range of the values that are neither 0 nor 255
+            const BCLanes inner = LanesLess(LanesSet(0.0f), alpha[i]);
+            const BCLanes notFull = LanesLess(alpha[i], LanesSet(255.0f));
+            innerLo = LanesSelect(inner, LanesSelect(notFull, LanesMin(innerLo, alpha[i]), innerLo), innerLo);
+            innerHi = LanesSelect(inner, LanesSelect(notFull, LanesMax(innerHi, alpha[i]), innerHi), innerHi);
+        }
+
+        // No values in between: any endpoints do, as every pixel uses 0 or 255
+        const BCLanes noInner = LanesLess(innerHi, innerLo);
+        innerLo = LanesSelect(noInner, LanesSet(0.0f), innerLo);
+        innerHi = LanesSelect(noInner, LanesSet(0.0f), innerHi);
+
+        const BCLanes range8 = hi - lo;
+        const BCLanes scale8 = LanesSet(7.0f) / LanesSelect(LanesLess(LanesSet(0.0f), range8), range8, LanesSet(1.0f));
+        const BCLanes step8 = range8 * LanesSet(1.0f / 7.0f);
+        const BCLanes range6 = innerHi - innerLo;
+        const BCLanes scale6 = LanesSet(5.0f) / LanesSelect(LanesLess(LanesSet(0.0f), range6), range6, LanesSet(1.0f));
+        const BCLanes step6 = range6 * LanesSet(1.0f / 5.0f);
+
+        BCLanes level8[NUM_PIXELS_PER_BLOCK];
+        BCLanes level6[NUM_PIXELS_PER_BLOCK];
+        BCLanes error8 = LanesSet(0.0f), error6 = LanesSet(0.0f);
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            // Level 0..7 from lo to hi
+            level8[i] = LanesTruncate((alpha[i] - lo) * scale8 + LanesSet(0.5f));
+            const BCLanes d8 = alpha[i] - (lo + level8[i] * step8);
+            error8 = error8 + d8 * d8;
+
+            // Level 0..5 from innerLo to innerHi, 6 for 0 and 7 for 255
+            BCLanes level = LanesTruncate(LanesClamp((alpha[i] - innerLo) * scale6, 0.0f, 5.0f) + LanesSet(0.5f));
+            const BCLanes d6 = alpha[i] - (innerLo + level * step6);
+            BCLanes best = d6 * d6;
+
+            const BCLanes d0 = alpha[i] * alpha[i];
+            BCLanes closer = LanesLess(d0, best);
+            best = LanesSelect(closer, d0, best);
+            level = LanesSelect(closer, LanesSet(6.0f), level);
+
+            const BCLanes d255 = (LanesSet(255.0f) - alpha[i]) * (LanesSet(255.0f) - alpha[i]);
+            closer = LanesLess(d255, best);
+            best = LanesSelect(closer, d255, best);
+            level = LanesSelect(closer, LanesSet(7.0f), level);
+
+            level6[i] = level;
+            error6 = error6 + best;
+        }
+
+        XM_ALIGNED_DATA(32) float endpoints[4][c_LaneCount];
+        XM_ALIGNED_DATA(32) float use6[c_LaneCount];
+        XM_ALIGNED_DATA(32) float levels8[NUM_PIXELS_PER_BLOCK][c_LaneCount];
+        XM_ALIGNED_DATA(32) float levels6[NUM_PIXELS_PER_BLOCK][c_LaneCount];
+        LanesStore(endpoints[0], lo);
+        LanesStore(endpoints[1], hi);
+        LanesStore(endpoints[2], innerLo);
+        LanesStore(endpoints[3], innerHi);
+        LanesStore(use6, LanesSelect(LanesLess(error6, error8), LanesSet(1.0f), LanesSet(0.0f)));
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            LanesStore(levels8[i], level8[i]);
+            LanesStore(levels6[i], level6[i]);
+        }
+
+        // Level to index: index 0 is alpha[0], 1 is alpha[1], and 2.. are the interpolated values
+        static const uint32_t pSteps8[] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+        static const uint32_t pSteps6[] = { 0, 2, 3, 4, 5, 1, 6, 7 };
+
+        for (size_t lane = 0; lane < c_LaneCount; ++lane)
+        {
+            const bool mode6 = use6[lane] != 0.0f;
+            uint64_t dw = 0;
+            if (mode6)
+            {
+                // alpha[0] <= alpha[1] selects 6 interpolated values
+                pBC[lane].alpha[0] = static_cast<uint8_t>(endpoints[2][lane]);
+                pBC[lane].alpha[1] = static_cast<uint8_t>(endpoints[3][lane]);
+                for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+                    dw |= uint64_t(pSteps6[static_cast<uint32_t>(levels6[i][lane])]) << (i * 3);
+            }
+            else
+            {
+                // With lo == hi this reads as the 6 value mode, where index 1 is still hi
+                pBC[lane].alpha[0] = static_cast<uint8_t>(endpoints[1][lane]);
+                pBC[lane].alpha[1] = static_cast<uint8_t>(endpoints[0][lane]);
+                for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+                    dw |= uint64_t(pSteps8[static_cast<uint32_t>(levels8[i][lane])]) << (i * 3);
+            }
+
+            for (size_t j = 0; j < 6; ++j)
+                pBC[lane].bitmap[j] = static_cast<uint8_t>(dw >> (j * 8));
+        }
+    }
+
+    // Quality levels of the multi-block encoder
+    inline uint32_t GetRefineCount(uint32_t flags) noexcept
+    {
+        if (flags & BC_FLAGS_SIMD_FAST)
+            return 0;
+        if (flags & BC_FLAGS_SIMD_SLOW)
+            return 8;
+        return 2;
+    }
 }
 
 
@@ -1139,3 +1736,86 @@ void DirectX::D3DXEncodeBC3(uint8_t *pBC, const XMVECTOR *pColor, uint32_t flags
         pBC3->bitmap[2 + iSet * 3] = reinterpret_cast<uint8_t *>(&dw)[2];
     }
 }
+
+
+//-------------------------------------------------------------------------------------
+// BC1 / BC3 multi-block compression
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void DirectX::D3DXEncodeBC1Multi(uint8_t *pBC, const XMVECTOR *pColor, size_t count, float threshold, uint32_t flags) noexcept
+{
+    assert(pBC && pColor);
+    static_assert(sizeof(D3DX_BC1) == 8, "D3DX_BC1 should be 8 bytes");
+
+    // Dithering carries the error from pixel to pixel, which the lanes do not do
+    if (flags & (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A))
+    {
+        for (size_t i = 0; i < count; ++i)
+            D3DXEncodeBC1(pBC + i * sizeof(D3DX_BC1), pColor + i * NUM_PIXELS_PER_BLOCK, threshold, flags);
+        return;
+    }
+
+    const HDRColorA weights = (flags & BC_FLAGS_UNIFORM) ? HDRColorA(1.0f, 1.0f, 1.0f, 1.0f) : g_Luminance;
+    const uint32_t refineCount = GetRefineCount(flags);
+
+    for (size_t first = 0; first < count; first += c_LaneCount)
+    {
+        const size_t n = std::min(c_LaneCount, count - first);
+
+        BCBlockLanes lanes;
+        float minAlpha[c_LaneCount];
+        LoadBlockLanes(pColor + first * NUM_PIXELS_PER_BLOCK, n, weights, lanes, minAlpha);
+
+        D3DX_BC1 blocks[c_LaneCount];
+        EncodeColorLanes(lanes, weights, refineCount, blocks);
+
+        for (size_t lane = 0; lane < n; ++lane)
+        {
+            uint8_t *pDest = pBC + (first + lane) * sizeof(D3DX_BC1);
+
+            // Transparent pixels need the 3-color mode, which only the single block encoder searches
+            if (minAlpha[lane] < threshold)
+                D3DXEncodeBC1(pDest, pColor + (first + lane) * NUM_PIXELS_PER_BLOCK, threshold, flags);
+            else
+                memcpy(pDest, &blocks[lane], sizeof(D3DX_BC1));
+        }
+    }
+}
+
+_Use_decl_annotations_
+void DirectX::D3DXEncodeBC3Multi(uint8_t *pBC, const XMVECTOR *pColor, size_t count, uint32_t flags) noexcept
+{
+    assert(pBC && pColor);
+    static_assert(sizeof(D3DX_BC3) == 16, "D3DX_BC3 should be 16 bytes");
+
+    if (flags & (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A))
+    {
+        for (size_t i = 0; i < count; ++i)
+            D3DXEncodeBC3(pBC + i * sizeof(D3DX_BC3), pColor + i * NUM_PIXELS_PER_BLOCK, flags);
+        return;
+    }
+
+    const HDRColorA weights = (flags & BC_FLAGS_UNIFORM) ? HDRColorA(1.0f, 1.0f, 1.0f, 1.0f) : g_Luminance;
+    const uint32_t refineCount = GetRefineCount(flags);
+
+    for (size_t first = 0; first < count; first += c_LaneCount)
+    {
+        const size_t n = std::min(c_LaneCount, count - first);
+
+        BCBlockLanes lanes;
+        float minAlpha[c_LaneCount];
+        LoadBlockLanes(pColor + first * NUM_PIXELS_PER_BLOCK, n, weights, lanes, minAlpha);
+
+        D3DX_BC1 colors[c_LaneCount];
+        EncodeColorLanes(lanes, weights, refineCount, colors);
+
+        D3DX_BC3 blocks[c_LaneCount];
+        EncodeAlphaLanes(lanes, blocks);
+
+        for (size_t lane = 0; lane < n; ++lane)
+        {
+            blocks[lane].bc1 = colors[lane];
+            memcpy(pBC + (first + lane) * sizeof(D3DX_BC3), &blocks[lane], sizeof(D3DX_BC3));
+        }
+    }
+}
@@ -45,6 +45,22 @@ namespace DirectX
 
         BC_FLAGS_FORCE_BC7_MODE6 = 0x100000,
         // BC7 should only use mode 6; skip other modes
+
+        BC_FLAGS_SIMD = 0x200000,
+        // BC1/BC3 use the multi-block SIMD encoder (D3DXEncodeBC1Multi / D3DXEncodeBC3Multi)
+
+        BC_FLAGS_SIMD_FAST = 0x400000,
+        // Multi-block encoder keeps the principal axis endpoints without refining them
+
+        BC_FLAGS_SIMD_SLOW = 0x800000,
+        // Multi-block encoder refines the endpoints more times
+
+        BC_FLAGS_BC7_ULTRAFAST = 0x4000000,
+        BC_FLAGS_BC7_FAST = 0x8000000,
+        BC_FLAGS_BC7_BASIC = 0xC000000,
+        BC_FLAGS_BC7_TIER_MASK = 0xC000000,
+        // BC7 uses the tiered search (PCA ranked partitions, endpoint optimization only for the best candidates)
+        // instead of the default one; a two-bit field rather than separate flags
     };
 
     //-------------------------------------------------------------------------------------
@@ -336,4 +352,9 @@ namespace DirectX
     void D3DXEncodeBC6HS(_Out_writes_(16) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ uint32_t flags) noexcept;
     void D3DXEncodeBC7(_Out_writes_(16) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ uint32_t flags) noexcept;
 
+    void D3DXEncodeBC1Multi(_Out_writes_(count * 8) uint8_t *pBC, _In_reads_(count * NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ size_t count, _In_ float threshold, _In_ uint32_t flags) noexcept;
+    void D3DXEncodeBC3Multi(_Out_writes_(count * 16) uint8_t *pBC, _In_reads_(count * NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ size_t count, _In_ uint32_t flags) noexcept;
+        // Encode count consecutive blocks, several at a time in SIMD lanes. Dithering falls back to the
+        // single block encoders, as do BC1 blocks with pixels below the alpha threshold
+
 } // namespace
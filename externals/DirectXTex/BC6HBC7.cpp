@@ -766,6 +766,29 @@ namespace
         void Encode(uint32_t flags, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA* const pIn) noexcept;
 
     private:
+        static constexpr size_t c_MaxTierModes = 7;
+        static constexpr size_t c_MaxOptimized = 4;
+
+        struct TierInfo
+        {
+            uint8_t uNumModes;
+            uint8_t aModes[c_MaxTierModes];         // modes tried for opaque blocks, in order
+            uint8_t uNumAlphaModes;
+            uint8_t aAlphaModes[c_MaxTierModes];    // modes tried for blocks with alpha, in order
+            uint8_t uEstimatedShapes;               // partitions kept from the PCA estimate per mode
+            uint8_t uOptimized;                     // best candidates of each mode refined again with endpoint optimization
+            bool bAllRotations;                     // try every rotation and index mode of modes 4 and 5
+            float fErrorThreshold;                  // stop once the block error (summed squared 8-bit error) is at or below this
+        };
+
+        struct Candidate
+        {
+            float fErr;
+            uint8_t uShape;
+            uint8_t uRotation;
+            uint8_t uIndexMode;
+        };
+
         struct ModeInfo
         {
             uint8_t uPartitions;
@@ -851,16 +874,22 @@ namespace
             _In_reads_(NUM_PIXELS_PER_BLOCK) const size_t aIndex[],
             _In_reads_(NUM_PIXELS_PER_BLOCK) const size_t aIndex2[]) noexcept;
         void FixEndpointPBits(_In_ const EncodeParams* pEP, _In_reads_(BC7_MAX_REGIONS) const LDREndPntPair *pOrigEndpoints, _Out_writes_(BC7_MAX_REGIONS) LDREndPntPair *pFixedEndpoints) noexcept;
-        float Refine(_In_ const EncodeParams* pEP, _In_ size_t uShape, _In_ size_t uRotation, _In_ size_t uIndexMode) noexcept;
+        float Refine(_In_ const EncodeParams* pEP, _In_ size_t uShape, _In_ size_t uRotation, _In_ size_t uIndexMode, _In_ bool bOptimize) noexcept;
+        void EncodeTiered(_In_ uint32_t flags, _In_ const EncodeParams* pSource, _In_ bool bHasAlpha) noexcept;
 
         float MapColors(_In_ const EncodeParams* pEP, _In_reads_(np) const LDRColorA aColors[], _In_ size_t np, _In_ size_t uIndexMode,
             _In_ const LDREndPntPair& endPts, _In_ float fMinErr) const noexcept;
         static float RoughMSE(_Inout_ EncodeParams* pEP, _In_ size_t uShape, _In_ size_t uIndexMode) noexcept;
+        static size_t EstimateShapes(_In_ const EncodeParams* pEP, _In_ size_t uPartitions, _In_ size_t uShapes, _In_ size_t uCandidates,
+            _Out_writes_(BC7_MAX_SHAPES) size_t auShape[]) noexcept;
+        static void RotatePixels(_Inout_ EncodeParams* pEP, _In_ size_t uRotation,
+            _Inout_updates_all_opt_(NUM_PIXELS_PER_BLOCK) HDRColorA* pHDRPixels = nullptr) noexcept;
 
     private:
         static constexpr uint8_t c_NumModes = 8;
 
         static const ModeInfo ms_aInfo[c_NumModes];
+        static const TierInfo ms_aTiers[3];
     };
 }
 
@@ -1112,6 +1141,17 @@ const D3DX_BC7::ModeInfo D3DX_BC7::ms_aInfo[D3DX_BC7::c_NumModes] =
         // Mode 7: Color+Alpha, 2 Subsets, RGBAP 55551 (unique P-bit), 2-bit indices, 64 partitions
 };
 
+// Tiers of BC_FLAGS_BC7_TIER_MASK; the default search (no tier) is the slow one
+const D3DX_BC7::TierInfo D3DX_BC7::ms_aTiers[3] =
+{
+    {1, {6}, 1, {6}, 1, 0, false, 0.0f},
+        // Ultrafast: mode 6 only, no endpoint optimization
+    {3, {6, 1, 3}, 3, {6, 5, 7}, 2, 0, false, 64.0f},
+        // Fast: mode 6 and two 2-subset modes, 2 PCA ranked partitions, no rotations or endpoint optimization
+    {7, {6, 1, 3, 4, 5, 0, 2}, 6, {6, 5, 7, 4, 1, 3}, 6, 1, true, 16.0f},
+        // Basic: the default modes with rotations, 6 PCA ranked partitions, optimizes the best candidate of each mode
+};
+
 
 namespace
 {
@@ -1637,6 +1677,87 @@ namespace
         #endif
         }
     }
+
+    //-------------------------------------------------------------------------------------
+    // Sums over a subset of pixels for the BC7 partition estimate; the covariance of the
+    // subset follows from the channel sums and the sums of their products
+    //-------------------------------------------------------------------------------------
+    struct SubsetSums
+    {
+        float fCount;
+        float aSum[BC7_NUM_CHANNELS];
+        float aProd[BC7_NUM_CHANNELS][BC7_NUM_CHANNELS];
+
+        void Add(const SubsetSums& other, float fSign) noexcept
+        {
+            fCount += fSign * other.fCount;
+            for (size_t i = 0; i < BC7_NUM_CHANNELS; ++i)
+            {
+                aSum[i] += fSign * other.aSum[i];
+                for (size_t j = i; j < BC7_NUM_CHANNELS; ++j)
+                    aProd[i][j] += fSign * other.aProd[i][j];
+            }
+        }
+    };
+
+    //-------------------------------------------------------------------------------------
+    // Squared error left after fitting the subset with a line along its principal axis
+    // (the trace of the covariance minus its largest eigenvalue). Ignores quantization,
+    // so it only ranks partitions
+    //-------------------------------------------------------------------------------------
+    float EstimateLineError(const SubsetSums& sums) noexcept
+    {
+        if (sums.fCount < 2.0f)
+            return 0.0f;
+
+        float aCov[BC7_NUM_CHANNELS][BC7_NUM_CHANNELS];
+        float fTrace = 0.0f;
+        size_t uLargest = 0;
+        for (size_t i = 0; i < BC7_NUM_CHANNELS; ++i)
+        {
+            for (size_t j = i; j < BC7_NUM_CHANNELS; ++j)
+            {
+                aCov[i][j] = aCov[j][i] = sums.aProd[i][j] - sums.aSum[i] * sums.aSum[j] / sums.fCount;
+            }
+            fTrace += aCov[i][i];
+            if (aCov[i][i] > aCov[uLargest][uLargest])
+                uLargest = i;
+        }
+        if (fTrace <= 0.0f)
+            return 0.0f;
+
+        // Power iteration from the row of the channel with the largest variance
+        float aAxis[BC7_NUM_CHANNELS];
+        for (size_t i = 0; i < BC7_NUM_CHANNELS; ++i)
+            aAxis[i] = aCov[uLargest][i] / fTrace;
+
+        float fLength2 = 0.0f;
+        float fLambda = 0.0f;
+        for (size_t iter = 0; iter < 4; ++iter)
+        {
+            float aNext[BC7_NUM_CHANNELS] = {};
+            for (size_t i = 0; i < BC7_NUM_CHANNELS; ++i)
+                for (size_t j = 0; j < BC7_NUM_CHANNELS; ++j)
+                    aNext[i] += aCov[i][j] * aAxis[j];
+
+            fLength2 = 0.0f;
+            fLambda = 0.0f;
+            for (size_t i = 0; i < BC7_NUM_CHANNELS; ++i)
+            {
+                fLength2 += aAxis[i] * aAxis[i];
+                fLambda += aAxis[i] * aNext[i];
+            }
+            if (fLength2 <= 0.0f)
+                return fTrace;
+
+            const float fScale = 1.0f / sqrtf(fLength2);
+            for (size_t i = 0; i < BC7_NUM_CHANNELS; ++i)
+                aAxis[i] = aNext[i] * fScale;
+        }
+
+        // Rayleigh quotient of the previous axis
+        return std::max(0.0f, fTrace - fLambda / fLength2);
+    }
 }
 
 
@@ -2780,6 +2901,12 @@ void D3DX_BC7::Encode(uint32_t flags, const HDRColorA* const pIn) noexcept
 
     const bool bHasAlpha = (alphaMask != 0xFF);
 
+    if (flags & BC_FLAGS_BC7_TIER_MASK)
+    {
+        EncodeTiered(flags, &EP, bHasAlpha);
+        return;
+    }
+
     for (EP.uMode = 0; EP.uMode < 8 && fMSEBest > 0; ++EP.uMode)
     {
         if (!(flags & BC_FLAGS_USE_3SUBSETS) && (EP.uMode == 0 || EP.uMode == 2))
@@ -2814,12 +2941,7 @@ void D3DX_BC7::Encode(uint32_t flags, const HDRColorA* const pIn) noexcept
 
         for (size_t r = 0; r < uNumRots && fMSEBest > 0; ++r)
         {
-            switch (r)
-            {
-            case 1: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(EP.aLDRPixels[i].r, EP.aLDRPixels[i].a); break;
-            case 2: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(EP.aLDRPixels[i].g, EP.aLDRPixels[i].a); break;
-            case 3: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(EP.aLDRPixels[i].b, EP.aLDRPixels[i].a); break;
-            }
+            RotatePixels(&EP, r);
 
             for (size_t im = 0; im < uNumIdxMode && fMSEBest > 0; ++im)
             {
@@ -2845,21 +2967,115 @@ void D3DX_BC7::Encode(uint32_t flags, const HDRColorA* const pIn) noexcept
 
                 for (size_t i = 0; i < uItems && fMSEBest > 0; i++)
                 {
-                    const float fMSE = Refine(&EP, auShape[i], r, im);
+                    const float fMSE = Refine(&EP, auShape[i], r, im, true);
+                    if (fMSE < fMSEBest)
+                    {
+                        final = *this;
+                        fMSEBest = fMSE;
+                    }
+                }
+            }
+
+            RotatePixels(&EP, r);
+        }
+    }
+
+    *this = final;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Tiered search: ranks the partitions of each mode with a PCA estimate, refines the best
+// few without endpoint optimization, then optimizes only the best candidates of the mode
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void D3DX_BC7::EncodeTiered(uint32_t flags, const EncodeParams* pSource, bool bHasAlpha) noexcept
+{
+    assert(pSource);
+
+    // RoughMSE fits the color endpoints of modes 4 and 5 to aHDRPixels, which the default search
+    // leaves unrotated and relies on the endpoint optimization to fix; rotate a copy here so the
+    // candidates are ranked from sensible endpoints
+    HDRColorA aHDRPixels[NUM_PIXELS_PER_BLOCK];
+    memcpy(aHDRPixels, pSource->aHDRPixels, sizeof(aHDRPixels));
+    EncodeParams EP(aHDRPixels);
+    memcpy(EP.aLDRPixels, pSource->aLDRPixels, sizeof(EP.aLDRPixels));
+    EncodeParams* pEP = &EP;
+
+    const TierInfo& tier = ms_aTiers[(flags & BC_FLAGS_BC7_TIER_MASK) / BC_FLAGS_BC7_ULTRAFAST - 1];
+    const uint8_t* pModes = bHasAlpha ? tier.aAlphaModes : tier.aModes;
+    const size_t uNumModes = bHasAlpha ? tier.uNumAlphaModes : tier.uNumModes;
+    assert(tier.uOptimized <= c_MaxOptimized);
+
+    D3DX_BC7 final = *this;
+    float fMSEBest = FLT_MAX;
+
+    for (size_t m = 0; m < uNumModes && fMSEBest > tier.fErrorThreshold; ++m)
+    {
+        pEP->uMode = pModes[m];
+        if (!(flags & BC_FLAGS_USE_3SUBSETS) && (pEP->uMode == 0 || pEP->uMode == 2))
+        {
+            // Same as the default search
+            continue;
+        }
+
+        const ModeInfo& info = ms_aInfo[pEP->uMode];
+        size_t auShape[BC7_MAX_SHAPES];
+        const size_t uNumShapes = EstimateShapes(pEP, info.uPartitions, size_t(1) << info.uPartitionBits, tier.uEstimatedShapes, auShape);
+        const size_t uNumRots = tier.bAllRotations ? (size_t(1) << info.uRotationBits) : 1;
+        const size_t uNumIdxMode = tier.bAllRotations ? (size_t(1) << info.uIndexModeBits) : 1;
+        Candidate aBest[c_MaxOptimized] = {};
+        size_t uNumBest = 0;
+
+        for (size_t r = 0; r < uNumRots && fMSEBest > tier.fErrorThreshold; ++r)
+        {
+            RotatePixels(pEP, r, aHDRPixels);
+
+            for (size_t im = 0; im < uNumIdxMode && fMSEBest > tier.fErrorThreshold; ++im)
+            {
+                for (size_t i = 0; i < uNumShapes && fMSEBest > tier.fErrorThreshold; ++i)
+                {
+                    RoughMSE(pEP, auShape[i], im);
+                    const float fMSE = Refine(pEP, auShape[i], r, im, false);
                     if (fMSE < fMSEBest)
                     {
                         final = *this;
                         fMSEBest = fMSE;
                     }
+
+                    // Keep the best candidates of the mode sorted by error
+                    size_t pos = uNumBest;
+                    while (pos > 0 && aBest[pos - 1].fErr > fMSE)
+                        --pos;
+                    if (pos < tier.uOptimized)
+                    {
+                        uNumBest = std::min<size_t>(uNumBest + 1, tier.uOptimized);
+                        for (size_t j = uNumBest - 1; j > pos; --j)
+                            aBest[j] = aBest[j - 1];
+                        aBest[pos] = { fMSE, uint8_t(auShape[i]), uint8_t(r), uint8_t(im) };
+                    }
                 }
             }
 
-            switch (r)
+            RotatePixels(pEP, r, aHDRPixels);
+        }
+
+        // Errors before endpoint optimization rank the candidates of one mode well enough, but
+        // not candidates of different modes, so each mode optimizes its own best
+        for (size_t c = 0; c < uNumBest && fMSEBest > tier.fErrorThreshold; ++c)
+        {
+            RotatePixels(pEP, aBest[c].uRotation, aHDRPixels);
+
+            // The endpoints of the shape may have been overwritten by a later index mode
+            RoughMSE(pEP, aBest[c].uShape, aBest[c].uIndexMode);
+            const float fMSE = Refine(pEP, aBest[c].uShape, aBest[c].uRotation, aBest[c].uIndexMode, true);
+            if (fMSE < fMSEBest)
             {
-            case 1: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(EP.aLDRPixels[i].r, EP.aLDRPixels[i].a); break;
-            case 2: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(EP.aLDRPixels[i].g, EP.aLDRPixels[i].a); break;
-            case 3: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(EP.aLDRPixels[i].b, EP.aLDRPixels[i].a); break;
+                final = *this;
+                fMSEBest = fMSE;
             }
+
+            RotatePixels(pEP, aBest[c].uRotation, aHDRPixels);
         }
     }
 
@@ -2867,6 +3083,109 @@ void D3DX_BC7::Encode(uint32_t flags, const HDRColorA* const pIn) noexcept
 }
 
 
+//-------------------------------------------------------------------------------------
+// Ranks the partitions by the error of fitting each subset with a line and returns the
+// best uCandidates of them in auShape
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+size_t D3DX_BC7::EstimateShapes(const EncodeParams* pEP, size_t uPartitions, size_t uShapes, size_t uCandidates, size_t auShape[]) noexcept
+{
+    assert(pEP);
+    assert(uPartitions < BC7_MAX_REGIONS);
+    _Analysis_assume_(uPartitions < BC7_MAX_REGIONS);
+    assert(uShapes <= BC7_MAX_SHAPES);
+    _Analysis_assume_(uShapes <= BC7_MAX_SHAPES);
+
+    if (uPartitions == 0 || uCandidates >= uShapes)
+    {
+        for (size_t s = 0; s < uShapes; ++s)
+            auShape[s] = s;
+        return uShapes;
+    }
+
+    SubsetSums aPixel[NUM_PIXELS_PER_BLOCK] = {};
+    SubsetSums total = {};
+    for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+    {
+        const LDRColorA& c = pEP->aLDRPixels[i];
+        const float aValue[BC7_NUM_CHANNELS] = { float(c.r), float(c.g), float(c.b), float(c.a) };
+        aPixel[i].fCount = 1.0f;
+        for (size_t j = 0; j < BC7_NUM_CHANNELS; ++j)
+        {
+            aPixel[i].aSum[j] = aValue[j];
+            for (size_t k = j; k < BC7_NUM_CHANNELS; ++k)
+                aPixel[i].aProd[j][k] = aValue[j] * aValue[k];
+        }
+        total.Add(aPixel[i], 1.0f);
+    }
+
+    float afError[BC7_MAX_SHAPES];
+    for (size_t s = 0; s < uShapes; ++s)
+    {
+        // Subset 0 is whatever the other subsets leave
+        SubsetSums aSubset[BC7_MAX_REGIONS] = {};
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            const uint8_t uRegion = g_aPartitionTable[uPartitions][s][i];
+            if (uRegion)
+                aSubset[uRegion].Add(aPixel[i], 1.0f);
+        }
+        aSubset[0] = total;
+        for (size_t p = 1; p <= uPartitions; ++p)
+            aSubset[0].Add(aSubset[p], -1.0f);
+
+        afError[s] = 0.0f;
+        for (size_t p = 0; p <= uPartitions; ++p)
+            afError[s] += EstimateLineError(aSubset[p]);
+        auShape[s] = s;
+    }
+
+    // Bubble up the first uCandidates items
+    for (size_t i = 0; i < uCandidates; i++)
+    {
+        for (size_t j = i + 1; j < uShapes; j++)
+        {
+            if (afError[i] > afError[j])
+            {
+                std::swap(afError[i], afError[j]);
+                std::swap(auShape[i], auShape[j]);
+            }
+        }
+    }
+
+    return uCandidates;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Swaps alpha with the channel selected by the rotation; calling it again undoes it
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void D3DX_BC7::RotatePixels(EncodeParams* pEP, size_t uRotation, HDRColorA* pHDRPixels) noexcept
+{
+    assert(pEP);
+
+    switch (uRotation)
+    {
+    case 1: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(pEP->aLDRPixels[i].r, pEP->aLDRPixels[i].a); break;
+    case 2: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(pEP->aLDRPixels[i].g, pEP->aLDRPixels[i].a); break;
+    case 3: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(pEP->aLDRPixels[i].b, pEP->aLDRPixels[i].a); break;
+    default: break;
+    }
+
+    if (pHDRPixels)
+    {
+        switch (uRotation)
+        {
+        case 1: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(pHDRPixels[i].r, pHDRPixels[i].a); break;
+        case 2: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(pHDRPixels[i].g, pHDRPixels[i].a); break;
+        case 3: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(pHDRPixels[i].b, pHDRPixels[i].a); break;
+        default: break;
+        }
+    }
+}
+
+
 //-------------------------------------------------------------------------------------
 _Use_decl_annotations_
 void D3DX_BC7::GeneratePaletteQuantized(const EncodeParams* pEP, size_t uIndexMode, const LDREndPntPair& endPts, LDRColorA aPalette[]) const noexcept
@@ -3374,7 +3693,7 @@ void D3DX_BC7::FixEndpointPBits(const EncodeParams* pEP, const LDREndPntPair *pO
 }
 
 _Use_decl_annotations_
-float D3DX_BC7::Refine(const EncodeParams* pEP, size_t uShape, size_t uRotation, size_t uIndexMode) noexcept
+float D3DX_BC7::Refine(const EncodeParams* pEP, size_t uShape, size_t uRotation, size_t uIndexMode, bool bOptimize) noexcept
 {
     assert(pEP);
     assert(uShape < BC7_MAX_SHAPES);
@@ -3408,6 +3727,15 @@ float D3DX_BC7::Refine(const EncodeParams* pEP, size_t uShape, size_t uRotation,
 
     AssignIndices(pEP, uShape, uIndexMode, newEndPts1, aOrgIdx, aOrgIdx2, aOrgErr);
 
+    if (!bOptimize)
+    {
+        float fOrgTotErr = 0;
+        for (size_t p = 0; p <= uPartitions; p++)
+            fOrgTotErr += aOrgErr[p];
+        EmitBlock(pEP, uShape, uRotation, uIndexMode, newEndPts1, aOrgIdx, aOrgIdx2);
+        return fOrgTotErr;
+    }
+
     OptimizeEndPoints(pEP, uShape, uIndexMode, aOrgErr, newEndPts1, aOptEndPts);
 
     LDREndPntPair newEndPts2[BC7_MAX_REGIONS];
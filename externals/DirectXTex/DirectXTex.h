@@ -704,6 +704,20 @@ namespace DirectX
         TEX_COMPRESS_BC7_QUICK = 0x100000,
         // Minimal modes (usually mode 6) for BC7 compression
 
+        TEX_COMPRESS_BC13_SIMD = 0x200000,
+        TEX_COMPRESS_BC13_SIMD_FAST = 0x600000,
+        TEX_COMPRESS_BC13_SIMD_SLOW = 0xA00000,
+        // Multi-block SIMD encoder for BC1 and BC3 (8 blocks at a time with AVX2, 4 with SSE); much faster than the
+        // default encoder at a slightly higher RMSE. FAST skips the endpoint refinement and SLOW refines more.
+        // Dithering and BC1 blocks with transparent pixels still use the default encoder
+
+        TEX_COMPRESS_BC7_ULTRAFAST = 0x4000000,
+        TEX_COMPRESS_BC7_FAST = 0x8000000,
+        TEX_COMPRESS_BC7_BASIC = 0xC000000,
+        // Tiered BC7 compression; the default (no tier) is the slow exhaustive search. Faster tiers rank the
+        // partitions with a PCA estimate, try fewer modes and optimize the endpoints of fewer candidates.
+        // A tier takes precedence over TEX_COMPRESS_BC7_QUICK
+
         TEX_COMPRESS_SRGB_IN = 0x1000000,
         TEX_COMPRESS_SRGB_OUT = 0x2000000,
         TEX_COMPRESS_SRGB = (TEX_COMPRESS_SRGB_IN | TEX_COMPRESS_SRGB_OUT),
@@ -712,6 +726,7 @@ namespace DirectX
 
         TEX_COMPRESS_PARALLEL = 0x10000000,
         // Compress is free to use multithreading to improve performance (by default it does not use multithreading)
+        // Uses std::thread with the default CompressParallelOptions, so it no longer requires OpenMP
     };
 
     HRESULT __cdecl Compress(
@@ -722,6 +737,25 @@ namespace DirectX
         _In_ DXGI_FORMAT format, _In_ TEX_COMPRESS_FLAGS compress, _In_ float threshold, _Out_ ScratchImage& cImages) noexcept;
         // Note that threshold is only used by BC1. TEX_THRESHOLD_DEFAULT is a typical value to use
 
+    struct CompressParallelOptions
+    {
+        size_t threadCount;
+        // Number of threads including the calling one; 0 uses std::thread::hardware_concurrency()
+
+        size_t blockRowsPerTask;
+        // Rows of 4x4 blocks handed to a thread at a time; 0 picks a size from the image width and thread count
+    };
+
+    HRESULT __cdecl Compress(
+        _In_ const Image& srcImage, _In_ DXGI_FORMAT format, _In_ TEX_COMPRESS_FLAGS compress, _In_ float threshold,
+        _In_ const CompressParallelOptions& options, _Out_ ScratchImage& cImage) noexcept;
+    HRESULT __cdecl Compress(
+        _In_reads_(nimages) const Image* srcImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
+        _In_ DXGI_FORMAT format, _In_ TEX_COMPRESS_FLAGS compress, _In_ float threshold,
+        _In_ const CompressParallelOptions& options, _Out_ ScratchImage& cImages) noexcept;
+        // Always multithreaded with std::thread (TEX_COMPRESS_PARALLEL is implied). All images of a mip chain or array
+        // are split into tasks together, so small mips do not leave threads idle. The output matches the serial encoder
+
 #if defined(__d3d11_h__) || defined(__d3d11_x_h__)
     HRESULT __cdecl Compress(
         _In_ ID3D11Device* pDevice, _In_ const Image& srcImage, _In_ DXGI_FORMAT format, _In_ TEX_COMPRESS_FLAGS compress,
@@ -11,10 +11,9 @@
 
 #include "DirectXTexP.h"
 
-#ifdef _OPENMP
-#include <omp.h>
-#pragma warning(disable : 4616 6993)
-#endif
+#include <atomic>
+#include <system_error>
+#include <thread>
 
 #include "BC.h"
 
@@ -31,7 +30,14 @@ namespace
         static_assert(static_cast<int>(TEX_COMPRESS_UNIFORM) == static_cast<int>(BC_FLAGS_UNIFORM), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
         static_assert(static_cast<int>(TEX_COMPRESS_BC7_USE_3SUBSETS) == static_cast<int>(BC_FLAGS_USE_3SUBSETS), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
         static_assert(static_cast<int>(TEX_COMPRESS_BC7_QUICK) == static_cast<int>(BC_FLAGS_FORCE_BC7_MODE6), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
-        return (compress & (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A | BC_FLAGS_UNIFORM | BC_FLAGS_USE_3SUBSETS | BC_FLAGS_FORCE_BC7_MODE6));
+        static_assert(static_cast<int>(TEX_COMPRESS_BC13_SIMD) == static_cast<int>(BC_FLAGS_SIMD), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        static_assert(static_cast<int>(TEX_COMPRESS_BC13_SIMD_FAST) == static_cast<int>(BC_FLAGS_SIMD | BC_FLAGS_SIMD_FAST), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        static_assert(static_cast<int>(TEX_COMPRESS_BC13_SIMD_SLOW) == static_cast<int>(BC_FLAGS_SIMD | BC_FLAGS_SIMD_SLOW), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        static_assert(static_cast<int>(TEX_COMPRESS_BC7_ULTRAFAST) == static_cast<int>(BC_FLAGS_BC7_ULTRAFAST), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        static_assert(static_cast<int>(TEX_COMPRESS_BC7_FAST) == static_cast<int>(BC_FLAGS_BC7_FAST), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        static_assert(static_cast<int>(TEX_COMPRESS_BC7_BASIC) == static_cast<int>(BC_FLAGS_BC7_BASIC), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        return (compress & (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A | BC_FLAGS_UNIFORM | BC_FLAGS_USE_3SUBSETS | BC_FLAGS_FORCE_BC7_MODE6
+            | BC_FLAGS_SIMD | BC_FLAGS_SIMD_FAST | BC_FLAGS_SIMD_SLOW | BC_FLAGS_BC7_TIER_MASK));
     }
 
     constexpr TEX_FILTER_FLAGS GetSRGBFlags(_In_ TEX_COMPRESS_FLAGS compress) noexcept
@@ -69,12 +75,14 @@ namespace
 
 
     //-------------------------------------------------------------------------------------
-    HRESULT CompressBC(
+    // Validates a source/destination pair and picks the encoder for the destination format
+    HRESULT GetEncoderSettings(
         const Image& image,
         const Image& result,
-        uint32_t bcflags,
-        TEX_FILTER_FLAGS srgb,
-        float threshold) noexcept
+        size_t& sbpp,
+        BC_ENCODE& pfEncode,
+        size_t& blocksize,
+        TEX_FILTER_FLAGS& cflags) noexcept
     {
         if (!image.pixels || !result.pixels)
             return E_POINTER;
@@ -82,8 +90,7 @@ namespace
         assert(image.width == result.width);
         assert(image.height == result.height);
 
-        const DXGI_FORMAT format = image.format;
-        size_t sbpp = BitsPerPixel(format);
+        sbpp = BitsPerPixel(image.format);
         if (!sbpp)
             return E_FAIL;
 
@@ -96,52 +103,105 @@ namespace
         // Round to bytes
         sbpp = (sbpp + 7) / 8;
 
-        uint8_t *pDest = result.pixels;
-
-        // Determine BC format encoder
-        BC_ENCODE pfEncode;
-        size_t blocksize;
-        TEX_FILTER_FLAGS cflags;
         if (!DetermineEncoderSettings(result.format, pfEncode, blocksize, cflags))
             return HRESULT_E_NOT_SUPPORTED;
 
-        XM_ALIGNED_DATA(16) XMVECTOR temp[16];
-        const uint8_t *pSrc = image.pixels;
-        const uint8_t *pEnd = image.pixels + image.slicePitch;
+        return S_OK;
+    }
+
+
+    //-------------------------------------------------------------------------------------
+    // Blocks handed to D3DXEncodeBC1Multi / D3DXEncodeBC3Multi at a time (a multiple of the SIMD width)
+    constexpr size_t c_MultiBlockBatch = 16;
+
+
+    //-------------------------------------------------------------------------------------
+    // Encodes the rows of 4x4 blocks [firstRow, firstRow + rowCount); each row of blocks is
+    // a contiguous span of the output, so ranges can be encoded independently
+    HRESULT CompressBlockRows(
+        const Image& image,
+        const Image& result,
+        size_t firstRow,
+        size_t rowCount,
+        size_t sbpp,
+        BC_ENCODE pfEncode,
+        size_t blocksize,
+        TEX_FILTER_FLAGS cflags,
+        uint32_t bcflags,
+        TEX_FILTER_FLAGS srgb,
+        float threshold) noexcept
+    {
+        const DXGI_FORMAT format = image.format;
+
+        // BC1 and BC3 can go to the multi-block encoder, which takes a run of blocks from one row at a time
+        bool multiBlock = false;
+        if (bcflags & BC_FLAGS_SIMD)
+        {
+            switch (result.format)
+            {
+            case DXGI_FORMAT_BC1_UNORM:
+            case DXGI_FORMAT_BC1_UNORM_SRGB:
+            case DXGI_FORMAT_BC3_UNORM:
+            case DXGI_FORMAT_BC3_UNORM_SRGB:
+                multiBlock = true;
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        auto encodeBatch = [&](uint8_t* dest, const XMVECTOR* blocks, size_t count) noexcept
+            {
+                if (blocksize == 8)
+                    D3DXEncodeBC1Multi(dest, blocks, count, threshold, bcflags);
+                else
+                    D3DXEncodeBC3Multi(dest, blocks, count, bcflags);
+            };
+
+        XM_ALIGNED_DATA(16) XMVECTOR temp[NUM_PIXELS_PER_BLOCK * c_MultiBlockBatch];
         const size_t rowPitch = image.rowPitch;
-        for (size_t h = 0; h < image.height; h += 4)
+        const uint8_t *pSrc = image.pixels + firstRow * 4 * rowPitch;
+        const uint8_t *pEnd = image.pixels + image.slicePitch;
+        uint8_t *pDest = result.pixels + firstRow * result.rowPitch;
+        const size_t hEnd = std::min<size_t>(image.height, (firstRow + rowCount) * 4);
+        for (size_t h = firstRow * 4; h < hEnd; h += 4)
         {
             const uint8_t *sptr = pSrc;
             uint8_t* dptr = pDest;
             const size_t ph = std::min<size_t>(4, image.height - h);
+            uint8_t* batchDest = pDest;
+            size_t batched = 0;
             size_t w = 0;
             for (size_t count = 0; (count < result.rowPitch) && (w < image.width); count += blocksize, w += 4)
             {
                 const size_t pw = std::min<size_t>(4, image.width - w);
                 assert(pw > 0 && ph > 0);
 
+                XMVECTOR* block = temp + batched * NUM_PIXELS_PER_BLOCK;
+
                 const ptrdiff_t bytesLeft = pEnd - sptr;
                 assert(bytesLeft > 0);
                 size_t bytesToRead = std::min<size_t>(rowPitch, static_cast<size_t>(bytesLeft));
-                if (!LoadScanline(&temp[0], pw, sptr, bytesToRead, format))
+                if (!LoadScanline(&block[0], pw, sptr, bytesToRead, format))
                     return E_FAIL;
 
                 if (ph > 1)
                 {
                     bytesToRead = std::min<size_t>(rowPitch, static_cast<size_t>(bytesLeft) - rowPitch);
-                    if (!LoadScanline(&temp[4], pw, sptr + rowPitch, bytesToRead, format))
+                    if (!LoadScanline(&block[4], pw, sptr + rowPitch, bytesToRead, format))
                         return E_FAIL;
 
                     if (ph > 2)
                     {
                         bytesToRead = std::min<size_t>(rowPitch, static_cast<size_t>(bytesLeft) - rowPitch * 2);
-                        if (!LoadScanline(&temp[8], pw, sptr + rowPitch * 2, bytesToRead, format))
+                        if (!LoadScanline(&block[8], pw, sptr + rowPitch * 2, bytesToRead, format))
                             return E_FAIL;
 
                         if (ph > 3)
                         {
                             bytesToRead = std::min<size_t>(rowPitch, static_cast<size_t>(bytesLeft) - rowPitch * 3);
-                            if (!LoadScanline(&temp[12], pw, sptr + rowPitch * 3, bytesToRead, format))
+                            if (!LoadScanline(&block[12], pw, sptr + rowPitch * 3, bytesToRead, format))
                                 return E_FAIL;
                         }
                     }
@@ -159,7 +219,7 @@ namespace
                             for (size_t s = pw; s < 4; ++s)
                             {
                             #pragma prefast(suppress: 26000, "PREFAST false positive")
-                                temp[(t << 2) | s] = temp[(t << 2) | uSrc[s]];
+                                block[(t << 2) | s] = block[(t << 2) | uSrc[s]];
                             }
                         }
                     }
@@ -171,23 +231,35 @@ namespace
                             for (size_t s = 0; s < 4; ++s)
                             {
                             #pragma prefast(suppress: 26000, "PREFAST false positive")
-                                temp[(t << 2) | s] = temp[(uSrc[t] << 2) | s];
+                                block[(t << 2) | s] = block[(uSrc[t] << 2) | s];
                             }
                         }
                     }
                 }
 
-                ConvertScanline(temp, 16, result.format, format, cflags | srgb);
+                ConvertScanline(block, 16, result.format, format, cflags | srgb);
 
-                if (pfEncode)
-                    pfEncode(dptr, temp, bcflags);
+                if (multiBlock)
+                {
+                    if (++batched == c_MultiBlockBatch)
+                    {
+                        encodeBatch(batchDest, temp, batched);
+                        batchDest = dptr + blocksize;
+                        batched = 0;
+                    }
+                }
+                else if (pfEncode)
+                    pfEncode(dptr, block, bcflags);
                 else
-                    D3DXEncodeBC1(dptr, temp, threshold, bcflags);
+                    D3DXEncodeBC1(dptr, block, threshold, bcflags);
 
                 sptr += sbpp * 4;
                 dptr += blocksize;
             }
 
+            if (batched > 0)
+                encodeBatch(batchDest, temp, batched);
+
             pSrc += rowPitch * 4;
             pDest += result.rowPitch;
         }
@@ -197,137 +269,162 @@ namespace
 
 
     //-------------------------------------------------------------------------------------
-#ifdef _OPENMP
-    HRESULT CompressBC_Parallel(
+    HRESULT CompressBC(
         const Image& image,
         const Image& result,
         uint32_t bcflags,
         TEX_FILTER_FLAGS srgb,
         float threshold) noexcept
     {
-        if (!image.pixels || !result.pixels)
-            return E_POINTER;
-
-        assert(image.width == result.width);
-        assert(image.height == result.height);
-
-        const DXGI_FORMAT format = image.format;
-        size_t sbpp = BitsPerPixel(format);
-        if (!sbpp)
-            return E_FAIL;
+        size_t sbpp;
+        BC_ENCODE pfEncode;
+        size_t blocksize;
+        TEX_FILTER_FLAGS cflags;
+        HRESULT hr = GetEncoderSettings(image, result, sbpp, pfEncode, blocksize, cflags);
+        if (FAILED(hr))
+            return hr;
 
-        if (sbpp < 8)
-        {
-            // We don't support compressing from monochrome (DXGI_FORMAT_R1_UNORM)
-            return HRESULT_E_NOT_SUPPORTED;
-        }
+        const size_t blockRows = std::max<size_t>(1, (image.height + 3) / 4);
+        return CompressBlockRows(image, result, 0, blockRows, sbpp, pfEncode, blocksize, cflags, bcflags, srgb, threshold);
+    }
 
-        // Round to bytes
-        sbpp = (sbpp + 7) / 8;
 
-        const uint8_t *pEnd = image.pixels + image.slicePitch;
+    //-------------------------------------------------------------------------------------
+    // Multithreaded version of CompressBC for a set of images (e.g. a whole mip chain)
+    //
+    // Every image is cut into tasks of whole rows of blocks, and all tasks go into one list that
+    // the threads (including the calling one) pull from with an atomic counter. A task writes one
+    // contiguous range of the output, so threads never share cache lines except at task edges,
+    // and small mips are mixed in with the large ones instead of each needing its own join
+    constexpr size_t c_TasksPerThread = 8;      // enough slack to balance uneven block costs
+    constexpr size_t c_MinBlocksPerTask = 64;   // keeps per-task overhead small for fast formats like BC1
+
+    struct CompressTask
+    {
+        size_t image;
+        size_t firstRow;
+        size_t rowCount;
+    };
 
-        // Determine BC format encoder
+    struct CompressImageSettings
+    {
+        size_t sbpp;
         BC_ENCODE pfEncode;
         size_t blocksize;
         TEX_FILTER_FLAGS cflags;
-        if (!DetermineEncoderSettings(result.format, pfEncode, blocksize, cflags))
-            return HRESULT_E_NOT_SUPPORTED;
-
-        // Refactored version of loop to support parallel independance
-        const size_t nBlocks = std::max<size_t>(1, (image.width + 3) / 4) * std::max<size_t>(1, (image.height + 3) / 4);
+    };
 
-        bool fail = false;
+    HRESULT CompressBC_Parallel(
+        const Image* images,
+        const Image* results,
+        size_t nimages,
+        uint32_t bcflags,
+        TEX_FILTER_FLAGS srgb,
+        float threshold,
+        const CompressParallelOptions& options) noexcept
+    {
+        if (!images || !results || !nimages)
+            return E_INVALIDARG;
 
-    #pragma omp parallel for
-        for (int nb = 0; nb < static_cast<int>(nBlocks); ++nb)
+        size_t threadCount = options.threadCount;
+        if (!threadCount)
         {
-            const int nbWidth = std::max<int>(1, int((image.width + 3) / 4));
+            threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
 
-            int y = nb / nbWidth;
-            const int x = (nb - (y*nbWidth)) * 4;
-            y *= 4;
+        std::unique_ptr<CompressImageSettings[]> settings(new (std::nothrow) CompressImageSettings[nimages]);
+        if (!settings)
+            return E_OUTOFMEMORY;
 
-            assert((x >= 0) && (x < int(image.width)));
-            assert((y >= 0) && (y < int(image.height)));
+        size_t totalBlocks = 0;
+        for (size_t index = 0; index < nimages; ++index)
+        {
+            CompressImageSettings& s = settings[index];
+            HRESULT hr = GetEncoderSettings(images[index], results[index], s.sbpp, s.pfEncode, s.blocksize, s.cflags);
+            if (FAILED(hr))
+                return hr;
 
-            const size_t rowPitch = image.rowPitch;
-            const uint8_t *pSrc = image.pixels + (size_t(y)*rowPitch) + (size_t(x)*sbpp);
+            totalBlocks += std::max<size_t>(1, (images[index].width + 3) / 4) * std::max<size_t>(1, (images[index].height + 3) / 4);
+        }
 
-            uint8_t *pDest = result.pixels + (size_t(nb)*blocksize);
+        // Size the tasks so that every thread gets several of them
+        const size_t blocksPerTask = std::max(c_MinBlocksPerTask, totalBlocks / (threadCount * c_TasksPerThread));
+        auto rowsPerTask = [&](size_t index) noexcept -> size_t
+            {
+                if (options.blockRowsPerTask)
+                    return options.blockRowsPerTask;
 
-            const size_t ph = std::min<size_t>(4, image.height - size_t(y));
-            const size_t pw = std::min<size_t>(4, image.width - size_t(x));
-            assert(pw > 0 && ph > 0);
+                const size_t blocksPerRow = std::max<size_t>(1, (images[index].width + 3) / 4);
+                return std::max<size_t>(1, blocksPerTask / blocksPerRow);
+            };
 
-            const ptrdiff_t bytesLeft = pEnd - pSrc;
-            assert(bytesLeft > 0);
-            size_t bytesToRead = std::min<size_t>(rowPitch, size_t(bytesLeft));
+        size_t taskCount = 0;
+        for (size_t index = 0; index < nimages; ++index)
+        {
+            const size_t blockRows = std::max<size_t>(1, (images[index].height + 3) / 4);
+            taskCount += (blockRows + rowsPerTask(index) - 1) / rowsPerTask(index);
+        }
 
-            XM_ALIGNED_DATA(16) XMVECTOR temp[16];
-            if (!LoadScanline(&temp[0], pw, pSrc, bytesToRead, format))
-                fail = true;
+        std::unique_ptr<CompressTask[]> tasks(new (std::nothrow) CompressTask[taskCount]);
+        if (!tasks)
+            return E_OUTOFMEMORY;
 
-            if (ph > 1)
+        size_t task = 0;
+        for (size_t index = 0; index < nimages; ++index)
+        {
+            const size_t blockRows = std::max<size_t>(1, (images[index].height + 3) / 4);
+            const size_t rows = rowsPerTask(index);
+            for (size_t row = 0; row < blockRows; row += rows)
             {
-                bytesToRead = std::min<size_t>(rowPitch, size_t(bytesLeft) - rowPitch);
-                if (!LoadScanline(&temp[4], pw, pSrc + rowPitch, bytesToRead, format))
-                    fail = true;
+                tasks[task++] = { index, row, std::min(rows, blockRows - row) };
+            }
+        }
+        assert(task == taskCount);
 
-                if (ph > 2)
+        std::atomic<size_t> nextTask(0);
+        std::atomic<bool> fail(false);
+        auto worker = [&]() noexcept
+            {
+                for (size_t t = nextTask++; t < taskCount && !fail; t = nextTask++)
                 {
-                    bytesToRead = std::min<size_t>(rowPitch, size_t(bytesLeft) - rowPitch * 2);
-                    if (!LoadScanline(&temp[8], pw, pSrc + rowPitch * 2, bytesToRead, format))
-                        fail = true;
-
-                    if (ph > 3)
+                    const CompressTask& current = tasks[t];
+                    const CompressImageSettings& s = settings[current.image];
+                    if (FAILED(CompressBlockRows(images[current.image], results[current.image], current.firstRow, current.rowCount,
+                        s.sbpp, s.pfEncode, s.blocksize, s.cflags, bcflags, srgb, threshold)))
                     {
-                        bytesToRead = std::min<size_t>(rowPitch, size_t(bytesLeft) - rowPitch * 3);
-                        if (!LoadScanline(&temp[12], pw, pSrc + rowPitch * 3, bytesToRead, format))
-                            fail = true;
+                        fail = true;
                     }
                 }
-            }
+            };
 
-            if (pw != 4 || ph != 4)
+        // The calling thread is one of the workers; if a thread cannot be created the rest still finish the work
+        const size_t extraThreads = std::min(threadCount, taskCount) - 1;
+        std::unique_ptr<std::thread[]> threads(new (std::nothrow) std::thread[extraThreads]);
+        size_t started = 0;
+        if (threads)
+        {
+            for (; started < extraThreads; ++started)
             {
-                // Replicate pixels for partial block
-                static const size_t uSrc[] = { 0, 0, 0, 1 };
-
-                if (pw < 4)
+                try
                 {
-                    for (size_t t = 0; t < ph && t < 4; ++t)
-                    {
-                        for (size_t s = pw; s < 4; ++s)
-                        {
-                            temp[(t << 2) | s] = temp[(t << 2) | uSrc[s]];
-                        }
-                    }
+                    threads[started] = std::thread(worker);
                 }
-
-                if (ph < 4)
+                catch (const std::system_error&)
                 {
-                    for (size_t t = ph; t < 4; ++t)
-                    {
-                        for (size_t s = 0; s < 4; ++s)
-                        {
-                            temp[(t << 2) | s] = temp[(uSrc[t] << 2) | s];
-                        }
-                    }
+                    break;
                 }
             }
+        }
 
-            ConvertScanline(temp, 16, result.format, format, cflags | srgb);
+        worker();
 
-            if (pfEncode)
-                pfEncode(pDest, temp, bcflags);
-            else
-                D3DXEncodeBC1(pDest, temp, threshold, bcflags);
+        for (size_t t = 0; t < started; ++t)
+        {
+            threads[t].join();
         }
 
         return (fail) ? E_FAIL : S_OK;
     }
-#endif // _OPENMP
 
 
     //-------------------------------------------------------------------------------------
@@ -585,134 +682,185 @@ bool DirectX::Internal::IsAlphaAllOpaqueBC(_In_ const Image& cImage) noexcept
 //-------------------------------------------------------------------------------------
 // Compression
 //-------------------------------------------------------------------------------------
-_Use_decl_annotations_
-HRESULT DirectX::Compress(
-    const Image& srcImage,
-    DXGI_FORMAT format,
-    TEX_COMPRESS_FLAGS compress,
-    float threshold,
-    ScratchImage& image) noexcept
+namespace
 {
-    if (IsCompressed(srcImage.format) || !IsCompressed(format))
-        return E_INVALIDARG;
-
-    if (IsTypeless(format)
-        || IsTypeless(srcImage.format) || IsPlanar(srcImage.format) || IsPalettized(srcImage.format))
-        return HRESULT_E_NOT_SUPPORTED;
-
-    // Create compressed image
-    HRESULT hr = image.Initialize2D(format, srcImage.width, srcImage.height, 1, 1);
-    if (FAILED(hr))
-        return hr;
-
-    const Image *img = image.GetImage(0, 0, 0);
-    if (!img)
-    {
-        image.Release();
-        return E_POINTER;
-    }
-
-    // Compress single image
-    if (compress & TEX_COMPRESS_PARALLEL)
+    // options is null for the serial encoder
+    HRESULT CompressSingle(
+        const Image& srcImage,
+        DXGI_FORMAT format,
+        TEX_COMPRESS_FLAGS compress,
+        float threshold,
+        const CompressParallelOptions* options,
+        ScratchImage& image) noexcept
     {
-    #ifndef _OPENMP
-        return E_NOTIMPL;
-    #else
-        hr = CompressBC_Parallel(srcImage, *img, GetBCFlags(compress), GetSRGBFlags(compress), threshold);
-    #endif // _OPENMP
-    }
-    else
-    {
-        hr = CompressBC(srcImage, *img, GetBCFlags(compress), GetSRGBFlags(compress), threshold);
-    }
-
-    if (FAILED(hr))
-        image.Release();
+        if (IsCompressed(srcImage.format) || !IsCompressed(format))
+            return E_INVALIDARG;
 
-    return hr;
-}
+        if (IsTypeless(format)
+            || IsTypeless(srcImage.format) || IsPlanar(srcImage.format) || IsPalettized(srcImage.format))
+            return HRESULT_E_NOT_SUPPORTED;
 
-_Use_decl_annotations_
-HRESULT DirectX::Compress(
-    const Image* srcImages,
-    size_t nimages,
-    const TexMetadata& metadata,
-    DXGI_FORMAT format,
-    TEX_COMPRESS_FLAGS compress,
-    float threshold,
-    ScratchImage& cImages) noexcept
-{
-    if (!srcImages || !nimages)
-        return E_INVALIDARG;
+        // Create compressed image
+        HRESULT hr = image.Initialize2D(format, srcImage.width, srcImage.height, 1, 1);
+        if (FAILED(hr))
+            return hr;
 
-    if (IsCompressed(metadata.format) || !IsCompressed(format))
-        return E_INVALIDARG;
+        const Image *img = image.GetImage(0, 0, 0);
+        if (!img)
+        {
+            image.Release();
+            return E_POINTER;
+        }
 
-    if (IsTypeless(format)
-        || IsTypeless(metadata.format) || IsPlanar(metadata.format) || IsPalettized(metadata.format))
-        return HRESULT_E_NOT_SUPPORTED;
+        // Compress single image
+        if (options)
+        {
+            hr = CompressBC_Parallel(&srcImage, img, 1, GetBCFlags(compress), GetSRGBFlags(compress), threshold, *options);
+        }
+        else
+        {
+            hr = CompressBC(srcImage, *img, GetBCFlags(compress), GetSRGBFlags(compress), threshold);
+        }
 
-    cImages.Release();
+        if (FAILED(hr))
+            image.Release();
 
-    TexMetadata mdata2 = metadata;
-    mdata2.format = format;
-    HRESULT hr = cImages.Initialize(mdata2);
-    if (FAILED(hr))
         return hr;
-
-    if (nimages != cImages.GetImageCount())
-    {
-        cImages.Release();
-        return E_FAIL;
     }
 
-    const Image* dest = cImages.GetImages();
-    if (!dest)
+    HRESULT CompressMultiple(
+        const Image* srcImages,
+        size_t nimages,
+        const TexMetadata& metadata,
+        DXGI_FORMAT format,
+        TEX_COMPRESS_FLAGS compress,
+        float threshold,
+        const CompressParallelOptions* options,
+        ScratchImage& cImages) noexcept
     {
-        cImages.Release();
-        return E_POINTER;
-    }
+        if (!srcImages || !nimages)
+            return E_INVALIDARG;
 
-    for (size_t index = 0; index < nimages; ++index)
-    {
-        assert(dest[index].format == format);
+        if (IsCompressed(metadata.format) || !IsCompressed(format))
+            return E_INVALIDARG;
 
-        const Image& src = srcImages[index];
+        if (IsTypeless(format)
+            || IsTypeless(metadata.format) || IsPlanar(metadata.format) || IsPalettized(metadata.format))
+            return HRESULT_E_NOT_SUPPORTED;
 
-        if (src.width != dest[index].width || src.height != dest[index].height)
+        cImages.Release();
+
+        TexMetadata mdata2 = metadata;
+        mdata2.format = format;
+        HRESULT hr = cImages.Initialize(mdata2);
+        if (FAILED(hr))
+            return hr;
+
+        if (nimages != cImages.GetImageCount())
         {
             cImages.Release();
             return E_FAIL;
         }
 
-        if ((compress & TEX_COMPRESS_PARALLEL))
+        const Image* dest = cImages.GetImages();
+        if (!dest)
+        {
+            cImages.Release();
+            return E_POINTER;
+        }
+
+        for (size_t index = 0; index < nimages; ++index)
         {
-        #ifndef _OPENMP
-            return E_NOTIMPL;
-        #else
-            if (compress & TEX_COMPRESS_PARALLEL)
+            assert(dest[index].format == format);
+
+            const Image& src = srcImages[index];
+
+            if (src.width != dest[index].width || src.height != dest[index].height)
             {
-                hr = CompressBC_Parallel(src, dest[index], GetBCFlags(compress), GetSRGBFlags(compress), threshold);
-                if (FAILED(hr))
-                {
-                    cImages.Release();
-                    return  hr;
-                }
+                cImages.Release();
+                return E_FAIL;
             }
-        #endif // _OPENMP
         }
-        else
+
+        if (options)
         {
-            hr = CompressBC(src, dest[index], GetBCFlags(compress), GetSRGBFlags(compress), threshold);
+            // All images share one task list
+            hr = CompressBC_Parallel(srcImages, dest, nimages, GetBCFlags(compress), GetSRGBFlags(compress), threshold, *options);
             if (FAILED(hr))
             {
                 cImages.Release();
                 return hr;
             }
         }
+        else
+        {
+            for (size_t index = 0; index < nimages; ++index)
+            {
+                hr = CompressBC(srcImages[index], dest[index], GetBCFlags(compress), GetSRGBFlags(compress), threshold);
+                if (FAILED(hr))
+                {
+                    cImages.Release();
+                    return hr;
+                }
+            }
+        }
+
+        return S_OK;
     }
 
-    return S_OK;
+    constexpr CompressParallelOptions c_DefaultParallelOptions = {};
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::Compress(
+    const Image& srcImage,
+    DXGI_FORMAT format,
+    TEX_COMPRESS_FLAGS compress,
+    float threshold,
+    ScratchImage& image) noexcept
+{
+    return CompressSingle(srcImage, format, compress, threshold,
+        (compress & TEX_COMPRESS_PARALLEL) ? &c_DefaultParallelOptions : nullptr, image);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::Compress(
+    const Image& srcImage,
+    DXGI_FORMAT format,
+    TEX_COMPRESS_FLAGS compress,
+    float threshold,
+    const CompressParallelOptions& options,
+    ScratchImage& image) noexcept
+{
+    return CompressSingle(srcImage, format, compress, threshold, &options, image);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::Compress(
+    const Image* srcImages,
+    size_t nimages,
+    const TexMetadata& metadata,
+    DXGI_FORMAT format,
+    TEX_COMPRESS_FLAGS compress,
+    float threshold,
+    ScratchImage& cImages) noexcept
+{
+    return CompressMultiple(srcImages, nimages, metadata, format, compress, threshold,
+        (compress & TEX_COMPRESS_PARALLEL) ? &c_DefaultParallelOptions : nullptr, cImages);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::Compress(
+    const Image* srcImages,
+    size_t nimages,
+    const TexMetadata& metadata,
+    DXGI_FORMAT format,
+    TEX_COMPRESS_FLAGS compress,
+    float threshold,
+    const CompressParallelOptions& options,
+    ScratchImage& cImages) noexcept
+{
+    return CompressMultiple(srcImages, nimages, metadata, format, compress, threshold, &options, cImages);
 }
 
 
@@ -1,13 +1,12 @@
 #include <Windows.h>
 #include <cstdint>		/*int32_tを使うためにincludeを追加*/
+#include <algorithm>
 #include <string>
 #include <format>
 #include <dxgi1_6.h>
 #include <cassert>
 #include <dxgidebug.h>
 #include <dxcapi.h>
-#include <fstream>
-#include <sstream>
 #include <wrl.h>
 
 #include "externals/DirectXTex/DirectXTex.h"
@@ -26,9 +25,17 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg
 #include "MatrixMath.h"
 #include "Transform.h"
 #include "VertexData.h"
+#include "ModelData.h"
+#include "ObjLoader.h"
+#include "MeshCache.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
+#include "VertexPacking.h"
 #include "Material.h"
 #include "TransformationMatrix.h"
 #include "DirectionalLight.h"
+#include "FrustumCulling.h"
+#include "TextureLoader.h"
 
 #pragma comment(lib,"dxgi.lib")
 #pragma comment(lib,"dxguid.lib")
@@ -59,19 +66,6 @@ struct D3DResourceLeakChecker
 	}
 };
 
-// MaterialDataの構造体
-struct MaterialData
-{
-	std::string textureFilePath;
-};
-
-// ModelData構造体
-struct ModelData
-{
-	std::vector<VertexData> vertices;
-	MaterialData material;
-};
-
 //ウィンドウプロシージャ
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
 {
@@ -188,7 +182,9 @@ IDxcBlob* CompilerShader(
 	//初期化で生成したものを3つ
 	IDxcUtils* dxcUtils,
 	IDxcCompiler3* dxcCompiler,
-	IDxcIncludeHandler* includeHandler)
+	IDxcIncludeHandler* includeHandler,
+	//定義するマクロ（無ければnullptr）
+	const wchar_t* define = nullptr)
 {
 	//これからシェーダーをコンパイルする旨をログに出す
 	Log(ConvertString(std::format(L"Begin CompileShader, path:{}, profile:{}\n", filePath, profile)));
@@ -204,7 +200,7 @@ IDxcBlob* CompilerShader(
 	shaderSourceBuffer.Encoding = DXC_CP_UTF8;	//UTF8の文字コードであることを通知
 
 	/// 2.Compileする
-	LPCWSTR arguments[] =
+	std::vector<LPCWSTR> arguments =
 	{
 		filePath.c_str(),			//コンパイル対象のhlslファイル名
 		L"-E",L"main",				//エントリーポイントの指定。基本的にmain以外にはしない
@@ -213,12 +209,17 @@ IDxcBlob* CompilerShader(
 		L"-Od",						//最適化を外しておく
 		L"-Zpr",					//メモリレイアウトは行優先
 	};
+	if (define)
+	{
+		arguments.push_back(L"-D");
+		arguments.push_back(define);
+	}
 	//実際にSahaderをコンパイルする
 	IDxcResult* shaderResult = nullptr;
 	hr = dxcCompiler->Compile(
 		&shaderSourceBuffer,		//読み込んだファイル
-		arguments,					//コンパイルオプション
-		_countof(arguments),		//コンパイルオプションの数
+		arguments.data(),			//コンパイルオプション
+		UINT32(arguments.size()),	//コンパイルオプションの数
 		includeHandler,				//includeが服待てた諸々
 		IID_PPV_ARGS(&shaderResult)	//コンパイル結果
 	);
@@ -252,24 +253,6 @@ IDxcBlob* CompilerShader(
 	return shaderBlob;
 }
 
-// Textureデータを読む
-DirectX::ScratchImage LoadTexture(const std::string& filePath)
-{
-	//テクスチャファイルを呼んでプログラムで扱えるようにする
-	DirectX::ScratchImage image{};
-	std::wstring filePathW = ConvertString(filePath);
-	HRESULT hr = DirectX::LoadFromWICFile(filePathW.c_str(), DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
-	assert(SUCCEEDED(hr));
-
-	//ミップマップの作成
-	DirectX::ScratchImage mipImages{};
-	hr = DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DirectX::TEX_FILTER_SRGB, 0, mipImages);
-	assert(SUCCEEDED(hr));
-
-	//ミップマップ付きのデータを返す
-	return mipImages;
-}
-
 // DirectX12のTextureResourceを作る
 Microsoft::WRL::ComPtr <ID3D12Resource> CreateTextureResource(Microsoft::WRL::ComPtr <ID3D12Device> device, const DirectX::TexMetadata& metadata)
 {
@@ -376,125 +359,6 @@ D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandle(ID3D12DescriptorHeap* descrip
 	return handleGPU;
 }
 
-MaterialData LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename)
-{
-	//1. 中で必要なる変数の宣言
-	MaterialData materialData;
-	std::string line;
-
-	//2. ファイルを開く
-	std::ifstream file(directoryPath + "/" + filename); //ファイルを開く
-	assert(file.is_open());// とりあえず開けなかったら止める
-
-	//3. 実際にファイルを読み、ModelDataを構築していく_頂点情報を読む
-	while (std::getline(file, line))
-	{
-		std::string identifire;
-		std::istringstream s(line);
-		s >> identifire;
-
-		// identifireに応じた処理
-		if (identifire == "map_Kd")
-		{
-			std::string textureFilename;
-			s >> textureFilename;
-			//連結してファイルパスにする
-			materialData.textureFilePath = directoryPath + "/" + textureFilename;
-		}
-	}
-
-	//4. MaterialDataを返す
-	return materialData;
-}
-
-// Objファイルを読み込む関数
-ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename)
-{
-	//1. 中で必要なる変数の宣言
-	ModelData modelData;				// 構築するModelData
-	std::vector<Vector4> positions;		// 位置
-	std::vector<Vector3> normals;		// 法線
-	std::vector<Vector2> texcoords;		// テクスチャ座標
-	std::string line;					// ファイルから読んだ1行を格納するもの
-
-	//2. ファイルを開く
-	std::ifstream file(directoryPath + "/" + filename);		// ファイルを開く
-	assert(file.is_open());									// 開けなかったら止める
-
-	//3. 実際にファイルを読み、ModelDataを構築していく_頂点情報を読む
-	while (std::getline(file, line))
-	{
-		std::string identifier;
-		std::stringstream s(line);
-		s >> identifier;			// 先頭の識別子を読む
-
-		// identifierに応じた処理
-		if (identifier == "v")
-		{
-			Vector4 position{};
-			s >> position.x >> position.y >> position.z;
-			position.w = 1.0f;
-			positions.push_back(position);
-		}
-		else if (identifier == "vt")
-		{
-			Vector2 texcoord{};
-			s >> texcoord.x >> texcoord.y;
-			texcoords.push_back(texcoord);
-		}
-		else if (identifier == "vn")
-		{
-			Vector3 normal{};
-			s >> normal.x >> normal.y >> normal.z;
-			normals.push_back(normal);
-		}
-		else if (identifier == "f")
-		{
-			VertexData triangle[3];
-			// 三角形限定。その他は未対応
-			for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex)
-			{
-				std::string vertexDefinition;
-				s >> vertexDefinition;
-				// 頂点の要素へのIndexは「位置/UV/法線」で格納されているので、分解してIndexを取得する
-				std::istringstream v(vertexDefinition);
-				uint32_t elementIndieces[3]{};
-				for (int32_t element = 0; element < 3; ++element)
-				{
-					std::string index;
-					std::getline(v, index, '/');	// 区切りでインデックスを読んでいく
-					elementIndieces[element] = std::stoi(index);
-				}
-				// 要素へのIndexから、実際の要素の値を取得して、頂点を構築する
-				Vector4 position = positions[static_cast<std::vector<Vector4, std::allocator<Vector4>>::size_type>(elementIndieces[0]) - 1];
-				Vector2 texcoord = texcoords[static_cast<std::vector<Vector2, std::allocator<Vector2>>::size_type>(elementIndieces[1]) - 1];
-				Vector3 normal = normals[static_cast<std::vector<Vector3, std::allocator<Vector3>>::size_type>(elementIndieces[2]) - 1];
-				position.x *= -1;
-				texcoord.y = 1.0f - texcoord.y;
-				normal.x *= -1;
-				/*VertexData vertex = { position,texcoord,normal };
-				modelData.vertices.push_back(vertex);*/
-				triangle[faceVertex] = { position,texcoord,normal };
-			}
-			modelData.vertices.push_back(triangle[2]);
-			modelData.vertices.push_back(triangle[1]);
-			modelData.vertices.push_back(triangle[0]);
-		}
-		else if (identifier == "mtllib")
-		{
-			// materialTemplateLibraryファイル名を取得
-			std::string materialFilename;
-			s >> materialFilename;
-			// 基本的にobjファイルと同一改装にmtlは存在させるので、ディレクトリ名とファイル名を渡す
-			modelData.material = LoadMaterialTemplateFile(directoryPath, materialFilename);
-		}
-	}
-
-	//4. ModelDataを返す
-	return modelData;
-}
-
-
 // Windowsアプリでのエントリーポイント(main関数)
 int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 {
@@ -799,7 +663,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	descriptorRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;	//Offsetを自動計算
 
 	//RootParameter作成。複数設定できるので配列。今回は1つだけなので長さ１の配列
-	D3D12_ROOT_PARAMETER rootParameters[4] = {};
+	D3D12_ROOT_PARAMETER rootParameters[5] = {};
 	rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;								//CBVを使う
 	rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;								//PixelShaderを使う
 	rootParameters[0].Descriptor.ShaderRegister = 0;												//レジスタ番号０とバインド
@@ -816,6 +680,10 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	rootParameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;								//CBVを使う
 	rootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;								//PixelShaderを使う
 	rootParameters[3].Descriptor.ShaderRegister = 1;												//レジスタ番号1を使う
+
+	rootParameters[4].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;								//CBVを使う
+	rootParameters[4].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;							//VertexShaderを使う（圧縮した頂点を元に戻す値）
+	rootParameters[4].Descriptor.ShaderRegister = 1;												//レジスタ番号1を使う
 	descriptionRootSignature.pParameters = rootParameters;											//ルートパラメータ配列へのポインタ
 	descriptionRootSignature.NumParameters = _countof(rootParameters);								//配列の長さ
 #pragma endregion
@@ -872,6 +740,18 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	D3D12_INPUT_LAYOUT_DESC inputLayoutDesc{};
 	inputLayoutDesc.pInputElementDescs = inputElementDescs;
 	inputLayoutDesc.NumElements = _countof(inputElementDescs);
+
+	//圧縮した頂点（PackedVertexData）のInputLayout。シェーダーには0～1 / float / -1～1に変換されて届く
+	D3D12_INPUT_ELEMENT_DESC packedInputElementDescs[3] = {};
+	packedInputElementDescs[0] = inputElementDescs[0];
+	packedInputElementDescs[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+	packedInputElementDescs[1] = inputElementDescs[1];
+	packedInputElementDescs[1].Format = DXGI_FORMAT_R16G16_FLOAT;
+	packedInputElementDescs[2] = inputElementDescs[2];
+	packedInputElementDescs[2].Format = DXGI_FORMAT_R16G16_SNORM;
+	D3D12_INPUT_LAYOUT_DESC packedInputLayoutDesc{};
+	packedInputLayoutDesc.pInputElementDescs = packedInputElementDescs;
+	packedInputLayoutDesc.NumElements = _countof(packedInputElementDescs);
 #pragma endregion
 
 
@@ -898,6 +778,10 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	Microsoft::WRL::ComPtr <IDxcBlob> vertexShaderBlob = CompilerShader(L"Object3D.VS.hlsl", L"vs_6_0", dxcUtils.Get(), dxcCompiler, includeHandler.Get());
 	assert(vertexShaderBlob != nullptr);
 
+	//圧縮した頂点を元に戻す版
+	Microsoft::WRL::ComPtr <IDxcBlob> packedVertexShaderBlob = CompilerShader(L"Object3D.VS.hlsl", L"vs_6_0", dxcUtils.Get(), dxcCompiler, includeHandler.Get(), L"PACKED_VERTEX");
+	assert(packedVertexShaderBlob != nullptr);
+
 	//Pixelをコンパイルする
 	Microsoft::WRL::ComPtr <IDxcBlob> pixelShaderBlob = CompilerShader(L"Object3D.PS.hlsl", L"ps_6_0", dxcUtils.Get(), dxcCompiler, includeHandler.Get());
 	assert(pixelShaderBlob != nullptr);
@@ -943,6 +827,14 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	Microsoft::WRL::ComPtr <ID3D12PipelineState> graphicsPipelineState = nullptr;
 	hr = device->CreateGraphicsPipelineState(&graphicsPipelineStateDesc, IID_PPV_ARGS(&graphicsPipelineState));
 	assert(SUCCEEDED(hr));
+
+	//圧縮した頂点用のPSO。InputLayoutとVertexShaderだけが違う
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC packedPipelineStateDesc = graphicsPipelineStateDesc;
+	packedPipelineStateDesc.InputLayout = packedInputLayoutDesc;
+	packedPipelineStateDesc.VS = { packedVertexShaderBlob->GetBufferPointer(),packedVertexShaderBlob->GetBufferSize() };
+	Microsoft::WRL::ComPtr <ID3D12PipelineState> packedPipelineState = nullptr;
+	hr = device->CreateGraphicsPipelineState(&packedPipelineStateDesc, IID_PPV_ARGS(&packedPipelineState));
+	assert(SUCCEEDED(hr));
 #pragma endregion
 
 
@@ -1068,47 +960,118 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
 #pragma region テクスチャファイルを読み込みテクスチャリソースを作成しそれに対してSRVを設定してこれらをデスクリプタヒープにバインド
 	// モデルの読み込み
-	ModelData modelData = LoadObjFile("resources", "axis.obj");
+	MeshOptimizationReport modelOptimization{};
+	ModelData modelData = LoadCachedObjFile("resources", "axis.obj", 0, &modelOptimization);
+	Log(std::format("Model vertex cache, ACMR:{:.3f} -> {:.3f}, ATVR:{:.3f} -> {:.3f}\n",
+		modelOptimization.before.acmr, modelOptimization.after.acmr, modelOptimization.before.atvr, modelOptimization.after.atvr));
+	//カリング用の境界球（ローカル空間）
+	const Sphere modelBoundingSphere = MakeBoundingSphere(modelData.vertices);
+
+	//変換済みテクスチャの一覧（無ければpngを読む）
+	TextureManifest textureManifest;
+	textureManifest.Load("resources/cooked/textures.manifest");
+
+	//読み終わるまで使うプレースホルダー（1x1の白）
+	DirectX::ScratchImage placeholderImage{};
+	hr = placeholderImage.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 1, 1, 1, 1);
+	assert(SUCCEEDED(hr));
+	std::fill_n(placeholderImage.GetPixels(), placeholderImage.GetPixelsSize(), uint8_t(0xFF));
+	Microsoft::WRL::ComPtr <ID3D12Resource> placeholderTextureResource = CreateTextureResource(device.Get(), placeholderImage.GetMetadata());
+	UploadTextureData(placeholderTextureResource.Get(), placeholderImage);
+
+	// プレースホルダーのSRVのデスクリプタヒープへのバインド（ImGuiの次）
+	D3D12_SHADER_RESOURCE_VIEW_DESC placeholderSrvDesc{};
+	placeholderSrvDesc.Format = placeholderImage.GetMetadata().format;
+	placeholderSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	placeholderSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;				//2Dテクスチャ
+	placeholderSrvDesc.Texture2D.MipLevels = 1;
+	device->CreateShaderResourceView(placeholderTextureResource.Get(), &placeholderSrvDesc, GetCPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, 1));
+	const D3D12_GPU_DESCRIPTOR_HANDLE placeholderSrvHandleGPU = GetGPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, 1);
+
+	//読み終わったテクスチャのリソースを作って転送し、descriptorIndexにSRVを作る。読めなければプレースホルダーのまま
+	auto uploadTexture = [&](const std::string& filePath, DirectX::ScratchImage& mipImages, bool succeeded, uint32_t descriptorIndex,
+		Microsoft::WRL::ComPtr <ID3D12Resource>& resource, D3D12_GPU_DESCRIPTOR_HANDLE& srvHandleGPU)
+		{
+			if (!succeeded)
+			{
+				Log(std::format("Texture could not be loaded, path:{}\n", filePath));
+				return;
+			}
+			const DirectX::TexMetadata& metadata = mipImages.GetMetadata();
+			resource = CreateTextureResource(device.Get(), metadata);
+			UploadTextureData(resource.Get(), mipImages);
+
+			D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+			srvDesc.Format = metadata.format;
+			srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;				//2Dテクスチャ
+			srvDesc.Texture2D.MipLevels = UINT(metadata.mipLevels);
+			assert(descriptorIndex < 128);		// ディスクリプタヒープに入りきらない
+			device->CreateShaderResourceView(resource.Get(), &srvDesc, GetCPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, descriptorIndex));
+			srvHandleGPU = GetGPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, descriptorIndex);
+		};
 
-	//Textureを読んで転送する
-	DirectX::ScratchImage mipImages = LoadTexture("resources/uvChecker.png");
-	const DirectX::TexMetadata& metadata = mipImages.GetMetadata();
-	Microsoft::WRL::ComPtr <ID3D12Resource> textureResource = CreateTextureResource(device.Get(), metadata);
-	UploadTextureData(textureResource.Get(), mipImages);
-
-	//2枚目のTextureを読んで転送する
-	DirectX::ScratchImage mipImages2 = LoadTexture(modelData.material.textureFilePath);
-	const DirectX::TexMetadata& metadata2 = mipImages2.GetMetadata();
-	Microsoft::WRL::ComPtr <ID3D12Resource> textureResource2 = CreateTextureResource(device.Get(), metadata2);
-	UploadTextureData(textureResource2.Get(), mipImages2);
-
-	// 1つ目のテクスチャのSRV設定
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
-	srvDesc.Format = metadata.format;
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;				//2Dテクスチャ
-	srvDesc.Texture2D.MipLevels = UINT(metadata.mipLevels);
-
-	// 2つ目のテクスチャのSRV設定
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc2{};
-	srvDesc2.Format = metadata2.format;
-	srvDesc2.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc2.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;				//2Dテクスチャ
-	srvDesc2.Texture2D.MipLevels = UINT(metadata2.mipLevels);
-
-	// 1つ目のテクスチャのSRVのデスクリプタヒープへのバインド
-	D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandleCPU = GetCPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, 1);
-	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU = GetGPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, 1);
-	textureSrvHandleCPU.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	textureSrvHandleGPU.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	device->CreateShaderResourceView(textureResource.Get(), &srvDesc, textureSrvHandleCPU);
-
-	// 2つ目のテクスチャのSRVのデスクリプタヒープへのバインド
-	D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandleCPU2 = GetCPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, 2);
-	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU2 = GetGPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, 2);
-	textureSrvHandleCPU2.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	textureSrvHandleGPU2.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	device->CreateShaderResourceView(textureResource2.Get(), &srvDesc2, textureSrvHandleCPU2);
+	//1つ目のTextureとモデルのマテリアルごとのTexture（map_Kdが無ければ1つ目を使う）
+	//読み込みはワーカースレッドで行い、読み終わったものから毎フレームの始めに転送する。それまではプレースホルダーで描く
+	Microsoft::WRL::ComPtr <ID3D12Resource> textureResource = nullptr;
+	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU = placeholderSrvHandleGPU;
+	std::vector<Microsoft::WRL::ComPtr <ID3D12Resource>> materialTextureResources(modelData.materials.size());
+	std::vector<D3D12_GPU_DESCRIPTOR_HANDLE> materialSrvHandlesGPU(modelData.materials.size(), placeholderSrvHandleGPU);
+	std::vector<bool> materialUsesFirstTexture(modelData.materials.size(), false);
+	std::vector<TextureLoader::RequestId> materialTextureRequests(modelData.materials.size());
+
+	TextureLoader textureLoader([&textureManifest](const std::string& filePath, DirectX::ScratchImage& image)
+		{
+			return LoadTextureFile(filePath, textureManifest, image);
+		});
+	//最初はモデルがマテリアルのテクスチャで見えているので、そちらを先に読む
+	const TextureLoader::RequestId textureRequest = textureLoader.Request("resources/uvChecker.png", TextureLoader::kPriorityDefault,
+		[&](const std::string& filePath, DirectX::ScratchImage& mipImages, bool succeeded)
+		{
+			uploadTexture(filePath, mipImages, succeeded, 2, textureResource, textureSrvHandleGPU);
+			for (size_t materialIndex = 0; materialIndex < modelData.materials.size(); ++materialIndex)
+			{
+				if (materialUsesFirstTexture[materialIndex])
+				{
+					materialSrvHandlesGPU[materialIndex] = textureSrvHandleGPU;
+				}
+			}
+		});
+	for (size_t materialIndex = 0; materialIndex < modelData.materials.size(); ++materialIndex)
+	{
+		const MaterialData& material = modelData.materials[materialIndex];
+		if (material.textureFilePath.empty())
+		{
+			materialUsesFirstTexture[materialIndex] = true;
+			continue;
+		}
+		// マテリアルのテクスチャのSRVは1つ目の次から順に並べる
+		const uint32_t descriptorIndex = 3 + uint32_t(materialIndex);
+		materialTextureRequests[materialIndex] = textureLoader.Request(material.textureFilePath, TextureLoader::kPriorityVisible,
+			[&, materialIndex, descriptorIndex](const std::string& filePath, DirectX::ScratchImage& mipImages, bool succeeded)
+			{
+				uploadTexture(filePath, mipImages, succeeded, descriptorIndex, materialTextureResources[materialIndex], materialSrvHandlesGPU[materialIndex]);
+			});
+	}
+
+	//マテリアルの順に並んだサブメッシュを、同じマテリアルが続く範囲ごとにまとめる（マテリアル1つにつき描画1回）
+	//LODごとに作る。modelDrawBatches[0]は元のメッシュ、[i]はmodelData.lods[i - 1]
+	std::vector<std::vector<SubmeshData>> modelDrawBatches(modelData.lods.size() + 1);
+	for (size_t lodIndex = 0; lodIndex < modelDrawBatches.size(); ++lodIndex)
+	{
+		std::vector<SubmeshData>& batches = modelDrawBatches[lodIndex];
+		for (const SubmeshData& submesh : lodIndex == 0 ? modelData.submeshes : modelData.lods[lodIndex - 1].submeshes)
+		{
+			if (!batches.empty() && batches.back().materialIndex == submesh.materialIndex &&
+				batches.back().indexStart + batches.back().indexCount == submesh.indexStart)
+			{
+				batches.back().indexCount += submesh.indexCount;
+				continue;
+			}
+			batches.push_back(submesh);
+		}
+	}
+	Log(std::format("Model LOD count:{}\n", modelData.lods.size()));
 #pragma endregion
 
 
@@ -1205,6 +1168,72 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 #pragma endregion
 
 
+#pragma region モデルの圧縮した頂点バッファと、それを元に戻す値の定数バッファを作成する
+	//座標は16bit、UVは半精度、法線は八面体の16bit x 2で1頂点16バイトになる
+	Microsoft::WRL::ComPtr <ID3D12Resource> packedVertexResource = CreateBufferResource(device.Get(), sizeof(PackedVertexData) * modelData.vertices.size());
+	D3D12_VERTEX_BUFFER_VIEW packedVertexBufferView{};
+	packedVertexBufferView.BufferLocation = packedVertexResource->GetGPUVirtualAddress();
+	packedVertexBufferView.SizeInBytes = UINT(sizeof(PackedVertexData) * modelData.vertices.size());
+	packedVertexBufferView.StrideInBytes = sizeof(PackedVertexData);
+
+	PackedVertexData* packedVertexData = nullptr;
+	packedVertexResource->Map(0, nullptr, reinterpret_cast<void**>(&packedVertexData));
+	const VertexQuantization modelQuantization = PackVertices(modelData.vertices, std::span<PackedVertexData>(packedVertexData, modelData.vertices.size()));
+	packedVertexResource->Unmap(0, nullptr);
+
+	Microsoft::WRL::ComPtr <ID3D12Resource> vertexQuantizationResource = CreateBufferResource(device.Get(), sizeof(VertexQuantization));
+	VertexQuantization* vertexQuantizationData = nullptr;
+	vertexQuantizationResource->Map(0, nullptr, reinterpret_cast<void**>(&vertexQuantizationData));
+	*vertexQuantizationData = modelQuantization;
+	Log(std::format("Model vertex buffer, {} bytes -> {} bytes (packed)\n", sizeof(VertexData) * modelData.vertices.size(), sizeof(PackedVertexData) * modelData.vertices.size()));
+#pragma endregion
+
+
+#pragma region モデルのインデックスバッファを作成および設定する
+	//頂点が65536個未満なら16bitのインデックスにして半分のサイズにする
+	const bool useIndex16 = modelData.vertices.size() <= 0xFFFF;
+	const size_t indexStride = useIndex16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	Microsoft::WRL::ComPtr <ID3D12Resource> indexResource = CreateBufferResource(device.Get(), indexStride * modelData.indices.size());
+	D3D12_INDEX_BUFFER_VIEW indexBufferView{};
+	//リソースの先頭のアドレスから使う
+	indexBufferView.BufferLocation = indexResource->GetGPUVirtualAddress();
+	//使用するリソースのサイズはインデックスの数分のサイズ
+	indexBufferView.SizeInBytes = UINT(indexStride * modelData.indices.size());
+	indexBufferView.Format = useIndex16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+	void* indexData = nullptr;
+	indexResource->Map(0, nullptr, &indexData);
+	if (useIndex16)
+	{
+		uint16_t* indexData16 = static_cast<uint16_t*>(indexData);
+		for (size_t i = 0; i < modelData.indices.size(); ++i)
+		{
+			indexData16[i] = uint16_t(modelData.indices[i]);
+		}
+	}
+	else
+	{
+		std::memcpy(indexData, modelData.indices.data(), sizeof(uint32_t) * modelData.indices.size());
+	}
+	indexResource->Unmap(0, nullptr);
+
+	//メッシュレットの判定で見える三角形だけを詰めるインデックスバッファ
+	//毎フレーム書き換えるのでMapしたままにする（GPUの描画の終わりを待ってから次のフレームを書くので1つで足りる）
+	Microsoft::WRL::ComPtr <ID3D12Resource> visibleIndexResource = CreateBufferResource(device.Get(), indexStride * modelData.indices.size());
+	D3D12_INDEX_BUFFER_VIEW visibleIndexBufferView{};
+	visibleIndexBufferView.BufferLocation = visibleIndexResource->GetGPUVirtualAddress();
+	visibleIndexBufferView.SizeInBytes = UINT(indexStride * modelData.indices.size());
+	visibleIndexBufferView.Format = indexBufferView.Format;
+	void* visibleIndexData = nullptr;
+	visibleIndexResource->Map(0, nullptr, &visibleIndexData);
+	std::vector<uint32_t> visibleIndices;
+	visibleIndices.reserve(modelData.indices.size());
+	std::vector<SubmeshData> visibleDrawBatches;
+	size_t visibleMeshletCount = 0;
+	Log(std::format("Model meshlet count:{}\n", modelData.meshlets.size()));
+#pragma endregion
+
+
 #pragma region 描画パイプラインで使用するビューポートとシザー矩形を設定
 	//ビューポート
 	D3D12_VIEWPORT viewport{};
@@ -1249,6 +1278,16 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	Transform uvTransformSprite{ {1.0f,1.0f,1.0f}, {0.0f,0.0f,0.0f}, {0.0f,0.0f,0.0f}, };
 
 	bool useMonsterBall = true;
+	//モデルを圧縮した頂点で描画する
+	bool usePackedVertex = true;
+	//LODを切り替える画面上のずれ（ピクセル）
+	float lodThresholdPixels = 1.0f;
+	uint32_t modelLod = 0;
+	//メッシュレットごとに視錐台と裏向きを判定して、見える三角形だけを描画する
+	bool useMeshletCulling = true;
+
+	//Sprite用のView*Projectionは定数なのでコンパイル時に計算しておく
+	constexpr Matrix4x4 kViewProjectionMatrixSprite = Multiply(MakeIdentity(), MakeOrthographicMatrix(0.0f, 0.0f, float(kClientWidth), float(kClientHeight), 0.0f, 100.0f));
 
 	//ウィンドウのｘボタンが押されるまでループ
 	while (msg.message != WM_QUIT)
@@ -1261,6 +1300,18 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 		}
 		else
 		{
+			//読み終わったテクスチャを転送する（前のフレームのGPUの処理は終わっている）
+			//まだ読んでいないものは、いま画面で使っている方を先に読む
+			textureLoader.SetPriority(textureRequest, useMonsterBall ? TextureLoader::kPriorityDefault : TextureLoader::kPriorityVisible);
+			for (size_t materialIndex = 0; materialIndex < modelData.materials.size(); ++materialIndex)
+			{
+				if (!materialUsesFirstTexture[materialIndex])
+				{
+					textureLoader.SetPriority(materialTextureRequests[materialIndex], useMonsterBall ? TextureLoader::kPriorityVisible : TextureLoader::kPriorityDefault);
+				}
+			}
+			textureLoader.DispatchCompleted();
+
 			//ImGuiを使う
 			ImGui_ImplDX12_NewFrame();
 			ImGui_ImplWin32_NewFrame();
@@ -1282,6 +1333,12 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 				ImGui::DragFloat3("rotate", &transform.rotate.x, 0.01f);
 				ImGui::DragFloat3("translate", &transform.translate.x, 0.01f);
 				ImGui::Checkbox("useMonsterBall", &useMonsterBall);
+				ImGui::Checkbox("usePackedVertex", &usePackedVertex);
+				ImGui::SliderFloat("lodThresholdPixels", &lodThresholdPixels, 0.25f, 16.0f);
+				ImGui::Text("LOD %u / %zu", modelLod, modelData.lods.size());
+				ImGui::Checkbox("useMeshletCulling", &useMeshletCulling);
+				ImGui::Text("visible meshlets %zu, triangles %zu", visibleMeshletCount, visibleIndices.size() / 3);
+				ImGui::Text("loading textures %zu (%u threads)", textureLoader.GetPendingCount(), textureLoader.GetThreadCount());
 				ImGui::DragFloat3("directionalLight", &directionalLightData->direction.x, 0.01f);
 				ImGui::DragFloat2("UVTranslete", &uvTransformSprite.translate.x, 0.01f, -10.0f, 10.0f);
 				ImGui::DragFloat2("UVScale", &uvTransformSprite.scale.x, 0.01f, -10.0f, 10.0f);
@@ -1297,19 +1354,66 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
 			/*-----Transform情報を作る-----*/
 			Matrix4x4 worldMatrix = MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
-			Matrix4x4 camraMatrix = MakeAffineMatrix(cameraTransform.scale, cameraTransform.rotate, cameraTransform.translate);
-			Matrix4x4 viewMatrix = Inverse(camraMatrix);
+			Matrix4x4 viewMatrix = MakeViewMatrix(cameraTransform);
 			Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(0.45f, float(kClientWidth) / float(kClientHeight), 0.1f, 100.0f);
-			Matrix4x4 worldViewProjectionMatrix = Multiply(worldMatrix, Multiply(viewMatrix, projectionMatrix));
+			Matrix4x4 viewProjectionMatrix = Multiply(viewMatrix, projectionMatrix);
+			Matrix4x4 worldViewProjectionMatrix = Multiply(worldMatrix, viewProjectionMatrix);
+
+			//画面外のモデルは描画しない
+			const Frustum frustum = MakeFrustum(viewProjectionMatrix);
+			const Sphere modelWorldSphere = TransformSphere(modelBoundingSphere, worldMatrix);
+			const bool isModelVisible = IsVisible(frustum, modelWorldSphere);
+
+			//カメラから境界球の表面までの距離でLODを選ぶ（球の中に入ったらニアクリップの距離とみなす）
+			const Vector3 toModel{ modelWorldSphere.center.x - cameraTransform.translate.x, modelWorldSphere.center.y - cameraTransform.translate.y, modelWorldSphere.center.z - cameraTransform.translate.z };
+			const float modelDistance = std::fmax(std::sqrt(toModel.x * toModel.x + toModel.y * toModel.y + toModel.z * toModel.z) - modelWorldSphere.radius, 0.1f);
+			const float modelScale = std::fmax(std::fabs(transform.scale.x), std::fmax(std::fabs(transform.scale.y), std::fabs(transform.scale.z)));
+			modelLod = SelectLod(modelData.lods, modelScale, modelDistance, 0.45f, float(kClientHeight), lodThresholdPixels);
+
+			//選んだLODのサブメッシュごとに見えるメッシュレットのインデックスを詰め、同じマテリアルが続く範囲を1回の描画にまとめる
+			const bool drawVisibleMeshlets = useMeshletCulling && !modelData.meshlets.empty();
+			visibleIndices.clear();
+			visibleDrawBatches.clear();
+			visibleMeshletCount = 0;
+			if (drawVisibleMeshlets && isModelVisible)
+			{
+				const MeshletCullingView cullingView = MakeMeshletCullingView(frustum, worldMatrix, cameraTransform.translate);
+				for (const SubmeshData& submesh : modelLod == 0 ? modelData.submeshes : modelData.lods[modelLod - 1].submeshes)
+				{
+					const uint32_t indexStart = uint32_t(visibleIndices.size());
+					visibleMeshletCount += CullMeshlets(std::span<const MeshletData>(modelData.meshlets).subspan(submesh.meshletStart, submesh.meshletCount), modelData.indices, cullingView, visibleIndices);
+					const uint32_t indexCount = uint32_t(visibleIndices.size()) - indexStart;
+					if (indexCount == 0)
+					{
+						continue;
+					}
+					if (!visibleDrawBatches.empty() && visibleDrawBatches.back().materialIndex == submesh.materialIndex)
+					{
+						visibleDrawBatches.back().indexCount += indexCount;
+						continue;
+					}
+					visibleDrawBatches.push_back({ {}, indexStart, indexCount, submesh.materialIndex });
+				}
+				if (useIndex16)
+				{
+					uint16_t* visibleIndexData16 = static_cast<uint16_t*>(visibleIndexData);
+					for (size_t i = 0; i < visibleIndices.size(); ++i)
+					{
+						visibleIndexData16[i] = uint16_t(visibleIndices[i]);
+					}
+				}
+				else
+				{
+					std::memcpy(visibleIndexData, visibleIndices.data(), sizeof(uint32_t) * visibleIndices.size());
+				}
+			}
 
 			wvpData->WVP = worldViewProjectionMatrix;
 			wvpData->World = worldMatrix;
 
 			//Sprite用のWorldViewProjectionMatrixを作る
 			Matrix4x4 worldMatrixSprite = MakeAffineMatrix(transformSprite.scale, transformSprite.rotate, transformSprite.translate);
-			Matrix4x4 viewMatrixSprite = MakeIdentity();
-			Matrix4x4 projectionMatrixSprite = MakeOrthographicMatrix(0.0f, 0.0f, float(kClientWidth), float(kClientHeight), 0.0f, 100.0f);
-			Matrix4x4 worldViewProjectionMatrixSprite = Multiply(worldMatrixSprite, Multiply(viewMatrixSprite, projectionMatrixSprite));
+			Matrix4x4 worldViewProjectionMatrixSprite = Multiply(worldMatrixSprite, kViewProjectionMatrixSprite);
 
 			transfomationMatrixDataSprite->WVP = worldViewProjectionMatrixSprite;
 			transfomationMatrixDataSprite->World = worldMatrix;
@@ -1366,19 +1470,37 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
 			//頂点バッファの設定とプリミティブトポロジの設定
 			commandList->IASetVertexBuffers(0, 1, &vertexBufferView);					//VBVを設定
+			commandList->IASetIndexBuffer(&indexBufferView);							//IBVを設定
 			commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);	//プリミティブトポロジを設定
 
 			//定数バッファビュー (CBV) とディスクリプタテーブルの設定
 			//マテリアルCBufferの場所を設定
 			commandList->SetGraphicsRootConstantBufferView(0, materialResource->GetGPUVirtualAddress());					// マテリアルCBVを設定
 			commandList->SetGraphicsRootConstantBufferView(1, wvpResource->GetGPUVirtualAddress());							// WVP用CBVを設定
-			commandList->SetGraphicsRootDescriptorTable(2, useMonsterBall ? textureSrvHandleGPU2 : textureSrvHandleGPU);	// SRVのディスクリプタテーブルを設定
 			commandList->SetGraphicsRootConstantBufferView(3, directionalLightResource->GetGPUVirtualAddress());			// ライトのCBVを設定
-			commandList->DrawInstanced(UINT(modelData.vertices.size()), 1, 0, 0);											// 描画コール。三角形を描画(頂点数を変えれば球体が出るようになる「TotalVertexCount」)
+			if (isModelVisible)
+			{
+				if (usePackedVertex)
+				{
+					commandList->SetPipelineState(packedPipelineState.Get());												// 圧縮した頂点用のPSOを設定
+					commandList->IASetVertexBuffers(0, 1, &packedVertexBufferView);										// 圧縮した頂点のVBVを設定
+					commandList->SetGraphicsRootConstantBufferView(4, vertexQuantizationResource->GetGPUVirtualAddress());	// 座標を元に戻す値のCBVを設定
+				}
+				if (drawVisibleMeshlets)
+				{
+					commandList->IASetIndexBuffer(&visibleIndexBufferView);												// 見える三角形だけを詰めたIBVを設定
+				}
+				for (const SubmeshData& batch : drawVisibleMeshlets ? visibleDrawBatches : modelDrawBatches[modelLod])
+				{
+					commandList->SetGraphicsRootDescriptorTable(2, useMonsterBall ? materialSrvHandlesGPU[batch.materialIndex] : textureSrvHandleGPU);	// SRVのディスクリプタテーブルを設定
+					commandList->DrawIndexedInstanced(batch.indexCount, 1, batch.indexStart, 0, 0);						// 描画コール。マテリアルごとのインデックスの範囲を描画
+				}
+			}
 
 			commandList->SetGraphicsRootDescriptorTable(2, textureSrvHandleGPU);
 
 			//スプライトの描画設定
+			commandList->SetPipelineState(graphicsPipelineState.Get());														// 通常の頂点用のPSOに戻す
 			commandList->IASetVertexBuffers(0, 1, &vertexBufferViewSprite);													// スプライトの頂点バッファビューを設定
 			commandList->IASetIndexBuffer(&indexBufferViewSprite);															// IBVの設定
 			commandList->SetGraphicsRootConstantBufferView(0, materialResourceSprite->GetGPUVirtualAddress());				// スプライトのマテリアルCBVを設定
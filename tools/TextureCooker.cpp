@@ -0,0 +1,404 @@
+///==========================================================
+/// テクスチャの事前変換ツール
+/// png を読んでミップマップを作り、BC7（既定）か BC1 に圧縮して dds に書き出す
+/// 出力フォルダに textures.manifest（TextureManifest.h）を書き、実行時の LoadTexture はこれを見て dds を直接読む
+/// 元の画像のハッシュ値と形式が一覧と同じで dds があれば変換しない
+/// 大きさが4の倍数でない画像はブロック圧縮できないので、RGBA8 のままミップマップだけ付ける
+/// 1枚でも失敗したら終了コード1を返す
+///
+/// ビルド例（Windowsは WIC、それ以外は libpng で png を読む。画面は使わない）
+///   （DirectXTex は Windows 以外では DirectX-Headers と DirectXMath を使う。<DXH> と <DXM> はそれぞれを置いた場所）
+///   g++ -std=c++20 -O2 -pthread -I.. -I../externals/DirectXTex -I<DXH>/include -I<DXH>/include/wsl/stubs -I<DXM>/Inc TextureCooker.cpp ../TextureManifest.cpp ../MappedFile.cpp ../externals/DirectXTex/{BC,BC4BC5,BC6HBC7,DirectXTexCompress,DirectXTexConvert,DirectXTexDDS,DirectXTexImage,DirectXTexMipmaps,DirectXTexMisc,DirectXTexResize,DirectXTexUtil}.cpp -lpng -o TextureCooker
+///   cl /std:c++20 /O2 /EHsc /I.. /I..\externals\DirectXTex TextureCooker.cpp ..\TextureManifest.cpp ..\MappedFile.cpp ..\externals\DirectXTex\BC.cpp ..\externals\DirectXTex\BC4BC5.cpp ..\externals\DirectXTex\BC6HBC7.cpp ..\externals\DirectXTex\DirectXTexCompress.cpp ..\externals\DirectXTex\DirectXTexConvert.cpp ..\externals\DirectXTex\DirectXTexDDS.cpp ..\externals\DirectXTex\DirectXTexImage.cpp ..\externals\DirectXTex\DirectXTexMipmaps.cpp ..\externals\DirectXTex\DirectXTexMisc.cpp ..\externals\DirectXTex\DirectXTexResize.cpp ..\externals\DirectXTex\DirectXTexUtil.cpp ..\externals\DirectXTex\DirectXTexWIC.cpp ole32.lib windowscodecs.lib
+///   （DirectXTex の *.cpp を全て渡すと、BCDirectCompute.cpp がシェーダーのコンパイル済みファイル（Shaders/Compiled）を要るので、使うものだけを渡す）
+///   （Linux では、DirectXMath の代わりの最小限のヘッダーと、DirectXTexConvert.cpp の代わり（RGBA8 と float の行の読み書きと sRGB の変換だけ）でビルドし、
+///    resources の png を既定 / --quick / -f bc1 で変換して、dds を展開したものが元の画像に近いこと（BC7 で RMSE 2 以下、BC1 で 5 以下）と、2回目は変換しないことを確かめた）
+///   （本物の DirectX-Headers / DirectXMath と MSVC、Visual Studio の本体のビルドではまだ確かめていない）
+///
+/// 使い方（作業フォルダはプロジェクトのフォルダ。実行時と同じ相対パスで一覧に書く）
+///   TextureCooker [-o 出力フォルダ] [-f bc7|bc1] [-j スレッド数] [--quick] [--force] [画像かフォルダ...]
+///   出力フォルダの既定は resources/cooked、画像を指定しなければ resources の下の png を全て変換する
+///==========================================================
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <png.h>
+#endif
+
+#include "DirectXTex.h"
+#include "TextureManifest.h"
+
+namespace
+{
+	//変換の設定
+	struct CookOptions
+	{
+		std::string outputDirectory = "resources/cooked";
+		DXGI_FORMAT format = DXGI_FORMAT_BC7_UNORM_SRGB;
+		uint32_t threadCount = 0;
+		uint32_t compressThreadCount = 1;	// 1枚の圧縮に使うスレッド数（枚数で分けた残り）
+		bool quick = false;			// BC7は段階を fast に、BC1は端点の調整を省いて速く圧縮する（画質は少し落ちる）
+		bool force = false;			// 一覧と同じでも変換し直す
+		std::vector<std::string> inputs;
+	};
+
+	//1枚分の結果
+	struct CookResult
+	{
+		bool cooked = false;		// 変換した（falseなら一覧のものをそのまま使う）
+		bool succeeded = false;
+		TextureManifestEntry entry{};
+		size_t width = 0;
+		size_t height = 0;
+		size_t mipLevels = 0;
+		size_t uncompressedSize = 0;	// RGBA8 でミップマップを付けたときの大きさ
+		size_t cookedSize = 0;
+		double milliseconds = 0.0;
+	};
+
+	const char* GetFormatName(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC7_UNORM_SRGB:	return "BC7";
+		case DXGI_FORMAT_BC1_UNORM_SRGB:	return "BC1";
+		default:							return "RGBA8";
+		}
+	}
+
+	//png を sRGB の RGBA8 として読む（実行時の LoadFromWICFile(WIC_FLAGS_FORCE_SRGB) と同じ扱い）
+	bool LoadPng(const std::string& path, DirectX::ScratchImage& image)
+	{
+#if defined(_WIN32)
+		const std::wstring pathW = std::filesystem::path(path).wstring();
+		return SUCCEEDED(DirectX::LoadFromWICFile(pathW.c_str(), DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image));
+#else
+		png_image png{};
+		png.version = PNG_IMAGE_VERSION;
+		if (!png_image_begin_read_from_file(&png, path.c_str()))
+		{
+			return false;
+		}
+		png.format = PNG_FORMAT_RGBA;
+		if (FAILED(image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, png.width, png.height, 1, 1)))
+		{
+			png_image_free(&png);
+			return false;
+		}
+		const DirectX::Image* pixels = image.GetImage(0, 0, 0);
+		if (!png_image_finish_read(&png, nullptr, pixels->pixels, static_cast<png_int_32>(pixels->rowPitch), nullptr))
+		{
+			png_image_free(&png);
+			image.Release();
+			return false;
+		}
+		return true;
+#endif
+	}
+
+	//出力フォルダの中の dds のパス。出力フォルダの親からの相対パスを使う（resources/a/b.png → resources/cooked/a/b.dds）
+	//名前が同じでもフォルダが違えば別の dds になる
+	std::string GetCookedPath(const CookOptions& options, const std::string& sourcePath)
+	{
+		const std::filesystem::path outputDirectory = std::filesystem::path(NormalizeTexturePath(options.outputDirectory));
+		std::filesystem::path relative = std::filesystem::path(sourcePath).lexically_relative(outputDirectory.parent_path());
+		if (relative.empty() || relative.generic_string().starts_with(".."))
+		{
+			relative = std::filesystem::path(sourcePath).relative_path();
+		}
+		if (relative.generic_string().starts_with(".."))
+		{
+			relative = relative.filename();
+		}
+		relative.replace_extension(".dds");
+		return NormalizeTexturePath((outputDirectory / relative).generic_string());
+	}
+
+	//一覧と同じで dds もあれば変換しなくてよい
+	bool IsUpToDate(const CookOptions& options, const TextureManifestEntry* entry, uint64_t sourceHash)
+	{
+		if (options.force || !entry || entry->sourceHash != sourceHash)
+		{
+			return false;
+		}
+		//4の倍数でない画像は指定した形式によらず RGBA8 になる
+		if (entry->format != GetFormatName(options.format) && entry->format != GetFormatName(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB))
+		{
+			return false;
+		}
+		std::error_code error;
+		return std::filesystem::is_regular_file(entry->cookedPath, error);
+	}
+
+	//1枚を変換する
+	CookResult CookTexture(const CookOptions& options, const TextureManifest& manifest, const std::string& sourcePath)
+	{
+		CookResult result{};
+		result.entry.sourcePath = sourcePath;
+		result.entry.sourceHash = HashTextureFile(sourcePath);
+		if (IsUpToDate(options, manifest.Find(sourcePath), result.entry.sourceHash))
+		{
+			result.entry = *manifest.Find(sourcePath);
+			result.succeeded = true;
+			return result;
+		}
+		result.cooked = true;
+		auto start = std::chrono::steady_clock::now();
+
+		DirectX::ScratchImage image{};
+		if (!LoadPng(sourcePath, image))
+		{
+			return result;
+		}
+		const DirectX::TexMetadata& metadata = image.GetMetadata();
+		result.width = metadata.width;
+		result.height = metadata.height;
+
+		//ミップマップの作成（1x1は作るものが無い）
+		DirectX::ScratchImage mipImages{};
+		if (metadata.width == 1 && metadata.height == 1)
+		{
+			mipImages = std::move(image);
+		}
+		else if (FAILED(DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), metadata, DirectX::TEX_FILTER_SRGB, 0, mipImages)))
+		{
+			return result;
+		}
+		result.mipLevels = mipImages.GetMetadata().mipLevels;
+		result.uncompressedSize = mipImages.GetPixelsSize();
+
+		//ブロック圧縮。D3D12は一番大きい段の幅と高さが4の倍数でないとBC形式のテクスチャを作れない
+		DirectX::ScratchImage compressed{};
+		const DirectX::ScratchImage* output = &mipImages;
+		if (metadata.width % 4 == 0 && metadata.height % 4 == 0)
+		{
+			//BC1は複数ブロックをまとめて圧縮する方を使う（BC7には効かない）
+			DirectX::TEX_COMPRESS_FLAGS flags = DirectX::TEX_COMPRESS_BC13_SIMD;
+			if (options.quick)
+			{
+				flags |= DirectX::TEX_COMPRESS_BC7_FAST | DirectX::TEX_COMPRESS_BC13_SIMD_FAST;
+			}
+			if (FAILED(DirectX::Compress(mipImages.GetImages(), mipImages.GetImageCount(), mipImages.GetMetadata(), options.format, flags, DirectX::TEX_THRESHOLD_DEFAULT, { options.compressThreadCount, 0 }, compressed)))
+			{
+				return result;
+			}
+			output = &compressed;
+		}
+		result.entry.format = GetFormatName(output->GetMetadata().format);
+		result.cookedSize = output->GetPixelsSize();
+
+		//一時ファイルに書いてから置き換える
+		result.entry.cookedPath = GetCookedPath(options, sourcePath);
+		const std::filesystem::path cookedPath(result.entry.cookedPath);
+		std::filesystem::path temporaryPath = cookedPath;
+		temporaryPath += ".tmp";
+		std::error_code error;
+		std::filesystem::create_directories(cookedPath.parent_path(), error);
+		if (FAILED(DirectX::SaveToDDSFile(output->GetImages(), output->GetImageCount(), output->GetMetadata(), DirectX::DDS_FLAGS_NONE, temporaryPath.wstring().c_str())))
+		{
+			std::filesystem::remove(temporaryPath, error);
+			return result;
+		}
+		std::filesystem::rename(temporaryPath, cookedPath, error);
+		if (error)
+		{
+			std::filesystem::remove(temporaryPath, error);
+			return result;
+		}
+
+		result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		result.succeeded = true;
+		return result;
+	}
+
+	//指定された画像とフォルダの下の png を集める（出力フォルダの中は見ない）
+	std::vector<std::string> CollectSources(const CookOptions& options)
+	{
+		const std::string outputDirectory = NormalizeTexturePath(options.outputDirectory);
+		std::vector<std::string> sources;
+		auto addFile = [&](const std::filesystem::path& path)
+			{
+				std::string extension = path.extension().string();
+				std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+				const std::string normalized = NormalizeTexturePath(path.generic_string());
+				if (extension == ".png" && !normalized.starts_with(outputDirectory + "/"))
+				{
+					sources.push_back(normalized);
+				}
+			};
+		for (const std::string& input : options.inputs)
+		{
+			std::error_code error;
+			if (std::filesystem::is_directory(input, error))
+			{
+				for (const auto& item : std::filesystem::recursive_directory_iterator(input, error))
+				{
+					if (item.is_regular_file())
+					{
+						addFile(item.path());
+					}
+				}
+			}
+			else
+			{
+				addFile(input);
+			}
+		}
+		std::sort(sources.begin(), sources.end());
+		sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+		return sources;
+	}
+
+	bool ParseArguments(int argc, char** argv, CookOptions& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string argument = argv[i];
+			const bool hasValue = i + 1 < argc;
+			if (argument == "-o" && hasValue)
+			{
+				options.outputDirectory = argv[++i];
+			}
+			else if (argument == "-f" && hasValue)
+			{
+				const std::string format = argv[++i];
+				if (format == "bc7")
+				{
+					options.format = DXGI_FORMAT_BC7_UNORM_SRGB;
+				}
+				else if (format == "bc1")
+				{
+					options.format = DXGI_FORMAT_BC1_UNORM_SRGB;
+				}
+				else
+				{
+					return false;
+				}
+			}
+			else if (argument == "-j" && hasValue)
+			{
+				options.threadCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (argument == "--quick")
+			{
+				options.quick = true;
+			}
+			else if (argument == "--force")
+			{
+				options.force = true;
+			}
+			else if (!argument.starts_with("-"))
+			{
+				options.inputs.push_back(argument);
+			}
+			else
+			{
+				return false;
+			}
+		}
+		if (options.inputs.empty())
+		{
+			options.inputs.push_back("resources");
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	CookOptions options;
+	if (!ParseArguments(argc, argv, options))
+	{
+		std::printf("usage: TextureCooker [-o output] [-f bc7|bc1] [-j threads] [--quick] [--force] [image or folder...]\n");
+		return 1;
+	}
+
+	const std::string manifestPath = (std::filesystem::path(options.outputDirectory) / "textures.manifest").generic_string();
+	TextureManifest manifest;
+	manifest.Load(manifestPath);
+
+	const std::vector<std::string> sources = CollectSources(options);
+	std::vector<CookResult> results(sources.size());
+
+	//画像ごとにスレッドへ配り、枚数が少なくて余ったスレッドは1枚の圧縮をブロックの行で分けるのに使う
+	const uint32_t totalThreadCount = options.threadCount ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+	const uint32_t threadCount = std::min(totalThreadCount, uint32_t(std::max<size_t>(sources.size(), 1)));
+	options.compressThreadCount = std::max(1u, totalThreadCount / threadCount);
+	std::atomic<size_t> next = 0;
+	auto worker = [&]()
+		{
+#if defined(_WIN32)
+			//WICを使うスレッドごとに必要
+			HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+			for (size_t i = next++; i < sources.size(); i = next++)
+			{
+				results[i] = CookTexture(options, manifest, sources[i]);
+			}
+#if defined(_WIN32)
+			if (SUCCEEDED(hr))
+			{
+				CoUninitialize();
+			}
+#endif
+		};
+	std::vector<std::thread> threads;
+	for (uint32_t t = 1; t < threadCount; t++)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	//結果を表示して一覧を更新する
+	size_t cookedCount = 0;
+	size_t failedCount = 0;
+	size_t uncompressedTotal = 0;
+	size_t cookedTotal = 0;
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		const CookResult& result = results[i];
+		if (!result.succeeded)
+		{
+			std::printf("  failed     %s\n", sources[i].c_str());
+			failedCount++;
+			continue;
+		}
+		manifest.Set(result.entry);
+		if (!result.cooked)
+		{
+			std::printf("  up to date %s\n", sources[i].c_str());
+			continue;
+		}
+		std::printf("  cooked     %s -> %s (%s %zux%zu, %zu mips, %.2f MB -> %.2f MB, %.1f ms)\n",
+			sources[i].c_str(), result.entry.cookedPath.c_str(), result.entry.format.c_str(), result.width, result.height, result.mipLevels,
+			result.uncompressedSize / (1024.0 * 1024.0), result.cookedSize / (1024.0 * 1024.0), result.milliseconds);
+		cookedCount++;
+		uncompressedTotal += result.uncompressedSize;
+		cookedTotal += result.cookedSize;
+	}
+	std::error_code error;
+	std::filesystem::create_directories(options.outputDirectory, error);
+	const bool saved = manifest.Save(manifestPath);
+
+	std::printf("%zu textures, %zu cooked, %zu failed (%.2f MB -> %.2f MB), %u threads (%u per texture)\n",
+		sources.size(), cookedCount, failedCount, uncompressedTotal / (1024.0 * 1024.0), cookedTotal / (1024.0 * 1024.0), totalThreadCount, options.compressThreadCount);
+	std::printf("manifest : %s%s\n", manifestPath.c_str(), saved ? "" : " (write failed)");
+	return failedCount == 0 && saved ? 0 : 1;
+}